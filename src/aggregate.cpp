@@ -14,6 +14,24 @@
 
 #include "schema/columninfo.h"
 
+void AggrFunc_i::UpdateBatch ( const VecTraits_T<AggrStep_t> & dSteps )
+{
+	for ( const auto & tStep : dSteps )
+		if ( tStep.m_bSetup )
+			Setup ( *tStep.m_pDst, *tStep.m_pSrc, false );
+		else
+			Update ( *tStep.m_pDst, *tStep.m_pSrc, false );
+}
+
+/// batch loop for row-based aggregates: their Setup() is a no-op, and Update() of a final class is not a virtual call
+template < typename AGGR >
+static void UpdateBatchPlain ( AGGR & tAggr, const VecTraits_T<AggrStep_t> & dSteps )
+{
+	for ( const auto & tStep : dSteps )
+		if ( !tStep.m_bSetup )
+			tAggr.Update ( *tStep.m_pDst, *tStep.m_pSrc, false );
+}
+
 /// aggregate traits for different attribute types
 template < typename T >
 class AggrFunc_Traits_T : public AggrFunc_i
@@ -87,6 +105,25 @@ public:
 protected:
 	CSphString m_sAttr;
 	CSphScopedPtr<columnar::Iterator_i> m_pIterator {nullptr};
+	CSphVector<uint32_t> m_dRowIDs;
+	CSphVector<int64_t> m_dValues;
+
+	/// decode source values of the whole batch at once instead of seeking the iterator step by step
+	bool FetchBatch ( const VecTraits_T<AggrStep_t> & dSteps )
+	{
+		if ( !m_pIterator.Ptr() )
+			return false;
+
+		m_dRowIDs.Resize ( dSteps.GetLength() );
+		m_dValues.Resize ( dSteps.GetLength() );
+		ARRAY_FOREACH ( i, dSteps )
+			m_dRowIDs[i] = dSteps[i].m_pSrc->m_tRowID;
+
+		columnar::Span_T<uint32_t> dRowIDs ( m_dRowIDs.Begin(), m_dRowIDs.GetLength() );
+		columnar::Span_T<int64_t> dValues ( m_dValues.Begin(), m_dValues.GetLength() );
+		m_pIterator->Fetch ( dRowIDs, dValues );
+		return true;
+	}
 };
 
 /// SUM() implementation
@@ -108,6 +145,8 @@ public:
 		if ( tSrcValue )
 			BASE::SetValue ( tDst, tDstValue+tSrcValue );
 	}
+
+	void UpdateBatch ( const VecTraits_T<AggrStep_t> & dSteps ) final { UpdateBatchPlain ( *this, dSteps ); }
 };
 
 template < typename T >
@@ -136,6 +175,22 @@ public:
 		if ( tSrcValue )
 			BASE::SetValue ( tDst, tDstValue+tSrcValue );
 	}
+
+	void UpdateBatch ( const VecTraits_T<AggrStep_t> & dSteps ) final
+	{
+		if ( !BASE::FetchBatch ( dSteps ) )
+			return;
+
+		ARRAY_FOREACH ( i, dSteps )
+		{
+			CSphMatch & tDst = *dSteps[i].m_pDst;
+			T tSrcValue = (T)BASE::m_dValues[i];
+			if ( dSteps[i].m_bSetup )
+				BASE::SetValue ( tDst, tSrcValue );
+			else if ( tSrcValue )
+				BASE::SetValue ( tDst, BASE::GetValue(tDst)+tSrcValue );
+		}
+	}
 };
 
 /// AVG() implementation
@@ -167,6 +222,8 @@ public:
 			SetValue ( tDst, tDstValue+tSrcValue );
 	}
 
+	void UpdateBatch ( const VecTraits_T<AggrStep_t> & dSteps ) final { UpdateBatchPlain ( *this, dSteps ); }
+
 	void Finalize ( CSphMatch & tDst ) final
 	{
 		auto uAttr = tDst.GetAttr ( m_tCountLoc );
@@ -220,6 +277,22 @@ public:
 			SetValue ( tDst, tDstValue + tSrcValue );
 	}
 
+	void UpdateBatch ( const VecTraits_T<AggrStep_t> & dSteps ) final
+	{
+		if ( !BASE::FetchBatch ( dSteps ) )
+			return;
+
+		ARRAY_FOREACH ( i, dSteps )
+		{
+			CSphMatch & tDst = *dSteps[i].m_pDst;
+			T tSrcValue = (T)BASE::m_dValues[i];
+			if ( dSteps[i].m_bSetup )
+				SetValue ( tDst, tSrcValue );
+			else if ( tSrcValue )
+				SetValue ( tDst, GetValue(tDst) + tSrcValue );
+		}
+	}
+
 	void Finalize ( CSphMatch & tDst ) final
 	{
 		auto uAttr = tDst.GetAttr ( m_tCountLoc );
@@ -246,6 +319,8 @@ public:
 		if ( tSrcValue>tDstValue )
 			BASE::SetValue ( tDst, tSrcValue );
 	}
+
+	void UpdateBatch ( const VecTraits_T<AggrStep_t> & dSteps ) final { UpdateBatchPlain ( *this, dSteps ); }
 };
 
 template < typename T >
@@ -273,6 +348,20 @@ public:
 		if ( tSrcValue>tDstValue )
 			BASE::SetValue ( tDst, tSrcValue );
 	}
+
+	void UpdateBatch ( const VecTraits_T<AggrStep_t> & dSteps ) final
+	{
+		if ( !BASE::FetchBatch ( dSteps ) )
+			return;
+
+		ARRAY_FOREACH ( i, dSteps )
+		{
+			CSphMatch & tDst = *dSteps[i].m_pDst;
+			T tSrcValue = (T)BASE::m_dValues[i];
+			if ( dSteps[i].m_bSetup || tSrcValue>BASE::GetValue(tDst) )
+				BASE::SetValue ( tDst, tSrcValue );
+		}
+	}
 };
 
 /// MIN() implementation
@@ -290,6 +379,8 @@ public:
 		if ( tSrcValue<tDstValue )
 			BASE::SetValue ( tDst, tSrcValue );
 	}
+
+	void UpdateBatch ( const VecTraits_T<AggrStep_t> & dSteps ) final { UpdateBatchPlain ( *this, dSteps ); }
 };
 
 template < typename T >
@@ -317,6 +408,20 @@ public:
 		if ( tSrcValue<tDstValue )
 			BASE::SetValue ( tDst, tSrcValue );
 	}
+
+	void UpdateBatch ( const VecTraits_T<AggrStep_t> & dSteps ) final
+	{
+		if ( !BASE::FetchBatch ( dSteps ) )
+			return;
+
+		ARRAY_FOREACH ( i, dSteps )
+		{
+			CSphMatch & tDst = *dSteps[i].m_pDst;
+			T tSrcValue = (T)BASE::m_dValues[i];
+			if ( dSteps[i].m_bSetup || tSrcValue<BASE::GetValue(tDst) )
+				BASE::SetValue ( tDst, tSrcValue );
+		}
+	}
 };
 
 
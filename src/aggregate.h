@@ -16,6 +16,14 @@
 #include "match.h"
 #include "columnarlib.h"
 
+/// one deferred aggregate step of a batch push: the group match and the (not grouped) match that goes into it
+struct AggrStep_t
+{
+	CSphMatch *			m_pDst;
+	const CSphMatch *	m_pSrc;
+	bool				m_bSetup;	///< first match of a new group (Setup), otherwise Update
+};
+
 class AggrFunc_i
 {
 public:
@@ -26,6 +34,9 @@ public:
 	virtual void	Setup ( CSphMatch & tDst, const CSphMatch & tSrc, bool bGrouped ) {}
 	virtual void	Finalize ( CSphMatch & tDst ) {}
 	virtual void	SetColumnar ( columnar::Columnar_i * pColumnar ) {}
+
+	/// apply the steps in the given order; same as calling Setup/Update on each of them
+	virtual void	UpdateBatch ( const VecTraits_T<AggrStep_t> & dSteps );
 };
 
 
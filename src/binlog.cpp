@@ -95,69 +95,72 @@ private:
 
 using namespace Binlog;
 
-class Binlog_c : public ISphNoncopyable
+enum OnCommitAction_e
+{
+	ACTION_NONE,
+	ACTION_FSYNC,
+	ACTION_WRITE
+};
+
+/// settings shared by all binlog streams
+/// flush mode and period are server-wide durability settings (binlog_flush), there is no per-index config for them;
+/// each stream still applies them on its own writer and lock
+struct BinlogConfig_t
+{
+	OnCommitAction_e	m_eOnCommit { ACTION_NONE };
+	int					m_iRestartSize = 268435456; // binlog size restart threshold, 256M
+	DWORD				m_uReplayFlags = 0;
+	bool				m_bReplayMode = false; // replay mode indicator
+};
+
+/// one independent binlog: own files, meta, write lock, rotation and flushing
+/// it is either the common one in binlog_path, or per-index one in binlog_path/<index>
+class BinlogStream_c : public ISphNoncopyable
 {
 public:
-	Binlog_c ();
-	~Binlog_c ();
+	BinlogStream_c ( const BinlogConfig_t & tConfig, CSphString sLogPath );
+	~BinlogStream_c ();
 
 	void	NotifyIndexFlush ( const char * sIndexName, int64_t iTID, bool bShutdown );
-	void	BinlogCommit (Blop_e eOp, int64_t * pTID, const char * sIndexName, bool bIncTID, FnWriteCommit&& fnSaver);
+	void	BinlogCommit ( Blop_e eOp, int64_t * pTID, const char * sIndexName, FnWriteCommit && fnSaver );
+	void	ForgetIndex ( const char * szIndexName );
+	void	Remove ();
 
-	void	Configure ( const CSphConfigSection & hSearchd, bool bTestMode, DWORD uReplayFlags );
-	void	Replay ( const SmallStringHash_T<CSphIndex*> & hIndexes, ProgressCallbackSimple_t * pfnProgressCallback );
+	bool	LoadMeta ();
+	void	Replay ( const SmallStringHash_T<CSphIndex*> & hIndexes, ProgressCallbackSimple_t * pfnProgressCallback, bool bRetire );
+	void	Start ();
 
-	bool	IsActive () const { return !m_bDisabled; }
-	void	CheckPath ( const CSphConfigSection & hSearchd, bool bTestMode );
-
-	bool	IsFlushingEnabled() const;
 	void	DoFlush ();
-	int64_t	NextFlushingTime() const;
 
-	CSphString GetLogPath() const;
+	bool	IsRetired () const { return m_bRetired; }
+	const CSphString & GetLogPath() const { return m_sLogPath; }
 
 private:
 	struct BlopStartEnd_t
 	{
-		Binlog_c & m_tBinlog;
+		BinlogStream_c & m_tBinlog;
 
-		BlopStartEnd_t ( Binlog_c & tBinlog, int64_t * pTID, Blop_e eBlop, const char * szIndexName );
+		BlopStartEnd_t ( BinlogStream_c & tBinlog, int64_t * pTID, Blop_e eBlop, const char * szIndexName );
 		~BlopStartEnd_t();
 	};
 
-	volatile int64_t		m_iLastFlushed = 0;
-	volatile int64_t		m_iFlushPeriod = BINLOG_AUTO_FLUSH;
-
-	enum OnCommitAction_e
-	{
-		ACTION_NONE,
-		ACTION_FSYNC,
-		ACTION_WRITE
-	};
-	OnCommitAction_e		m_eOnCommit { ACTION_NONE };
+	const BinlogConfig_t &	m_tConfig;
+	CSphString				m_sLogPath;
 
 	CSphMutex				m_tWriteLock; // lock on operation
 
-	int						m_iLockFD = -1;
 	CSphString				m_sWriterError;
 	BinlogWriter_c			m_tWriter;
 
 	mutable CSphVector<BinlogFileDesc_t>	m_dLogFiles; // active log files
 
-	CSphString				m_sLogPath;
-
-	bool					m_bReplayMode = false; // replay mode indicator
-	bool					m_bDisabled = true;
-	DWORD					m_uReplayFlags = 0;
-
-	int						m_iRestartSize = 268435456; // binlog size restart threshold, 256M
+	bool					m_bRetired = false;	///< replayed only to be unlinked after flush; never written again
 
 private:
 
 	int 					GetWriteIndexID ( const char * sName, int64_t iTID, int64_t tmNow );
-	void					LoadMeta ();
+	void					ReleaseLogs ( const char * sIndexName, int64_t iTID, bool bShutdown );
 	void					SaveMeta ();
-	void					LockFile ( bool bLock );
 	void					DoCacheWrite ();
 	void					CheckDoRestart ();
 	void					CheckDoFlush ();
@@ -168,7 +171,6 @@ private:
 	bool					ReplayUpdateAttributes ( int iBinlog, BinlogReader_c & tReader ) const;
 	bool					ReplayIndexAdd ( int iBinlog, const SmallStringHash_T<CSphIndex*> & hIndexes, BinlogReader_c & tReader ) const;
 	bool					ReplayCacheAdd ( int iBinlog, BinlogReader_c & tReader ) const;
-	bool 					IsBinlogWritable ( int64_t * pTID = nullptr );
 
 	static bool	CheckCrc ( const char * sOp, const CSphString & sIndex, int64_t iTID, int64_t iTxnPos, BinlogReader_c & tReader ) ;
 	bool		CheckTid ( const char * sOp, const BinlogIndexInfo_t & tIndex, int64_t iTID, int64_t iTxnPos ) const;
@@ -184,6 +186,54 @@ private:
 	int		ReplayIndexID ( BinlogReader_c & tReader, const BinlogFileDesc_t & tLog, const char * sPlace ) const;
 };
 
+
+/// binlog manager: either one common stream for all indexes (binlog_common=1, default),
+/// or separate stream per index, so that commits into different indexes don't serialize on one lock and file
+class Binlog_c : public ISphNoncopyable
+{
+public:
+	~Binlog_c ();
+
+	void	NotifyIndexFlush ( const char * sIndexName, int64_t iTID, bool bShutdown );
+	void	BinlogCommit ( Blop_e eOp, int64_t * pTID, const char * sIndexName, bool bIncTID, FnWriteCommit && fnSaver );
+	void	ForgetIndex ( const char * szIndexName );
+
+	void	Configure ( const CSphConfigSection & hSearchd, bool bTestMode, DWORD uReplayFlags );
+	void	Replay ( const SmallStringHash_T<CSphIndex*> & hIndexes, ProgressCallbackSimple_t * pfnProgressCallback );
+
+	bool	IsActive () const { return !m_bDisabled; }
+	void	CheckPath ( const CSphConfigSection & hSearchd, bool bTestMode );
+
+	bool	IsFlushingEnabled() const;
+	void	DoFlush ();
+	int64_t	NextFlushingTime() const;
+
+	CSphString GetLogPath() const;
+
+private:
+	BinlogConfig_t			m_tConfig;
+
+	volatile int64_t		m_iLastFlushed = 0;
+	volatile int64_t		m_iFlushPeriod = BINLOG_AUTO_FLUSH;
+
+	CSphMutex				m_tTIDLock; // advance TID when binlog is disabled
+
+	int						m_iLockFD = -1;
+	CSphString				m_sLogPath;
+	bool					m_bDisabled = true;
+	bool					m_bCommon = true;
+
+	CSphScopedPtr<BinlogStream_c>	m_pCommon { nullptr };
+
+	mutable RwLock_t						m_tStreamsLock;
+	SmallStringHash_T<BinlogStream_c *>		m_hStreams GUARDED_BY ( m_tStreamsLock );	///< per-index streams, owned; only used under the lock, as ForgetIndex() deletes them
+
+private:
+	void					LockFile ( bool bLock );
+	CSphString				GetStreamPath ( const char * szIndexName ) const;
+	void					AddIndexStream ( const char * szIndexName );
+};
+
 static Binlog_c *		g_pRtBinlog				= nullptr;
 
 //////////////////////////////////////////////////////////////////////////
@@ -345,14 +395,14 @@ void BinlogReader_c::HashCollected ()
 /// helper to RAII write txn infix and postfix
 //////////////////////////////////////////////////////////////////////////
 
-Binlog_c::BlopStartEnd_t::BlopStartEnd_t ( Binlog_c & tBinlog, int64_t * pTID, Blop_e eBlop, const char * szIndexName )
+BinlogStream_c::BlopStartEnd_t::BlopStartEnd_t ( BinlogStream_c & tBinlog, int64_t * pTID, Blop_e eBlop, const char * szIndexName )
 	: m_tBinlog ( tBinlog )
 {
 	m_tBinlog.WriteBlopHeader ( pTID, eBlop, szIndexName );
 }
 
 
-Binlog_c::BlopStartEnd_t::~BlopStartEnd_t ()
+BinlogStream_c::BlopStartEnd_t::~BlopStartEnd_t ()
 {
 	// checksum
 	m_tBinlog.m_tWriter.WriteCrc ();
@@ -364,24 +414,25 @@ Binlog_c::BlopStartEnd_t::~BlopStartEnd_t ()
 
 //////////////////////////////////////////////////////////////////////////
 
-Binlog_c::Binlog_c ()
+BinlogStream_c::BinlogStream_c ( const BinlogConfig_t & tConfig, CSphString sLogPath )
+	: m_tConfig ( tConfig )
+	, m_sLogPath ( std::move ( sLogPath ) )
 {
 	MEMORY ( MEM_BINLOG );
 	m_tWriter.SetBufferSize ( BINLOG_WRITE_BUFFER );
 }
 
-Binlog_c::~Binlog_c ()
+BinlogStream_c::~BinlogStream_c ()
 {
-	if ( !m_bDisabled )
+	if ( !m_bRetired )
 	{
 		DoCacheWrite();
 		m_tWriter.CloseFile();
-		LockFile ( false );
 	}
 }
 
 
-void Binlog_c::WriteBlopHeader ( int64_t * pTID, Blop_e eBlop, const char * szIndexName )
+void BinlogStream_c::WriteBlopHeader ( int64_t * pTID, Blop_e eBlop, const char * szIndexName )
 {
 	int64_t iTID = ++(*pTID);
 	const int64_t tmNow = sphMicroTimer();
@@ -399,19 +450,18 @@ void Binlog_c::WriteBlopHeader ( int64_t * pTID, Blop_e eBlop, const char * szIn
 
 
 // here's been going binlogs with ALL closed indices removing
-void Binlog_c::NotifyIndexFlush ( const char * sIndexName, int64_t iTID, bool bShutdown )
+void BinlogStream_c::NotifyIndexFlush ( const char * sIndexName, int64_t iTID, bool bShutdown )
 {
-	if ( m_bReplayMode )
-		sphInfo ( "index '%s': ramchunk saved. TID=" INT64_FMT "", sIndexName, iTID );
-
-	if (!IsBinlogWritable ())
-		return;
-
 	MEMORY ( MEM_BINLOG );
-	assert ( bShutdown || m_dLogFiles.GetLength() );
+	assert ( bShutdown || m_bRetired || m_dLogFiles.GetLength() );
 
 	ScopedMutex_t tWriteLock ( m_tWriteLock );
+	ReleaseLogs ( sIndexName, iTID, bShutdown );
+}
 
+// caller must hold the write lock
+void BinlogStream_c::ReleaseLogs ( const char * sIndexName, int64_t iTID, bool bShutdown )
+{
 	bool bCurrentLogAbandoned = false;
 	const int iPreflushFiles = m_dLogFiles.GetLength();
 
@@ -459,7 +509,7 @@ void Binlog_c::NotifyIndexFlush ( const char * sIndexName, int64_t iTID, bool bS
 		m_dLogFiles.Remove ( iLog-- );
 	}
 
-	if ( bCurrentLogAbandoned && !bShutdown )
+	if ( bCurrentLogAbandoned && !bShutdown && !m_bRetired )
 	{
 		// if current log was closed, we need a new one (it will automatically save meta, too)
 		OpenNewLog ();
@@ -471,49 +521,68 @@ void Binlog_c::NotifyIndexFlush ( const char * sIndexName, int64_t iTID, bool bS
 	}
 }
 
-#ifndef LOCALDATADIR
-#define LOCALDATADIR "."
-#endif
-
-void Binlog_c::Configure ( const CSphConfigSection & hSearchd, bool bTestMode, DWORD uReplayFlags )
+// dropped index needs none of its records, so they must not keep the logs alive;
+// and index created under the same name later starts from TID 0 again, so it must not share the log entry either
+void BinlogStream_c::ForgetIndex ( const char * szIndexName )
 {
 	MEMORY ( MEM_BINLOG );
+	ScopedMutex_t tWriteLock ( m_tWriteLock );
 
-	const int iMode = hSearchd.GetInt ( "binlog_flush", 2 );
-	switch ( iMode )
-	{
-		case 0:		m_eOnCommit = ACTION_NONE; break;
-		case 1:		m_eOnCommit = ACTION_FSYNC; break;
-		case 2:		m_eOnCommit = ACTION_WRITE; break;
-		default:	sphDie ( "unknown binlog flush mode %d (must be 0, 1, or 2)\n", iMode );
-	}
+	int64_t iTID = -1;
+	for ( const auto & tLog : m_dLogFiles )
+		for ( const auto & tIndex : tLog.m_dIndexInfos )
+			if ( tIndex.m_sName==szIndexName )
+				iTID = Max ( iTID, Max ( tIndex.m_iMaxTID, tIndex.m_iFlushedTID ) );
 
-	m_sLogPath = hSearchd.GetStr ( "binlog_path", bTestMode ? "" : LOCALDATADIR );
-	m_bDisabled = m_sLogPath.IsEmpty();
+	if ( iTID<0 )
+		return;
 
-	m_iRestartSize = hSearchd.GetSize ( "binlog_max_log_size", m_iRestartSize );
-	m_uReplayFlags = uReplayFlags;
+	ReleaseLogs ( szIndexName, iTID, false );
 
-	if ( !m_bDisabled )
+	// current log was not released, as other indexes still need it; start a new one without that entry
+	if ( m_bRetired )
+		return;
+
+	assert ( m_dLogFiles.GetLength() );
+	if ( m_dLogFiles.Last().m_dIndexInfos.any_of ( [szIndexName] ( const BinlogIndexInfo_t & tIndex ) { return tIndex.m_sName==szIndexName; } ) )
 	{
-		LockFile ( true );
-		LoadMeta();
+		DoCacheWrite();
+		m_tWriter.CloseFile();
+		OpenNewLog();
 	}
 }
 
-void Binlog_c::Replay ( const SmallStringHash_T<CSphIndex*> & hIndexes, ProgressCallbackSimple_t * pfnProgressCallback )
+// unlink all the files of the stream; it is never written again
+void BinlogStream_c::Remove ()
 {
-	if ( m_bDisabled )
-		return;
+	MEMORY ( MEM_BINLOG );
+	ScopedMutex_t tWriteLock ( m_tWriteLock );
 
-	// on replay started
-	if ( pfnProgressCallback )
-		pfnProgressCallback();
+	if ( !m_bRetired )
+		m_tWriter.CloseFile();
+	m_bRetired = true;
+
+	for ( const auto & tLog : m_dLogFiles )
+	{
+		CSphString sLog = MakeBinlogName ( m_sLogPath.cstr(), tLog.m_iExt );
+		if ( ::unlink ( sLog.cstr() ) )
+			sphWarning ( "binlog: failed to unlink %s: %s", sLog.cstr(), strerrorm(errno) );
+	}
+	m_dLogFiles.Reset();
 
+	CSphString sMeta;
+	sMeta.SetSprintf ( "%s/binlog.meta", m_sLogPath.cstr() );
+	::unlink ( sMeta.cstr() );
+
+	if ( ::rmdir ( m_sLogPath.cstr() ) )
+		sphWarning ( "binlog: failed to remove %s: %s", m_sLogPath.cstr(), strerrorm(errno) );
+}
+
+void BinlogStream_c::Replay ( const SmallStringHash_T<CSphIndex*> & hIndexes, ProgressCallbackSimple_t * pfnProgressCallback, bool bRetire )
+{
 	int64_t tmReplay = sphMicroTimer();
 
 	// do replay
-	m_bReplayMode = true;
 	int iLastLogState = 0;
 	ARRAY_FOREACH ( i, m_dLogFiles )
 	{
@@ -535,24 +604,27 @@ void Binlog_c::Replay ( const SmallStringHash_T<CSphIndex*> & hIndexes, Progress
 	// and we might therefore want to update m_iFlushedTID everywhere
 	// but for now, let's just wait until next flush for simplicity
 
-	// resume normal operation
-	m_bReplayMode = false;
-	OpenNewLog ( iLastLogState );
+	// stream of another binlog mode is only kept until its indexes are flushed
+	m_bRetired = bRetire;
+	if ( !m_bRetired )
+		OpenNewLog ( iLastLogState );
 }
 
 
-bool Binlog_c::IsFlushingEnabled () const
+void BinlogStream_c::Start ()
 {
-	return ( !m_bDisabled && m_eOnCommit!=ACTION_FSYNC );
+	LoadMeta();
+	OpenNewLog();
 }
 
 
-void Binlog_c::DoFlush ()
+void BinlogStream_c::DoFlush ()
 {
-	assert ( !m_bDisabled );
 	MEMORY ( MEM_BINLOG );
+	if ( m_bRetired )
+		return;
 
-	if ( m_eOnCommit==ACTION_NONE || m_tWriter.HasUnwrittenData() )
+	if ( m_tConfig.m_eOnCommit==ACTION_NONE || m_tWriter.HasUnwrittenData() )
 	{
 		ScopedMutex_t LockWriter( m_tWriteLock);
 		m_tWriter.Flush();
@@ -560,18 +632,9 @@ void Binlog_c::DoFlush ()
 
 	if ( m_tWriter.HasUnsyncedData() )
 		m_tWriter.Fsync();
-
-	m_iLastFlushed = sphMicroTimer ();
 }
 
-int64_t Binlog_c::NextFlushingTime () const
-{
-	if ( !m_iLastFlushed )
-		return sphMicroTimer () + m_iFlushPeriod;
-	return m_iLastFlushed + m_iFlushPeriod;
-}
-
-int Binlog_c::GetWriteIndexID ( const char * sName, int64_t iTID, int64_t tmNow )
+int BinlogStream_c::GetWriteIndexID ( const char * sName, int64_t iTID, int64_t tmNow )
 {
 	MEMORY ( MEM_BINLOG );
 	assert ( m_dLogFiles.GetLength() );
@@ -614,14 +677,15 @@ int Binlog_c::GetWriteIndexID ( const char * sName, int64_t iTID, int64_t tmNow
 	return iID;
 }
 
-void Binlog_c::LoadMeta ()
+// returns true if there are log files to replay
+bool BinlogStream_c::LoadMeta ()
 {
 	MEMORY ( MEM_BINLOG );
 
 	CSphString sMeta;
 	sMeta.SetSprintf ( "%s/binlog.meta", m_sLogPath.cstr() );
 	if ( !sphIsReadable ( sMeta.cstr() ) )
-		return;
+		return false;
 
 	CSphString sError;
 
@@ -645,7 +709,7 @@ void Binlog_c::LoadMeta ()
 	m_dLogFiles.Resize ( rdMeta.UnzipInt() ); // FIXME! sanity check
 
 	if ( !m_dLogFiles.GetLength() )
-		return;
+		return false;
 
 	// ok, so there is actual recovery data
 	// let's require that exact version and bitness, then
@@ -659,9 +723,11 @@ void Binlog_c::LoadMeta ()
 	// load list of active log files
 	ARRAY_FOREACH ( i, m_dLogFiles )
 		m_dLogFiles[i].m_iExt = rdMeta.UnzipInt(); // everything else is saved in logs themselves
+
+	return true;
 }
 
-void Binlog_c::SaveMeta ()
+void BinlogStream_c::SaveMeta ()
 {
 	MEMORY ( MEM_BINLOG );
 
@@ -725,7 +791,7 @@ void Binlog_c::LockFile ( bool bLock )
 	}
 }
 
-void Binlog_c::OpenNewLog ( int iLastState )
+void BinlogStream_c::OpenNewLog ( int iLastState )
 {
 	MEMORY ( MEM_BINLOG );
 
@@ -763,7 +829,7 @@ void Binlog_c::OpenNewLog ( int iLastState )
 
 // cache is a small summary of affected indexes, it is written at the very end of binlog file when it exceeded size limit,
 // before opening new file.
-void Binlog_c::DoCacheWrite ()
+void BinlogStream_c::DoCacheWrite ()
 {
 	if ( !m_dLogFiles.GetLength() )
 		return;
@@ -786,10 +852,10 @@ void Binlog_c::DoCacheWrite ()
 	m_tWriter.WriteCrc ();
 }
 
-void Binlog_c::CheckDoRestart ()
+void BinlogStream_c::CheckDoRestart ()
 {
 	// restart on exceed file size limit
-	if ( m_iRestartSize>0 && m_tWriter.GetPos()>m_iRestartSize )
+	if ( m_tConfig.m_iRestartSize>0 && m_tWriter.GetPos()>m_tConfig.m_iRestartSize )
 	{
 		MEMORY ( MEM_BINLOG );
 
@@ -801,9 +867,9 @@ void Binlog_c::CheckDoRestart ()
 	}
 }
 
-void Binlog_c::CheckDoFlush ()
+void BinlogStream_c::CheckDoFlush ()
 {
-	switch ( m_eOnCommit )
+	switch ( m_tConfig.m_eOnCommit )
 	{
 	case ACTION_NONE: return;
 	case ACTION_WRITE:
@@ -822,7 +888,7 @@ void Binlog_c::CheckDoFlush ()
 	}
 }
 
-int Binlog_c::ReplayBinlog ( const SmallStringHash_T<CSphIndex*> & hIndexes, int iBinlog )
+int BinlogStream_c::ReplayBinlog ( const SmallStringHash_T<CSphIndex*> & hIndexes, int iBinlog )
 {
 	assert ( iBinlog>=0 && iBinlog<m_dLogFiles.GetLength() );
 	CSphString sError;
@@ -973,7 +1039,7 @@ int Binlog_c::ReplayBinlog ( const SmallStringHash_T<CSphIndex*> & hIndexes, int
 	return ( bHaveCacheOp && dTotal[TOTAL]==1 ) ? 1 : 0;
 }
 
-bool Binlog_c::ReplayIndexAdd ( int iBinlog, const SmallStringHash_T<CSphIndex*> & hIndexes, BinlogReader_c & tReader ) const
+bool BinlogStream_c::ReplayIndexAdd ( int iBinlog, const SmallStringHash_T<CSphIndex*> & hIndexes, BinlogReader_c & tReader ) const
 {
 	// load and check index
 	const int64_t iTxnPos = tReader.GetPos(); // that is purely for reporting anomalities
@@ -1025,7 +1091,7 @@ bool Binlog_c::ReplayIndexAdd ( int iBinlog, const SmallStringHash_T<CSphIndex*>
 	return true;
 }
 
-bool Binlog_c::ReplayCacheAdd ( int iBinlog, BinlogReader_c & tReader ) const
+bool BinlogStream_c::ReplayCacheAdd ( int iBinlog, BinlogReader_c & tReader ) const
 {
 	const int64_t iTxnPos = tReader.GetPos();
 	BinlogFileDesc_t & tLog = m_dLogFiles[iBinlog];
@@ -1086,7 +1152,7 @@ bool Binlog_c::ReplayCacheAdd ( int iBinlog, BinlogReader_c & tReader ) const
 //////////////////////////////////////////////////////////////////////////
 
 // helper used in about all replay ops
-int Binlog_c::ReplayIndexID ( BinlogReader_c & tReader, const BinlogFileDesc_t & tLog, const char * sPlace ) const
+int BinlogStream_c::ReplayIndexID ( BinlogReader_c & tReader, const BinlogFileDesc_t & tLog, const char * sPlace ) const
 {
 	const int64_t iTxnPos = tReader.GetPos();
 	const int iVal = (int)tReader.UnzipOffset();
@@ -1101,11 +1167,6 @@ int Binlog_c::ReplayIndexID ( BinlogReader_c & tReader, const BinlogFileDesc_t &
 	return iVal;
 }
 
-CSphString Binlog_c::GetLogPath() const
-{
-	return m_sLogPath;
-}
-
 static const char* OpName ( Binlog::Blop_e eOp)
 {
 	switch (eOp)
@@ -1120,7 +1181,7 @@ static const char* OpName ( Binlog::Blop_e eOp)
 }
 
 // dedicated function for replay attribute update
-bool Binlog_c::ReplayUpdateAttributes ( int iBinlog, BinlogReader_c & tReader ) const
+bool BinlogStream_c::ReplayUpdateAttributes ( int iBinlog, BinlogReader_c & tReader ) const
 {
 	// load and lookup index
 	const int64_t iTxnPos = tReader.GetPos();
@@ -1175,7 +1236,7 @@ bool Binlog_c::ReplayUpdateAttributes ( int iBinlog, BinlogReader_c & tReader )
 	return true;
 }
 
-bool Binlog_c::ReplayTxn ( Binlog::Blop_e eOp, int iBinlog, BinlogReader_c & tReader ) const
+bool BinlogStream_c::ReplayTxn ( Binlog::Blop_e eOp, int iBinlog, BinlogReader_c & tReader ) const
 {
 	// load and lookup index
 	const int64_t iTxnPos = tReader.GetPos();
@@ -1230,6 +1291,10 @@ bool Binlog_c::ReplayTxn ( Binlog::Blop_e eOp, int iBinlog, BinlogReader_c & tRe
 
 }
 
+#ifndef LOCALDATADIR
+#define LOCALDATADIR "."
+#endif
+
 void Binlog_c::CheckPath ( const CSphConfigSection & hSearchd, bool bTestMode )
 {
 	m_sLogPath = hSearchd.GetStr ( "binlog_path", bTestMode ? "" : LOCALDATADIR );
@@ -1242,12 +1307,12 @@ void Binlog_c::CheckPath ( const CSphConfigSection & hSearchd, bool bTestMode )
 	}
 }
 
-bool Binlog_c::CheckCrc ( const char * sOp, const CSphString & sIndex, int64_t iTID, int64_t iTxnPos, BinlogReader_c & tReader )
+bool BinlogStream_c::CheckCrc ( const char * sOp, const CSphString & sIndex, int64_t iTID, int64_t iTxnPos, BinlogReader_c & tReader )
 {
 	return !tReader.GetErrorFlag() && tReader.CheckCrc ( sOp, sIndex.cstr(), iTID, iTxnPos );
 }
 
-bool Binlog_c::CheckTid ( const char * sOp, const BinlogIndexInfo_t & tIndex, int64_t iTID, int64_t iTxnPos ) const
+bool BinlogStream_c::CheckTid ( const char * sOp, const BinlogIndexInfo_t & tIndex, int64_t iTID, int64_t iTxnPos ) const
 {
 	if ( iTID<tIndex.m_iMaxTID )
 	{
@@ -1260,14 +1325,14 @@ bool Binlog_c::CheckTid ( const char * sOp, const BinlogIndexInfo_t & tIndex, in
 }
 
 
-void Binlog_c::CheckTidSeq ( const char * sOp, const BinlogIndexInfo_t & tIndex, int64_t iTID, CSphIndex * pIndexTID, int64_t iTxnPos ) const
+void BinlogStream_c::CheckTidSeq ( const char * sOp, const BinlogIndexInfo_t & tIndex, int64_t iTID, CSphIndex * pIndexTID, int64_t iTxnPos ) const
 {
 	if ( pIndexTID && iTID!=pIndexTID->m_iTID+1 )
 		sphWarning ( "binlog: %s: unexpected tid (index=%s, indextid=" INT64_FMT ", logtid=" INT64_FMT ", pos=" INT64_FMT ")",
 			sOp, tIndex.m_sName.cstr(), pIndexTID->m_iTID, iTID, iTxnPos );
 }
 
-bool Binlog_c::CheckTime ( BinlogIndexInfo_t & tIndex, const char * sOp, int64_t tmStamp, int64_t iTID, int64_t iTxnPos ) const
+bool BinlogStream_c::CheckTime ( BinlogIndexInfo_t & tIndex, const char * sOp, int64_t tmStamp, int64_t iTID, int64_t iTxnPos ) const
 {
 	if ( tmStamp<tIndex.m_tmMax )
 	{
@@ -1281,7 +1346,7 @@ bool Binlog_c::CheckTime ( BinlogIndexInfo_t & tIndex, const char * sOp, int64_t
 }
 
 
-bool Binlog_c::PerformChecks ( const char * szOp, BinlogIndexInfo_t & tIndex, int64_t iTID, int64_t iTxnPos, int64_t tmStamp,
+bool BinlogStream_c::PerformChecks ( const char * szOp, BinlogIndexInfo_t & tIndex, int64_t iTID, int64_t iTxnPos, int64_t tmStamp,
 		BinlogReader_c & tReader ) const
 {
 	// checksum
@@ -1300,7 +1365,7 @@ bool Binlog_c::PerformChecks ( const char * szOp, BinlogIndexInfo_t & tIndex, in
 }
 
 
-void Binlog_c::UpdateIndexInfo ( BinlogIndexInfo_t & tIndex, int64_t iTID, int64_t tmStamp )
+void BinlogStream_c::UpdateIndexInfo ( BinlogIndexInfo_t & tIndex, int64_t iTID, int64_t tmStamp )
 {
 	tIndex.m_iMinTID = Min ( tIndex.m_iMinTID, iTID );
 	tIndex.m_iMaxTID = Max ( tIndex.m_iMaxTID, iTID );
@@ -1308,34 +1373,256 @@ void Binlog_c::UpdateIndexInfo ( BinlogIndexInfo_t & tIndex, int64_t iTID, int64
 	tIndex.m_tmMax = Max ( tIndex.m_tmMax, tmStamp );
 }
 
-bool Binlog_c::IsBinlogWritable ( int64_t * pTID )
+// commit stuff. Indexes call this function with serialization cb; binlog is agnostic to alien data structures.
+void BinlogStream_c::BinlogCommit ( Blop_e eOp, int64_t * pTID, const char * sIndexName, FnWriteCommit && fnSaver )
 {
-	if ( m_bReplayMode )
-		return false;
+	MEMORY ( MEM_BINLOG );
+	assert ( !m_bRetired );
+	ScopedMutex_t tWriteLock ( m_tWriteLock );
+	BlopStartEnd_t tStartEnd ( *this, pTID, eOp, sIndexName );
+
+	// save txn data
+	fnSaver ( m_tWriter );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+Binlog_c::~Binlog_c ()
+{
+	if ( m_bDisabled )
+		return;
+
+	{
+		ScWL_t tLock ( m_tStreamsLock );
+		for ( auto & tStream : m_hStreams )
+			SafeDelete ( tStream.second );
+		m_hStreams.Reset();
+	}
+
+	m_pCommon = nullptr;
+	LockFile ( false );
+}
+
+void Binlog_c::Configure ( const CSphConfigSection & hSearchd, bool bTestMode, DWORD uReplayFlags )
+{
+	MEMORY ( MEM_BINLOG );
+
+	const int iMode = hSearchd.GetInt ( "binlog_flush", 2 );
+	switch ( iMode )
+	{
+		case 0:		m_tConfig.m_eOnCommit = ACTION_NONE; break;
+		case 1:		m_tConfig.m_eOnCommit = ACTION_FSYNC; break;
+		case 2:		m_tConfig.m_eOnCommit = ACTION_WRITE; break;
+		default:	sphDie ( "unknown binlog flush mode %d (must be 0, 1, or 2)\n", iMode );
+	}
+
+	m_sLogPath = hSearchd.GetStr ( "binlog_path", bTestMode ? "" : LOCALDATADIR );
+	m_bDisabled = m_sLogPath.IsEmpty();
+	m_bCommon = hSearchd.GetInt ( "binlog_common", 1 )!=0;
+
+	m_tConfig.m_iRestartSize = hSearchd.GetSize ( "binlog_max_log_size", m_tConfig.m_iRestartSize );
+	m_tConfig.m_uReplayFlags = uReplayFlags;
 
 	if ( !m_bDisabled )
-		return true;
+	{
+		LockFile ( true );
+		m_pCommon = new BinlogStream_c ( m_tConfig, m_sLogPath );
+	}
+}
+
+void Binlog_c::Replay ( const SmallStringHash_T<CSphIndex*> & hIndexes, ProgressCallbackSimple_t * pfnProgressCallback )
+{
+	if ( m_bDisabled )
+		return;
+
+	// on replay started
+	if ( pfnProgressCallback )
+		pfnProgressCallback();
 
-	if ( pTID ) // still need to advance TID as index flush according to it
+	m_tConfig.m_bReplayMode = true;
+
+	// per-index streams are only looked up for served indexes; logs of others are useless anyway
+	// and are unlinked once an index with the same name creates its stream again
+	bool bHaveCommon = m_pCommon->LoadMeta();
+	CSphVector<std::pair<CSphString, BinlogStream_c *>> dIndexStreams;
+	for ( const auto & tIndex : hIndexes )
 	{
-		ScopedMutex_t tLock ( m_tWriteLock );
-		++(*pTID);
+		CSphScopedPtr<BinlogStream_c> pStream { new BinlogStream_c ( m_tConfig, GetStreamPath ( tIndex.first.cstr() ) ) };
+		if ( pStream->LoadMeta() )
+			dIndexStreams.Add ( { tIndex.first, pStream.LeakPtr() } );
 	}
-	return false;
+
+	// streams left from the other binlog mode hold older transactions, so they go first
+	// and then stay retired until their indexes are flushed
+	if ( m_bCommon )
+	{
+		for ( auto & tStream : dIndexStreams )
+			tStream.second->Replay ( hIndexes, pfnProgressCallback, true );
+		m_pCommon->Replay ( hIndexes, pfnProgressCallback, false );
+	} else
+	{
+		if ( bHaveCommon )
+			m_pCommon->Replay ( hIndexes, pfnProgressCallback, true );
+		else
+			m_pCommon = nullptr;
+
+		for ( auto & tStream : dIndexStreams )
+			tStream.second->Replay ( hIndexes, pfnProgressCallback, false );
+	}
+
+	ScWL_t tLock ( m_tStreamsLock );
+	for ( auto & tStream : dIndexStreams )
+		m_hStreams.Add ( tStream.second, tStream.first );
+
+	// resume normal operation
+	m_tConfig.m_bReplayMode = false;
 }
 
-// commit stuff. Indexes call this function with serialization cb; binlog is agnostic to alien data structures.
-void Binlog_c::BinlogCommit (Blop_e eOp, int64_t * pTID, const char * sIndexName, bool bIncTID, FnWriteCommit&& fnSaver )
+
+bool Binlog_c::IsFlushingEnabled () const
+{
+	return ( !m_bDisabled && m_tConfig.m_eOnCommit!=ACTION_FSYNC );
+}
+
+
+void Binlog_c::DoFlush ()
 {
-	if (!IsBinlogWritable ( bIncTID ? pTID : nullptr )) // m.b. need to advance TID as index flush according to it
+	assert ( !m_bDisabled );
+	if ( m_pCommon )
+		m_pCommon->DoFlush();
+
+	{
+		ScRL_t tLock ( m_tStreamsLock );
+		for ( auto & tStream : m_hStreams )
+			tStream.second->DoFlush();
+	}
+
+	m_iLastFlushed = sphMicroTimer ();
+}
+
+int64_t Binlog_c::NextFlushingTime () const
+{
+	if ( !m_iLastFlushed )
+		return sphMicroTimer () + m_iFlushPeriod;
+	return m_iLastFlushed + m_iFlushPeriod;
+}
+
+CSphString Binlog_c::GetLogPath() const
+{
+	return m_sLogPath;
+}
+
+CSphString Binlog_c::GetStreamPath ( const char * szIndexName ) const
+{
+	CSphString sPath;
+	sPath.SetSprintf ( "%s/%s", m_sLogPath.cstr(), szIndexName );
+	return sPath;
+}
+
+void Binlog_c::AddIndexStream ( const char * szIndexName )
+{
+	ScWL_t tLock ( m_tStreamsLock );
+	if ( m_hStreams.Exists ( szIndexName ) )
 		return;
 
-	MEMORY ( MEM_BINLOG );
-	ScopedMutex_t tWriteLock ( m_tWriteLock );
-	BlopStartEnd_t tStartEnd ( *this, pTID, eOp, sIndexName );
+	// replay has taken the streams of all the served indexes already, so logs left there belong to no index;
+	// loading them would replay them into this one on the next start
+	CSphString sPath = GetStreamPath ( szIndexName );
+	{
+		BinlogStream_c tStale ( m_tConfig, sPath );
+		if ( tStale.LoadMeta() )
+			tStale.Remove();
+	}
 
-	// save txn data
-	fnSaver ( m_tWriter );
+	if ( !MkDir ( sPath.cstr() ) )
+		sphDie ( "binlog: failed to create %s: %s", sPath.cstr(), strerrorm(errno) );
+
+	auto * pStream = new BinlogStream_c ( m_tConfig, sPath );
+	pStream->Start();
+	m_hStreams.Add ( pStream, szIndexName );
+}
+
+// the stream of a dropped index must go together with its files, and its records in the common stream are released;
+// otherwise an index re-created under the same name would get the old logs replayed into it
+void Binlog_c::ForgetIndex ( const char * szIndexName )
+{
+	if ( m_tConfig.m_bReplayMode || m_bDisabled )
+		return;
+
+	if ( m_pCommon )
+		m_pCommon->ForgetIndex ( szIndexName );
+
+	BinlogStream_c * pStream = nullptr;
+	{
+		ScWL_t tLock ( m_tStreamsLock );
+		BinlogStream_c ** ppStream = m_hStreams ( szIndexName );
+		if ( !ppStream )
+			return;
+
+		pStream = *ppStream;
+		m_hStreams.Delete ( szIndexName );
+	}
+
+	// nobody else can reach it now: all the users work under the read lock
+	pStream->Remove();
+	SafeDelete ( pStream );
+}
+
+// here's been going binlogs with ALL closed indices removing
+void Binlog_c::NotifyIndexFlush ( const char * sIndexName, int64_t iTID, bool bShutdown )
+{
+	if ( m_tConfig.m_bReplayMode )
+		sphInfo ( "index '%s': ramchunk saved. TID=" INT64_FMT "", sIndexName, iTID );
+
+	if ( m_tConfig.m_bReplayMode || m_bDisabled )
+		return;
+
+	if ( m_pCommon )
+		m_pCommon->NotifyIndexFlush ( sIndexName, iTID, bShutdown );
+
+	ScRL_t tLock ( m_tStreamsLock );
+	BinlogStream_c ** ppStream = m_hStreams ( sIndexName );
+	if ( ppStream )
+		(*ppStream)->NotifyIndexFlush ( sIndexName, iTID, bShutdown );
+}
+
+void Binlog_c::BinlogCommit ( Blop_e eOp, int64_t * pTID, const char * sIndexName, bool bIncTID, FnWriteCommit && fnSaver )
+{
+	if ( m_tConfig.m_bReplayMode )
+		return;
+
+	if ( m_bDisabled )
+	{
+		// still need to advance TID as index flush according to it
+		if ( bIncTID )
+		{
+			ScopedMutex_t tLock ( m_tTIDLock );
+			++(*pTID);
+		}
+		return;
+	}
+
+	if ( m_bCommon )
+	{
+		m_pCommon->BinlogCommit ( eOp, pTID, sIndexName, std::move ( fnSaver ) );
+		return;
+	}
+
+	// stream is created lazily; it might also be forgotten in between, then just create it again
+	while ( true )
+	{
+		{
+			ScRL_t tLock ( m_tStreamsLock );
+			BinlogStream_c ** ppStream = m_hStreams ( sIndexName );
+			if ( ppStream )
+			{
+				(*ppStream)->BinlogCommit ( eOp, pTID, sIndexName, std::move ( fnSaver ) );
+				return;
+			}
+		}
+
+		AddIndexStream ( sIndexName );
+	}
 }
 
 static auto&	g_bRTChangesAllowed		= RTChangesAllowed ();
@@ -1418,6 +1705,14 @@ void Binlog::NotifyIndexFlush ( const char * sIndexName, int64_t iTID, bool bShu
 	g_pRtBinlog->NotifyIndexFlush ( sIndexName, iTID, bShutdown );
 }
 
+void Binlog::ForgetIndex ( const char * szIndexName )
+{
+	if ( !g_pRtBinlog )
+		return;
+
+	g_pRtBinlog->ForgetIndex ( szIndexName );
+}
+
 CSphString Binlog::GetPath()
 {
 	if ( g_pRtBinlog )
@@ -1450,12 +1745,12 @@ int64_t Binlog::NextFlushTimestamp ()
 	return g_pRtBinlog->NextFlushingTime ();
 }
 
-void Binlog_c::Log ( DWORD uFlag, const char * sTemplate, ... ) const
+void BinlogStream_c::Log ( DWORD uFlag, const char * sTemplate, ... ) const
 {
 	va_list ap;
 
 	va_start ( ap, sTemplate );
-	if ( ( m_uReplayFlags & uFlag )==0 )
+	if ( ( m_tConfig.m_uReplayFlags & uFlag )==0 )
 	{
 		sphDieVa ( sTemplate, ap );
 		exit ( 1 );
@@ -69,5 +69,8 @@ namespace Binlog {
 
 	void NotifyIndexFlush ( const char * sIndexName, int64_t iTID, bool bShutdown );
 
+	// index is dropped or (re)created; its own logs (if any) must not outlive it
+	void ForgetIndex ( const char * szIndexName );
+
 	CSphString GetPath();
 }
@@ -0,0 +1,148 @@
+//
+// Copyright (c) 2022, Manticore Software LTD (https://manticoresearch.com)
+// All rights reserved
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License. You should have
+// received a copy of the GPL license along with this program; if you
+// did not, you can find it at http://www.gnu.org/
+//
+
+#include "civiltime.h"
+#include "sphinxint.h"
+
+#include <time.h>
+
+namespace {
+
+const int64_t SECONDS_PER_DAY = 86400;
+
+// the only place where libc is asked about the zone
+int LibcOffset ( int64_t iTimestamp )
+{
+	auto tStamp = (time_t)iTimestamp;
+	struct tm tSplit;
+	localtime_r ( &tStamp, &tSplit );
+
+	int64_t iLocal = CivilTime::DaysFromCivil ( tSplit.tm_year+1900, tSplit.tm_mon+1, tSplit.tm_mday )*SECONDS_PER_DAY
+		+ tSplit.tm_hour*3600 + tSplit.tm_min*60 + tSplit.tm_sec;
+
+	return int ( iLocal-iTimestamp );
+}
+
+
+/// immutable table of the zone's UTC offset transitions
+class LocalZone_c
+{
+public:
+	LocalZone_c()
+	{
+		Build();
+	}
+
+	void Build()
+	{
+		// timestamp attributes are unsigned 32-bit, so 1970..2106 covers all of them
+		// zones do not change offset more than once a day, so daily probes find every transition
+		m_iMax = int64_t(UINT_MAX)+1;
+		m_dStarts.Reset();
+		m_dOffsets.Reset();
+
+		int iPrev = LibcOffset ( m_iMin );
+		m_dStarts.Add ( m_iMin );
+		m_dOffsets.Add ( iPrev );
+
+		for ( int64_t iStamp = SECONDS_PER_DAY; iStamp<m_iMax; iStamp += SECONDS_PER_DAY )
+		{
+			int iOffset = LibcOffset ( iStamp );
+			if ( iOffset==iPrev )
+				continue;
+
+			// the transition is within (iStamp-day, iStamp]; find the first second with the new offset
+			int64_t iLo = iStamp-SECONDS_PER_DAY;
+			int64_t iHi = iStamp;
+			while ( iHi-iLo>1 )
+			{
+				int64_t iMid = ( iLo+iHi )/2;
+				if ( LibcOffset ( iMid )==iPrev )
+					iLo = iMid;
+				else
+					iHi = iMid;
+			}
+
+			m_dStarts.Add ( iHi );
+			m_dOffsets.Add ( iOffset );
+			iPrev = iOffset;
+		}
+	}
+
+	bool Covers ( int64_t iTimestamp ) const
+	{
+		return iTimestamp>=m_iMin && iTimestamp<m_iMax;
+	}
+
+	int Offset ( int64_t iTimestamp ) const
+	{
+		assert ( Covers ( iTimestamp ) );
+
+		// last transition that is not after the timestamp
+		int iLo = 0;
+		int iHi = m_dStarts.GetLength();
+		while ( iHi-iLo>1 )
+		{
+			int iMid = ( iLo+iHi )/2;
+			if ( m_dStarts[iMid]<=iTimestamp )
+				iLo = iMid;
+			else
+				iHi = iMid;
+		}
+
+		return m_dOffsets[iLo];
+	}
+
+private:
+	CSphVector<int64_t>	m_dStarts;		///< moments when offsets come in effect, sorted
+	CSphVector<int>		m_dOffsets;		///< offset in effect from the matching start up to the next one
+	int64_t				m_iMin = 0;
+	int64_t				m_iMax = 0;
+};
+
+
+LocalZone_c & LocalZone()
+{
+	static LocalZone_c tZone;
+	return tZone;
+}
+
+} // namespace
+
+
+void CivilTime::FromLocal ( int64_t iTimestamp, CivilTime_t & tTime )
+{
+	const LocalZone_c & tZone = LocalZone();
+	if ( tZone.Covers ( iTimestamp ) )
+	{
+		FromUTC ( iTimestamp + tZone.Offset ( iTimestamp ), tTime );
+		return;
+	}
+
+	auto tStamp = (time_t)iTimestamp;
+	struct tm tSplit = {0};
+	localtime_r ( &tStamp, &tSplit );
+
+	tTime.m_iYear = tSplit.tm_year+1900;
+	tTime.m_iMonth = tSplit.tm_mon+1;
+	tTime.m_iDay = tSplit.tm_mday;
+	tTime.m_iHour = tSplit.tm_hour;
+	tTime.m_iMinute = tSplit.tm_min;
+	tTime.m_iSecond = tSplit.tm_sec;
+	tTime.m_iWeekDay = tSplit.tm_wday;
+	tTime.m_iYearDay = tSplit.tm_yday;
+}
+
+
+void CivilTime::InitLocalZone()
+{
+	// the table might have been built on the first use, before the zone was changed
+	LocalZone().Build();
+}
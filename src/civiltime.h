@@ -0,0 +1,96 @@
+//
+// Copyright (c) 2022, Manticore Software LTD (https://manticoresearch.com)
+// All rights reserved
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License. You should have
+// received a copy of the GPL license along with this program; if you
+// did not, you can find it at http://www.gnu.org/
+//
+
+/// @file civiltime.h
+/// Arithmetic timestamp to civil date conversion (no libc calls, no locks) for date functions and date groupers
+
+#pragma once
+
+#include "sphinxstd.h"
+
+struct CivilTime_t
+{
+	int m_iYear = 1970;
+	int m_iMonth = 1;		///< 1..12
+	int m_iDay = 1;			///< 1..31
+	int m_iHour = 0;
+	int m_iMinute = 0;
+	int m_iSecond = 0;
+	int m_iWeekDay = 4;		///< 0..6, Sunday is 0 (same as tm_wday)
+	int m_iYearDay = 0;		///< 0..365 (same as tm_yday)
+};
+
+namespace CivilTime
+{
+	inline bool IsLeapYear ( int64_t iYear )
+	{
+		return ( iYear%4==0 && iYear%100!=0 ) || iYear%400==0;
+	}
+
+	/// days since 1970-01-01 for a proleptic gregorian date
+	inline int64_t DaysFromCivil ( int64_t iYear, int iMonth, int iDay )
+	{
+		iYear -= iMonth<=2;
+		int64_t iEra = ( iYear>=0 ? iYear : iYear-399 ) / 400;
+		auto uYearOfEra = (DWORD)( iYear - iEra*400 );
+		DWORD uDayOfYear = ( 153*( iMonth>2 ? iMonth-3 : iMonth+9 ) + 2 )/5 + iDay - 1;
+		DWORD uDayOfEra = uYearOfEra*365 + uYearOfEra/4 - uYearOfEra/100 + uDayOfYear;
+		return iEra*146097 + (int64_t)uDayOfEra - 719468;
+	}
+
+	/// split UTC timestamp into civil date and time
+	inline void FromUTC ( int64_t iTimestamp, CivilTime_t & tTime )
+	{
+		const int64_t SECONDS_PER_DAY = 86400;
+		int64_t iDays = iTimestamp / SECONDS_PER_DAY;
+		int64_t iSecs = iTimestamp % SECONDS_PER_DAY;
+		if ( iSecs<0 )
+		{
+			iSecs += SECONDS_PER_DAY;
+			iDays--;
+		}
+
+		tTime.m_iHour = int ( iSecs/3600 );
+		tTime.m_iMinute = int ( iSecs/60%60 );
+		tTime.m_iSecond = int ( iSecs%60 );
+
+		// 1970-01-01 was Thursday
+		int iWeekDay = int ( ( iDays+4 )%7 );
+		tTime.m_iWeekDay = iWeekDay<0 ? iWeekDay+7 : iWeekDay;
+
+		// eras are 400 years long and start at March 1st, so that the leap day is the last day of a year
+		int64_t iShifted = iDays + 719468;
+		int64_t iEra = ( iShifted>=0 ? iShifted : iShifted-146096 ) / 146097;
+		auto uDayOfEra = DWORD ( iShifted - iEra*146097 );
+		DWORD uYearOfEra = ( uDayOfEra - uDayOfEra/1460 + uDayOfEra/36524 - uDayOfEra/146096 ) / 365;
+		DWORD uDayOfYear = uDayOfEra - ( 365*uYearOfEra + uYearOfEra/4 - uYearOfEra/100 );
+		DWORD uMonthIdx = ( 5*uDayOfYear + 2 )/153;
+		int iMonth = uMonthIdx<10 ? uMonthIdx+3 : uMonthIdx-9;
+		int64_t iYear = (int64_t)uYearOfEra + iEra*400 + ( iMonth<=2 );
+
+		tTime.m_iYear = (int)iYear;
+		tTime.m_iMonth = iMonth;
+		tTime.m_iDay = int ( uDayOfYear - ( 153*uMonthIdx + 2 )/5 + 1 );
+
+		// day of year counted from January; march-based day of year needs just a shift
+		if ( iMonth>2 )
+			tTime.m_iYearDay = int ( uDayOfYear ) + 59 + IsLeapYear(iYear);
+		else
+			tTime.m_iYearDay = int ( uDayOfYear ) - 306;
+	}
+
+	/// split timestamp into civil date and time in the daemon's time zone
+	/// uses the transitions table built once per process, falls back to localtime_r out of the table range
+	void FromLocal ( int64_t iTimestamp, CivilTime_t & tTime );
+
+	/// (re)build the local time zone transitions table now rather than on the first query; call after tzset()
+	/// not safe against concurrent FromLocal(), so only at startup (or in tests)
+	void InitLocalZone();
+}
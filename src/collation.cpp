@@ -33,6 +33,67 @@ inline static void UnpackStrings ( ByteBlob_t& dStr1, ByteBlob_t& dStr2, bool bD
 }
 
 
+/////////////////////////////
+// ASCII FAST PATH
+/////////////////////////////
+
+static const uint64_t ASCII_ONES = 0x0101010101010101ULL;
+static const uint64_t ASCII_HIGH = 0x8080808080808080ULL;
+
+/// true if all 8 bytes are 7-bit and none of them is zero
+static inline bool IsAsciiWord ( uint64_t uWord )
+{
+	return !( ( uWord | ( ( uWord-ASCII_ONES ) & ~uWord ) ) & ASCII_HIGH );
+}
+
+/// fold a-z to A-Z (or A-Z to a-z) in all 8 bytes at once; only valid for ascii words
+template<bool UPPER>
+static inline uint64_t FoldAsciiWord ( uint64_t uWord )
+{
+	const uint64_t uFrom = UPPER ? 'a' : 'A';
+	const uint64_t uTo = UPPER ? 'z' : 'Z';
+	uint64_t uMask = ( uWord + ( 0x80-uFrom )*ASCII_ONES ) & ~( uWord + ( 0x80-uTo-1 )*ASCII_ONES ) & ASCII_HIGH;
+	return UPPER ? uWord - ( uMask>>2 ) : uWord + ( uMask>>2 );
+}
+
+/// compare ascii prefix of both strings word by word, case folded
+/// returns non-zero result of the first differing byte, or 0 and advances both strings past the equal ascii prefix
+template<bool UPPER>
+static inline int CmpAsciiPrefix ( const BYTE * & pStr1, const BYTE * & pStr2, int iLen )
+{
+	const BYTE * pMax = pStr1 + iLen - sizeof(uint64_t);
+	while ( pStr1<=pMax )
+	{
+		uint64_t uWord1, uWord2;
+		memcpy ( &uWord1, pStr1, sizeof(uWord1) );
+		memcpy ( &uWord2, pStr2, sizeof(uWord2) );
+		if ( !IsAsciiWord ( uWord1 ) || !IsAsciiWord ( uWord2 ) )
+			break;
+
+		if ( uWord1!=uWord2 )
+		{
+			uWord1 = FoldAsciiWord<UPPER> ( uWord1 );
+			uWord2 = FoldAsciiWord<UPPER> ( uWord2 );
+			if ( uWord1!=uWord2 )
+			{
+				BYTE dFolded1[sizeof(uWord1)], dFolded2[sizeof(uWord2)];
+				memcpy ( dFolded1, &uWord1, sizeof(uWord1) );
+				memcpy ( dFolded2, &uWord2, sizeof(uWord2) );
+				int i = 0;
+				while ( dFolded1[i]==dFolded2[i] )
+					++i;
+				return (int)dFolded1[i] - (int)dFolded2[i];
+			}
+		}
+
+		pStr1 += sizeof(uint64_t);
+		pStr2 += sizeof(uint64_t);
+	}
+
+	return 0;
+}
+
+
 static int CollateBinary ( ByteBlob_t dStr1, ByteBlob_t dStr2, bool bDataPtr )
 {
 	UnpackStrings ( dStr1, dStr2, bDataPtr );
@@ -46,7 +107,14 @@ static int CollateLibcCI ( ByteBlob_t dStr1, ByteBlob_t dStr2, bool bDataPtr )
 {
 	UnpackStrings ( dStr1, dStr2, bDataPtr );
 
-	int iRes = strncasecmp ( (const char *) dStr1.first, (const char *) dStr2.first, Min ( dStr1.second, dStr2.second ) );
+	// ascii words are folded in registers; strncasecmp only gets the tail
+	const BYTE * pStr1 = dStr1.first;
+	const BYTE * pStr2 = dStr2.first;
+	int iLen = Min ( dStr1.second, dStr2.second );
+	int iRes = CmpAsciiPrefix<false> ( pStr1, pStr2, iLen );
+	if ( !iRes )
+		iRes = strncasecmp ( (const char *) pStr1, (const char *) pStr2, iLen - ( pStr1-dStr1.first ) );
+
 	return iRes ? iRes : ( dStr1.second-dStr2.second );
 }
 
@@ -274,8 +342,27 @@ static int CollateUtf8GeneralCI ( ByteBlob_t dStr1, ByteBlob_t dStr2, bool bData
 	const BYTE * pMax1 = dStr1.first + dStr1.second;
 	const BYTE * pMax2 = dStr2.first + dStr2.second;
 
+	// ascii weights are just a-z folded to A-Z, so compare 8 ascii chars at a time
+	int iRes = CmpAsciiPrefix<true> ( dStr1.first, dStr2.first, Min ( dStr1.second, dStr2.second ) );
+	if ( iRes )
+		return iRes;
+
 	while (dStr1.first<pMax1 && dStr2.first<pMax2 )
 	{
+		// single ascii chars do not need a decoder or a lookup
+		if ( ( *dStr1.first | *dStr2.first )<0x80 && *dStr1.first && *dStr2.first )
+		{
+			int iCode1 = *dStr1.first++;
+			int iCode2 = *dStr2.first++;
+			if ( iCode1==iCode2 )
+				continue;
+			iCode1 -= ( iCode1>='a' && iCode1<='z' ) ? 32 : 0;
+			iCode2 -= ( iCode2>='a' && iCode2<='z' ) ? 32 : 0;
+			if ( iCode1!=iCode2 )
+				return iCode1-iCode2;
+			continue;
+		}
+
 		// FIXME! on broken data, decode might go beyond buffer bounds
 		int iCode1 = sphUTF8Decode ( dStr1.first );
 		int iCode2 = sphUTF8Decode ( dStr2.first );
@@ -311,6 +398,75 @@ SphStringCmp_fn GetStringCmpFunc ( ESphCollation eCollation )
 }
 
 
+/////////////////////////////
+// sort keys
+/////////////////////////////
+
+// big-endian pack, so that unsigned key order matches memcmp order of the bytes
+static inline uint64_t PackSortKey ( const BYTE * pKey )
+{
+	uint64_t uKey = 0;
+	for ( int i = 0; i<SORT_KEY_LEN; ++i )
+		uKey = ( uKey<<8 ) | pKey[i];
+	return uKey;
+}
+
+
+static uint64_t BinarySortKey ( ByteBlob_t dStr )
+{
+	BYTE dKey[SORT_KEY_LEN] = {0};
+	if ( dStr.first )
+		memcpy ( dKey, dStr.first, Min ( dStr.second, SORT_KEY_LEN ) );
+
+	return PackSortKey ( dKey );
+}
+
+
+static uint64_t LibcCISortKey ( ByteBlob_t dStr )
+{
+	// strncasecmp stops at the first zero, and so must we
+	BYTE dKey[SORT_KEY_LEN] = {0};
+	int iLen = dStr.first ? Min ( dStr.second, SORT_KEY_LEN ) : 0;
+	for ( int i = 0; i<iLen && dStr.first[i]; ++i )
+		dKey[i] = (BYTE) tolower ( dStr.first[i] );
+
+	return PackSortKey ( dKey );
+}
+
+
+static uint64_t Utf8GeneralCISortKey ( ByteBlob_t dStr )
+{
+	// utf8 encoding keeps codepoint order, so encoded weights compare the same way as the weights themselves
+	BYTE dKey[SORT_KEY_LEN+SPH_MAX_UTF8_BYTES] = {0};
+	BYTE * pKey = dKey;
+	const BYTE * pStr = dStr.first;
+	const BYTE * pMax = pStr + ( pStr ? dStr.second : 0 );
+	while ( pStr<pMax && pKey<dKey+SORT_KEY_LEN )
+	{
+		int iCode = sphUTF8Decode ( pStr );
+		if ( iCode<=0 )
+			break;
+
+		pKey += sphUTF8Encode ( pKey, CollateUTF8CI ( iCode ) );
+	}
+
+	// encoded chars that did not fit get cut off
+	memset ( dKey+SORT_KEY_LEN, 0, SPH_MAX_UTF8_BYTES );
+	return PackSortKey ( dKey );
+}
+
+
+StrSortKey_fn GetStringSortKeyFunc ( ESphCollation eCollation )
+{
+	switch ( eCollation )
+	{
+	case SPH_COLLATION_LIBC_CS:			return nullptr; // strcoll order can not be derived from a prefix
+	case SPH_COLLATION_UTF8_GENERAL_CI:	return Utf8GeneralCISortKey;
+	case SPH_COLLATION_BINARY:			return BinarySortKey;
+	default:							return LibcCISortKey;
+	}
+}
+
 /////////////////////////////
 // hashing functions
 /////////////////////////////
@@ -343,8 +499,9 @@ uint64_t LibcCIHash_fn::Hash ( const BYTE * pStr, int iLen, uint64_t uPrev )
 {
 	assert ( pStr && iLen );
 
+	// strncasecmp stops at the first zero, and so must we; strings that compare equal must hash equal
 	uint64_t uAcc = uPrev;
-	while ( iLen-- )
+	while ( iLen-- && *pStr )
 	{
 		int iChar = tolower ( *pStr++ );
 		uAcc = sphFNV64 ( &iChar, 4, uAcc );
@@ -358,12 +515,26 @@ uint64_t Utf8CIHash_fn::Hash ( const BYTE * pStr, int iLen, uint64_t uPrev )
 {
 	assert ( pStr && iLen );
 
+	// must stay consistent with CollateUtf8GeneralCI, ie. strings that compare equal must hash equal
 	uint64_t uAcc = uPrev;
-	while ( iLen-- )
+	const BYTE * pMax = pStr + iLen;
+	while ( pStr<pMax )
 	{
-		const BYTE * pCur = pStr++;
-		int iCode = sphUTF8Decode ( pCur );
-		iCode = CollateUTF8CI ( iCode );
+		int iCode;
+		if ( *pStr<0x80 )
+		{
+			iCode = *pStr++;
+			if ( !iCode )
+				break;
+			iCode -= ( iCode>='a' && iCode<='z' ) ? 32 : 0;
+		} else
+		{
+			iCode = sphUTF8Decode ( pStr );
+			if ( !iCode )
+				break;
+
+			iCode = CollateUTF8CI ( iCode );
+		}
 		uAcc = sphFNV64 ( &iCode, 4, uAcc );
 	}
 
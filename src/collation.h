@@ -61,6 +61,13 @@ using StrHashCalc_fn = uint64_t (*) ( const BYTE * pStr, int iLen, uint64_t uPre
 SphStringCmp_fn GetStringCmpFunc ( ESphCollation eCollation );
 StrHashCalc_fn	GetStringHashCalcFunc ( ESphCollation eCollation );
 
+/// 8-byte prefix sort key; keys are compared as unsigned ints
+/// if key(a)<key(b) then a<b under the collation; equal keys mean that the full strings must be compared
+/// returns nullptr for collations that can't produce such keys (libc_cs)
+static const int SORT_KEY_LEN = 8;
+using StrSortKey_fn = uint64_t (*) ( ByteBlob_t dStr );
+StrSortKey_fn	GetStringSortKeyFunc ( ESphCollation eCollation );
+
 void sphCollationInit();
 volatile ESphCollation& GlobalCollation();
 
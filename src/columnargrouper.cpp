@@ -24,11 +24,14 @@ public:
 	void			MultipleKeysFromMatch ( const CSphMatch & tMatch, CSphVector<SphGroupKey_t> & dKeys ) const override { assert(0); }
 	void			SetColumnar ( const columnar::Columnar_i * pColumnar ) final;
 	CSphGrouper *	Clone() const final;
+	bool			CanFetchKeys() const final { return true; }
+	void			KeysFromMatches ( const VecTraits_T<const CSphMatch> & dMatches, SphGroupKey_t * pKeys ) const final;
 
 private:
 	ESphAttr							m_eAttrType = SPH_ATTR_INTEGER;
 	CSphString							m_sAttrName;
 	CSphScopedPtr<columnar::Iterator_i>	m_pIterator {nullptr};
+	mutable CSphVector<uint32_t>		m_dRowIDs;
 };
 
 
@@ -53,6 +56,25 @@ SphGroupKey_t GrouperColumnarInt_c::KeyFromMatch ( const CSphMatch & tMatch ) co
 }
 
 
+void GrouperColumnarInt_c::KeysFromMatches ( const VecTraits_T<const CSphMatch> & dMatches, SphGroupKey_t * pKeys ) const
+{
+	if ( !m_pIterator.Ptr() )
+	{
+		memset ( pKeys, 0, dMatches.GetLength()*sizeof(pKeys[0]) );
+		return;
+	}
+
+	// decode the whole block at once instead of seeking the iterator match by match
+	m_dRowIDs.Resize ( dMatches.GetLength() );
+	ARRAY_FOREACH ( i, dMatches )
+		m_dRowIDs[i] = dMatches[i].m_tRowID;
+
+	columnar::Span_T<uint32_t> dRowIDs ( m_dRowIDs.Begin(), m_dRowIDs.GetLength() );
+	columnar::Span_T<int64_t> dKeys ( pKeys, dMatches.GetLength() );
+	m_pIterator->Fetch ( dRowIDs, dKeys );
+}
+
+
 void GrouperColumnarInt_c::SetColumnar ( const columnar::Columnar_i * pColumnar )
 {
 	assert(pColumnar);
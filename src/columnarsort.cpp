@@ -1071,6 +1071,237 @@ void ColumnarProxySorter_T<GENERIC,COMP,SINGLE>::FetchColumnarValues ( VecTraits
 }
 
 
+/////////////////////////////////////////////////////////////////////
+
+/// collects matches and passes them to a group sorter in blocks
+/// the group sorter decodes all group keys of a block at once and prefetches its hash slots
+class ColumnarProxyGroupSorter_c : public ISphMatchSorter
+{
+public:
+			ColumnarProxyGroupSorter_c ( ISphMatchSorter * pSorter );
+			~ColumnarProxyGroupSorter_c() override;
+
+	bool	Push ( const CSphMatch & tEntry ) final							{ return PushMatch(tEntry); }
+	void	Push ( const VecTraits_T<const CSphMatch> & dMatches ) override	{ assert ( 0 && "No batch push to proxy sorter" ); }
+
+	bool	IsGroupby() const override										{ return m_pSorter->IsGroupby(); }
+	bool	PushGrouped ( const CSphMatch & tEntry, bool bNewSet, bool bUpdateDistinct ) override;
+	int		GetLength () override;
+	void	Finalize ( MatchProcessor_i & tProcessor, bool bCallProcessInResultSetOrder, bool bFinalizeMatches ) override;
+	int		Flatten ( CSphMatch * pTo ) override;
+	void	MoveTo ( ISphMatchSorter * pRhs, bool bCopyMeta ) override;
+
+	ISphMatchSorter * Clone() const override								{ return new ColumnarProxyGroupSorter_c ( m_pSorter->Clone() ); }
+	void	CloneTo ( ISphMatchSorter * pTrg ) const override;
+	bool	CanBeCloned() const override									{ return m_pSorter->CanBeCloned(); }
+
+	void	SetState ( const CSphMatchComparatorState & tState ) override	{ m_pSorter->SetState(tState); }
+	const CSphMatchComparatorState & GetState() const override				{ return m_pSorter->GetState(); }
+	void	SetGroupState ( const CSphMatchComparatorState & tState ) override { m_pSorter->SetGroupState(tState); }
+	void	SetBlobPool ( const BYTE * pBlobPool ) override;
+
+	void	SetSchema ( ISphSchema * pSchema, bool bRemapCmp ) override;
+	const ISphSchema * GetSchema() const override							{ return m_pSchema; }
+
+	void	SetColumnar ( columnar::Columnar_i * pColumnar ) override;
+	int64_t	GetTotalCount() const override									{ return m_pSorter->GetTotalCount(); }
+
+	void	SetFilteredAttrs ( const sph::StringSet & hAttrs, bool bAddDocid ) override { m_pSorter->SetFilteredAttrs ( hAttrs, bAddDocid ); }
+	void	TransformPooled2StandalonePtrs ( GetBlobPoolFromMatch_fn fnBlobPoolFromMatch, GetColumnarFromMatch_fn fnGetColumnarFromMatch, bool bFinalizeSorters ) override;
+
+	bool	IsRandom() const override 										{ return m_pSorter->IsRandom(); }
+	void	SetRandom ( bool bRandom ) override								{ m_pSorter->SetRandom(bRandom); }
+
+	int		GetMatchCapacity() const override								{ return m_pSorter->GetMatchCapacity(); }
+
+	RowTagged_t					GetJustPushed() const override				{ assert (0 && "Not supported" ); return RowTagged_t(); }
+	VecTraits_T<RowTagged_t>	GetJustPopped() const override				{ assert (0 && "Not supported" ); return {}; }
+
+private:
+	static const int MATCH_BUFFER_SIZE = 1024;
+
+	CSphFixedVector<CSphMatch>	m_dData{MATCH_BUFFER_SIZE};
+	CSphVector<CSphRowitem>		m_dDynamic;
+	CSphScopedPtr<ISphMatchSorter> m_pSorter;
+	const ISphSchema *			m_pSchema = nullptr;
+	CSphMatch *					m_pCurMatch = nullptr;
+	CSphMatch *					m_pEndMatch = nullptr;
+	int							m_iDynamicSize = 0;
+
+	FORCE_INLINE bool PushMatch ( const CSphMatch & tEntry );
+	void	PushCollectedToSorter();
+	void	DoSetSchema ( const ISphSchema * pSchema );
+};
+
+
+ColumnarProxyGroupSorter_c::ColumnarProxyGroupSorter_c ( ISphMatchSorter * pSorter )
+	: m_pSorter ( pSorter )
+{
+	assert(pSorter);
+	m_pCurMatch = m_dData.Begin();
+	m_pEndMatch = m_pCurMatch + m_dData.GetLength();
+	DoSetSchema ( pSorter->GetSchema() );
+}
+
+
+ColumnarProxyGroupSorter_c::~ColumnarProxyGroupSorter_c()
+{
+	for ( auto & i : m_dData )
+		i.m_pDynamic = nullptr;
+}
+
+
+void ColumnarProxyGroupSorter_c::SetSchema ( ISphSchema * pSchema, bool bRemapCmp )
+{
+	PushCollectedToSorter();
+	m_pSorter->SetSchema ( pSchema, bRemapCmp );
+	DoSetSchema(pSchema);
+}
+
+
+void ColumnarProxyGroupSorter_c::DoSetSchema ( const ISphSchema * pSchema )
+{
+	m_pSchema = pSchema;
+	if ( !m_pSchema )
+		return;
+
+	m_iDynamicSize = m_pSchema->GetDynamicSize();
+#if NDEBUG
+	int iStride = m_iDynamicSize;
+#else
+	int iStride = m_iDynamicSize+1;
+#endif
+	m_dDynamic.Resize ( iStride*m_dData.GetLength() );
+	CSphRowitem * pDynamic = m_dDynamic.Begin();
+
+	for ( auto & i : m_dData )
+	{
+#if NDEBUG
+		i.m_pDynamic = pDynamic;
+#else
+		*pDynamic = m_iDynamicSize;
+		i.m_pDynamic = pDynamic+1;
+#endif
+
+		pDynamic += iStride;
+	}
+}
+
+
+void ColumnarProxyGroupSorter_c::CloneTo ( ISphMatchSorter * pTrg ) const
+{
+	pTrg->SetRandom ( IsRandom() );
+	pTrg->SetState  ( GetState() );
+	pTrg->SetSchema ( m_pSchema->CloneMe(), false );
+}
+
+
+bool ColumnarProxyGroupSorter_c::PushGrouped ( const CSphMatch & tEntry, bool bNewSet, bool bUpdateDistinct )
+{
+	PushCollectedToSorter();
+	return m_pSorter->PushGrouped ( tEntry, bNewSet, bUpdateDistinct );
+}
+
+
+int ColumnarProxyGroupSorter_c::GetLength()
+{
+	PushCollectedToSorter();
+	return m_pSorter->GetLength();
+}
+
+
+void ColumnarProxyGroupSorter_c::SetBlobPool ( const BYTE * pBlobPool )
+{
+	// collected matches belong to the previous pool
+	PushCollectedToSorter();
+	m_pSorter->SetBlobPool(pBlobPool);
+}
+
+
+void ColumnarProxyGroupSorter_c::SetColumnar ( columnar::Columnar_i * pColumnar )
+{
+	// grouper keys of collected matches must be fetched from the previous chunk
+	PushCollectedToSorter();
+	m_pSorter->SetColumnar(pColumnar);
+}
+
+
+void ColumnarProxyGroupSorter_c::TransformPooled2StandalonePtrs ( GetBlobPoolFromMatch_fn fnBlobPoolFromMatch, GetColumnarFromMatch_fn fnGetColumnarFromMatch, bool bFinalizeSorters )
+{
+	PushCollectedToSorter();
+	m_pSorter->TransformPooled2StandalonePtrs ( fnBlobPoolFromMatch, fnGetColumnarFromMatch, bFinalizeSorters );
+	DoSetSchema ( m_pSorter->GetSchema() );
+}
+
+
+bool ColumnarProxyGroupSorter_c::PushMatch ( const CSphMatch & tEntry )
+{
+	CSphMatch & tMatch = *m_pCurMatch++;
+	tMatch.m_tRowID		= tEntry.m_tRowID;
+	tMatch.m_iWeight	= tEntry.m_iWeight;
+	tMatch.m_pStatic	= tEntry.m_pStatic;
+	tMatch.m_iTag		= tEntry.m_iTag;
+	memcpy ( tMatch.m_pDynamic, tEntry.m_pDynamic, m_iDynamicSize*sizeof(CSphRowitem) );
+
+	if ( m_pCurMatch==m_pEndMatch )
+		PushCollectedToSorter();
+
+	return true;
+}
+
+
+void ColumnarProxyGroupSorter_c::Finalize ( MatchProcessor_i & tProcessor, bool bCallProcessInResultSetOrder, bool bFinalizeMatches )
+{
+	PushCollectedToSorter();
+	m_pSorter->Finalize ( tProcessor, bCallProcessInResultSetOrder, bFinalizeMatches );
+}
+
+
+int ColumnarProxyGroupSorter_c::Flatten ( CSphMatch * pTo )
+{
+	PushCollectedToSorter();
+	return m_pSorter->Flatten(pTo);
+}
+
+
+void ColumnarProxyGroupSorter_c::MoveTo ( ISphMatchSorter * pRhs, bool bCopyMeta )
+{
+	// we assume that the rhs sorter is of the same type, i.e. proxy
+	auto pRhsProxy = (ColumnarProxyGroupSorter_c*)pRhs;
+
+	PushCollectedToSorter();
+	pRhsProxy->PushCollectedToSorter();
+
+	m_pSorter->MoveTo ( pRhsProxy->m_pSorter.Ptr(), bCopyMeta );
+}
+
+
+void ColumnarProxyGroupSorter_c::PushCollectedToSorter()
+{
+	CSphMatch * pData = m_dData.Begin();
+	int iNumMatches = m_pCurMatch-pData;
+	if ( !iNumMatches )
+		return;
+
+	m_pSorter->Push ( VecTraits_T<CSphMatch> ( pData, iNumMatches ) );
+	m_pCurMatch = m_dData.Begin();
+}
+
+/////////////////////////////////////////////////////////////////////
+
+static bool HavePresortDataPtrExprs ( const ISphSchema & tSchema )
+{
+	for ( int i = 0; i < tSchema.GetAttrsCount(); i++ )
+	{
+		const CSphColumnInfo & tAttr = tSchema.GetAttr(i);
+		if ( tAttr.m_eStage<=SPH_EVAL_PRESORT && tAttr.m_pExpr && sphIsDataPtrAttr ( tAttr.m_eAttrType ) )
+			return true;
+	}
+
+	return false;
+}
+
+
 static bool CanCreateColumnarSorter ( const ISphSchema & tSchema, const CSphMatchComparatorState & tState, bool bNeedFactors, bool bComputeItems, bool bMulti )
 {
 	// everything precomputed? no need for batched sorter
@@ -1088,12 +1319,8 @@ static bool CanCreateColumnarSorter ( const ISphSchema & tSchema, const CSphMatc
 
 	// check that we don't have strings/mvas in presort/prefilter
 	// in this case match cloning is slow, so there's no point in spawning proxy sorter
-	for ( int i = 0; i < tSchema.GetAttrsCount(); i++ )
-	{
-		const CSphColumnInfo & tAttr = tSchema.GetAttr(i);
-		if ( tAttr.m_eStage<=SPH_EVAL_PRESORT && tAttr.m_pExpr && sphIsDataPtrAttr ( tAttr.m_eAttrType ) )
-			return false;
-	}
+	if ( HavePresortDataPtrExprs(tSchema) )
+		return false;
 
 	bool bHaveColumnar = false;
 	bool bAllColumnar = true;
@@ -1242,3 +1469,16 @@ ISphMatchSorter * CreateColumnarProxySorter ( ISphMatchSorter * pSorter, int iMa
 
 	return pSorter;
 }
+
+
+ISphMatchSorter * CreateColumnarProxyGroupSorter ( ISphMatchSorter * pSorter, const ISphSchema & tSchema, const CSphGrouper * pGrouper, bool bNeedFactors, bool bComputeItems, bool bMulti )
+{
+	// same restrictions as for the plain proxy sorter, plus we need a grouper that fetches keys in blocks
+	if ( !bComputeItems || bMulti || bNeedFactors || !pGrouper || !pGrouper->CanFetchKeys() )
+		return pSorter;
+
+	if ( HavePresortDataPtrExprs(tSchema) )
+		return pSorter;
+
+	return new ColumnarProxyGroupSorter_c(pSorter);
+}
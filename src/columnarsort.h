@@ -15,4 +15,8 @@
 
 ISphMatchSorter * CreateColumnarProxySorter ( ISphMatchSorter * pSorter, int iMaxMatches, const ISphSchema & tSchema, const CSphMatchComparatorState & tState, ESphSortFunc eSortFunc, bool bNeedFactors, bool bComputeItems, bool bMulti );
 
+/// wraps a group sorter that supports batch pushes; matches are collected and pushed in blocks
+/// so that group keys are decoded block-wise from columnar storage
+ISphMatchSorter * CreateColumnarProxyGroupSorter ( ISphMatchSorter * pSorter, const ISphSchema & tSchema, const CSphGrouper * pGrouper, bool bNeedFactors, bool bComputeItems, bool bMulti );
+
 #endif // _columnarsort_
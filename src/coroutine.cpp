@@ -230,6 +230,7 @@ class Worker_c
 	int64_t m_tmCpuTimeBase = 0; // add sphCpuTime() to this value to get truly cpu time ticks
 	uint64_t m_uId { InitWorkerID() };
 	std::atomic<size_t> m_iWakerEpoch { 0 };
+	Priority_e m_ePriority { InheritPriority() };
 
 	static uint64_t InitWorkerID()
 	{
@@ -237,6 +238,12 @@ class Worker_c
 		return uWorker.fetch_add ( 1, std::memory_order_relaxed );
 	}
 
+	// subtasks belong to the same class as the task which spawned them
+	static Priority_e InheritPriority()
+	{
+		return m_pTlsThis ? m_pTlsThis->m_ePriority : Priority_e::NORMAL;
+	}
+
 	// RAII worker's keeper
 	struct CoroGuard_t
 	{
@@ -295,7 +302,7 @@ private:
 			if ( uPrevState & CoroState_t::Paused_e )
 			{
 				LOG ( DIAG, COROW ) << "ResetRunningAndReschedule schedule because done";
-				Schedule();
+				Schedule ( m_ePriority!=Priority_e::LOW ); // voluntary yield of low class goes behind queued work
 				return;
 			}
 		while ( !m_tState.m_uState.compare_exchange_weak ( uPrevState, uPrevState & ~CoroState_t::Running_e, std::memory_order_relaxed ) );
@@ -321,7 +328,10 @@ private:
 	{
 		LOG ( DEBUGV, COROW ) << "Coro::Worker_c::Schedule (" << bVip << ", " << m_pScheduler << ")";
 		assert ( m_pScheduler );
-		m_pScheduler->Schedule ( [this] { Run (); }, bVip ); // true means 'vip', false - 'secondary'
+		if ( bVip )
+			m_pScheduler->Schedule ( [this] { Run (); }, true );
+		else
+			m_pScheduler->SchedulePrio ( [this] { Run (); }, m_ePriority ); // 'secondary' queue of my class
 	}
 
 	// continuation means, task is already started, and, if possible, should not be scheduled/paused.
@@ -487,6 +497,16 @@ public:
 		return m_uId;
 	}
 
+	inline void SetPriority ( Priority_e ePrio ) noexcept
+	{
+		m_ePriority = ePrio;
+	}
+
+	inline Priority_e GetPriority() const noexcept
+	{
+		return m_ePriority;
+	}
+
 	inline int ID() const noexcept
 	{
 		return (int)m_uId;
@@ -589,6 +609,19 @@ void Reschedule() noexcept
 	Worker()->Reschedule();
 }
 
+void SetPriority ( Priority_e ePrio ) noexcept
+{
+	auto pWorker = CurrentWorker();
+	if ( pWorker )
+		pWorker->SetPriority ( ePrio );
+}
+
+Priority_e GetPriority() noexcept
+{
+	auto pWorker = CurrentWorker();
+	return pWorker ? pWorker->GetPriority() : Priority_e::NORMAL;
+}
+
 int ID() noexcept
 {
 	return Worker()->ID();
@@ -294,6 +294,10 @@ void Yield_ () noexcept;
 
 void Reschedule() noexcept;
 
+// priority class of current task; inherited by subtasks started from it
+void SetPriority ( Priority_e ePrio ) noexcept;
+Priority_e GetPriority() noexcept;
+
 int ID() noexcept;
 
 static const int tmDefaultThrotleTimeQuantumMs = 100; // default value, if nothing specified
@@ -46,7 +46,7 @@ enum FieldFlags_e : BYTE
 	FIELD_FLAG_EMPTY		= 1 << 1
 };
 
-static const int STORAGE_VERSION = 1;
+static const int STORAGE_VERSION = 2;
 
 //////////////////////////////////////////////////////////////////////////
 
@@ -510,6 +510,22 @@ static void CreateFieldRemap ( VecTraits_T<int> & dFieldInRset, const VecTraits_
 			dFieldInRset[i] = i;
 }
 
+// same as above, but for the subset of fields that are stored in one block stream
+static void CreateFieldRemap ( VecTraits_T<int> & dFieldInRset, const VecTraits_T<int> & dStreamFields, const VecTraits_T<int> * pFieldIds )
+{
+	ARRAY_CONSTFOREACH ( i, dFieldInRset )
+	{
+		int iField = dStreamFields[i];
+		if ( pFieldIds )
+		{
+			int * pFound = pFieldIds->BinarySearch(iField);
+			dFieldInRset[i] = pFound ? pFieldIds->Idx ( pFound ) : -1;
+		}
+		else
+			dFieldInRset[i] = iField;
+	}
+}
+
 
 //////////////////////////////////////////////////////////////////////////
 
@@ -545,23 +561,32 @@ private:
 		DWORD	m_uUncompressedLen = 0;
 	};
 
+	// a sequence of blocks that holds a subset of fields
+	struct Stream_t
+	{
+		CSphVector<int>				m_dFields;
+		CSphFixedVector<Block_t>	m_dBlocks{0};
+	};
+
 
 	int64_t						m_iIndexId = 0;
 	CSphString					m_sFilename;
 	CSphAutofile				m_tFile;
-	CSphFixedVector<Block_t>	m_dBlocks{0};
+	CSphFixedVector<Stream_t>	m_dStreams{0};
 	CSphScopedPtr<Compressor_i> m_pCompressor{nullptr};
 	DocstoreFields_c			m_tFields;
 
-	const Block_t *				FindBlock ( RowID_t tRowID ) const;
+	static const Block_t *		FindBlock ( const Stream_t & tStream, RowID_t tRowID );
 	void						ReadFromFile ( BYTE * pData, int iLength, SphOffset_t tOffset, int64_t iSessionId ) const;
-	DocstoreDoc_t				ReadDocFromSmallBlock ( const Block_t & tBlock, RowID_t tRowID, const VecTraits_T<int> * pFieldIds, int64_t iSessionId, bool bPack ) const;
-	DocstoreDoc_t				ReadDocFromBigBlock ( const Block_t & tBlock, const VecTraits_T<int> * pFieldIds, int64_t iSessionId, bool bPack ) const;
+	void						ReadDocFromSmallBlock ( const Block_t & tBlock, RowID_t tRowID, const Stream_t & tStream, const CSphFixedVector<int> & dFieldInRset, int64_t iSessionId, bool bPack, DocstoreDoc_t & tResult ) const;
+	void						ReadDocFromBigBlock ( const Block_t & tBlock, const Stream_t & tStream, const CSphFixedVector<int> & dFieldInRset, int64_t iSessionId, bool bPack, DocstoreDoc_t & tResult ) const;
 	BlockData_t					UncompressSmallBlock ( const Block_t & tBlock, int64_t iSessionId ) const;
 	BlockData_t					UncompressBigBlockField ( SphOffset_t tOffset, const FieldInfo_t & tInfo, int64_t iSessionId ) const;
 
-	bool						ProcessSmallBlockDoc ( RowID_t tCurDocRowID, RowID_t tRowID, const VecTraits_T<int> * pFieldIds, const CSphFixedVector<int> & dFieldInRset, bool bPack, MemoryReader2_c & tReader, CSphBitvec & tEmptyFields, DocstoreDoc_t & tResult ) const;
+	bool						ProcessSmallBlockDoc ( RowID_t tCurDocRowID, RowID_t tRowID, const Stream_t & tStream, const CSphFixedVector<int> & dFieldInRset, bool bPack, MemoryReader2_c & tReader, CSphBitvec & tEmptyFields, DocstoreDoc_t & tResult ) const;
 	void						ProcessBigBlockField ( int iField, const FieldInfo_t & tInfo, int iFieldInRset, bool bPack, int64_t iSessionId, SphOffset_t & tOffset, DocstoreDoc_t & tResult ) const;
+
+	bool						ReadStreams ( CSphReader & tReader, DWORD uStorageVersion );
 };
 
 
@@ -605,54 +630,106 @@ bool Docstore_c::Init ( CSphString & sError )
 
 	m_tFields.Load(tReader);
 
-	DWORD uNumBlocks = tReader.GetDword();
-	if ( !uNumBlocks )
-		return true;
+	if ( !ReadStreams ( tReader, uStorageVersion ) )
+		return false;
 
-	SphOffset_t tHeaderOffset = tReader.GetOffset();
+	tReader.Close();
 
-	tReader.SeekTo ( tHeaderOffset, 0 );
+	// keep the field layout when this docstore gets rebuilt by merge/optimize
+	m_dSeparateFields.Reset();
+	for ( int i = 1; i < m_dStreams.GetLength(); i++ )
+		for ( int iField : m_dStreams[i].m_dFields )
+			m_dSeparateFields.Add ( m_tFields.GetField(iField).m_sName );
 
-	m_dBlocks.Reset(uNumBlocks);
-	DWORD tPrevBlockRowID = 0;
-	SphOffset_t tPrevBlockOffset = 0;
-	for ( auto & i : m_dBlocks )
-	{
-		i.m_tRowID = tReader.UnzipRowid() + tPrevBlockRowID;
-		i.m_eType = (BlockType_e)tReader.GetByte();
-		i.m_tOffset = tReader.UnzipOffset() + tPrevBlockOffset;
-		if ( i.m_eType==BLOCK_TYPE_BIG )
-			i.m_uHeaderSize = tReader.UnzipInt();
+	if ( m_tFile.Open ( m_sFilename, SPH_O_READ, sError ) < 0 )
+		return false;
 
-		tPrevBlockRowID = i.m_tRowID;
-		tPrevBlockOffset = i.m_tOffset;
+	return true;
+}
+
+
+bool Docstore_c::ReadStreams ( CSphReader & tReader, DWORD uStorageVersion )
+{
+	// v.1 has all fields in a single stream
+	if ( uStorageVersion<2 )
+	{
+		m_dStreams.Reset(1);
+		m_dStreams[0].m_dFields.Resize ( m_tFields.GetNumFields() );
+		ARRAY_FOREACH ( i, m_dStreams[0].m_dFields )
+			m_dStreams[0].m_dFields[i] = i;
+	}
+	else
+	{
+		m_dStreams.Reset ( tReader.GetDword() );
+		for ( auto & tStream : m_dStreams )
+		{
+			tStream.m_dFields.Resize ( tReader.GetDword() );
+			for ( auto & iField : tStream.m_dFields )
+				iField = tReader.GetDword();
+		}
 	}
 
-	for ( int i = 1; i<m_dBlocks.GetLength(); i++ )
-		m_dBlocks[i-1].m_uSize = m_dBlocks[i].m_tOffset-m_dBlocks[i-1].m_tOffset;
+	CSphFixedVector<DWORD> dNumBlocks ( m_dStreams.GetLength() );
+	CSphFixedVector<SphOffset_t> dHeaderOffsets ( m_dStreams.GetLength() );
+	ARRAY_FOREACH ( i, m_dStreams )
+	{
+		dNumBlocks[i] = tReader.GetDword();
+		if ( uStorageVersion<2 && !dNumBlocks[i] )
+			return !tReader.GetErrorFlag();
 
-	m_dBlocks.Last().m_uSize = tHeaderOffset-m_dBlocks.Last().m_tOffset;
+		dHeaderOffsets[i] = tReader.GetOffset();
+	}
 
-	if ( tReader.GetErrorFlag() )
-		return false;
+	// blocks of all streams are interleaved in the file and followed by stream headers
+	CSphVector<SphOffset_t> dBounds;
+	dBounds.Add ( dHeaderOffsets[0] );
+	ARRAY_FOREACH ( iStream, m_dStreams )
+	{
+		auto & dBlocks = m_dStreams[iStream].m_dBlocks;
+		dBlocks.Reset ( dNumBlocks[iStream] );
+		if ( dBlocks.IsEmpty() )
+			continue;
 
-	tReader.Close();
+		tReader.SeekTo ( dHeaderOffsets[iStream], 0 );
 
-	if ( m_tFile.Open ( m_sFilename, SPH_O_READ, sError ) < 0 )
-		return false;
+		DWORD tPrevBlockRowID = 0;
+		SphOffset_t tPrevBlockOffset = 0;
+		for ( auto & i : dBlocks )
+		{
+			i.m_tRowID = tReader.UnzipRowid() + tPrevBlockRowID;
+			i.m_eType = (BlockType_e)tReader.GetByte();
+			i.m_tOffset = tReader.UnzipOffset() + tPrevBlockOffset;
+			if ( i.m_eType==BLOCK_TYPE_BIG )
+				i.m_uHeaderSize = tReader.UnzipInt();
+
+			tPrevBlockRowID = i.m_tRowID;
+			tPrevBlockOffset = i.m_tOffset;
+			dBounds.Add ( i.m_tOffset );
+		}
+	}
 
-	return true;
+	dBounds.Uniq();
+	for ( auto & tStream : m_dStreams )
+		for ( auto & i : tStream.m_dBlocks )
+		{
+			const SphOffset_t * pFound = dBounds.BinarySearch ( i.m_tOffset );
+			assert ( pFound && pFound+1<dBounds.End() );
+			i.m_uSize = DWORD ( pFound[1]-i.m_tOffset );
+		}
+
+	return !tReader.GetErrorFlag();
 }
 
 
-const Docstore_c::Block_t * Docstore_c::FindBlock ( RowID_t tRowID ) const
+const Docstore_c::Block_t * Docstore_c::FindBlock ( const Stream_t & tStream, RowID_t tRowID )
 {
-	const Block_t * pFound = sphBinarySearchFirst ( m_dBlocks.Begin(), m_dBlocks.End()-1, bind(&Block_t::m_tRowID), tRowID );
+	auto & dBlocks = tStream.m_dBlocks;
+	const Block_t * pFound = sphBinarySearchFirst ( dBlocks.Begin(), dBlocks.End()-1, bind(&Block_t::m_tRowID), tRowID );
 	assert(pFound);
 
 	if ( pFound->m_tRowID>tRowID )
 	{
-		if ( pFound==m_dBlocks.Begin() )
+		if ( pFound==dBlocks.Begin() )
 			return nullptr;
 
 		return pFound-1;
@@ -684,13 +761,28 @@ DocstoreDoc_t Docstore_c::GetDoc ( RowID_t tRowID, const VecTraits_T<int> * pFie
 		assert ( (*pFieldIds)[i-1] < (*pFieldIds)[i] );
 #endif
 
-	const Block_t * pBlock = FindBlock(tRowID);
-	assert ( pBlock );
+	DocstoreDoc_t tResult;
+	tResult.m_dFields.Resize ( pFieldIds ? pFieldIds->GetLength() : m_tFields.GetNumFields() );
 
-	if ( pBlock->m_eType==BLOCK_TYPE_SMALL )
-		return ReadDocFromSmallBlock ( *pBlock, tRowID, pFieldIds, iSessionId, bPack );
-	else
-		return ReadDocFromBigBlock ( *pBlock, pFieldIds, iSessionId, bPack );
+	for ( const auto & tStream : m_dStreams )
+	{
+		// don't touch blocks of streams that have none of the requested fields
+		if ( pFieldIds && !tStream.m_dFields.any_of ( [pFieldIds]( int iField ){ return !!pFieldIds->BinarySearch(iField); } ) )
+			continue;
+
+		const Block_t * pBlock = FindBlock ( tStream, tRowID );
+		assert ( pBlock );
+
+		CSphFixedVector<int> dFieldInRset ( tStream.m_dFields.GetLength() );
+		CreateFieldRemap ( dFieldInRset, tStream.m_dFields, pFieldIds );
+
+		if ( pBlock->m_eType==BLOCK_TYPE_SMALL )
+			ReadDocFromSmallBlock ( *pBlock, tRowID, tStream, dFieldInRset, iSessionId, bPack, tResult );
+		else
+			ReadDocFromBigBlock ( *pBlock, tStream, dFieldInRset, iSessionId, bPack, tResult );
+	}
+
+	return tResult;
 }
 
 
@@ -764,23 +856,17 @@ BlockData_t Docstore_c::UncompressSmallBlock ( const Block_t & tBlock, int64_t i
 }
 
 
-bool Docstore_c::ProcessSmallBlockDoc ( RowID_t tCurDocRowID, RowID_t tRowID, const VecTraits_T<int> * pFieldIds, const CSphFixedVector<int> & dFieldInRset, bool bPack,
+bool Docstore_c::ProcessSmallBlockDoc ( RowID_t tCurDocRowID, RowID_t tRowID, const Stream_t & tStream, const CSphFixedVector<int> & dFieldInRset, bool bPack,
 	MemoryReader2_c & tReader, CSphBitvec & tEmptyFields, DocstoreDoc_t & tResult ) const
 {
 	bool bDocFound = tCurDocRowID==tRowID;
-	if ( bDocFound )
-		tResult.m_dFields.Resize ( pFieldIds ? pFieldIds->GetLength() : m_tFields.GetNumFields() );
 
 	DWORD uBitMaskSize = tEmptyFields.GetSize()*sizeof(DWORD);
 
+	// result fields are already empty
 	BYTE uDocFlags = tReader.GetByte();
 	if ( uDocFlags & DOC_FLAG_ALL_EMPTY )
-	{
-		for ( auto & i : tResult.m_dFields )
-			i.Resize(0);
-
 		return bDocFound;
-	}
 
 	bool bHasBitmask = !!(uDocFlags & DOC_FLAG_EMPTY_BITMASK);
 	if ( bHasBitmask )
@@ -789,13 +875,13 @@ bool Docstore_c::ProcessSmallBlockDoc ( RowID_t tCurDocRowID, RowID_t tRowID, co
 		tReader.SetPos ( tReader.GetPos()+uBitMaskSize );
 	}
 
-	for ( int iField = 0; iField < m_tFields.GetNumFields(); iField++ )
-		if ( !bHasBitmask || !tEmptyFields.BitGet(iField) )
+	ARRAY_FOREACH ( i, tStream.m_dFields )
+		if ( !bHasBitmask || !tEmptyFields.BitGet(i) )
 		{
 			DWORD uFieldLength = tReader.UnzipInt();
-			int iFieldInRset = dFieldInRset[iField];
+			int iFieldInRset = dFieldInRset[i];
 			if ( bDocFound && iFieldInRset!=-1 )
-				PackData ( tResult.m_dFields[iFieldInRset], tReader.Begin()+tReader.GetPos(), uFieldLength, m_tFields.GetField(iField).m_eType==DOCSTORE_TEXT, bPack );
+				PackData ( tResult.m_dFields[iFieldInRset], tReader.Begin()+tReader.GetPos(), uFieldLength, m_tFields.GetField ( tStream.m_dFields[i] ).m_eType==DOCSTORE_TEXT, bPack );
 
 			tReader.SetPos ( tReader.GetPos()+uFieldLength );
 		}
@@ -804,7 +890,7 @@ bool Docstore_c::ProcessSmallBlockDoc ( RowID_t tCurDocRowID, RowID_t tRowID, co
 }
 
 
-DocstoreDoc_t Docstore_c::ReadDocFromSmallBlock ( const Block_t & tBlock, RowID_t tRowID, const VecTraits_T<int> * pFieldIds, int64_t iSessionId, bool bPack ) const
+void Docstore_c::ReadDocFromSmallBlock ( const Block_t & tBlock, RowID_t tRowID, const Stream_t & tStream, const CSphFixedVector<int> & dFieldInRset, int64_t iSessionId, bool bPack, DocstoreDoc_t & tResult ) const
 {
 	BlockCache_c * pBlockCache = BlockCache_c::Get();
 
@@ -826,23 +912,16 @@ DocstoreDoc_t Docstore_c::ReadDocFromSmallBlock ( const Block_t & tBlock, RowID_
 	else
 		tDataPtr.Set ( tBlockData.m_pData, 0 );
 
-	CSphFixedVector<int> dFieldInRset (	m_tFields.GetNumFields() );
-	CreateFieldRemap ( dFieldInRset, pFieldIds );
-
-	DocstoreDoc_t tResult;
-
 	RowID_t tCurDocRowID = tBlock.m_tRowID;
 	MemoryReader2_c tReader ( tBlockData.m_pData, tBlockData.m_uSize );
-	CSphBitvec tEmptyFields ( m_tFields.GetNumFields() );
+	CSphBitvec tEmptyFields ( tStream.m_dFields.GetLength() );
 	for ( int i = 0; i < (int)tBlockData.m_uNumDocs; i++ )
 	{
-		if ( ProcessSmallBlockDoc ( tCurDocRowID, tRowID, pFieldIds, dFieldInRset, bPack, tReader, tEmptyFields, tResult ) )
+		if ( ProcessSmallBlockDoc ( tCurDocRowID, tRowID, tStream, dFieldInRset, bPack, tReader, tEmptyFields, tResult ) )
 			break;
 
 		tCurDocRowID++;
 	}
-
-	return tResult;
 }
 
 
@@ -910,9 +989,10 @@ void Docstore_c::ProcessBigBlockField ( int iField, const FieldInfo_t & tInfo, i
 }
 
 
-DocstoreDoc_t Docstore_c::ReadDocFromBigBlock ( const Block_t & tBlock, const VecTraits_T<int> * pFieldIds, int64_t iSessionId, bool bPack ) const
+void Docstore_c::ReadDocFromBigBlock ( const Block_t & tBlock, const Stream_t & tStream, const CSphFixedVector<int> & dFieldInRset, int64_t iSessionId, bool bPack, DocstoreDoc_t & tResult ) const
 {
-	CSphFixedVector<FieldInfo_t> dFieldInfo ( m_tFields.GetNumFields() );
+	int iNumFields = tStream.m_dFields.GetLength();
+	CSphFixedVector<FieldInfo_t> dFieldInfo ( iNumFields );
 	CSphFixedVector<BYTE> dBlockHeader(tBlock.m_uHeaderSize);
 
 	ReadFromFile ( dBlockHeader.Begin(), dBlockHeader.GetLength(), tBlock.m_tOffset, iSessionId );
@@ -923,12 +1003,12 @@ DocstoreDoc_t Docstore_c::ReadDocFromBigBlock ( const Block_t & tBlock, const Ve
 	bool bNeedReorder = !!( uBlockFlags & BLOCK_FLAG_FIELD_REORDER );
 	if ( bNeedReorder )
 	{
-		dFieldSort.Resize ( m_tFields.GetNumFields() );
+		dFieldSort.Resize ( iNumFields );
 		for ( auto & i : dFieldSort )
 			i = tReader.UnzipInt();
 	}
 
-	for ( int i = 0; i < m_tFields.GetNumFields(); i++ )
+	for ( int i = 0; i < iNumFields; i++ )
 	{
 		int iField = bNeedReorder ? dFieldSort[i] : i;
 		FieldInfo_t & tInfo = dFieldInfo[iField];
@@ -944,24 +1024,16 @@ DocstoreDoc_t Docstore_c::ReadDocFromBigBlock ( const Block_t & tBlock, const Ve
 
 	dBlockHeader.Reset(0);
 
-	CSphFixedVector<int> dFieldInRset ( m_tFields.GetNumFields() );
-	CreateFieldRemap ( dFieldInRset, pFieldIds );
-
-	DocstoreDoc_t tResult;
-	tResult.m_dFields.Resize ( pFieldIds ? pFieldIds->GetLength() : m_tFields.GetNumFields() );
-
 	SphOffset_t tOffset = tBlock.m_tOffset+tBlock.m_uHeaderSize;
 
 	// i == physical field order in file
-	// dFieldSort[i] == field order as in m_dFields
+	// dFieldSort[i] == field order as in stream fields
 	// dFieldInRset[iField] == field order in result set
-	for ( int i = 0; i < m_tFields.GetNumFields(); i++ )
+	for ( int i = 0; i < iNumFields; i++ )
 	{
 		int iField = bNeedReorder ? dFieldSort[i] : i;
-		ProcessBigBlockField ( iField, dFieldInfo[iField], dFieldInRset[iField], bPack, iSessionId, tOffset, tResult );
+		ProcessBigBlockField ( tStream.m_dFields[iField], dFieldInfo[iField], dFieldInRset[iField], bPack, iSessionId, tOffset, tResult );
 	}
-
-	return tResult;
 }
 
 
@@ -1003,37 +1075,43 @@ private:
 		CSphVector<CSphVector<BYTE>>	m_dFields;
 	};
 
+	// a sequence of blocks that holds a subset of fields
+	struct Stream_t
+	{
+		CSphVector<int>			m_dFields;
+		CSphVector<StoredDoc_t>	m_dStoredDocs;
+		CSphVector<BYTE>		m_dHeader;
+		DWORD					m_uStoredLen = 0;
+		int						m_iNumBlocks = 0;
+		SphOffset_t				m_tPrevBlockOffset = 0;
+		DWORD					m_tPrevBlockRowID = 0;
+	};
+
 	CSphString				m_sFilename;
-	CSphVector<StoredDoc_t>	m_dStoredDocs;
-	CSphVector<BYTE>		m_dHeader;
+	CSphFixedVector<Stream_t> m_dStreams{0};
 	CSphVector<BYTE>		m_dBuffer;
 	CSphScopedPtr<Compressor_i> m_pCompressor{nullptr};
-	MemoryWriter2_c			m_tHeaderWriter;
 	CSphWriter				m_tWriter;
 	DocstoreFields_c		m_tFields;
-	DWORD					m_uStoredLen = 0;
-	int						m_iNumBlocks = 0;
 	SphOffset_t				m_tHeaderOffset = 0;
-	SphOffset_t				m_tPrevBlockOffset = 0;
-	DWORD					m_tPrevBlockRowID = 0;
 
 	using SortedField_t = std::pair<int,int>;
 	CSphVector<SortedField_t>		m_dFieldSort;
 	CSphVector<CSphVector<BYTE>>	m_dCompressedBuffers;
 
+	void	SetupStreams();
 	void	WriteInitialHeader();
 	void	WriteTrailingHeader();
-	void	WriteBlock();
-	void	WriteSmallBlockHeader ( SphOffset_t tBlockOffset );
-	void	WriteBigBlockHeader ( SphOffset_t tBlockOffset, SphOffset_t tHeaderSize );
-	void	WriteSmallBlock();
-	void	WriteBigBlock();
+	void	WriteBlock ( Stream_t & tStream );
+	void	WriteSmallBlockHeader ( Stream_t & tStream, SphOffset_t tBlockOffset );
+	void	WriteBigBlockHeader ( Stream_t & tStream, SphOffset_t tBlockOffset, SphOffset_t tHeaderSize );
+	void	WriteSmallBlock ( Stream_t & tStream );
+	void	WriteBigBlock ( Stream_t & tStream );
 };
 
 
 DocstoreBuilder_c::DocstoreBuilder_c ( const CSphString & sFilename, const DocstoreSettings_t & tSettings )
 	: m_sFilename ( sFilename )
-	, m_tHeaderWriter ( m_dHeader )
 {
 	*(DocstoreSettings_t*)this = tSettings;
 }
@@ -1052,39 +1130,77 @@ bool DocstoreBuilder_c::Init ( CSphString & sError )
 }
 
 
+void DocstoreBuilder_c::SetupStreams()
+{
+	// fields from docstore_separate_fields get a stream of their own, all other fields share the first one
+	CSphVector<int> dShared, dSeparate;
+	for ( int i = 0; i < m_tFields.GetNumFields(); i++ )
+	{
+		const CSphString & sName = m_tFields.GetField(i).m_sName;
+		if ( m_dSeparateFields.any_of ( [&sName]( const CSphString & sField ){ return sField==sName; } ) )
+			dSeparate.Add(i);
+		else
+			dShared.Add(i);
+	}
+
+	int iShared = ( dShared.GetLength() || dSeparate.IsEmpty() ) ? 1 : 0;
+	m_dStreams.Reset ( iShared + dSeparate.GetLength() );
+	if ( iShared )
+		m_dStreams[0].m_dFields = dShared;
+
+	ARRAY_FOREACH ( i, dSeparate )
+		m_dStreams[i+iShared].m_dFields.Add ( dSeparate[i] );
+}
+
+
 void DocstoreBuilder_c::AddDoc ( RowID_t tRowID, const Doc_t & tDoc )
 {
 	assert ( tDoc.m_dFields.GetLength()==m_tFields.GetNumFields() );
 
-	DWORD uLen = 0;
-	for ( const auto & i : tDoc.m_dFields )
-		uLen += i.GetLength();
-
-	if ( m_uStoredLen+uLen > m_uBlockSize )
-		WriteBlock();
+	if ( m_dStreams.IsEmpty() )
+		SetupStreams();
 
-	StoredDoc_t & tStoredDoc = m_dStoredDocs.Add();
-	tStoredDoc.m_tRowID = tRowID;
-	tStoredDoc.m_dFields.Resize ( m_tFields.GetNumFields() );
-	for ( int i = 0; i<m_tFields.GetNumFields(); i++ )
+	for ( auto & tStream : m_dStreams )
 	{
-		int iLen = tDoc.m_dFields[i].GetLength();
+		DWORD uLen = 0;
+		for ( int iField : tStream.m_dFields )
+			uLen += tDoc.m_dFields[iField].GetLength();
 
-		// remove trailing zero
-		if ( m_tFields.GetField(i).m_eType==DOCSTORE_TEXT && iLen>0 && tDoc.m_dFields[i][iLen-1]=='\0' )
-			iLen--;
+		if ( tStream.m_uStoredLen+uLen > m_uBlockSize )
+			WriteBlock(tStream);
 
-		tStoredDoc.m_dFields[i].Resize(iLen);
-		memcpy ( tStoredDoc.m_dFields[i].Begin(), tDoc.m_dFields[i].Begin(), iLen );
-	}
+		StoredDoc_t & tStoredDoc = tStream.m_dStoredDocs.Add();
+		tStoredDoc.m_tRowID = tRowID;
+		tStoredDoc.m_dFields.Resize ( tStream.m_dFields.GetLength() );
+		ARRAY_FOREACH ( i, tStream.m_dFields )
+		{
+			int iField = tStream.m_dFields[i];
+			int iLen = tDoc.m_dFields[iField].GetLength();
+
+			// remove trailing zero
+			if ( m_tFields.GetField(iField).m_eType==DOCSTORE_TEXT && iLen>0 && tDoc.m_dFields[iField][iLen-1]=='\0' )
+				iLen--;
 
-	m_uStoredLen += uLen;
+			tStoredDoc.m_dFields[i].Resize(iLen);
+			memcpy ( tStoredDoc.m_dFields[i].Begin(), tDoc.m_dFields[iField].Begin(), iLen );
+		}
+
+		tStream.m_uStoredLen += uLen;
+	}
 }
 
 
 void DocstoreBuilder_c::Finalize()
 {
-	WriteBlock();
+	if ( m_dStreams.IsEmpty() )
+		SetupStreams();
+
+	if ( !m_tWriter.GetPos() )
+		WriteInitialHeader();
+
+	for ( auto & tStream : m_dStreams )
+		WriteBlock(tStream);
+
 	WriteTrailingHeader();
 }
 
@@ -1096,68 +1212,89 @@ void DocstoreBuilder_c::WriteInitialHeader()
 	m_tWriter.PutByte ( Compression2Byte(m_eCompression) );
 	m_tFields.Save(m_tWriter);
 
-	m_tHeaderOffset = m_tWriter.GetPos();
+	m_tWriter.PutDword ( m_dStreams.GetLength() );
+	for ( const auto & tStream : m_dStreams )
+	{
+		m_tWriter.PutDword ( tStream.m_dFields.GetLength() );
+		for ( int iField : tStream.m_dFields )
+			m_tWriter.PutDword(iField);
+	}
 
-	// reserve space for number of blocks
-	m_tWriter.PutDword(0);
+	m_tHeaderOffset = m_tWriter.GetPos();
 
-	// reserve space for header offset
-	m_tWriter.PutOffset(0);
+	// reserve space for number of blocks and header offset of every stream
+	for ( int i = 0; i < m_dStreams.GetLength(); i++ )
+	{
+		m_tWriter.PutDword(0);
+		m_tWriter.PutOffset(0);
+	}
 }
 
 
 void DocstoreBuilder_c::WriteTrailingHeader()
 {
-	SphOffset_t tHeaderPos = m_tWriter.GetPos();
-
-	// write header
-	m_tWriter.PutBytes ( m_dHeader.Begin(), m_dHeader.GetLength() );
+	// write headers
+	CSphFixedVector<SphOffset_t> dHeaderPos ( m_dStreams.GetLength() );
+	ARRAY_FOREACH ( i, m_dStreams )
+	{
+		dHeaderPos[i] = m_tWriter.GetPos();
+		m_tWriter.PutBytes ( m_dStreams[i].m_dHeader.Begin(), m_dStreams[i].m_dHeader.GetLength() );
+	}
 
 	// rewind to the beginning, store num_blocks, offset to header
 	m_tWriter.Flush();	// flush is necessary, see similar code in BlobRowBuilder_File_c::Done
 	m_tWriter.SeekTo(m_tHeaderOffset); 
-	m_tWriter.PutDword(m_iNumBlocks);
-	m_tWriter.PutOffset(tHeaderPos);
+	ARRAY_FOREACH ( i, m_dStreams )
+	{
+		m_tWriter.PutDword ( m_dStreams[i].m_iNumBlocks );
+		m_tWriter.PutOffset ( dHeaderPos[i] );
+	}
+
 	m_tWriter.CloseFile();
 }
 
 
-void DocstoreBuilder_c::WriteSmallBlockHeader ( SphOffset_t tBlockOffset )
+void DocstoreBuilder_c::WriteSmallBlockHeader ( Stream_t & tStream, SphOffset_t tBlockOffset )
 {
-	m_tHeaderWriter.ZipInt ( m_dStoredDocs[0].m_tRowID-m_tPrevBlockRowID );		// initial block rowid delta
-	m_tHeaderWriter.PutByte ( BLOCK_TYPE_SMALL );								// block type
-	m_tHeaderWriter.ZipOffset ( tBlockOffset-m_tPrevBlockOffset );				// block offset	delta
+	MemoryWriter2_c tHeaderWriter ( tStream.m_dHeader );
+	tHeaderWriter.ZipInt ( tStream.m_dStoredDocs[0].m_tRowID-tStream.m_tPrevBlockRowID );	// initial block rowid delta
+	tHeaderWriter.PutByte ( BLOCK_TYPE_SMALL );											// block type
+	tHeaderWriter.ZipOffset ( tBlockOffset-tStream.m_tPrevBlockOffset );					// block offset	delta
 
-	m_tPrevBlockOffset = tBlockOffset;
-	m_tPrevBlockRowID = m_dStoredDocs[0].m_tRowID;
+	tStream.m_tPrevBlockOffset = tBlockOffset;
+	tStream.m_tPrevBlockRowID = tStream.m_dStoredDocs[0].m_tRowID;
 }
 
 
-void DocstoreBuilder_c::WriteBigBlockHeader ( SphOffset_t tBlockOffset, SphOffset_t tHeaderSize )
+void DocstoreBuilder_c::WriteBigBlockHeader ( Stream_t & tStream, SphOffset_t tBlockOffset, SphOffset_t tHeaderSize )
 {
-	m_tHeaderWriter.ZipInt ( m_dStoredDocs[0].m_tRowID-m_tPrevBlockRowID );		// initial block rowid delta
-	m_tHeaderWriter.PutByte ( BLOCK_TYPE_BIG );									// block type
-	m_tHeaderWriter.ZipOffset ( tBlockOffset-m_tPrevBlockOffset );				// block offset	delta
-	m_tHeaderWriter.ZipInt ( tHeaderSize );										// on-disk header size
+	MemoryWriter2_c tHeaderWriter ( tStream.m_dHeader );
+	tHeaderWriter.ZipInt ( tStream.m_dStoredDocs[0].m_tRowID-tStream.m_tPrevBlockRowID );	// initial block rowid delta
+	tHeaderWriter.PutByte ( BLOCK_TYPE_BIG );												// block type
+	tHeaderWriter.ZipOffset ( tBlockOffset-tStream.m_tPrevBlockOffset );					// block offset	delta
+	tHeaderWriter.ZipInt ( tHeaderSize );													// on-disk header size
 
-	m_tPrevBlockOffset = tBlockOffset;
-	m_tPrevBlockRowID = m_dStoredDocs[0].m_tRowID;
+	tStream.m_tPrevBlockOffset = tBlockOffset;
+	tStream.m_tPrevBlockRowID = tStream.m_dStoredDocs[0].m_tRowID;
 }
 
 
-void DocstoreBuilder_c::WriteSmallBlock()
+void DocstoreBuilder_c::WriteSmallBlock ( Stream_t & tStream )
 {
 	m_dCompressedBuffers.Resize(1);
 	m_dBuffer.Resize(0);
 	MemoryWriter2_c tMemWriter ( m_dBuffer );
 
+	const auto & dStoredDocs = tStream.m_dStoredDocs;
+	int iNumFields = tStream.m_dFields.GetLength();
+
 #ifndef NDEBUG
-	for ( int i=1; i < m_dStoredDocs.GetLength(); i++ )
-		assert ( m_dStoredDocs[i].m_tRowID-m_dStoredDocs[i-1].m_tRowID==1 );
+	for ( int i=1; i < dStoredDocs.GetLength(); i++ )
+		assert ( dStoredDocs[i].m_tRowID-dStoredDocs[i-1].m_tRowID==1 );
 #endif // !NDEBUG
 
-	CSphBitvec tEmptyFields ( m_tFields.GetNumFields() );
-	for ( const auto & tDoc : m_dStoredDocs )
+	CSphBitvec tEmptyFields ( iNumFields );
+	for ( const auto & tDoc : dStoredDocs )
 	{
 		tEmptyFields.Clear();
 		ARRAY_FOREACH ( iField, tDoc.m_dFields )
@@ -1165,7 +1302,7 @@ void DocstoreBuilder_c::WriteSmallBlock()
 				tEmptyFields.BitSet(iField);
 
 		int iEmptyFields = tEmptyFields.BitCount();
-		if ( iEmptyFields==m_tFields.GetNumFields() )
+		if ( iEmptyFields==iNumFields )
 			tMemWriter.PutByte ( DOC_FLAG_ALL_EMPTY );
 		else
 		{
@@ -1191,10 +1328,10 @@ void DocstoreBuilder_c::WriteSmallBlock()
 	if ( bCompressed )
 		uBlockFlags |= BLOCK_FLAG_COMPRESSED;
 
-	WriteSmallBlockHeader ( m_tWriter.GetPos() );
+	WriteSmallBlockHeader ( tStream, m_tWriter.GetPos() );
 
 	m_tWriter.PutByte ( uBlockFlags );									// block flags
-	m_tWriter.ZipInt ( m_dStoredDocs.GetLength() );						// num docs
+	m_tWriter.ZipInt ( dStoredDocs.GetLength() );						// num docs
 	m_tWriter.ZipInt ( m_dBuffer.GetLength() );							// uncompressed length
 
 	if ( bCompressed )
@@ -1208,15 +1345,16 @@ void DocstoreBuilder_c::WriteSmallBlock()
 }
 
 
-void DocstoreBuilder_c::WriteBigBlock()
+void DocstoreBuilder_c::WriteBigBlock ( Stream_t & tStream )
 {
-	assert ( m_dStoredDocs.GetLength()==1 );
-	StoredDoc_t & tDoc = m_dStoredDocs[0];
+	assert ( tStream.m_dStoredDocs.GetLength()==1 );
+	StoredDoc_t & tDoc = tStream.m_dStoredDocs[0];
+	int iNumFields = tStream.m_dFields.GetLength();
 
-	m_dCompressedBuffers.Resize ( m_tFields.GetNumFields() );
+	m_dCompressedBuffers.Resize ( iNumFields );
 
 	bool bNeedReorder = false;
-	CSphBitvec tCompressedFields ( m_tFields.GetNumFields() );
+	CSphBitvec tCompressedFields ( iNumFields );
 	int iPrevSize = 0;
 	ARRAY_FOREACH ( iField, tDoc.m_dFields )
 	{
@@ -1233,7 +1371,7 @@ void DocstoreBuilder_c::WriteBigBlock()
 
 	if ( bNeedReorder )
 	{
-		m_dFieldSort.Resize ( m_tFields.GetNumFields() );
+		m_dFieldSort.Resize ( iNumFields );
 		ARRAY_FOREACH ( iField, tDoc.m_dFields )
 		{
 			m_dFieldSort[iField].first = iField;
@@ -1253,7 +1391,7 @@ void DocstoreBuilder_c::WriteBigBlock()
 			m_tWriter.ZipInt(i.first);										// field reorder map
 	}
 
-	for ( int i = 0; i < m_tFields.GetNumFields(); i++ )
+	for ( int i = 0; i < iNumFields; i++ )
 	{
 		int iField = bNeedReorder ? m_dFieldSort[i].first : i;
 		bool bCompressed = tCompressedFields.BitGet(iField);
@@ -1274,7 +1412,7 @@ void DocstoreBuilder_c::WriteBigBlock()
 
 	SphOffset_t tOnDiskHeaderSize = m_tWriter.GetPos() - tOnDiskHeaderStart;
 
-	for ( int i = 0; i < m_tFields.GetNumFields(); i++ )
+	for ( int i = 0; i < iNumFields; i++ )
 	{
 		int iField = bNeedReorder ? m_dFieldSort[i].first : i;
 		bool bCompressed = tCompressedFields.BitGet(iField);
@@ -1289,28 +1427,28 @@ void DocstoreBuilder_c::WriteBigBlock()
 			m_tWriter.PutBytes( tDoc.m_dFields[iField].Begin(), tDoc.m_dFields[iField].GetLength() );				// uncompressed data
 	}
 
-	WriteBigBlockHeader ( tOnDiskHeaderStart, tOnDiskHeaderSize );
+	WriteBigBlockHeader ( tStream, tOnDiskHeaderStart, tOnDiskHeaderSize );
 }
 
 
-void DocstoreBuilder_c::WriteBlock()
+void DocstoreBuilder_c::WriteBlock ( Stream_t & tStream )
 {
 	if ( !m_tWriter.GetPos() )
 		WriteInitialHeader();
 
-	if ( !m_dStoredDocs.GetLength() )
+	if ( !tStream.m_dStoredDocs.GetLength() )
 		return;
 
-	bool bBigBlock = m_dStoredDocs.GetLength()==1 && m_uStoredLen>=m_uBlockSize;
+	bool bBigBlock = tStream.m_dStoredDocs.GetLength()==1 && tStream.m_uStoredLen>=m_uBlockSize;
 
 	if ( bBigBlock )
-		WriteBigBlock();
+		WriteBigBlock(tStream);
 	else
-		WriteSmallBlock();
+		WriteSmallBlock(tStream);
 
-	m_iNumBlocks++;
-	m_uStoredLen = 0;
-	m_dStoredDocs.Resize(0);
+	tStream.m_iNumBlocks++;
+	tStream.m_uStoredLen = 0;
+	tStream.m_dStoredDocs.Resize(0);
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -1604,7 +1742,9 @@ private:
 	DocstoreFields_c	m_tFields;
 	CSphScopedPtr<Compressor_i> m_pCompressor{nullptr};
 	int64_t				m_iRowsCount = 0;
+	int					m_iStreamFields = 0;	// number of fields in the stream that is being checked
 
+	bool				CheckStreams ( DWORD uStorageVersion );
 	void				CheckSmallBlockDoc ( MemoryReader2_c & tReader, CSphBitvec & tEmptyFields, SphOffset_t tOffset );
 	void				CheckSmallBlock ( const Docstore_c::Block_t & tBlock );
 	void				CheckBlock ( const Docstore_c::Block_t & tBlock );
@@ -1657,70 +1797,129 @@ bool DocstoreChecker_c::Check()
 		m_tFields.AddField ( sName, eType );
 	}
 
-	DWORD uNumBlocks = m_tReader.GetDword();
-	// docstore from empty index
-	if ( !uNumBlocks )
-	{
-		if ( !m_iRowsCount )
-			return true;
-
-		return m_tReporter.Fail ( "Docstore has 0 blocks but " INT64_FMT " documents in %s", m_iRowsCount, m_szFilename );
-	}
+	if ( !CheckStreams(uStorageVersion) )
+		return false;
 
-	SphOffset_t tHeaderOffset = m_tReader.GetOffset();
-	if ( tHeaderOffset <= 0 || tHeaderOffset >= m_tReader.GetFilesize() )
-		return m_tReporter.Fail ( "Wrong docstore header offset (" INT64_FMT ") in %s", tHeaderOffset, m_szFilename );
+	if ( m_tReader.GetErrorFlag() )
+		return m_tReporter.Fail ( "%s", m_tReader.GetErrorMessage().cstr() );
 
-	m_tReader.SeekTo ( tHeaderOffset, 0 );
+	return true;
+}
 
-	CSphFixedVector<Docstore_c::Block_t> dBlocks(uNumBlocks);
 
-	DWORD tPrevBlockRowID = 0;
-	SphOffset_t tPrevBlockOffset = 0;
-	for ( auto & i : dBlocks )
+bool DocstoreChecker_c::CheckStreams ( DWORD uStorageVersion )
+{
+	CSphFixedVector<int> dStreamFields(1);
+	dStreamFields[0] = m_tFields.GetNumFields();
+	if ( uStorageVersion>=2 )
 	{
-		RowID_t uUnzipped = m_tReader.UnzipRowid();
-		if ( (int64_t)uUnzipped + tPrevBlockRowID >= (int64_t)0xFFFFFFFF )
-			m_tReporter.Fail ( "Docstore rowid overflow in %s", m_szFilename );
+		DWORD uNumStreams = m_tReader.GetDword();
+		if ( !uNumStreams || uNumStreams > (DWORD)Max ( m_tFields.GetNumFields(), 1 ) )
+			return m_tReporter.Fail ( "Wrong number of docstore streams (%u) in %s", uNumStreams, m_szFilename );
+
+		dStreamFields.Reset(uNumStreams);
+		int iTotalFields = 0;
+		for ( auto & iNumFields : dStreamFields )
+		{
+			iNumFields = m_tReader.GetDword();
+			for ( int i = 0; i < iNumFields; i++ )
+			{
+				DWORD uField = m_tReader.GetDword();
+				if ( uField >= (DWORD)m_tFields.GetNumFields() )
+					return m_tReporter.Fail ( "Wrong docstore stream field id (%u) in %s", uField, m_szFilename );
+			}
+
+			iTotalFields += iNumFields;
+		}
 
-		i.m_tRowID = uUnzipped + tPrevBlockRowID;
-		BYTE uBlockType = m_tReader.GetByte();
-		if ( uBlockType>BLOCK_TYPE_TOTAL )
-			return m_tReporter.Fail ( "Unknown docstore block type (%u) in %s", uBlockType, m_szFilename );
+		if ( iTotalFields!=m_tFields.GetNumFields() )
+			return m_tReporter.Fail ( "Docstore streams have %d fields, expected %d in %s", iTotalFields, m_tFields.GetNumFields(), m_szFilename );
+	}
 
-		i.m_eType = (BlockType_e)uBlockType;
-		i.m_tOffset = m_tReader.UnzipOffset() + tPrevBlockOffset;
-		if ( i.m_tOffset <= 0 || i.m_tOffset >= m_tReader.GetFilesize() )
-			return m_tReporter.Fail ( "Wrong docstore block offset (" INT64_FMT ") in %s", i.m_tOffset, m_szFilename );
+	CSphFixedVector<DWORD> dNumBlocks ( dStreamFields.GetLength() );
+	CSphFixedVector<SphOffset_t> dHeaderOffsets ( dStreamFields.GetLength() );
+	ARRAY_FOREACH ( i, dStreamFields )
+	{
+		dNumBlocks[i] = m_tReader.GetDword();
 
-		if ( i.m_eType==BLOCK_TYPE_BIG )
-			i.m_uHeaderSize = m_tReader.UnzipInt();
+		// docstore from empty index
+		if ( !dNumBlocks[i] && m_iRowsCount )
+			return m_tReporter.Fail ( "Docstore has 0 blocks but " INT64_FMT " documents in %s", m_iRowsCount, m_szFilename );
 
-		tPrevBlockRowID = i.m_tRowID;
-		tPrevBlockOffset = i.m_tOffset;
+		if ( uStorageVersion<2 && !dNumBlocks[i] )
+			return true;
+
+		dHeaderOffsets[i] = m_tReader.GetOffset();
+		if ( dHeaderOffsets[i] <= 0 || dHeaderOffsets[i] > m_tReader.GetFilesize() )
+			return m_tReporter.Fail ( "Wrong docstore header offset (" INT64_FMT ") in %s", dHeaderOffsets[i], m_szFilename );
 	}
 
-	for ( int i = 1; i<dBlocks.GetLength(); i++ )
+	CSphVector<SphOffset_t> dBounds;
+	dBounds.Add ( dHeaderOffsets[0] );
+
+	CSphFixedVector<CSphVector<Docstore_c::Block_t>> dStreamBlocks ( dStreamFields.GetLength() );
+	ARRAY_FOREACH ( iStream, dStreamBlocks )
 	{
-		if ( dBlocks[i-1].m_tOffset>=dBlocks[i].m_tOffset )
-			return m_tReporter.Fail ( "Descending docstore block offset in %s", m_szFilename );
+		auto & dBlocks = dStreamBlocks[iStream];
+		dBlocks.Resize ( dNumBlocks[iStream] );
+		if ( dBlocks.IsEmpty() )
+			continue;
+
+		m_tReader.SeekTo ( dHeaderOffsets[iStream], 0 );
+
+		DWORD tPrevBlockRowID = 0;
+		SphOffset_t tPrevBlockOffset = 0;
+		for ( auto & i : dBlocks )
+		{
+			RowID_t uUnzipped = m_tReader.UnzipRowid();
+			if ( (int64_t)uUnzipped + tPrevBlockRowID >= (int64_t)0xFFFFFFFF )
+				m_tReporter.Fail ( "Docstore rowid overflow in %s", m_szFilename );
+
+			i.m_tRowID = uUnzipped + tPrevBlockRowID;
+			BYTE uBlockType = m_tReader.GetByte();
+			if ( uBlockType>BLOCK_TYPE_TOTAL )
+				return m_tReporter.Fail ( "Unknown docstore block type (%u) in %s", uBlockType, m_szFilename );
+
+			i.m_eType = (BlockType_e)uBlockType;
+			i.m_tOffset = m_tReader.UnzipOffset() + tPrevBlockOffset;
+			if ( i.m_tOffset <= 0 || i.m_tOffset >= m_tReader.GetFilesize() )
+				return m_tReporter.Fail ( "Wrong docstore block offset (" INT64_FMT ") in %s", i.m_tOffset, m_szFilename );
+
+			if ( i.m_eType==BLOCK_TYPE_BIG )
+				i.m_uHeaderSize = m_tReader.UnzipInt();
+
+			tPrevBlockRowID = i.m_tRowID;
+			tPrevBlockOffset = i.m_tOffset;
+			dBounds.Add ( i.m_tOffset );
+		}
 
-		dBlocks[i-1].m_uSize = dBlocks[i].m_tOffset-dBlocks[i-1].m_tOffset;
+		for ( int i = 1; i<dBlocks.GetLength(); i++ )
+			if ( dBlocks[i-1].m_tOffset>=dBlocks[i].m_tOffset )
+				return m_tReporter.Fail ( "Descending docstore block offset in %s", m_szFilename );
 	}
 
-	if ( dBlocks.GetLength() )
-		dBlocks.Last().m_uSize = tHeaderOffset-dBlocks.Last().m_tOffset;
+	// blocks of different streams are interleaved, so block size is the distance to the next block of any stream
+	int iNumBounds = dBounds.GetLength();
+	dBounds.Uniq();
+	if ( dBounds.GetLength()!=iNumBounds )
+		return m_tReporter.Fail ( "Duplicate docstore block offsets in %s", m_szFilename );
 
-	for ( auto & i : dBlocks )
+	ARRAY_FOREACH ( iStream, dStreamBlocks )
 	{
-		if ( i.m_tOffset+i.m_uSize > m_tReader.GetFilesize() )
-			return m_tReporter.Fail ( "Docstore block size+offset out of bounds in %s", m_szFilename );
+		m_iStreamFields = dStreamFields[iStream];
+		for ( auto & i : dStreamBlocks[iStream] )
+		{
+			const SphOffset_t * pFound = dBounds.BinarySearch ( i.m_tOffset );
+			if ( !pFound || pFound+1>=dBounds.End() )
+				return m_tReporter.Fail ( "Docstore block offset after header (" INT64_FMT ") in %s", i.m_tOffset, m_szFilename );
 
-		CheckBlock(i);
-	}
+			i.m_uSize = DWORD ( pFound[1]-i.m_tOffset );
+			if ( i.m_tOffset+i.m_uSize > m_tReader.GetFilesize() )
+				return m_tReporter.Fail ( "Docstore block size+offset out of bounds in %s", m_szFilename );
 
-	if ( m_tReader.GetErrorFlag() )
-		return m_tReporter.Fail ( "%s", m_tReader.GetErrorMessage().cstr() );
+			CheckBlock(i);
+		}
+	}
 
 	return true;
 }
@@ -1745,7 +1944,7 @@ void DocstoreChecker_c::CheckSmallBlockDoc ( MemoryReader2_c & tReader, CSphBitv
 		tReader.SetPos ( tReader.GetPos()+uBitMaskSize );
 	}
 
-	for ( int iField = 0; iField < m_tFields.GetNumFields(); iField++ )
+	for ( int iField = 0; iField < m_iStreamFields; iField++ )
 		if ( !bHasBitmask || !tEmptyFields.BitGet(iField) )
 		{
 			DWORD uFieldLength = tReader.UnzipInt();
@@ -1801,7 +2000,7 @@ void DocstoreChecker_c::CheckSmallBlock ( const Docstore_c::Block_t & tBlock )
 	}
 
 	MemoryReader2_c tReader ( tResult.m_pData, tResult.m_uSize );
-	CSphBitvec tEmptyFields ( m_tFields.GetNumFields() );
+	CSphBitvec tEmptyFields ( m_iStreamFields );
 	for ( int i = 0; i < (int)tResult.m_uNumDocs; i++ )
 		CheckSmallBlockDoc ( tReader, tEmptyFields, tBlock.m_tOffset );
 
@@ -1841,7 +2040,7 @@ void DocstoreChecker_c::CheckBigBlockField ( const Docstore_c::FieldInfo_t & tIn
 
 void DocstoreChecker_c::CheckBigBlock ( const Docstore_c::Block_t & tBlock )
 {
-	CSphFixedVector<Docstore_c::FieldInfo_t> dFieldInfo ( m_tFields.GetNumFields() );
+	CSphFixedVector<Docstore_c::FieldInfo_t> dFieldInfo ( m_iStreamFields );
 
 	CSphFixedVector<BYTE> dBlockHeader(tBlock.m_uHeaderSize);
 	CSphFixedVector<BYTE> dBlock ( tBlock.m_uSize );
@@ -1859,16 +2058,16 @@ void DocstoreChecker_c::CheckBigBlock ( const Docstore_c::Block_t & tBlock )
 	bool bNeedReorder = !!( uBlockFlags & BLOCK_FLAG_FIELD_REORDER );
 	if ( bNeedReorder )
 	{
-		dFieldSort.Resize ( m_tFields.GetNumFields() );
+		dFieldSort.Resize ( m_iStreamFields );
 		for ( auto & i : dFieldSort )
 		{
 			i = tReader.UnzipInt();
-			if ( i<0 || i>m_tFields.GetNumFields() )
+			if ( i<0 || i>m_iStreamFields )
 				m_tReporter.Fail ( "Error in docstore field remap (%d) in %s (offset " INT64_FMT ")", i, m_szFilename, tBlock.m_tOffset );
 		}
 	}
 
-	for ( int i = 0; i < m_tFields.GetNumFields(); i++ )
+	for ( int i = 0; i < m_iStreamFields; i++ )
 	{
 		int iField = bNeedReorder ? dFieldSort[i] : i;
 		Docstore_c::FieldInfo_t & tInfo = dFieldInfo[iField];
@@ -1893,7 +2092,7 @@ void DocstoreChecker_c::CheckBigBlock ( const Docstore_c::Block_t & tBlock )
 
 	SphOffset_t tOffset = tBlock.m_tOffset+tBlock.m_uHeaderSize;
 
-	for ( int i = 0; i < m_tFields.GetNumFields(); i++ )
+	for ( int i = 0; i < m_iStreamFields; i++ )
 		CheckBigBlockField ( dFieldInfo[bNeedReorder ? dFieldSort[i] : i], tOffset );
 }
 
@@ -0,0 +1,91 @@
+//
+// Copyright (c) 2022, Manticore Software LTD (https://manticoresearch.com)
+// All rights reserved
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License. You should have
+// received a copy of the GPL license along with this program; if you
+// did not, you can find it at http://www.gnu.org/
+//
+
+#include <benchmark/benchmark.h>
+
+#include "sphinxint.h"
+
+#if WITH_ICU
+
+class bench_icu : public benchmark::Fixture
+{
+public:
+	void SetUp ( const ::benchmark::State & state )
+	{
+		CSphString sError;
+		m_pFilter = sphCreateFilterICU ( nullptr, nullptr, sError );
+
+		StringBuilder_c sText;
+		for ( int i = 0; i<64; ++i )
+			sText << "Manticore 搜索引擎 supports 中文分词 and 全文检索, 版本 " << i << ". ";
+		m_sMixed = sText.cstr();
+
+		sText.Clear();
+		for ( int i = 0; i<64; ++i )
+			sText << "plain latin text without any cjk characters at all " << i << ". ";
+		m_sLatin = sText.cstr();
+	}
+
+	void TearDown ( const ::benchmark::State & state )
+	{
+		m_pFilter = nullptr;
+	}
+
+	FieldFilterRefPtr_c m_pFilter;
+	CSphString m_sMixed;
+	CSphString m_sLatin;
+	CSphVector<BYTE> m_dOut;
+};
+
+BENCHMARK_F ( bench_icu, mixed ) ( benchmark::State & st )
+{
+	if ( !m_pFilter )
+	{
+		st.SkipWithError ( "unable to create ICU filter" );
+		return;
+	}
+
+	for ( auto _ : st )
+		benchmark::DoNotOptimize ( m_pFilter->Apply ( m_sMixed.cstr(), m_dOut, false ) );
+
+	st.SetBytesProcessed ( st.iterations() * m_sMixed.Length() );
+}
+
+BENCHMARK_F ( bench_icu, latin ) ( benchmark::State & st )
+{
+	if ( !m_pFilter )
+	{
+		st.SkipWithError ( "unable to create ICU filter" );
+		return;
+	}
+
+	for ( auto _ : st )
+		benchmark::DoNotOptimize ( m_pFilter->Apply ( m_sLatin.cstr(), m_dOut, false ) );
+
+	st.SetBytesProcessed ( st.iterations() * m_sLatin.Length() );
+}
+
+// queries clone filter each time, so clone must not reload break rules
+BENCHMARK_F ( bench_icu, clone_and_apply ) ( benchmark::State & st )
+{
+	if ( !m_pFilter )
+	{
+		st.SkipWithError ( "unable to create ICU filter" );
+		return;
+	}
+
+	for ( auto _ : st )
+	{
+		FieldFilterRefPtr_c pClone { m_pFilter->Clone() };
+		benchmark::DoNotOptimize ( pClone->Apply ( "中文分词 query", m_dOut, true ) );
+	}
+}
+
+#endif // WITH_ICU
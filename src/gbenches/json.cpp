@@ -305,3 +305,55 @@ BENCHMARK_F( BM_formatter, stringbuilder ) ( benchmark::State & st )
 		tOut.MoveTo ( sResult );
 	}
 }
+
+
+class bench_jsonparse : public benchmark::Fixture
+{
+public:
+	void SetUp ( const ::benchmark::State & state )
+	{
+		StringBuilder_c sDoc;
+		sDoc << "{";
+		for ( int i = 0; i<60; ++i )
+		{
+			sDoc.Appendf ( R"("field%d":)", i );
+			switch ( i%3 )
+			{
+			case 0: sDoc << R"("some text value with \"escapes\" and a few more words",)"; break;
+			case 1: sDoc.Appendf ( "%d,", i*12345 ); break;
+			default: sDoc << R"([1,2,3,4.5,"x",{"a":true}],)"; break;
+			}
+		}
+		sDoc << R"("last":null})";
+		sDoc.MoveTo ( sLiteral );
+	}
+
+	CSphString sLiteral;
+	CSphString sBuf;
+	CSphVector<BYTE> dBson;
+	StringBuilder_c sError;
+};
+
+BENCHMARK_F( bench_jsonparse, grammar ) ( benchmark::State & st )
+{
+	for ( auto _ : st )
+	{
+		st.PauseTiming ();
+		sBuf = sLiteral;
+		dBson.Resize ( 0 );
+		st.ResumeTiming ();
+		sphJsonParseGrammar ( dBson, (char *) sBuf.cstr (), false, true, false, sError );
+	}
+}
+
+BENCHMARK_F( bench_jsonparse, packer ) ( benchmark::State & st )
+{
+	for ( auto _ : st )
+	{
+		st.PauseTiming ();
+		sBuf = sLiteral;
+		dBson.Resize ( 0 );
+		st.ResumeTiming ();
+		sphJsonParse ( dBson, (char *) sBuf.cstr (), false, true, false, sError );
+	}
+}
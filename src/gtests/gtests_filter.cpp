@@ -13,7 +13,9 @@
 #include <gtest/gtest.h>
 
 #include "sphinxfilter.h"
+#include "sphinxint.h"
 #include "conversion.h"
+#include "sphinxsort.h"
 
 class filter_block_level : public ::testing::Test
 {
@@ -435,6 +437,47 @@ TEST_F ( filter_block_level, values )
 	ASSERT_TRUE ( tFilter->EvalBlock ( dMin.Begin(), dMax.Begin() ) );
 }
 
+TEST_F ( filter_block_level, values_lookup )
+{
+	CSphString sWarning, sError;
+	CSphSchema tSchema;
+	CSphColumnInfo tCol;
+	CSphScopedPtr<ISphFilter> tFilter ( NULL );
+
+	tCol.m_eAttrType = SPH_ATTR_BIGINT;
+	tCol.m_sName = "gid";
+	tSchema.AddAttr ( tCol, false );
+	tCtx.m_pSchema = &tSchema;
+
+	CSphFixedVector<DWORD> dRow ( DWSIZEOF(SphAttr_t) );
+	CSphMatch tMatch;
+	tMatch.m_pStatic = dRow.Begin();
+	const CSphAttrLocator & tLoc = tSchema.GetAttr(0).m_tLocator;
+
+	// dense list goes to bitmap, sparse list goes to hash
+	for ( SphAttr_t iStep : { 3, 1000003 } )
+	{
+		CSphVector<SphAttr_t> dValues;
+		for ( int i = 0; i < 1000; i++ )
+			dValues.Add ( -500*iStep + i*iStep );
+
+		SetDefault();
+		tOpt.m_eType = SPH_FILTER_VALUES;
+		tOpt.SetExternalValues ( dValues.Begin(), dValues.GetLength() );
+
+		tFilter = sphCreateFilter ( tOpt, tCtx, sError, sWarning );
+		ASSERT_TRUE ( tFilter.Ptr()!=NULL );
+
+		for ( SphAttr_t iValue = dValues[0]-2*iStep; iValue<=dValues.Last()+2*iStep; iValue += ( iStep>3 ? iStep : 1 ) )
+		{
+			sphSetRowAttr ( dRow.Begin(), tLoc, iValue );
+			ASSERT_EQ ( tFilter->Eval ( tMatch ), !!dValues.BinarySearch ( iValue ) ) << "value " << iValue;
+			sphSetRowAttr ( dRow.Begin(), tLoc, iValue+1 );
+			ASSERT_EQ ( tFilter->Eval ( tMatch ), !!dValues.BinarySearch ( iValue+1 ) ) << "value " << iValue+1;
+		}
+	}
+}
+
 TEST_F ( filter_block_level, and2 )
 {
 	CSphString sWarning, sError;
@@ -585,3 +628,121 @@ TEST_F ( filter_block_level, and )
 	*dMax.Begin() = 30;
 	ASSERT_TRUE ( tFilter->EvalBlock ( dMin.Begin(), dMax.Begin() ) );
 }
+
+TEST_F ( filter_block_level, search_after )
+{
+	CSphString sWarning, sError;
+	CSphSchema tSchema;
+	CSphColumnInfo tCol;
+	CSphFixedVector<DWORD> dMin ( DWSIZEOF(DocID_t) + 1 ), dMax ( DWSIZEOF(DocID_t) + 1 );
+	CSphScopedPtr<ISphFilter> tFilter ( NULL );
+
+	tCol.m_eAttrType = SPH_ATTR_INTEGER;
+	tCol.m_sName = "gid";
+	tSchema.AddAttr ( tCol, false );
+	tCol.m_eAttrType = SPH_ATTR_STRING;
+	tCol.m_sName = "title";
+	tSchema.AddAttr ( tCol, false );
+	tCtx.m_pSchema = &tSchema;
+
+	CSphQuery tQuery;
+	tQuery.m_eSort = SPH_SORT_EXTENDED;
+	tQuery.m_sSortBy = "gid desc, id asc";
+	tQuery.m_dSearchAfter.Add ( "40" );
+	tQuery.m_dSearchAfter.Add ( "1001" );
+
+	CSphFilterSettings tAfter;
+	ASSERT_TRUE ( sphSetupSearchAfterFilter ( tQuery, tSchema, tAfter ) );
+	tFilter = sphCreateFilter ( tAfter, tCtx, sError, sWarning );
+	ASSERT_TRUE ( tFilter.Ptr()!=NULL );
+
+	// desc cursor 40 vs block 41-50; all rows were on previous pages
+	*dMin.Begin() = 41;
+	*dMax.Begin() = 50;
+	ASSERT_FALSE ( tFilter->EvalBlock ( dMin.Begin(), dMax.Begin() ) );
+
+	// desc cursor 40 vs block 40-50; ties on gid are resolved by id in the sorter
+	*dMin.Begin() = 40;
+	ASSERT_TRUE ( tFilter->EvalBlock ( dMin.Begin(), dMax.Begin() ) );
+
+	// asc cursor 40 vs block 30-39
+	tQuery.m_sSortBy = "gid asc";
+	tQuery.m_dSearchAfter.Resize ( 1 );
+	ASSERT_TRUE ( sphSetupSearchAfterFilter ( tQuery, tSchema, tAfter ) );
+	tFilter = sphCreateFilter ( tAfter, tCtx, sError, sWarning );
+	ASSERT_TRUE ( tFilter.Ptr()!=NULL );
+	*dMin.Begin() = 30;
+	*dMax.Begin() = 39;
+	ASSERT_FALSE ( tFilter->EvalBlock ( dMin.Begin(), dMax.Begin() ) );
+
+	// no block bound on string keys or malformed values
+	tQuery.m_sSortBy = "title asc";
+	ASSERT_FALSE ( sphSetupSearchAfterFilter ( tQuery, tSchema, tAfter ) );
+	tQuery.m_sSortBy = "gid asc";
+	tQuery.m_dSearchAfter[0] = "4o";
+	ASSERT_FALSE ( sphSetupSearchAfterFilter ( tQuery, tSchema, tAfter ) );
+}
+
+TEST ( filter, sample )
+{
+	// roughly the requested share of documents is kept, and the choice is stable for the same seed
+	int iKept = 0;
+	for ( DocID_t tDocID = 1; tDocID<=100000; ++tDocID )
+		if ( sphSampleKeepsDoc ( tDocID, 0.1f, 0 ) )
+			++iKept;
+
+	ASSERT_GT ( iKept, 9500 );
+	ASSERT_LT ( iKept, 10500 );
+
+	for ( DocID_t tDocID = 1; tDocID<=1000; ++tDocID )
+	{
+		ASSERT_EQ ( sphSampleKeepsDoc ( tDocID, 0.3f, 42 ), sphSampleKeepsDoc ( tDocID, 0.3f, 42 ) );
+		ASSERT_TRUE ( sphSampleKeepsDoc ( tDocID, 1.0f, 42 ) );
+	}
+}
+
+
+TEST ( filter, sample_segments )
+{
+	CSphString sError;
+	CSphSchema tSchema;
+	CSphColumnInfo tCol ( sphGetDocidName(), SPH_ATTR_BIGINT );
+	tSchema.AddAttr ( tCol, false );
+
+	CreateFilterContext_t tCtx;
+	tCtx.m_pSchema = &tSchema;
+	CSphScopedPtr<ISphFilter> tFilter ( sphCreateSampleFilter ( 0.1f, 0, tCtx, sError ) );
+	ASSERT_TRUE ( tFilter.Ptr()!=NULL ) << sError.cstr();
+
+	// many small segments with row ids restarting from 0 in each; none of them may be taken or dropped as a whole
+	const int SEGMENTS = 500;
+	const int ROWS = 200;
+	CSphFixedVector<CSphRowitem> dRow ( DWSIZEOF(DocID_t) );
+	CSphMatch tMatch;
+	tMatch.m_pStatic = dRow.Begin();
+
+	int iKept = 0;
+	int iWholeSegments = 0;
+	DocID_t tDocID = 1;
+	for ( int iSeg = 0; iSeg<SEGMENTS; ++iSeg )
+	{
+		int iSegKept = 0;
+		for ( RowID_t tRowID = 0; tRowID<ROWS; ++tRowID )
+		{
+			sphUnalignedWrite ( dRow.Begin(), tDocID++ );
+			tMatch.m_tRowID = tRowID;
+			if ( tFilter->Eval ( tMatch ) )
+				++iSegKept;
+		}
+
+		iKept += iSegKept;
+		if ( iSegKept==0 || iSegKept==ROWS )
+			++iWholeSegments;
+	}
+
+	tMatch.m_pStatic = nullptr;
+
+	ASSERT_GT ( iKept, 9500 );
+	ASSERT_LT ( iKept, 10500 );
+	ASSERT_LT ( iWholeSegments, SEGMENTS/10 );
+}
@@ -20,6 +20,11 @@
 #include "histogram.h"
 #include "conversion.h"
 #include "digest_sha1.h"
+#include "civiltime.h"
+#include "termfilter.h"
+#include "rollup.h"
+#include "sphinxqcache.h"
+#include "sphinxsort.h"
 
 // Miscelaneous short functional tests: TDigest, SpanSearch,
 // stringbuilder, CJson, TaggedHash, Log2
@@ -3064,3 +3069,473 @@ TEST ( functions, mutate_via_ref )
 	ASSERT_EQ ( refData->GetRefcount (), 1 );
 
 }
+
+static void CheckCivilTime ( const CivilTime_t & tTime, const struct tm & tRef, int64_t iStamp )
+{
+	ASSERT_EQ ( tTime.m_iYear, tRef.tm_year+1900 ) << iStamp;
+	ASSERT_EQ ( tTime.m_iMonth, tRef.tm_mon+1 ) << iStamp;
+	ASSERT_EQ ( tTime.m_iDay, tRef.tm_mday ) << iStamp;
+	ASSERT_EQ ( tTime.m_iHour, tRef.tm_hour ) << iStamp;
+	ASSERT_EQ ( tTime.m_iMinute, tRef.tm_min ) << iStamp;
+	ASSERT_EQ ( tTime.m_iSecond, tRef.tm_sec ) << iStamp;
+	ASSERT_EQ ( tTime.m_iWeekDay, tRef.tm_wday ) << iStamp;
+	ASSERT_EQ ( tTime.m_iYearDay, tRef.tm_yday ) << iStamp;
+}
+
+TEST ( functions, civil_time )
+{
+	// leap days, year boundaries and the far end of 32-bit timestamps
+	int64_t dStamps[] = { 0, 59, 86399, 86400, 68169599, 68169600, 951782400, 951868799, 951868800, 978307199,
+		1582934400, 1609459199, 1609459200, 2147483647, 2147483648, 4107542400, 4294967295 };
+
+	for ( int64_t iStamp : dStamps )
+	{
+		auto tStamp = (time_t)iStamp;
+		struct tm tRef;
+		gmtime_r ( &tStamp, &tRef );
+
+		CivilTime_t tTime;
+		CivilTime::FromUTC ( iStamp, tTime );
+		CheckCivilTime ( tTime, tRef, iStamp );
+	}
+
+}
+
+#if !_WIN32
+static void CheckCivilLocal ( int64_t iStamp )
+{
+	auto tStamp = (time_t)iStamp;
+	struct tm tRef;
+	localtime_r ( &tStamp, &tRef );
+
+	CivilTime_t tTime;
+	CivilTime::FromLocal ( iStamp, tTime );
+	CheckCivilTime ( tTime, tRef, iStamp );
+}
+
+TEST ( functions, civil_time_local )
+{
+	// the zone with daylight saving time, so that the table has transitions to find (posix rule, no tzdata needed)
+	CSphString sWasTZ = getenv ( "TZ" );
+	bool bHadTZ = getenv ( "TZ" )!=nullptr;
+	setenv ( "TZ", "CET-1CEST,M3.5.0,M10.5.0/3", 1 );
+	tzset();
+	CivilTime::InitLocalZone();
+
+	// 2021-03-28 01:00:00 UTC: 01:59:59 CET is followed by 03:00:00 CEST
+	CivilTime_t tTime;
+	CivilTime::FromLocal ( 1616893199, tTime );
+	ASSERT_EQ ( tTime.m_iHour, 1 );
+	ASSERT_EQ ( tTime.m_iMinute, 59 );
+	CivilTime::FromLocal ( 1616893200, tTime );
+	ASSERT_EQ ( tTime.m_iHour, 3 );
+	ASSERT_EQ ( tTime.m_iMinute, 0 );
+
+	// 2021-10-31 01:00:00 UTC: 02:59:59 CEST is followed by 02:00:00 CET
+	CivilTime::FromLocal ( 1635642000-1, tTime );
+	ASSERT_EQ ( tTime.m_iHour, 2 );
+	ASSERT_EQ ( tTime.m_iMinute, 59 );
+	CivilTime::FromLocal ( 1635642000, tTime );
+	ASSERT_EQ ( tTime.m_iHour, 2 );
+	ASSERT_EQ ( tTime.m_iMinute, 0 );
+
+	// every second around the transitions, then arbitrary points all over the table
+	for ( int64_t iStamp = 1616893200-7200; iStamp<=1616893200+7200; ++iStamp )
+		CheckCivilLocal ( iStamp );
+	for ( int64_t iStamp = 1635642000-7200; iStamp<=1635642000+7200; ++iStamp )
+		CheckCivilLocal ( iStamp );
+	for ( int64_t iStamp = 0; iStamp<=4294967295LL; iStamp += 7919*3607 )
+		CheckCivilLocal ( iStamp );
+
+	if ( bHadTZ )
+		setenv ( "TZ", sWasTZ.cstr(), 1 );
+	else
+		unsetenv ( "TZ" );
+	tzset();
+	CivilTime::InitLocalZone();
+}
+#endif
+
+TEST ( functions, search_after_cursor )
+{
+	StrVec_t dKeys;
+	CSphString sError;
+	ASSERT_TRUE ( sphParseSearchAfter ( " 129.5, 10023 ", dKeys, sError ) );
+	ASSERT_EQ ( dKeys.GetLength(), 2 );
+	ASSERT_STREQ ( dKeys[0].cstr(), "129.5" );
+	ASSERT_STREQ ( dKeys[1].cstr(), "10023" );
+	ASSERT_STREQ ( sphFormatSearchAfter ( dKeys ).cstr(), "129.5,10023" );
+
+	ASSERT_TRUE ( sphParseSearchAfter ( "  ", dKeys, sError ) );
+	ASSERT_EQ ( dKeys.GetLength(), 0 );
+
+	// quoted values keep commas, spaces and doubled quotes
+	ASSERT_TRUE ( sphParseSearchAfter ( R"(abc, "Smith, John" , " x ","say ""hi""","",7)", dKeys, sError ) );
+	ASSERT_EQ ( dKeys.GetLength(), 6 );
+	ASSERT_STREQ ( dKeys[0].cstr(), "abc" );
+	ASSERT_STREQ ( dKeys[1].cstr(), "Smith, John" );
+	ASSERT_STREQ ( dKeys[2].cstr(), " x " );
+	ASSERT_STREQ ( dKeys[3].cstr(), R"(say "hi")" );
+	ASSERT_STREQ ( dKeys[4].cstr(), "" );
+	ASSERT_STREQ ( dKeys[5].cstr(), "7" );
+
+	// formatted cursor parses back to the same values
+	CSphString sCursor = sphFormatSearchAfter ( dKeys );
+	ASSERT_STREQ ( sCursor.cstr(), R"(abc,"Smith, John"," x ","say ""hi""","",7)" );
+	StrVec_t dParsed;
+	ASSERT_TRUE ( sphParseSearchAfter ( sCursor.cstr(), dParsed, sError ) );
+	ASSERT_EQ ( dParsed.GetLength(), dKeys.GetLength() );
+	ARRAY_FOREACH ( i, dKeys )
+		ASSERT_STREQ ( dParsed[i].cstr(), dKeys[i].cstr() );
+
+	ASSERT_FALSE ( sphParseSearchAfter ( R"(1,"abc)", dKeys, sError ) );
+	ASSERT_STREQ ( sError.cstr(), "search_after: unterminated quoted value at 2" );
+	ASSERT_FALSE ( sphParseSearchAfter ( R"("ab"c,1)", dKeys, sError ) );
+	ASSERT_STREQ ( sError.cstr(), "search_after: unexpected 'c' after quoted value 1" );
+}
+
+TEST ( functions, term_filter )
+{
+	TermFilterBuilder_c tBuilder;
+	for ( uint64_t i = 0; i<10000; ++i )
+		tBuilder.Add ( sphFNV64 ( &i, sizeof(i) ) );
+
+	TermFilter_c tFilter;
+	tBuilder.Build ( tFilter );
+
+	// every added term must pass
+	for ( uint64_t i = 0; i<10000; ++i )
+		ASSERT_TRUE ( tFilter.MayContain ( sphFNV64 ( &i, sizeof(i) ) ) ) << i;
+
+	// absent terms mostly must not
+	int iFalsePositives = 0;
+	for ( uint64_t i = 10000; i<110000; ++i )
+		if ( tFilter.MayContain ( sphFNV64 ( &i, sizeof(i) ) ) )
+			++iFalsePositives;
+
+	ASSERT_LT ( iFalsePositives, 2000 );
+
+	// empty filter refuses everything
+	TermFilter_c tEmpty;
+	TermFilterBuilder_c().Build ( tEmpty );
+	ASSERT_FALSE ( tEmpty.MayContain ( 1 ) );
+}
+
+// a filter only loads along with the very dictionary it was saved for
+static void TermFilterTestDict ( const CSphString & sFile, BYTE uFill )
+{
+	CSphString sError;
+	CSphWriter tWriter;
+	ASSERT_TRUE ( tWriter.OpenFile ( sFile, sError ) ) << sError.cstr();
+	for ( int i = 0; i<1000; ++i )
+		tWriter.PutByte ( i<100 ? 1 : uFill );
+}
+
+TEST ( functions, term_filter_signature )
+{
+	const CSphString sDict = "test_termfilter.spi";
+	const CSphString sFilter = "test_termfilter.spif";
+	const int64_t iCheckpoints = 100;
+	CSphString sError;
+
+	TermFilterBuilder_c tBuilder;
+	tBuilder.Add(1);
+	tBuilder.Add(2);
+
+	TermFilterTestDict ( sDict, 7 );
+	ASSERT_TRUE ( tBuilder.Save ( sFilter, sDict, iCheckpoints, sError ) ) << sError.cstr();
+
+	TermFilter_c tFilter;
+	ASSERT_TRUE ( tFilter.Load ( sFilter, sDict, iCheckpoints, sError ) ) << sError.cstr();
+	ASSERT_TRUE ( tFilter.MayContain(1) );
+
+	// another dictionary of the same size with checkpoints at the same offset
+	TermFilterTestDict ( sDict, 8 );
+	TermFilter_c tStale;
+	ASSERT_FALSE ( tStale.Load ( sFilter, sDict, iCheckpoints, sError ) );
+	ASSERT_FALSE ( tStale.MayContain(1) );
+
+	ASSERT_FALSE ( tStale.Load ( sFilter, sDict, iCheckpoints+1, sError ) );
+
+	::unlink ( sDict.cstr() );
+	::unlink ( sFilter.cstr() );
+}
+
+TEST ( functions, parse_rollups )
+{
+	CSphVector<RollupDesc_t> dRollups;
+	CSphString sError;
+	ASSERT_TRUE ( ParseRollups ( "gid: count(*), SUM(price), max(ts); tag: min(price)", dRollups, sError ) ) << sError.cstr();
+	ASSERT_EQ ( dRollups.GetLength(), 2 );
+
+	ASSERT_STREQ ( dRollups[0].m_sKey.cstr(), "gid" );
+	ASSERT_EQ ( dRollups[0].m_dAggrs.GetLength(), 2 );
+	ASSERT_EQ ( dRollups[0].m_dAggrs[0].m_eFunc, SPH_AGGR_SUM );
+	ASSERT_STREQ ( dRollups[0].m_dAggrs[0].m_sAttr.cstr(), "price" );
+	ASSERT_EQ ( dRollups[0].m_dAggrs[1].m_eFunc, SPH_AGGR_MAX );
+
+	ASSERT_STREQ ( dRollups[1].m_sKey.cstr(), "tag" );
+	ASSERT_EQ ( dRollups[1].m_dAggrs[0].m_eFunc, SPH_AGGR_MIN );
+
+	ASSERT_TRUE ( ParseRollups ( "", dRollups, sError ) );
+	ASSERT_TRUE ( dRollups.IsEmpty() );
+
+	ASSERT_FALSE ( ParseRollups ( "avg(price)", dRollups, sError ) );
+	ASSERT_FALSE ( ParseRollups ( "gid: avg(price)", dRollups, sError ) );
+}
+
+//////////////////////////////////////////////////////////////////////////
+// query cache eviction
+
+// entry that pretends it took iElapsedMsec to compute
+static void QcacheTestAdd ( const char * szQuery, int iElapsedMsec )
+{
+	CSphQuery tQuery;
+	tQuery.m_sQuery = szQuery;
+	CSphSchema tSchema;
+
+	QcacheEntryRefPtr_t pEntry { new QcacheEntry_c };
+	pEntry->m_iIndexId = 1;
+	pEntry->m_tmStarted = sphMicroTimer() - int64_t(iElapsedMsec)*1000;
+	for ( RowID_t i=0; i<100; ++i )
+		pEntry->Append ( i*3, 1 );
+
+	QcacheAdd ( tQuery, pEntry, tSchema );
+}
+
+static bool QcacheTestHit ( const char * szQuery )
+{
+	CSphQuery tQuery;
+	tQuery.m_sQuery = szQuery;
+	CSphSchema tSchema;
+
+	QcacheEntryRefPtr_t pEntry { QcacheFind ( 1, tQuery, tSchema ) };
+	return pEntry;
+}
+
+TEST ( functions, qcache_gdsf )
+{
+	const int64_t BIG = 1024*1024*1024;
+	QcacheSetup ( BIG, 0, 60 );
+
+	// same sizes, so priority is frequency * elapsed
+	QcacheTestAdd ( "expensive", 4000 );
+	QcacheTestAdd ( "popular", 1000 );
+	QcacheTestAdd ( "cheap", 2000 );
+	ASSERT_EQ ( QcacheGetStatus().m_iCachedQueries, 3 );
+	int64_t iSize = QcacheGetStatus().m_iUsedBytes/3;
+
+	for ( int i=0; i<5; ++i )
+		ASSERT_TRUE ( QcacheTestHit ( "popular" ) );
+
+	// cheap goes first, and clock moves up to its priority
+	QcacheSetup ( 2*iSize + iSize/2, 0, 60 );
+	ASSERT_EQ ( QcacheGetStatus().m_iCachedQueries, 2 );
+
+	// new entry is cheaper than the expensive one by itself, but gets the clock on top
+	// shards are picked by key, so that is also a check that all the shards share the clock
+	QcacheSetup ( BIG, 0, 60 );
+	QcacheTestAdd ( "fresh", 2500 );
+	QcacheSetup ( 2*iSize + iSize/2, 0, 60 );
+	ASSERT_EQ ( QcacheGetStatus().m_iCachedQueries, 2 );
+
+	ASSERT_FALSE ( QcacheTestHit ( "cheap" ) );
+	ASSERT_FALSE ( QcacheTestHit ( "expensive" ) );
+	ASSERT_TRUE ( QcacheTestHit ( "popular" ) );
+	ASSERT_TRUE ( QcacheTestHit ( "fresh" ) );
+
+	QcacheSetup ( 0, 0, 60 );
+	ASSERT_EQ ( QcacheGetStatus().m_iCachedQueries, 0 );
+}
+
+TEST ( functions, qcache_evict_many )
+{
+	const int64_t BIG = 1024*1024*1024;
+	const int ENTRIES = 200;
+	QcacheSetup ( BIG, 0, 60 );
+
+	CSphString sQuery;
+	for ( int i=0; i<ENTRIES; ++i )
+	{
+		sQuery.SetSprintf ( "q%d", i );
+		QcacheTestAdd ( sQuery.cstr(), 1000 + ( i*37 % ENTRIES )*20 );
+	}
+	ASSERT_EQ ( QcacheGetStatus().m_iCachedQueries, ENTRIES );
+	int64_t iSize = QcacheGetStatus().m_iUsedBytes/ENTRIES;
+
+	// the most expensive half stays, whatever shards they are in
+	QcacheSetup ( iSize*ENTRIES/2 + iSize/2, 0, 60 );
+	ASSERT_EQ ( QcacheGetStatus().m_iCachedQueries, ENTRIES/2 );
+
+	for ( int i=0; i<ENTRIES; ++i )
+	{
+		sQuery.SetSprintf ( "q%d", i );
+		ASSERT_EQ ( QcacheTestHit ( sQuery.cstr() ), ( i*37 % ENTRIES )>=ENTRIES/2 ) << i;
+	}
+
+	QcacheSetup ( 0, 0, 60 );
+}
+
+//////////////////////////////////////////////////////////////////////////
+// batched push into the group sorter (used by the columnar grouping proxy)
+
+static ISphMatchSorter * CreateBatchTestSorter ( const CSphSchema & tSchema, const CSphQuery & tQuery )
+{
+	SphQueueSettings_t tQueueSettings ( tSchema );
+	tQueueSettings.m_bComputeItems = true;
+	tQueueSettings.m_iMaxMatches = tQuery.m_iMaxMatches;
+	CSphString sError;
+	SphQueueRes_t tRes;
+	ISphMatchSorter * pSorter = sphCreateQueue ( tQueueSettings, tQuery, sError, tRes );
+	EXPECT_TRUE ( pSorter ) << sError.cstr();
+	return pSorter;
+}
+
+TEST ( functions, group_sorter_batch_push )
+{
+	const int MATCHES = 1000;
+	const int BATCH = 100;
+
+	CSphSchema tSchema;
+	tSchema.AddAttr ( CSphColumnInfo ( sphGetDocidName(), SPH_ATTR_BIGINT ), true );
+	tSchema.AddAttr ( CSphColumnInfo ( "gid", SPH_ATTR_INTEGER ), true );
+	tSchema.AddAttr ( CSphColumnInfo ( "val", SPH_ATTR_INTEGER ), true );
+
+	CSphQuery tQuery;
+	tQuery.m_sGroupBy = "gid";
+	tQuery.m_sGroupSortBy = "@groupby asc";
+	tQuery.m_iMaxMatches = 8; // less slots than groups, so that the worst groups get cut in the middle of a batch
+	tQuery.m_iLimit = 8;
+
+	auto fnAddItem = [&tQuery] ( const char * szExpr, const char * szAlias, ESphAggrFunc eFunc )
+	{
+		CSphQueryItem & tItem = tQuery.m_dItems.Add();
+		tItem.m_sExpr = szExpr;
+		tItem.m_sAlias = szAlias;
+		tItem.m_eAggrFunc = eFunc;
+	};
+
+	fnAddItem ( "gid", "gid", SPH_AGGR_NONE );
+	fnAddItem ( "val", "s", SPH_AGGR_SUM );
+	fnAddItem ( "val", "mx", SPH_AGGR_MAX );
+	fnAddItem ( "val", "mn", SPH_AGGR_MIN );
+	fnAddItem ( "val", "a", SPH_AGGR_AVG );
+
+	CSphScopedPtr<ISphMatchSorter> pSingle ( CreateBatchTestSorter ( tSchema, tQuery ) );
+	CSphScopedPtr<ISphMatchSorter> pBatched ( CreateBatchTestSorter ( tSchema, tQuery ) );
+	ASSERT_TRUE ( pSingle.Ptr() && pBatched.Ptr() );
+
+	const ISphSchema & tSorterSchema = *pSingle->GetSchema();
+	const CSphAttrLocator & tLocGid = tSorterSchema.GetAttr ( "gid" )->m_tLocator;
+	const CSphAttrLocator & tLocVal = tSorterSchema.GetAttr ( "val" )->m_tLocator;
+
+	// what the index would compute at presort stage: aggregate columns start as the plain value
+	CSphFixedVector<CSphMatch> dMatches ( MATCHES );
+	ARRAY_FOREACH ( i, dMatches )
+	{
+		CSphMatch & tMatch = dMatches[i];
+		tMatch.Reset ( tSorterSchema.GetDynamicSize() );
+		tMatch.m_tRowID = i;
+		tMatch.m_iWeight = 1 + i%3;
+		tMatch.SetAttr ( tLocGid, ( i*7919 ) % 37 );
+		tMatch.SetAttr ( tLocVal, 1 + i%13 );
+		for ( int iAttr=0; iAttr<tSorterSchema.GetAttrsCount(); ++iAttr )
+			if ( tSorterSchema.GetAttr(iAttr).m_eAggrFunc!=SPH_AGGR_NONE )
+				tMatch.SetAttr ( tSorterSchema.GetAttr(iAttr).m_tLocator, 1 + i%13 );
+	}
+
+	for ( const auto & tMatch : dMatches )
+		pSingle->Push ( tMatch );
+
+	for ( int i=0; i<MATCHES; i+=BATCH )
+		pBatched->Push ( VecTraits_T<const CSphMatch> ( dMatches.Begin()+i, BATCH ) );
+
+	ASSERT_EQ ( pSingle->GetLength(), pBatched->GetLength() );
+	ASSERT_EQ ( pSingle->GetTotalCount(), pBatched->GetTotalCount() );
+
+	CSphFixedVector<CSphMatch> dSingle ( pSingle->GetLength() );
+	CSphFixedVector<CSphMatch> dBatched ( pBatched->GetLength() );
+	ASSERT_EQ ( pSingle->Flatten ( dSingle.Begin() ), pBatched->Flatten ( dBatched.Begin() ) );
+
+	ARRAY_FOREACH ( i, dSingle )
+		for ( const char * szAttr : { "@groupby", "@count", "s", "mx", "mn", "a" } )
+		{
+			const CSphAttrLocator & tLoc = tSorterSchema.GetAttr ( szAttr )->m_tLocator;
+			ASSERT_EQ ( dSingle[i].GetAttr ( tLoc ), dBatched[i].GetAttr ( tLoc ) ) << szAttr << " of group " << i;
+		}
+}
+
+#if !_WIN32
+// counts how many regions went the huge pages way (advised or refused by the kernel)
+static int64_t HugePagesTestTouched()
+{
+	auto tStats = GetHugePagesStats();
+	return tStats.m_iAdvised + tStats.m_iFallbacks;
+}
+
+static void HugePagesTestAlloc ( size_t uSize, Share_e eAccess, bool bExpectHuge )
+{
+	int64_t iTouched = HugePagesTestTouched();
+	size_t uMapped = 0;
+	bool bExplicit = false;
+	auto * pMem = (BYTE *) mmallochuge ( uSize, eAccess, uMapped, bExplicit );
+	ASSERT_TRUE ( mmapvalid ( pMem ) );
+
+	// whole buffer is usable
+	pMem[0] = 1;
+	pMem[uSize-1] = 1;
+
+	if ( bExplicit )
+	{
+		// hugetlb mapping is made of whole huge pages
+		ASSERT_GE ( uMapped, uSize );
+		ASSERT_EQ ( uMapped % HUGE_PAGE_SIZE, 0u );
+		ASSERT_LT ( uMapped-uSize, HUGE_PAGE_SIZE );
+	} else
+	{
+		// otherwise size is never rounded up
+		ASSERT_EQ ( uMapped, uSize );
+		if ( bExpectHuge )
+		{
+			// explicit mode might also count refusal of hugetlb pool before falling back
+			ASSERT_GT ( HugePagesTestTouched(), iTouched );
+			if ( eAccess==Share_e::ANON_PRIVATE )
+			{
+				ASSERT_EQ ( (uintptr_t)pMem % HUGE_PAGE_SIZE, 0u );
+			}
+		} else
+		{
+			ASSERT_EQ ( HugePagesTestTouched(), iTouched );
+		}
+	}
+
+	ASSERT_EQ ( mmfreehuge ( pMem, uMapped, bExplicit ), 0 );
+}
+
+TEST ( functions, huge_pages_gating )
+{
+	HugePages_e eWas = GetHugePages();
+
+	// disabled - nothing is advised, whatever the size
+	SetHugePages ( HugePages_e::NONE );
+	HugePagesTestAlloc ( HUGE_PAGE_MIN_BUFFER*2, Share_e::ANON_PRIVATE, false );
+
+	SetHugePages ( HugePages_e::TRANSPARENT );
+
+	// small buffers stay on regular pages, even if they are multiple of huge page
+	HugePagesTestAlloc ( HUGE_PAGE_SIZE, Share_e::ANON_PRIVATE, false );
+	HugePagesTestAlloc ( HUGE_PAGE_MIN_BUFFER-1, Share_e::ANON_PRIVATE, false );
+
+	// large ones are aligned to 2M and advised, but keep their size
+	HugePagesTestAlloc ( HUGE_PAGE_MIN_BUFFER, Share_e::ANON_PRIVATE, true );
+	HugePagesTestAlloc ( HUGE_PAGE_MIN_BUFFER+12345, Share_e::ANON_PRIVATE, true );
+	HugePagesTestAlloc ( HUGE_PAGE_MIN_BUFFER+12345, Share_e::ANON_SHARED, true );
+
+	// explicit either gets whole pages from the pool or falls back to transparent
+	SetHugePages ( HugePages_e::EXPLICIT );
+	HugePagesTestAlloc ( HUGE_PAGE_MIN_BUFFER-1, Share_e::ANON_PRIVATE, false );
+	HugePagesTestAlloc ( HUGE_PAGE_MIN_BUFFER+12345, Share_e::ANON_PRIVATE, true );
+
+	SetHugePages ( eWas );
+}
+#endif
@@ -285,6 +285,55 @@ TEST_F( TJson, parser )
 	ASSERT_TRUE ( testcase ( R"({"a":{"b":0,"c":0},"d":[2,3333333333333333,45,-235]})" ) );
 }
 
+TEST_F ( TJson, packer_matches_grammar )
+{
+	const char * dDocs[] = {
+		"",
+		" // just a comment",
+		"{}",
+		"[]",
+		R"({sv:["one","two","three"],sp:["foo","fee"],gid:315})",
+		R"({'single':'quotes', "mixed":[1,"two",3.0,true,null,{},[]]})",
+		R"({"ints":[1,2,3],"bigs":[4294967296,-4294967296],"dbl":[1.5,.5,5.,1e3,-2E-2],"strs":["a","b\"c"]})",
+		R"({"TrUe":TRUE,"n":Null,"f":fAlSe, Key_1:{Nested:{"Deep":[[1],[2,3],["x"]]}}})",
+		R"({"esc":"\u0041\ud83d\ude00\n\t\\", "big":9223372036854775807, "bigger":99999999999999999999})",
+		"{ # comment\n \"a\" : 1 // another\n , \"B\":\"\xd0\xbf\xd1\x80\xd0\xb8\" }",
+		R"({"num":"123","neg":" -45 ","flt":"1.5e3","bad":"12ab","vec":["1","2","3"],"mix":["1","x"]})",
+		R"([6,[6,[6,[6,6.0]]]])",
+		// malformed ones
+		"{",
+		R"({"a":1,})",
+		R"({"a" 1})",
+		R"({true:1})",
+		R"([1 2])",
+		R"(["unterminated])",
+		R"({"a":1}x)",
+		"1",
+		R"([0x10])",
+		R"([1e])",
+	};
+
+	for ( const char * szDoc : dDocs )
+		for ( int iFlags = 0; iFlags<4; ++iFlags )
+		{
+			bool bAutoconv = iFlags & 1;
+			bool bToLowercase = iFlags & 2;
+
+			CSphString sPacker = szDoc;
+			CSphString sGrammar = szDoc;
+			CSphVector<BYTE> dPacker, dGrammar;
+			StringBuilder_c sPackerErr, sGrammarErr;
+			bool bPacker = sphJsonParse ( dPacker, (char *)sPacker.cstr(), bAutoconv, bToLowercase, true, sPackerErr );
+			bool bGrammar = sphJsonParseGrammar ( dGrammar, (char *)sGrammar.cstr(), bAutoconv, bToLowercase, true, sGrammarErr );
+
+			ASSERT_EQ ( bPacker, bGrammar ) << szDoc;
+			ASSERT_STREQ ( sPackerErr.cstr(), sGrammarErr.cstr() ) << szDoc;
+			ASSERT_EQ ( dPacker.GetLength(), dGrammar.GetLength() ) << szDoc;
+			for ( int i = 0; i<dPacker.GetLength(); ++i )
+				ASSERT_EQ ( dPacker[i], dGrammar[i] ) << szDoc << " at " << i;
+		}
+}
+
 TEST_F ( TJson, accessor )
 {
 
@@ -343,3 +343,193 @@ TEST_F ( PQ_merge, FullResultWithEverything )
 	for ( auto qid : { 100, 101, 102, 103, 180, 190 } )
 		ASSERT_EQ ( dResult.m_dQueryDesc[j++].m_iQUID, qid );
 }
+
+//////////////////////////////////////////////////////////////////////////
+// stored queries file: snapshot followed by journal of adds and deletes
+
+static const char * PQS_TEST_FILE = "test_pq.pqs";
+
+class PQ_stored : public ::testing::Test
+{
+protected:
+	void TearDown () override
+	{
+		::unlink ( PQS_TEST_FILE );
+		CSphString sNew;
+		sNew.SetSprintf ( "%s.new", PQS_TEST_FILE );
+		::unlink ( sNew.cstr() );
+	}
+
+	static void MakeQueries ( std::initializer_list<int64_t> dQUIDs, const char * szQuery, CSphVector<StoredQueryDesc_t> & dQueries, CSphVector<const StoredQueryDesc_t *> & dPtrs )
+	{
+		for ( int64_t iQUID : dQUIDs )
+		{
+			auto & tQuery = dQueries.Add();
+			tQuery.m_iQUID = iQUID;
+			tQuery.m_sQuery = szQuery;
+			tQuery.m_sTags = "tag";
+		}
+
+		for ( const auto & tQuery : dQueries )
+			dPtrs.Add ( &tQuery );
+	}
+
+	static void Snapshot ( std::initializer_list<int64_t> dQUIDs )
+	{
+		CSphVector<StoredQueryDesc_t> dQueries;
+		CSphVector<const StoredQueryDesc_t *> dStored;
+		MakeQueries ( dQUIDs, "snapshot", dQueries, dStored );
+
+		CSphString sError;
+		ASSERT_TRUE ( PqsWriteSnapshot ( PQS_TEST_FILE, dStored, sError ) ) << sError.cstr();
+	}
+
+	void Record ( std::initializer_list<int64_t> dAdd, std::initializer_list<int64_t> dDelete, const char * szQuery = "journal" )
+	{
+		CSphVector<StoredQueryDesc_t> dQueries;
+		CSphVector<const StoredQueryDesc_t *> dNew;
+		MakeQueries ( dAdd, szQuery, dQueries, dNew );
+
+		CSphVector<int64_t> dDel;
+		for ( int64_t iQUID : dDelete )
+			dDel.Add ( iQUID );
+
+		PqsAddRecord ( dNew, dDel, m_dRecords );
+	}
+
+	void Append ()
+	{
+		CSphString sError;
+		ASSERT_TRUE ( PqsAppendRecords ( PQS_TEST_FILE, m_dRecords, sError ) ) << sError.cstr();
+		m_dRecords.Reset();
+	}
+
+	void Load ( int64_t & iJournalOps, bool & bTorn )
+	{
+		CSphString sError;
+		ASSERT_TRUE ( PqsLoad ( PQS_TEST_FILE, m_dLoaded, iJournalOps, bTorn, sError ) ) << sError.cstr();
+	}
+
+	const StoredQueryDesc_t * Loaded ( int64_t iQUID ) const
+	{
+		for ( const auto & tQuery : m_dLoaded )
+			if ( tQuery.m_iQUID==iQUID )
+				return &tQuery;
+		return nullptr;
+	}
+
+	// drops the last iCut bytes of the file, as an interrupted append would leave it
+	static void CutTail ( int iCut )
+	{
+		FILE * pFile = fopen ( PQS_TEST_FILE, "rb" );
+		ASSERT_NE ( pFile, nullptr );
+		fseek ( pFile, 0, SEEK_END );
+		CSphVector<BYTE> dData;
+		dData.Resize ( (int)ftell ( pFile ) );
+		fseek ( pFile, 0, SEEK_SET );
+		ASSERT_EQ ( fread ( dData.Begin(), 1, dData.GetLength(), pFile ), (size_t)dData.GetLength() );
+		fclose ( pFile );
+
+		ASSERT_GT ( dData.GetLength(), iCut );
+		pFile = fopen ( PQS_TEST_FILE, "wb" );
+		ASSERT_NE ( pFile, nullptr );
+		fwrite ( dData.Begin(), 1, dData.GetLength()-iCut, pFile );
+		fclose ( pFile );
+	}
+
+	CSphVector<BYTE> m_dRecords;
+	CSphVector<StoredQueryDesc_t> m_dLoaded;
+};
+
+
+TEST_F ( PQ_stored, snapshot_and_journal_round_trip )
+{
+	Snapshot ( { 1, 2, 3 } );
+	Record ( { 4, 5 }, {} );
+	Record ( {}, { 2, 100 } );
+	Append();
+	Record ( { 3 }, {}, "replaced" );
+	Append();
+
+	int64_t iJournalOps = -1;
+	bool bTorn = true;
+	Load ( iJournalOps, bTorn );
+
+	ASSERT_FALSE ( bTorn );
+	ASSERT_EQ ( iJournalOps, 5 ); // adds and deletes after the snapshot, including the delete of unknown query
+	ASSERT_EQ ( m_dLoaded.GetLength(), 4 );
+	ASSERT_TRUE ( Loaded ( 1 ) );
+	ASSERT_FALSE ( Loaded ( 2 ) );
+	ASSERT_TRUE ( Loaded ( 3 ) );
+	ASSERT_TRUE ( Loaded ( 4 ) );
+	ASSERT_TRUE ( Loaded ( 5 ) );
+	ASSERT_STREQ ( Loaded ( 1 )->m_sQuery.cstr(), "snapshot" );
+	ASSERT_STREQ ( Loaded ( 3 )->m_sQuery.cstr(), "replaced" );
+	ASSERT_STREQ ( Loaded ( 5 )->m_sQuery.cstr(), "journal" );
+	ASSERT_STREQ ( Loaded ( 5 )->m_sTags.cstr(), "tag" );
+}
+
+
+TEST_F ( PQ_stored, compaction )
+{
+	// journal is kept until it outgrows both the stored set and the minimum
+	ASSERT_FALSE ( PqsNeedsCompaction ( 10, 10 ) );
+	ASSERT_FALSE ( PqsNeedsCompaction ( PQS_JOURNAL_MIN_OPS, 10 ) );
+	ASSERT_TRUE ( PqsNeedsCompaction ( PQS_JOURNAL_MIN_OPS+1, 10 ) );
+	ASSERT_FALSE ( PqsNeedsCompaction ( 5000, 5000 ) );
+	ASSERT_TRUE ( PqsNeedsCompaction ( 5001, 5000 ) );
+
+	// new snapshot replaces the journal
+	Snapshot ( { 1, 2 } );
+	Record ( { 3 }, { 1 } );
+	Append();
+	Snapshot ( { 2, 3 } );
+
+	int64_t iJournalOps = -1;
+	bool bTorn = true;
+	Load ( iJournalOps, bTorn );
+
+	ASSERT_FALSE ( bTorn );
+	ASSERT_EQ ( iJournalOps, 0 );
+	ASSERT_EQ ( m_dLoaded.GetLength(), 2 );
+	ASSERT_TRUE ( Loaded ( 2 ) );
+	ASSERT_TRUE ( Loaded ( 3 ) );
+	ASSERT_STREQ ( Loaded ( 3 )->m_sQuery.cstr(), "snapshot" );
+}
+
+
+TEST_F ( PQ_stored, truncated_tail )
+{
+	Snapshot ( { 1, 2 } );
+	Record ( { 3 }, {} );
+	Record ( { 4 }, { 1 } );
+	Append();
+
+	// cut in the middle of the last record; the records before it are still good
+	CutTail ( 2 );
+
+	int64_t iJournalOps = -1;
+	bool bTorn = false;
+	Load ( iJournalOps, bTorn );
+
+	ASSERT_TRUE ( bTorn );
+	ASSERT_EQ ( iJournalOps, 1 );
+	ASSERT_EQ ( m_dLoaded.GetLength(), 3 );
+	ASSERT_TRUE ( Loaded ( 1 ) );
+	ASSERT_TRUE ( Loaded ( 2 ) );
+	ASSERT_TRUE ( Loaded ( 3 ) );
+	ASSERT_FALSE ( Loaded ( 4 ) );
+
+	// cut in the middle of the length of the only journal record
+	Snapshot ( { 1, 2 } );
+	Record ( { 5 }, {} );
+	int iRecord = m_dRecords.GetLength();
+	Append();
+	CutTail ( iRecord-2 );
+
+	Load ( iJournalOps, bTorn );
+	ASSERT_TRUE ( bTorn );
+	ASSERT_EQ ( iJournalOps, 0 );
+	ASSERT_EQ ( m_dLoaded.GetLength(), 2 );
+	ASSERT_FALSE ( Loaded ( 5 ) );
+}
@@ -18,6 +18,12 @@
 #include "sphinxsort.h"
 #include "searchdaemon.h"
 #include "binlog.h"
+#include "resultcache.h"
+#include "docstore.h"
+#include "fileio.h"
+#include "memio.h"
+#include "searchnode.h"
+#include "secondaryindex.h"
 
 #include <gmock/gmock.h>
 
@@ -652,3 +658,1528 @@ TEST_F ( RT, SendVsMerge )
 	pTok = nullptr; // owned and deleted by index
 	});
 }
+
+TEST_F ( RT, StaleMinMaxRefresh )
+{
+	using namespace testing;
+	Threads::CallCoroutine ( [&] {
+
+	DictRefPtr_c pDict { sphCreateDictionaryCRC ( tDictSettings, nullptr, pTok, "rt", false, 32, nullptr, sError ) };
+
+	tCol.m_sName = "id";
+	tCol.m_eAttrType = SPH_ATTR_BIGINT;
+	tSrcSchema.AddAttr ( tCol, true );
+
+	tCol.m_sName = "tag1";
+	tCol.m_eAttrType = SPH_ATTR_INTEGER;
+	tSrcSchema.AddAttr ( tCol, true );
+
+	tCol.m_sName = "tag2";
+	tCol.m_eAttrType = SPH_ATTR_INTEGER;
+	tSrcSchema.AddAttr ( tCol, true );
+
+	auto pSrc = new MockDocRandomizer_c ( tSrcSchema );
+
+	EXPECT_CALL ( *pSrc, Connect ( _ ) ).WillOnce ( Return ( true ) );
+	EXPECT_CALL ( *pSrc, GetFieldLengths () ).Times ( 801 ).WillRepeatedly ( Return ( pSrc->m_dFieldLengths ) );
+	EXPECT_CALL ( *pSrc, Disconnect () );
+
+	pSrc->SetTokenizer ( pTok );
+	pSrc->SetDict ( pDict );
+	pSrc->Setup ( CSphSourceSettings(), nullptr );
+	ASSERT_TRUE ( pSrc->Connect ( sError ) );
+	ASSERT_TRUE ( pSrc->IterateStart ( sError ) );
+	ASSERT_TRUE ( pSrc->UpdateSchema ( &tSrcSchema, sError ) );
+
+	CSphSchema tSchema;
+	for ( int i=0; i<tSrcSchema.GetFieldsCount(); i++ )
+		tSchema.AddField ( tSrcSchema.GetField(i) );
+
+	for ( int i=0; i<tSrcSchema.GetAttrsCount(); i++ )
+		tSchema.AddAttr ( tSrcSchema.GetAttr(i), false );
+
+	RtIndex_i * pIndex = sphCreateIndexRT ( tSchema, "testrt", 32 * 1024 * 1024, RT_INDEX_FILE_NAME, false );
+	pIndex->SetTokenizer ( pTok->Clone ( SPH_CLONE_INDEX ) );
+	pIndex->SetDictionary ( pDict->Clone () );
+	pIndex->PostSetup ();
+	StrVec_t dWarnings;
+	ASSERT_TRUE ( pIndex->Prealloc ( false, nullptr, dWarnings ) );
+
+	CSphString sFilter;
+	InsertDocData_t tDoc ( pIndex->GetMatchSchema() );
+	int iDynamic = pIndex->GetMatchSchema().GetRowSize();
+
+	bool bEOF = false;
+	while (true)
+	{
+		ASSERT_TRUE ( pSrc->IterateDocument ( bEOF, sError ) );
+		if ( bEOF )
+			break;
+
+		tDoc.m_dFields = pSrc->GetFields();
+		tDoc.m_tDoc.Combine ( pSrc->m_tDocInfo, iDynamic );
+		pIndex->AddDocument ( tDoc, false, sFilter, sError, sWarning, nullptr );
+	}
+	pIndex->Commit ( nullptr, nullptr );
+	pSrc->Disconnect ();
+
+	// min/max only exists in disk chunks
+	ASSERT_TRUE ( pIndex->ForceDiskChunk () );
+
+	CSphIndexStatus tStatus;
+	pIndex->GetStatus ( &tStatus );
+	ASSERT_EQ ( tStatus.m_iStaleMinMaxBlocks, 0 );
+
+	// ids are 1000..1800, row N holds id 1000+N; kill the first row of block 0, update a row of block 3
+	DocID_t tKilled = 1000;
+	ASSERT_TRUE ( pIndex->DeleteDocument ( { &tKilled, 1 }, sError, nullptr ) ) << sError.cstr();
+	pIndex->Commit ( nullptr, nullptr );
+
+	AttrUpdateSharedPtr_t pUpd { new CSphAttrUpdate };
+	pUpd->m_dAttributes.Add ( { "tag2", SPH_ATTR_INTEGER } );
+	pUpd->m_dDocids.Add ( 1000 + 3*DOCINFO_INDEX_FREQ );
+	pUpd->m_dPool.Add ( 7 );
+	AttrUpdateInc_t tUpd ( pUpd );
+	bool bCritical = false;
+	ASSERT_EQ ( pIndex->UpdateAttributes ( tUpd, bCritical, sError, sWarning ), 1 ) << sError.cstr();
+
+	pIndex->GetStatus ( &tStatus );
+	ASSERT_EQ ( tStatus.m_iStaleMinMaxBlocks, 2 ) << "killed and updated blocks are stale";
+
+	// flush the update, so that only the refresh marks the attributes dirty again
+	ASSERT_TRUE ( pIndex->SaveAttributes ( sError ) ) << sError.cstr();
+	ASSERT_EQ ( pIndex->GetAttributeStatus (), 0u );
+
+	// batch limit is honored
+	ASSERT_EQ ( pIndex->RefreshStaleMinMax ( 1 ), 1 );
+	pIndex->GetStatus ( &tStatus );
+	ASSERT_EQ ( tStatus.m_iStaleMinMaxBlocks, 1 );
+
+	ASSERT_EQ ( pIndex->RefreshStaleMinMax ( 100 ), 1 );
+	pIndex->GetStatus ( &tStatus );
+	ASSERT_EQ ( tStatus.m_iStaleMinMaxBlocks, 0 );
+	ASSERT_NE ( pIndex->GetAttributeStatus (), 0u ) << "tightened min/max must be saved";
+
+	// nothing is left to refresh
+	ASSERT_EQ ( pIndex->RefreshStaleMinMax ( 100 ), 0 );
+
+	SafeDelete ( pIndex );
+	SafeDelete ( pSrc );
+	});
+}
+
+//////////////////////////////////////////////////////////////////////////
+// result cache
+
+// final result of iMatches standalone matches, as the master has it after the merge
+static void RcacheTestResult ( AggrResult_t & tRes, int iMatches )
+{
+	CSphSchema tSchema;
+	tSchema.AddAttr ( CSphColumnInfo ( "n", SPH_ATTR_BIGINT ), true );
+
+	OneResultset_t & tChunk = tRes.m_dResults.Add();
+	tChunk.m_tSchema = tSchema;
+	for ( int i=0; i<iMatches; ++i )
+	{
+		CSphMatch & tMatch = tChunk.m_dMatches.Add();
+		tMatch.Reset ( tSchema.GetDynamicSize() );
+		tMatch.SetAttr ( tSchema.GetAttr(0).m_tLocator, i );
+	}
+	tRes.m_iTotalMatches = iMatches;
+}
+
+static bool RcacheTestHit ( const char * szKey, uint64_t uLocalVersion, uint64_t uRemoteVersion=1 )
+{
+	AggrResult_t tRes;
+	if ( !RcacheFind ( szKey, uLocalVersion, uRemoteVersion, tRes ) )
+		return false;
+
+	EXPECT_EQ ( tRes.m_dResults.GetLength(), 1 );
+	EXPECT_EQ ( tRes.m_dResults.First().m_dMatches.GetLength(), tRes.m_iTotalMatches );
+	return true;
+}
+
+TEST ( rcache, hit_and_versions )
+{
+	RcacheSetup ( 1024*1024, 0, 60 );
+	AggrResult_t tRes;
+	RcacheTestResult ( tRes, 10 );
+
+	int64_t iHits = RcacheGetStatus().m_iHits;
+	RcacheAdd ( "q", 5, 7, tRes );
+	ASSERT_EQ ( RcacheGetStatus().m_iCachedQueries, 1 );
+
+	uint64_t uRemote = 0;
+	ASSERT_TRUE ( RcachePeek ( "q", 5, uRemote ) );
+	ASSERT_EQ ( uRemote, 7u );
+	ASSERT_TRUE ( RcacheTestHit ( "q", 5, 7 ) );
+	ASSERT_EQ ( RcacheGetStatus().m_iHits, iHits+1 );
+
+	// other agents data is not the cached result, but the entry is still good for the local data
+	ASSERT_FALSE ( RcacheTestHit ( "q", 5, 8 ) );
+	ASSERT_EQ ( RcacheGetStatus().m_iCachedQueries, 1 );
+
+	// local data moved on; the entry is of no use anymore
+	ASSERT_FALSE ( RcacheTestHit ( "q", 6, 7 ) );
+	ASSERT_EQ ( RcacheGetStatus().m_iCachedQueries, 0 );
+	ASSERT_EQ ( RcacheGetStatus().m_iUsedBytes, 0 );
+
+	// unknown version is never cached
+	RcacheAdd ( "q", 0, 7, tRes );
+	ASSERT_EQ ( RcacheGetStatus().m_iCachedQueries, 0 );
+
+	RcacheSetup ( 0, 0, 60 );
+}
+
+TEST ( rcache, lru )
+{
+	RcacheSetup ( 1024*1024, 0, 60 );
+	AggrResult_t tRes;
+	RcacheTestResult ( tRes, 10 );
+
+	RcacheAdd ( "a", 1, 1, tRes );
+	int64_t iSize = RcacheGetStatus().m_iUsedBytes;
+	RcacheAdd ( "b", 1, 1, tRes );
+	RcacheAdd ( "c", 1, 1, tRes );
+	ASSERT_EQ ( RcacheGetStatus().m_iCachedQueries, 3 );
+
+	// 'a' is the oldest, but the recently used one; 'b' goes first, then 'c'
+	ASSERT_TRUE ( RcacheTestHit ( "a", 1 ) );
+	RcacheSetup ( 2*iSize, 0, 60 );
+	ASSERT_EQ ( RcacheGetStatus().m_iCachedQueries, 2 );
+	ASSERT_FALSE ( RcacheTestHit ( "b", 1 ) );
+
+	RcacheAdd ( "d", 1, 1, tRes );
+	ASSERT_EQ ( RcacheGetStatus().m_iCachedQueries, 2 );
+	ASSERT_EQ ( RcacheGetStatus().m_iUsedBytes, 2*iSize );
+	ASSERT_FALSE ( RcacheTestHit ( "c", 1 ) );
+	ASSERT_TRUE ( RcacheTestHit ( "a", 1 ) );
+	ASSERT_TRUE ( RcacheTestHit ( "d", 1 ) );
+
+	RcacheSetup ( 0, 0, 60 );
+	ASSERT_EQ ( RcacheGetStatus().m_iCachedQueries, 0 );
+}
+
+TEST ( rcache, ttl )
+{
+	RcacheSetup ( 1024*1024, 0, 1 );
+	AggrResult_t tRes;
+	RcacheTestResult ( tRes, 10 );
+
+	RcacheAdd ( "old", 1, 1, tRes );
+	ASSERT_TRUE ( RcacheTestHit ( "old", 1 ) );
+	sphSleepMsec ( 1100 );
+
+	// expired entry is not served even though it is used; others are swept out on add
+	RcacheAdd ( "new", 1, 1, tRes );
+	ASSERT_EQ ( RcacheGetStatus().m_iCachedQueries, 1 );
+	ASSERT_FALSE ( RcacheTestHit ( "old", 1 ) );
+	ASSERT_TRUE ( RcacheTestHit ( "new", 1 ) );
+
+	RcacheAdd ( "old", 1, 1, tRes );
+	sphSleepMsec ( 1100 );
+	ASSERT_FALSE ( RcacheTestHit ( "old", 1 ) );
+
+	RcacheSetup ( 0, 0, 60 );
+}
+
+// the data version of an index moves on update and kill, so a result cached over the old one misses
+TEST_F ( RT, ResultCacheVersions )
+{
+	using namespace testing;
+	Threads::CallCoroutine ( [&] {
+
+	DictRefPtr_c pDict { sphCreateDictionaryCRC ( tDictSettings, nullptr, pTok, "rt", false, 32, nullptr, sError ) };
+
+	tCol.m_sName = "id";
+	tCol.m_eAttrType = SPH_ATTR_BIGINT;
+	tSrcSchema.AddAttr ( tCol, true );
+
+	tCol.m_sName = "tag1";
+	tCol.m_eAttrType = SPH_ATTR_INTEGER;
+	tSrcSchema.AddAttr ( tCol, true );
+
+	tCol.m_sName = "tag2";
+	tCol.m_eAttrType = SPH_ATTR_INTEGER;
+	tSrcSchema.AddAttr ( tCol, true );
+
+	auto pSrc = new MockDocRandomizer_c ( tSrcSchema );
+
+	EXPECT_CALL ( *pSrc, Connect ( _ ) ).WillOnce ( Return ( true ) );
+	EXPECT_CALL ( *pSrc, GetFieldLengths () ).Times ( 801 ).WillRepeatedly ( Return ( pSrc->m_dFieldLengths ) );
+	EXPECT_CALL ( *pSrc, Disconnect () );
+
+	pSrc->SetTokenizer ( pTok );
+	pSrc->SetDict ( pDict );
+	pSrc->Setup ( CSphSourceSettings(), nullptr );
+	ASSERT_TRUE ( pSrc->Connect ( sError ) );
+	ASSERT_TRUE ( pSrc->IterateStart ( sError ) );
+	ASSERT_TRUE ( pSrc->UpdateSchema ( &tSrcSchema, sError ) );
+
+	CSphSchema tSchema;
+	for ( int i=0; i<tSrcSchema.GetFieldsCount(); i++ )
+		tSchema.AddField ( tSrcSchema.GetField(i) );
+
+	for ( int i=0; i<tSrcSchema.GetAttrsCount(); i++ )
+		tSchema.AddAttr ( tSrcSchema.GetAttr(i), false );
+
+	RtIndex_i * pIndex = sphCreateIndexRT ( tSchema, "testrt", 32 * 1024 * 1024, RT_INDEX_FILE_NAME, false );
+	pIndex->SetTokenizer ( pTok->Clone ( SPH_CLONE_INDEX ) );
+	pIndex->SetDictionary ( pDict->Clone () );
+	pIndex->PostSetup ();
+	StrVec_t dWarnings;
+	ASSERT_TRUE ( pIndex->Prealloc ( false, nullptr, dWarnings ) );
+
+	CSphString sFilter;
+	InsertDocData_t tDoc ( pIndex->GetMatchSchema() );
+	int iDynamic = pIndex->GetMatchSchema().GetRowSize();
+
+	bool bEOF = false;
+	while (true)
+	{
+		ASSERT_TRUE ( pSrc->IterateDocument ( bEOF, sError ) );
+		if ( bEOF )
+			break;
+
+		tDoc.m_dFields = pSrc->GetFields();
+		tDoc.m_tDoc.Combine ( pSrc->m_tDocInfo, iDynamic );
+		pIndex->AddDocument ( tDoc, false, sFilter, sError, sWarning, nullptr );
+	}
+	pIndex->Commit ( nullptr, nullptr );
+	pSrc->Disconnect ();
+
+	// searchd never uses 0 as a version, that means unknown
+	auto fnVersion = [pIndex] { return (uint64_t)pIndex->GetDataVersion()+1; };
+
+	RcacheSetup ( 1024*1024, 0, 60 );
+	AggrResult_t tRes;
+	RcacheTestResult ( tRes, 10 );
+
+	RcacheAdd ( "q", fnVersion(), 1, tRes );
+	ASSERT_TRUE ( RcacheTestHit ( "q", fnVersion() ) );
+
+	// attribute update
+	uint64_t uVersion = fnVersion();
+	AttrUpdateSharedPtr_t pUpd { new CSphAttrUpdate };
+	pUpd->m_dAttributes.Add ( { "tag2", SPH_ATTR_INTEGER } );
+	pUpd->m_dDocids.Add ( 1005 );
+	pUpd->m_dPool.Add ( 7 );
+	AttrUpdateInc_t tUpd ( pUpd );
+	bool bCritical = false;
+	ASSERT_EQ ( pIndex->UpdateAttributes ( tUpd, bCritical, sError, sWarning ), 1 ) << sError.cstr();
+	ASSERT_NE ( fnVersion(), uVersion );
+	ASSERT_FALSE ( RcacheTestHit ( "q", fnVersion() ) );
+
+	// kill
+	RcacheAdd ( "q", fnVersion(), 1, tRes );
+	ASSERT_TRUE ( RcacheTestHit ( "q", fnVersion() ) );
+	uVersion = fnVersion();
+	DocID_t tKilled = 1000;
+	ASSERT_TRUE ( pIndex->DeleteDocument ( { &tKilled, 1 }, sError, nullptr ) ) << sError.cstr();
+	pIndex->Commit ( nullptr, nullptr );
+	ASSERT_NE ( fnVersion(), uVersion );
+	ASSERT_FALSE ( RcacheTestHit ( "q", fnVersion() ) );
+
+	RcacheSetup ( 0, 0, 60 );
+	SafeDelete ( pIndex );
+	SafeDelete ( pSrc );
+	});
+}
+
+//////////////////////////////////////////////////////////////////////////
+// full-text tree driven by the rows of attribute filters
+
+// doclist of the given rows, returned a few docs at a time
+class RowIdTestNode_c : public ExtNode_i
+{
+public:
+	explicit			RowIdTestNode_c ( const CSphVector<RowID_t> & dRows ) : m_dRows ( dRows ) {}
+
+	void				Reset ( const ISphQwordSetup & ) final {}
+	void				HintRowID ( RowID_t tRowID ) final	{ while ( m_iRow<m_dRows.GetLength() && m_dRows[m_iRow]<tRowID ) m_iRow++; }
+	const ExtHit_t *	GetHits ( const ExtDoc_t * ) final	{ return nullptr; }
+	int					GetQwords ( ExtQwordsHash_t & ) final { return 0; }
+	void				SetQwordsIDF ( const ExtQwordsHash_t & ) final {}
+	void				GetTerms ( const ExtQwordsHash_t &, CSphVector<TermPos_t> & ) const final {}
+	bool				GotHitless() final					{ return false; }
+	uint64_t			GetWordID() const final				{ return 0; }
+	void				SetAtomPos ( int ) final {}
+	int					GetAtomPos() const final			{ return 0; }
+	void				DebugDump ( int ) final {}
+
+	const ExtDoc_t * GetDocsChunk() final
+	{
+		int iDoc = 0;
+		for ( ; iDoc<CHUNK_DOCS && m_iRow<m_dRows.GetLength(); iDoc++ )
+			m_dDocs[iDoc] = { m_dRows[m_iRow++], 1, 0.0f };
+
+		m_dDocs[iDoc].m_tRowID = INVALID_ROWID;
+		return iDoc ? m_dDocs : nullptr;
+	}
+
+private:
+	static const int	CHUNK_DOCS = 5;
+	CSphVector<RowID_t>	m_dRows;
+	int					m_iRow = 0;
+	ExtDoc_t			m_dDocs[CHUNK_DOCS+1];
+};
+
+// rows of a filter, returned a block at a time; hints only work for an ordered one
+class RowIdTestIterator_c : public RowidIterator_i
+{
+public:
+				RowIdTestIterator_c ( const CSphVector<RowID_t> & dRows, bool bOrdered ) : m_dRows ( dRows ), m_bOrdered ( bOrdered ) {}
+
+	bool HintRowID ( RowID_t tRowID ) final
+	{
+		if ( m_bOrdered )
+			while ( m_iRow<m_dRows.GetLength() && m_dRows[m_iRow]<tRowID )
+				m_iRow++;
+
+		return m_iRow<m_dRows.GetLength();
+	}
+
+	bool GetNextRowIdBlock ( RowIdBlock_t & dRowIdBlock ) final
+	{
+		if ( m_iRow>=m_dRows.GetLength() )
+			return false;
+
+		int iRows = Min ( BLOCK_ROWS, m_dRows.GetLength()-m_iRow );
+		dRowIdBlock = RowIdBlock_t ( m_dRows.Begin()+m_iRow, iRows );
+		m_iRow += iRows;
+		m_iProcessed += iRows;
+		return true;
+	}
+
+	int64_t		GetNumProcessed() const final { return m_iProcessed; }
+
+private:
+	static const int	BLOCK_ROWS = 8;
+	CSphVector<RowID_t>	m_dRows;
+	bool				m_bOrdered;
+	int					m_iRow = 0;
+	int64_t				m_iProcessed = 0;
+};
+
+static CSphVector<RowID_t> RowIdIteratorTestRun ( const CSphVector<RowID_t> & dDocs, RowIdTestIterator_c * pIterator, bool bOrdered )
+{
+	CSphScopedPtr<ExtNode_i> pNode ( CreateRowIdIteratorNode ( new RowIdTestNode_c(dDocs), pIterator, bOrdered ) );
+
+	CSphVector<RowID_t> dRes;
+	for ( const ExtDoc_t * pDoc = pNode->GetDocsChunk(); pDoc; pDoc = pNode->GetDocsChunk() )
+		for ( ; pDoc->m_tRowID!=INVALID_ROWID; pDoc++ )
+			dRes.Add ( pDoc->m_tRowID );
+
+	return dRes;
+}
+
+TEST ( rowid_iterator, intersects_tree )
+{
+	CSphVector<RowID_t> dDocs, dRows, dExpected;
+	for ( RowID_t i=0; i<1000; i+=3 )
+		dDocs.Add(i);
+
+	for ( RowID_t i=0; i<1000; i+=7 )
+		dRows.Add(i);
+
+	for ( RowID_t i=0; i<1000; i+=21 )
+		dExpected.Add(i);
+
+	// ordered rows are fetched block by block
+	{
+		auto pIterator = new RowIdTestIterator_c ( dRows, true );
+		auto dRes = RowIdIteratorTestRun ( dDocs, pIterator, true );
+		ASSERT_EQ ( dRes.GetLength(), dExpected.GetLength() );
+		for ( int i=0; i<dRes.GetLength(); i++ )
+			ASSERT_EQ ( dRes[i], dExpected[i] );
+	}
+
+	// docid lookups return rows out of order and with duplicates
+	CSphVector<RowID_t> dShuffled;
+	for ( int i=dRows.GetLength()-1; i>=0; i-=2 )
+		dShuffled.Add ( dRows[i] );
+	for ( int i=dRows.GetLength()-2; i>=0; i-=2 )
+		dShuffled.Add ( dRows[i] );
+	dShuffled.Add ( dRows[5] );
+
+	{
+		auto pIterator = new RowIdTestIterator_c ( dShuffled, false );
+		auto dRes = RowIdIteratorTestRun ( dDocs, pIterator, false );
+		ASSERT_EQ ( dRes.GetLength(), dExpected.GetLength() );
+		for ( int i=0; i<dRes.GetLength(); i++ )
+			ASSERT_EQ ( dRes[i], dExpected[i] );
+	}
+}
+
+TEST ( rowid_iterator, fetches_lazily )
+{
+	// a short doclist against a long ordered filter: rows past the doclist and between its docs are never fetched
+	CSphVector<RowID_t> dDocs, dRows;
+	dDocs.Add(5);
+	dDocs.Add(50000);
+	dDocs.Add(50001);
+
+	for ( RowID_t i=0; i<100000; i++ )
+		dRows.Add(i);
+
+	auto pIterator = new RowIdTestIterator_c ( dRows, true );
+	CSphScopedPtr<ExtNode_i> pNode ( CreateRowIdIteratorNode ( new RowIdTestNode_c(dDocs), pIterator, true ) );
+
+	CSphVector<RowID_t> dRes;
+	for ( const ExtDoc_t * pDoc = pNode->GetDocsChunk(); pDoc; pDoc = pNode->GetDocsChunk() )
+	{
+		for ( ; pDoc->m_tRowID!=INVALID_ROWID; pDoc++ )
+			dRes.Add ( pDoc->m_tRowID );
+
+		ASSERT_LT ( pIterator->GetNumProcessed(), 100 );
+	}
+
+	ASSERT_EQ ( dRes.GetLength(), 3 );
+	ASSERT_EQ ( dRes[0], 5u );
+	ASSERT_EQ ( dRes[1], 50000u );
+	ASSERT_EQ ( dRes[2], 50001u );
+}
+
+// same matches with and without the docid lookup iterator driving the full-text tree of a disk chunk
+TEST_F ( RT, RowIdIteratorVsFilters )
+{
+	using namespace testing;
+	Threads::CallCoroutine ( [&] {
+
+	DictRefPtr_c pDict { sphCreateDictionaryCRC ( tDictSettings, nullptr, pTok, "rt", false, 32, nullptr, sError ) };
+
+	tCol.m_sName = "id";
+	tCol.m_eAttrType = SPH_ATTR_BIGINT;
+	tSrcSchema.AddAttr ( tCol, true );
+
+	tCol.m_sName = "tag1";
+	tCol.m_eAttrType = SPH_ATTR_INTEGER;
+	tSrcSchema.AddAttr ( tCol, true );
+
+	auto pSrc = new MockDocRandomizer_c ( tSrcSchema );
+
+	EXPECT_CALL ( *pSrc, Connect ( _ ) ).WillOnce ( Return ( true ) );
+	EXPECT_CALL ( *pSrc, GetFieldLengths () ).Times ( 801 ).WillRepeatedly ( Return ( pSrc->m_dFieldLengths ) );
+	EXPECT_CALL ( *pSrc, Disconnect () );
+
+	pSrc->SetTokenizer ( pTok );
+	pSrc->SetDict ( pDict );
+	pSrc->Setup ( CSphSourceSettings(), nullptr );
+	ASSERT_TRUE ( pSrc->Connect ( sError ) );
+	ASSERT_TRUE ( pSrc->IterateStart ( sError ) );
+	ASSERT_TRUE ( pSrc->UpdateSchema ( &tSrcSchema, sError ) );
+
+	CSphSchema tSchema;
+	for ( int i=0; i<tSrcSchema.GetFieldsCount(); i++ )
+		tSchema.AddField ( tSrcSchema.GetField(i) );
+
+	for ( int i=0; i<tSrcSchema.GetAttrsCount(); i++ )
+		tSchema.AddAttr ( tSrcSchema.GetAttr(i), false );
+
+	RtIndex_i * pIndex = sphCreateIndexRT ( tSchema, "testrt", 32 * 1024 * 1024, RT_INDEX_FILE_NAME, false );
+	pIndex->SetTokenizer ( pTok->Clone ( SPH_CLONE_INDEX ) );
+	pIndex->SetDictionary ( pDict->Clone () );
+	pIndex->PostSetup ();
+	StrVec_t dWarnings;
+	ASSERT_TRUE ( pIndex->Prealloc ( false, nullptr, dWarnings ) );
+
+	CSphString sFilter;
+	InsertDocData_t tDoc ( pIndex->GetMatchSchema() );
+	int iDynamic = pIndex->GetMatchSchema().GetRowSize();
+
+	bool bEOF = false;
+	while (true)
+	{
+		ASSERT_TRUE ( pSrc->IterateDocument ( bEOF, sError ) );
+		if ( bEOF )
+			break;
+
+		tDoc.m_dFields = pSrc->GetFields();
+		tDoc.m_tDoc.Combine ( pSrc->m_tDocInfo, iDynamic );
+		pIndex->AddDocument ( tDoc, false, sFilter, sError, sWarning, nullptr );
+	}
+	pIndex->Commit ( nullptr, nullptr );
+	pSrc->Disconnect ();
+
+	// docid lookups and histograms only exist in disk chunks
+	ASSERT_TRUE ( pIndex->ForceDiskChunk () );
+
+	// every doc has "cat", so a few dozen filtered rows are well worth driving the tree with
+	auto fnQuery = [&] ( const CSphFilterSettings & tFilter, IndexHint_e eHint, CSphVector<SphAttr_t> & dIds )
+	{
+		CSphQuery tQuery;
+		AggrResult_t tResult;
+		CSphQueryResult tQueryResult;
+		tQueryResult.m_pMeta = &tResult;
+		CSphMultiQueryArgs tArgs ( 1 );
+		tQuery.m_sQuery = "cat";
+		tQuery.m_pQueryParser = sphCreatePlainQueryParser();
+		tQuery.m_dFilters.Add ( tFilter );
+		tQuery.m_dIndexHints.Add ( { "id", eHint } );
+
+		SphQueueSettings_t tQueueSettings ( pIndex->GetMatchSchema () );
+		SphQueueRes_t tRes;
+		CSphScopedPtr<ISphMatchSorter> pSorter ( sphCreateQueue ( tQueueSettings, tQuery, tResult.m_sError, tRes ) );
+		ASSERT_TRUE ( pSorter.Ptr() );
+		ISphMatchSorter * pRawSorter = pSorter.Ptr();
+		ASSERT_TRUE ( pIndex->MultiQuery ( tQueryResult, tQuery, { &pRawSorter, 1 }, tArgs ) ) << tResult.m_sError.cstr();
+
+		auto & tOneRes = tResult.m_dResults.Add ();
+		tOneRes.FillFromSorter ( pSorter.Ptr() );
+		const CSphAttrLocator & tLoc = pSorter->GetSchema()->GetAttr("id")->m_tLocator;
+		dIds.Resize(0);
+		for ( const auto & tMatch : tOneRes.m_dMatches )
+			dIds.Add ( tMatch.GetAttr(tLoc) );
+
+		dIds.Sort();
+		SafeDelete ( tQuery.m_pQueryParser );
+	};
+
+	CSphFilterSettings tRange;
+	tRange.m_sAttrName = "id";
+	tRange.m_eType = SPH_FILTER_RANGE;
+	tRange.m_iMinValue = 1100;
+	tRange.m_iMaxValue = 1140;
+
+	CSphFilterSettings tValues;
+	tValues.m_sAttrName = "id";
+	tValues.m_eType = SPH_FILTER_VALUES;
+	for ( int i=1003; i<1800; i+=37 )
+		tValues.m_dValues.Add(i);
+
+	for ( const auto * pFilter : { &tRange, &tValues } )
+	{
+		CSphVector<SphAttr_t> dWithIterator, dWithFilters;
+		fnQuery ( *pFilter, INDEX_HINT_FORCE, dWithIterator );
+		fnQuery ( *pFilter, INDEX_HINT_IGNORE, dWithFilters );
+
+		ASSERT_FALSE ( dWithFilters.IsEmpty() );
+		ASSERT_EQ ( dWithIterator.GetLength(), dWithFilters.GetLength() );
+		for ( int i=0; i<dWithIterator.GetLength(); i++ )
+			ASSERT_EQ ( dWithIterator[i], dWithFilters[i] );
+	}
+
+	SafeDelete ( pIndex );
+	SafeDelete ( pSrc );
+	});
+}
+
+//////////////////////////////////////////////////////////////////////////
+// doclist bitmaps
+
+struct DocBitmapTestMatch_t
+{
+	SphAttr_t	m_tID;
+	int			m_iWeight;
+
+	bool operator< ( const DocBitmapTestMatch_t & tOther ) const { return m_tID<tOther.m_tID; }
+};
+
+static void DocBitmapTestQuery ( RtIndex_i * pIndex, const char * szQuery, ESphRankMode eRanker, CSphVector<DocBitmapTestMatch_t> & dMatches )
+{
+	CSphQuery tQuery;
+	AggrResult_t tResult;
+	CSphQueryResult tQueryResult;
+	tQueryResult.m_pMeta = &tResult;
+	CSphMultiQueryArgs tArgs ( 1 );
+	tQuery.m_sQuery = szQuery;
+	tQuery.m_eRanker = eRanker;
+	tQuery.m_pQueryParser = sphCreatePlainQueryParser();
+
+	SphQueueSettings_t tQueueSettings ( pIndex->GetMatchSchema () );
+	SphQueueRes_t tRes;
+	CSphScopedPtr<ISphMatchSorter> pSorter ( sphCreateQueue ( tQueueSettings, tQuery, tResult.m_sError, tRes ) );
+	ASSERT_TRUE ( pSorter.Ptr() );
+	ISphMatchSorter * pRawSorter = pSorter.Ptr();
+	ASSERT_TRUE ( pIndex->MultiQuery ( tQueryResult, tQuery, { &pRawSorter, 1 }, tArgs ) ) << tResult.m_sError.cstr();
+
+	auto & tOneRes = tResult.m_dResults.Add ();
+	tOneRes.FillFromSorter ( pSorter.Ptr() );
+	const CSphAttrLocator & tLoc = pSorter->GetSchema()->GetAttr("id")->m_tLocator;
+	dMatches.Resize(0);
+	for ( const auto & tMatch : tOneRes.m_dMatches )
+		dMatches.Add ( { tMatch.GetAttr(tLoc), tMatch.m_iWeight } );
+
+	dMatches.Sort();
+	SafeDelete ( tQuery.m_pQueryParser );
+}
+
+// ids of rows divisible by all the given numbers; ids are rowids+1000 and rows start at 1
+static void DocBitmapTestCheck ( RtIndex_i * pIndex, const char * szQuery, int iDiv, ESphRankMode eRanker, int iWeight )
+{
+	CSphVector<DocBitmapTestMatch_t> dMatches;
+	DocBitmapTestQuery ( pIndex, szQuery, eRanker, dMatches );
+
+	int iMatch = 0;
+	for ( int iRow=iDiv; iRow<=801; iRow+=iDiv, iMatch++ )
+	{
+		ASSERT_LT ( iMatch, dMatches.GetLength() ) << szQuery;
+		ASSERT_EQ ( dMatches[iMatch].m_tID, iRow+1000 ) << szQuery;
+		ASSERT_EQ ( dMatches[iMatch].m_iWeight, iWeight ) << szQuery;
+	}
+	ASSERT_EQ ( dMatches.GetLength(), iMatch ) << szQuery;
+}
+
+TEST_F ( RT, DocBitmapAnd )
+{
+	using namespace testing;
+	Threads::CallCoroutine ( [&] {
+
+	DictRefPtr_c pDict { sphCreateDictionaryCRC ( tDictSettings, nullptr, pTok, "rt", false, 32, nullptr, sError ) };
+
+	tCol.m_sName = "id";
+	tCol.m_eAttrType = SPH_ATTR_BIGINT;
+	tSrcSchema.AddAttr ( tCol, true );
+
+	tCol.m_sName = "tag1";
+	tCol.m_eAttrType = SPH_ATTR_INTEGER;
+	tSrcSchema.AddAttr ( tCol, true );
+
+	auto pSrc = new MockDocRandomizer_c ( tSrcSchema );
+
+	EXPECT_CALL ( *pSrc, Connect ( _ ) ).WillOnce ( Return ( true ) );
+	EXPECT_CALL ( *pSrc, GetFieldLengths () ).Times ( 801 ).WillRepeatedly ( Return ( pSrc->m_dFieldLengths ) );
+	EXPECT_CALL ( *pSrc, Disconnect () );
+
+	pSrc->SetTokenizer ( pTok );
+	pSrc->SetDict ( pDict );
+	pSrc->Setup ( CSphSourceSettings(), nullptr );
+	ASSERT_TRUE ( pSrc->Connect ( sError ) );
+	ASSERT_TRUE ( pSrc->IterateStart ( sError ) );
+	ASSERT_TRUE ( pSrc->UpdateSchema ( &tSrcSchema, sError ) );
+
+	CSphSchema tSchema;
+	for ( int i=0; i<tSrcSchema.GetFieldsCount(); i++ )
+		tSchema.AddField ( tSrcSchema.GetField(i) );
+
+	for ( int i=0; i<tSrcSchema.GetAttrsCount(); i++ )
+		tSchema.AddAttr ( tSrcSchema.GetAttr(i), false );
+
+	RtIndex_i * pIndex = sphCreateIndexRT ( tSchema, "testrt", 32 * 1024 * 1024, RT_INDEX_FILE_NAME, false );
+	pIndex->SetTokenizer ( pTok->Clone ( SPH_CLONE_INDEX ) );
+	pIndex->SetDictionary ( pDict->Clone () );
+	pIndex->PostSetup ();
+	StrVec_t dWarnings;
+	ASSERT_TRUE ( pIndex->Prealloc ( false, nullptr, dWarnings ) );
+
+	CSphString sFilter;
+	InsertDocData_t tDoc ( pIndex->GetMatchSchema() );
+	int iDynamic = pIndex->GetMatchSchema().GetRowSize();
+
+	// every term is frequent enough for bitmaps; "seven" only lives in the content field
+	bool bEOF = false;
+	while (true)
+	{
+		ASSERT_TRUE ( pSrc->IterateDocument ( bEOF, sError ) );
+		if ( bEOF )
+			break;
+
+		int iRow = (int)pSrc->m_tDocInfo.m_tRowID;
+		snprintf ( pSrc->m_dFields[0], MockDocRandomizer_c::m_iMaxFieldLen, "cat%s%s", iRow%3 ? "" : " three", iRow%5 ? "" : " five" );
+		snprintf ( pSrc->m_dFields[1], MockDocRandomizer_c::m_iMaxFieldLen, "dog%s", iRow%7 ? "" : " seven" );
+
+		tDoc.m_dFields = pSrc->GetFields();
+		tDoc.m_tDoc.Combine ( pSrc->m_tDocInfo, iDynamic );
+		pIndex->AddDocument ( tDoc, false, sFilter, sError, sWarning, nullptr );
+	}
+	pIndex->Commit ( nullptr, nullptr );
+	pSrc->Disconnect ();
+
+	// bitmaps are only built for disk chunks
+	ASSERT_TRUE ( pIndex->ForceDiskChunk () );
+
+	auto fnCheckAll = [pIndex]
+	{
+		// ranker=none only probes the bitmaps; others still advance the doclists, as fieldmask needs their hits
+		for ( auto eRanker : { SPH_RANK_NONE, SPH_RANK_FIELDMASK } )
+		{
+			bool bNone = eRanker==SPH_RANK_NONE;
+			DocBitmapTestCheck ( pIndex, "three five", 15, eRanker, 1 );
+			DocBitmapTestCheck ( pIndex, "cat three five", 15, eRanker, 1 );
+			DocBitmapTestCheck ( pIndex, "seven three", 21, eRanker, bNone ? 1 : 3 );
+			DocBitmapTestCheck ( pIndex, "dog five cat seven three", 105, eRanker, bNone ? 1 : 3 );
+		}
+
+		// the same rows as the scoring rankers see them
+		CSphVector<DocBitmapTestMatch_t> dNone, dBM25;
+		DocBitmapTestQuery ( pIndex, "five dog three", SPH_RANK_NONE, dNone );
+		DocBitmapTestQuery ( pIndex, "five dog three", SPH_RANK_PROXIMITY_BM25, dBM25 );
+		ASSERT_EQ ( dNone.GetLength(), dBM25.GetLength() );
+		for ( int i=0; i<dNone.GetLength(); i++ )
+			ASSERT_EQ ( dNone[i].m_tID, dBM25[i].m_tID );
+	};
+
+	// no cache means no bitmaps
+	fnCheckAll();
+
+	// first pass decodes the bitmaps, second one takes them from the cache
+	InitDocBitmapCache ( 1048576 );
+	fnCheckAll();
+	fnCheckAll();
+
+	// cache too small to hold any bitmap
+	ShutdownDocBitmapCache();
+	InitDocBitmapCache ( 64 );
+	fnCheckAll();
+
+	// cached bitmaps must be dropped along with the index
+	ShutdownDocBitmapCache();
+	InitDocBitmapCache ( 1048576 );
+	fnCheckAll();
+	SafeDelete ( pIndex );
+	ShutdownDocBitmapCache();
+
+	SafeDelete ( pSrc );
+	});
+}
+
+//////////////////////////////////////////////////////////////////////////
+// rollups
+
+struct RollupTestGroup_t
+{
+	SphAttr_t	m_tKey;
+	SphAttr_t	m_iCount;
+	SphAttr_t	m_iSum;
+	SphAttr_t	m_iMin;
+	SphAttr_t	m_iMax;
+};
+
+// grouped full-scan of the rollup; a cutoff keeps the query off the rollup, so it scans the rows
+static void RollupTestQuery ( RtIndex_i * pIndex, bool bRollup, CSphVector<RollupTestGroup_t> & dGroups )
+{
+	CSphQuery tQuery;
+	AggrResult_t tResult;
+	CSphQueryResult tQueryResult;
+	tQueryResult.m_pMeta = &tResult;
+	CSphMultiQueryArgs tArgs ( 1 );
+	tQuery.m_pQueryParser = sphCreatePlainQueryParser();
+	tQuery.m_sGroupBy = "tag1";
+	tQuery.m_sGroupSortBy = "@groupby asc";
+	tQuery.m_iCutoff = bRollup ? 0 : 1000000;
+
+	auto fnAddItem = [&tQuery] ( const char * szExpr, const char * szAlias, ESphAggrFunc eFunc )
+	{
+		CSphQueryItem & tItem = tQuery.m_dItems.Add();
+		tItem.m_sExpr = szExpr;
+		tItem.m_sAlias = szAlias;
+		tItem.m_eAggrFunc = eFunc;
+	};
+
+	fnAddItem ( "tag1", "tag1", SPH_AGGR_NONE );
+	fnAddItem ( "tag2", "s", SPH_AGGR_SUM );
+	fnAddItem ( "tag2", "mn", SPH_AGGR_MIN );
+	fnAddItem ( "tag2", "mx", SPH_AGGR_MAX );
+
+	SphQueueSettings_t tQueueSettings ( pIndex->GetMatchSchema () );
+	tQueueSettings.m_bComputeItems = true;
+	SphQueueRes_t tRes;
+	CSphScopedPtr<ISphMatchSorter> pSorter ( sphCreateQueue ( tQueueSettings, tQuery, tResult.m_sError, tRes ) );
+	ASSERT_TRUE ( pSorter.Ptr() ) << tResult.m_sError.cstr();
+	ISphMatchSorter * pRawSorter = pSorter.Ptr();
+	ASSERT_TRUE ( pIndex->MultiQuery ( tQueryResult, tQuery, { &pRawSorter, 1 }, tArgs ) ) << tResult.m_sError.cstr();
+
+	auto & tOneRes = tResult.m_dResults.Add ();
+	tOneRes.FillFromSorter ( pSorter.Ptr() );
+
+	const ISphSchema & tSchema = *pSorter->GetSchema();
+	dGroups.Resize(0);
+	for ( const auto & tMatch : tOneRes.m_dMatches )
+		dGroups.Add ( { tMatch.GetAttr ( tSchema.GetAttr("@groupby")->m_tLocator ), tMatch.GetAttr ( tSchema.GetAttr("@count")->m_tLocator ),
+			tMatch.GetAttr ( tSchema.GetAttr("s")->m_tLocator ), tMatch.GetAttr ( tSchema.GetAttr("mn")->m_tLocator ), tMatch.GetAttr ( tSchema.GetAttr("mx")->m_tLocator ) } );
+
+	dGroups.Sort ( bind ( &RollupTestGroup_t::m_tKey ) );
+	SafeDelete ( tQuery.m_pQueryParser );
+}
+
+static void RollupTestCompare ( RtIndex_i * pIndex, const char * szStage )
+{
+	CSphVector<RollupTestGroup_t> dRollup, dScan;
+	RollupTestQuery ( pIndex, true, dRollup );
+	RollupTestQuery ( pIndex, false, dScan );
+
+	ASSERT_FALSE ( dScan.IsEmpty() ) << szStage;
+	ASSERT_EQ ( dRollup.GetLength(), dScan.GetLength() ) << szStage;
+	ARRAY_FOREACH ( i, dScan )
+	{
+		ASSERT_EQ ( dRollup[i].m_tKey, dScan[i].m_tKey ) << szStage;
+		ASSERT_EQ ( dRollup[i].m_iCount, dScan[i].m_iCount ) << szStage << ", group " << dScan[i].m_tKey;
+		ASSERT_EQ ( dRollup[i].m_iSum, dScan[i].m_iSum ) << szStage << ", group " << dScan[i].m_tKey;
+		ASSERT_EQ ( dRollup[i].m_iMin, dScan[i].m_iMin ) << szStage << ", group " << dScan[i].m_tKey;
+		ASSERT_EQ ( dRollup[i].m_iMax, dScan[i].m_iMax ) << szStage << ", group " << dScan[i].m_tKey;
+	}
+}
+
+// rollup answers match a scan of the rows while a disk chunk and RAM segments take inserts, kills and updates
+TEST_F ( RT, RollupVsScan )
+{
+	using namespace testing;
+	Threads::CallCoroutine ( [&] {
+
+	DictRefPtr_c pDict { sphCreateDictionaryCRC ( tDictSettings, nullptr, pTok, "rt", false, 32, nullptr, sError ) };
+
+	tCol.m_sName = "id";
+	tCol.m_eAttrType = SPH_ATTR_BIGINT;
+	tSrcSchema.AddAttr ( tCol, true );
+
+	tCol.m_sName = "tag1";
+	tCol.m_eAttrType = SPH_ATTR_INTEGER;
+	tSrcSchema.AddAttr ( tCol, true );
+
+	tCol.m_sName = "tag2";
+	tCol.m_eAttrType = SPH_ATTR_INTEGER;
+	tSrcSchema.AddAttr ( tCol, true );
+
+	auto pSrc = new MockDocRandomizer_c ( tSrcSchema );
+
+	EXPECT_CALL ( *pSrc, Connect ( _ ) ).WillOnce ( Return ( true ) );
+	EXPECT_CALL ( *pSrc, GetFieldLengths () ).Times ( 801 ).WillRepeatedly ( Return ( pSrc->m_dFieldLengths ) );
+	EXPECT_CALL ( *pSrc, Disconnect () );
+
+	pSrc->SetTokenizer ( pTok );
+	pSrc->SetDict ( pDict );
+	pSrc->Setup ( CSphSourceSettings(), nullptr );
+	ASSERT_TRUE ( pSrc->Connect ( sError ) );
+	ASSERT_TRUE ( pSrc->IterateStart ( sError ) );
+	ASSERT_TRUE ( pSrc->UpdateSchema ( &tSrcSchema, sError ) );
+
+	CSphSchema tSchema;
+	for ( int i=0; i<tSrcSchema.GetFieldsCount(); i++ )
+		tSchema.AddField ( tSrcSchema.GetField(i) );
+
+	for ( int i=0; i<tSrcSchema.GetAttrsCount(); i++ )
+		tSchema.AddAttr ( tSrcSchema.GetAttr(i), false );
+
+	// the rollup is declared in the runtime settings, which the index picks up on prealloc
+	CSphString sSettings;
+	sSettings.SetSprintf ( "%s.settings", RT_INDEX_FILE_NAME );
+	{
+		CSphWriter tWriter;
+		ASSERT_TRUE ( tWriter.OpenFile ( sSettings, sError ) ) << sError.cstr();
+		const char * szSettings = "{\"rollup\":\"tag1: count(*), sum(tag2), min(tag2), max(tag2)\"}";
+		tWriter.PutBytes ( szSettings, (int)strlen(szSettings) );
+	}
+
+	RtIndex_i * pIndex = sphCreateIndexRT ( tSchema, "testrt", 32 * 1024 * 1024, RT_INDEX_FILE_NAME, false );
+	pIndex->SetTokenizer ( pTok->Clone ( SPH_CLONE_INDEX ) );
+	pIndex->SetDictionary ( pDict->Clone () );
+	pIndex->PostSetup ();
+	StrVec_t dWarnings;
+	ASSERT_TRUE ( pIndex->Prealloc ( false, nullptr, dWarnings ) );
+
+	CSphString sFilter;
+	InsertDocData_t tDoc ( pIndex->GetMatchSchema() );
+	int iDynamic = pIndex->GetMatchSchema().GetRowSize();
+
+	auto fnAdd = [&] ( SphAttr_t tID )
+	{
+		pSrc->m_tDocInfo.SetAttr ( tSrcSchema.GetAttr(0).m_tLocator, tID );
+		pSrc->m_tDocInfo.SetAttr ( tSrcSchema.GetAttr(1).m_tLocator, tID % 7 );
+		pSrc->m_tDocInfo.SetAttr ( tSrcSchema.GetAttr(2).m_tLocator, ( tID*31 ) % 101 );
+		tDoc.m_tDoc.Combine ( pSrc->m_tDocInfo, iDynamic );
+		pIndex->AddDocument ( tDoc, false, sFilter, sError, sWarning, nullptr );
+	};
+
+	// first half goes to a disk chunk, the rest stays in RAM
+	bool bEOF = false;
+	while (true)
+	{
+		ASSERT_TRUE ( pSrc->IterateDocument ( bEOF, sError ) );
+		if ( bEOF )
+			break;
+
+		tDoc.m_dFields = pSrc->GetFields();
+		fnAdd ( pSrc->m_tDocInfo.GetAttr ( tSrcSchema.GetAttr(0).m_tLocator ) );
+		if ( pSrc->m_iDocsCounter==400 )
+		{
+			pIndex->Commit ( nullptr, nullptr );
+			ASSERT_TRUE ( pIndex->ForceDiskChunk () );
+		}
+	}
+	pIndex->Commit ( nullptr, nullptr );
+	pSrc->Disconnect ();
+
+	RollupTestCompare ( pIndex, "initial" );
+
+	// a new segment on top of the ones with states already built
+	for ( SphAttr_t tID = 5000; tID<5050; ++tID )
+		fnAdd ( tID );
+	pIndex->Commit ( nullptr, nullptr );
+	RollupTestCompare ( pIndex, "insert" );
+
+	// kills in the disk chunk (ids 1001..1400) and in RAM; plain rows retract, group maximums (1225 on disk, 1730 in RAM) drop the states
+	CSphVector<DocID_t> dKilled;
+	for ( DocID_t tID : { 1001, 1002, 1100, 1225, 1600, 1601, 1730, 5007 } )
+		dKilled.Add ( tID );
+	ASSERT_TRUE ( pIndex->DeleteDocument ( dKilled, sError, nullptr ) ) << sError.cstr();
+	pIndex->Commit ( nullptr, nullptr );
+	RollupTestCompare ( pIndex, "kill" );
+
+	// updates of an aggregated attribute
+	AttrUpdateSharedPtr_t pUpd { new CSphAttrUpdate };
+	pUpd->m_dAttributes.Add ( { "tag2", SPH_ATTR_INTEGER } );
+	for ( DocID_t tID : { 1010, 1700, 5010 } )
+	{
+		pUpd->m_dDocids.Add ( tID );
+		pUpd->m_dPool.Add ( 1000 );
+	}
+	AttrUpdateInc_t tUpd ( pUpd );
+	bool bCritical = false;
+	ASSERT_EQ ( pIndex->UpdateAttributes ( tUpd, bCritical, sError, sWarning ), 3 ) << sError.cstr();
+	RollupTestCompare ( pIndex, "update" );
+
+	// kills after the states were rebuilt
+	dKilled.Resize(0);
+	for ( DocID_t tID : { 1010, 1200, 1750, 5020 } )
+		dKilled.Add ( tID );
+	ASSERT_TRUE ( pIndex->DeleteDocument ( dKilled, sError, nullptr ) ) << sError.cstr();
+	pIndex->Commit ( nullptr, nullptr );
+	RollupTestCompare ( pIndex, "kill after update" );
+
+	SafeDelete ( pIndex );
+	SafeDelete ( pSrc );
+	::unlink ( sSettings.cstr() );
+	});
+}
+
+//////////////////////////////////////////////////////////////////////////
+// binlog
+
+#define BINLOG_TEST_PATH "test_binlog"
+
+static void BinlogTestStart ( bool bCommon, CSphIndex * pIndex )
+{
+	CSphConfigSection tConf;
+	tConf.AddEntry ( "binlog_path", BINLOG_TEST_PATH );
+	tConf.AddEntry ( "binlog_common", bCommon ? "1" : "0" );
+
+	Binlog::Deinit();
+	Binlog::Init ( tConf, true );
+	Binlog::Configure ( tConf, true, Binlog::REPLAY_IGNORE_TRX_ERROR );
+
+	SmallStringHash_T<CSphIndex *> hIndexes;
+	if ( pIndex )
+		hIndexes.Add ( pIndex, pIndex->GetName() );
+	Binlog::Replay ( hIndexes );
+}
+
+static void BinlogTestCleanup()
+{
+	for ( const auto & sFile : FindFiles ( BINLOG_TEST_PATH "/testrt/*" ) )
+		::unlink ( sFile.cstr() );
+	::rmdir ( BINLOG_TEST_PATH "/testrt" );
+
+	for ( const auto & sFile : FindFiles ( BINLOG_TEST_PATH "/*" ) )
+		::unlink ( sFile.cstr() );
+	::rmdir ( BINLOG_TEST_PATH );
+}
+
+// dropped index must not leave its logs behind: neither in the common log nor in its own directory
+TEST_F ( RT, BinlogDropCreateReplay )
+{
+	Threads::CallCoroutine ( [&] {
+
+	DictRefPtr_c pDict { sphCreateDictionaryCRC ( tDictSettings, nullptr, pTok, "rt", false, 32, nullptr, sError ) };
+
+	CSphSchema tSchema;
+	tSchema.AddField ( "title" );
+	tCol.m_sName = "id";
+	tCol.m_eAttrType = SPH_ATTR_BIGINT;
+	tSchema.AddAttr ( tCol, false );
+
+	// every incarnation starts from scratch, at TID 0
+	auto fnCreate = [&]() -> RtIndex_i *
+	{
+		DeleteIndexFiles ( RT_INDEX_FILE_NAME );
+		RtIndex_i * pIndex = sphCreateIndexRT ( tSchema, "testrt", 32 * 1024 * 1024, RT_INDEX_FILE_NAME, false );
+		pIndex->SetTokenizer ( pTok->Clone ( SPH_CLONE_INDEX ) );
+		pIndex->SetDictionary ( pDict->Clone () );
+		pIndex->PostSetup ();
+		StrVec_t dWarnings;
+		EXPECT_TRUE ( pIndex->Prealloc ( false, nullptr, dWarnings ) );
+		return pIndex;
+	};
+
+	// one transaction per doc
+	auto fnInsert = [&] ( RtIndex_i * pIndex, DocID_t tFirst, int iDocs )
+	{
+		CSphString sFilter;
+		InsertDocData_t tDoc ( pIndex->GetMatchSchema() );
+		for ( int i=0; i<iDocs; i++ )
+		{
+			tDoc.SetID ( tFirst+i );
+			tDoc.m_dFields[0] = { "hello", 5 };
+			pIndex->AddDocument ( tDoc, false, sFilter, sError, sWarning, nullptr );
+			pIndex->Commit ( nullptr, nullptr );
+		}
+	};
+
+	// ram chunk of a crashed daemon is lost, so whatever replay brings is all the index has
+	auto fnCrashAndReplay = [&] ( bool bCommon, RtIndex_i * pIndex ) -> int64_t
+	{
+		Binlog::Deinit();
+		SafeDelete ( pIndex );
+
+		pIndex = fnCreate();
+		BinlogTestStart ( bCommon, pIndex );
+		int64_t iTID = pIndex->m_iTID;
+
+		// drop it for good, so that nothing is left for the next run
+		pIndex->IndexDeleted();
+		Binlog::ForgetIndex ( "testrt" );
+		SafeDelete ( pIndex );
+		return iTID;
+	};
+
+	BinlogTestCleanup();
+	ASSERT_TRUE ( MkDir ( BINLOG_TEST_PATH ) );
+
+	for ( bool bCommon : { true, false } )
+	{
+		BinlogTestStart ( bCommon, nullptr );
+
+		// DROP, then CREATE with the same name; only the transaction of the new index is replayed
+		RtIndex_i * pIndex = fnCreate();
+		fnInsert ( pIndex, 1, 3 );
+		pIndex->IndexDeleted();
+		Binlog::ForgetIndex ( "testrt" );
+		SafeDelete ( pIndex );
+
+		Binlog::ForgetIndex ( "testrt" );
+		pIndex = fnCreate();
+		fnInsert ( pIndex, 10, 1 );
+		ASSERT_EQ ( fnCrashAndReplay ( bCommon, pIndex ), 1 ) << ( bCommon ? "common" : "per-index" );
+	}
+
+	// logs left in the directory of an index that was not served on replay are not picked up by the new stream
+	BinlogTestStart ( false, nullptr );
+	RtIndex_i * pIndex = fnCreate();
+	fnInsert ( pIndex, 1, 3 );
+	Binlog::Deinit();
+	SafeDelete ( pIndex );
+
+	BinlogTestStart ( false, nullptr );
+	pIndex = fnCreate();
+	fnInsert ( pIndex, 10, 1 );
+	ASSERT_EQ ( fnCrashAndReplay ( false, pIndex ), 1 );
+
+	Binlog::Deinit();
+	BinlogTestCleanup();
+	});
+}
+
+// run a full-text query over all the docs, either reading tag1 of every doc, or updating it for every match
+static void UpdateTestQuery ( RtIndex_i * pIndex, CSphAttrUpdateEx * pUpdate, CSphFixedVector<SphAttr_t> & dTags )
+{
+	CSphQuery tQuery;
+	AggrResult_t tResult;
+	CSphQueryResult tQueryResult;
+	tQueryResult.m_pMeta = &tResult;
+	CSphMultiQueryArgs tArgs ( 1 );
+	tQuery.m_sQuery = "cat";
+	tQuery.m_pQueryParser = sphCreatePlainQueryParser();
+
+	// update queue used to apply the matches by max_matches batches, one binlog record per every batch
+	SphQueueSettings_t tQueueSettings ( pIndex->GetMatchSchema () );
+	tQueueSettings.m_pUpdate = pUpdate;
+	if ( pUpdate )
+		tQueueSettings.m_iMaxMatches = 20;
+
+	SphQueueRes_t tRes;
+	CSphScopedPtr<ISphMatchSorter> pSorter ( sphCreateQueue ( tQueueSettings, tQuery, tResult.m_sError, tRes ) );
+	ASSERT_TRUE ( pSorter.Ptr() );
+	ISphMatchSorter * pRawSorter = pSorter.Ptr();
+	ASSERT_TRUE ( pIndex->MultiQuery ( tQueryResult, tQuery, { &pRawSorter, 1 }, tArgs ) ) << tResult.m_sError.cstr();
+
+	auto & tOneRes = tResult.m_dResults.Add ();
+	tOneRes.FillFromSorter ( pSorter.Ptr() );
+	SafeDelete ( tQuery.m_pQueryParser );
+	if ( pUpdate )
+		return;
+
+	const CSphAttrLocator & tIdLoc = pSorter->GetSchema()->GetAttr("id")->m_tLocator;
+	const CSphAttrLocator & tTagLoc = pSorter->GetSchema()->GetAttr("tag1")->m_tLocator;
+	dTags.Fill ( -1 );
+	for ( const auto & tMatch : tOneRes.m_dMatches )
+		dTags[tMatch.GetAttr(tIdLoc)-1001] = tMatch.GetAttr(tTagLoc);
+}
+
+// bulk updates resolve rows of all the disk chunks in parallel, and go to the binlog as one record
+TEST_F ( RT, UpdateDiskChunks )
+{
+	using namespace testing;
+	Threads::CallCoroutine ( [&] {
+
+	DictRefPtr_c pDict { sphCreateDictionaryCRC ( tDictSettings, nullptr, pTok, "rt", false, 32, nullptr, sError ) };
+
+	tCol.m_sName = "id";
+	tCol.m_eAttrType = SPH_ATTR_BIGINT;
+	tSrcSchema.AddAttr ( tCol, true );
+
+	tCol.m_sName = "tag1";
+	tCol.m_eAttrType = SPH_ATTR_INTEGER;
+	tSrcSchema.AddAttr ( tCol, true );
+
+	auto pSrc = new MockDocRandomizer_c ( tSrcSchema );
+
+	EXPECT_CALL ( *pSrc, Connect ( _ ) ).WillOnce ( Return ( true ) );
+	EXPECT_CALL ( *pSrc, GetFieldLengths () ).Times ( 801 ).WillRepeatedly ( Return ( pSrc->m_dFieldLengths ) );
+	EXPECT_CALL ( *pSrc, Disconnect () );
+
+	pSrc->SetTokenizer ( pTok );
+	pSrc->SetDict ( pDict );
+	pSrc->Setup ( CSphSourceSettings(), nullptr );
+	ASSERT_TRUE ( pSrc->Connect ( sError ) );
+	ASSERT_TRUE ( pSrc->IterateStart ( sError ) );
+	ASSERT_TRUE ( pSrc->UpdateSchema ( &tSrcSchema, sError ) );
+
+	CSphSchema tSchema;
+	for ( int i=0; i<tSrcSchema.GetFieldsCount(); i++ )
+		tSchema.AddField ( tSrcSchema.GetField(i) );
+
+	for ( int i=0; i<tSrcSchema.GetAttrsCount(); i++ )
+		tSchema.AddAttr ( tSrcSchema.GetAttr(i), false );
+
+	// updates only advance the TID when they are binlogged
+	BinlogTestCleanup();
+	ASSERT_TRUE ( MkDir ( BINLOG_TEST_PATH ) );
+	BinlogTestStart ( true, nullptr );
+
+	RtIndex_i * pIndex = sphCreateIndexRT ( tSchema, "testrt", 32 * 1024 * 1024, RT_INDEX_FILE_NAME, false );
+	pIndex->SetTokenizer ( pTok->Clone ( SPH_CLONE_INDEX ) );
+	pIndex->SetDictionary ( pDict->Clone () );
+	pIndex->PostSetup ();
+	StrVec_t dWarnings;
+	ASSERT_TRUE ( pIndex->Prealloc ( false, nullptr, dWarnings ) );
+
+	CSphString sFilter;
+	InsertDocData_t tDoc ( pIndex->GetMatchSchema() );
+	int iDynamic = pIndex->GetMatchSchema().GetRowSize();
+
+	// 4 disk chunks of 200 docs (ids 1001..1800), and the last doc in RAM
+	bool bEOF = false;
+	while (true)
+	{
+		ASSERT_TRUE ( pSrc->IterateDocument ( bEOF, sError ) );
+		if ( bEOF )
+			break;
+
+		tDoc.m_dFields = pSrc->GetFields();
+		tDoc.m_tDoc.Combine ( pSrc->m_tDocInfo, iDynamic );
+		pIndex->AddDocument ( tDoc, false, sFilter, sError, sWarning, nullptr );
+		if ( pSrc->m_iDocsCounter%200==0 )
+		{
+			pIndex->Commit ( nullptr, nullptr );
+			ASSERT_TRUE ( pIndex->ForceDiskChunk () );
+		}
+	}
+	pIndex->Commit ( nullptr, nullptr );
+	pSrc->Disconnect ();
+
+	CSphFixedVector<SphAttr_t> dTags ( 801 );
+	UpdateTestQuery ( pIndex, nullptr, dTags );
+	for ( auto tTag : dTags )
+		ASSERT_EQ ( tTag, 1313 );
+
+	// docids of every chunk and of the RAM segment, and one that is not there at all
+	AttrUpdateSharedPtr_t pUpd { new CSphAttrUpdate };
+	pUpd->m_dAttributes.Add ( { "tag1", SPH_ATTR_INTEGER } );
+	for ( DocID_t tID : { 1801, 1005, 1250, 9999, 1499, 1600, 1777 } )
+	{
+		pUpd->m_dDocids.Add ( tID );
+		pUpd->m_dRowOffset.Add ( pUpd->m_dPool.GetLength() );
+		pUpd->m_dPool.Add ( DWORD ( tID*2 ) );
+	}
+
+	int64_t iTID = pIndex->m_iTID;
+	AttrUpdateInc_t tUpd ( pUpd );
+	bool bCritical = false;
+	ASSERT_EQ ( pIndex->UpdateAttributes ( tUpd, bCritical, sError, sWarning ), 6 ) << sError.cstr();
+	ASSERT_EQ ( pIndex->m_iTID, iTID+1 );
+
+	UpdateTestQuery ( pIndex, nullptr, dTags );
+	ARRAY_FOREACH ( i, dTags )
+	{
+		SphAttr_t tID = i+1001;
+		bool bUpdated = tID==1801 || tID==1005 || tID==1250 || tID==1499 || tID==1600 || tID==1777;
+		ASSERT_EQ ( dTags[i], bUpdated ? tID*2 : 1313 ) << "id " << tID;
+	}
+
+	// update by matches: all 801 docs with max_matches of 20 make one update and one binlog record
+	CSphAttrUpdateEx tUpdateEx;
+	tUpdateEx.m_pUpdate = new CSphAttrUpdate;
+	tUpdateEx.m_pUpdate->m_dAttributes.Add ( { "tag1", SPH_ATTR_INTEGER } );
+	tUpdateEx.m_pUpdate->m_dPool.Add ( 7 );
+	tUpdateEx.m_pIndex = pIndex;
+	tUpdateEx.m_pError = &sError;
+	tUpdateEx.m_pWarning = &sWarning;
+
+	iTID = pIndex->m_iTID;
+	UpdateTestQuery ( pIndex, &tUpdateEx, dTags );
+	ASSERT_EQ ( tUpdateEx.m_iAffected, 801 ) << sError.cstr();
+	ASSERT_EQ ( pIndex->m_iTID, iTID+1 );
+
+	UpdateTestQuery ( pIndex, nullptr, dTags );
+	for ( auto tTag : dTags )
+		ASSERT_EQ ( tTag, 7 );
+
+	SafeDelete ( pIndex );
+	SafeDelete ( pSrc );
+	Binlog::Deinit();
+	BinlogTestCleanup();
+	for ( const auto & sFile : FindFiles ( RT_INDEX_FILE_NAME ".*" ) )
+		::unlink ( sFile.cstr() );
+	});
+}
+
+//////////////////////////////////////////////////////////////////////////
+// docstore
+
+static const char * DOCSTORE_TEST_FILE = "test_docstore.spds";
+
+// text of a field of a row: some fields are empty, some bodies are bigger than a block
+static CSphString DocstoreTestField ( int iRow, int iField )
+{
+	CSphString sRes;
+	switch ( iField )
+	{
+	case 0:		sRes.SetSprintf ( "title %d", iRow ); break;
+	case 1:
+	{
+		int iLen = iRow%50==7 ? 3000 : 10+iRow%100;
+		CSphFixedVector<char> dBody ( iLen+1 );
+		for ( int i=0; i<iLen; ++i )
+			dBody[i] = char ( 'a' + ( iRow+i ) % 26 );
+		dBody[iLen] = '\0';
+		sRes = dBody.Begin();
+		break;
+	}
+	default:	if ( iRow%3 ) sRes.SetSprintf ( "tag%d tag%d", iRow%7, iRow%11 ); break;
+	}
+	return sRes;
+}
+
+static void DocstoreTestCheck ( const Docstore_i & tDocstore, int iRows, const VecTraits_T<int> * pFieldIds, int iFields )
+{
+	for ( int iRow=0; iRow<iRows; ++iRow )
+	{
+		DocstoreDoc_t tDoc = tDocstore.GetDoc ( iRow, pFieldIds, -1, false );
+		int iRequested = pFieldIds ? pFieldIds->GetLength() : iFields;
+		ASSERT_EQ ( tDoc.m_dFields.GetLength(), iRequested );
+		for ( int i=0; i<iRequested; ++i )
+		{
+			CSphString sExpected = DocstoreTestField ( iRow, pFieldIds ? (*pFieldIds)[i] : i );
+			const auto & dField = tDoc.m_dFields[i];
+			ASSERT_EQ ( dField.GetLength(), sExpected.Length() ) << "row " << iRow << ", field " << i;
+			ASSERT_TRUE ( !dField.GetLength() || !memcmp ( dField.Begin(), sExpected.cstr(), dField.GetLength() ) ) << "row " << iRow << ", field " << i;
+		}
+	}
+}
+
+static const int64_t MERGE_MB = 1024*1024;
+
+static ChunkMergeStats_t MergeTestChunk ( int iId, int64_t iSizeMb, int64_t iDiskUseMb=0 )
+{
+	if ( !iDiskUseMb )
+		iDiskUseMb = iSizeMb;
+
+	return { iId, iSizeMb*MERGE_MB, iDiskUseMb*MERGE_MB, iSizeMb*1000, ( iDiskUseMb-iSizeMb )*1000 };
+}
+
+TEST ( optimize, write_amplification )
+{
+	// tiny chunks are counted as floor sized, so the ratio never gets below 2
+	ASSERT_DOUBLE_EQ ( MergeWriteAmplification ( { 0, 1024, 1024, 1, 0 }, { 1, 10, 10, 1, 0 } ), 2.0 );
+	ASSERT_DOUBLE_EQ ( MergeWriteAmplification ( MergeTestChunk ( 0, 10 ), MergeTestChunk ( 1, 10 ) ), 2.0 );
+	ASSERT_DOUBLE_EQ ( MergeWriteAmplification ( MergeTestChunk ( 0, 100 ), MergeTestChunk ( 1, 10 ) ), 11.0 );
+	ASSERT_DOUBLE_EQ ( MergeWriteAmplification ( MergeTestChunk ( 0, 10 ), MergeTestChunk ( 1, 100 ) ), 11.0 );
+}
+
+TEST ( optimize, prefers_dead_rows )
+{
+	// same sizes everywhere; only the last pair reclaims space
+	CSphVector<ChunkMergeStats_t> dChunks;
+	dChunks.Add ( MergeTestChunk ( 0, 10 ) );
+	dChunks.Add ( MergeTestChunk ( 1, 10 ) );
+	dChunks.Add ( MergeTestChunk ( 2, 10, 50 ) );
+	dChunks.Add ( MergeTestChunk ( 3, 10, 50 ) );
+	ASSERT_EQ ( GetBestMergePair ( dChunks, 0 ), std::make_pair ( 2, 3 ) );
+
+	// no dead rows; balanced small pair wins over rewriting the big chunk
+	dChunks.Reset();
+	dChunks.Add ( MergeTestChunk ( 0, 1000 ) );
+	dChunks.Add ( MergeTestChunk ( 1, 10 ) );
+	dChunks.Add ( MergeTestChunk ( 2, 10 ) );
+	ASSERT_EQ ( GetBestMergePair ( dChunks, 0 ), std::make_pair ( 1, 2 ) );
+}
+
+TEST ( optimize, write_amplification_budget )
+{
+	// 90% dead big chunk makes the unbalanced pair the best one
+	CSphVector<ChunkMergeStats_t> dChunks;
+	dChunks.Add ( MergeTestChunk ( 0, 100, 1000 ) );
+	dChunks.Add ( MergeTestChunk ( 1, 10 ) );
+	dChunks.Add ( MergeTestChunk ( 2, 100 ) );
+	ASSERT_EQ ( GetBestMergePair ( dChunks, 0 ), std::make_pair ( 0, 1 ) );
+	ASSERT_EQ ( GetBestMergePair ( dChunks, 20 ), std::make_pair ( 0, 1 ) );
+
+	// ...unless it rewrites too much; balanced pair fits any budget
+	ASSERT_EQ ( GetBestMergePair ( dChunks, 5 ), std::make_pair ( 0, 2 ) );
+	ASSERT_EQ ( GetBestMergePair ( dChunks, OPTIMIZE_MIN_WRITE_AMPLIFICATION ), std::make_pair ( 0, 2 ) );
+}
+
+TEST ( optimize, write_amplification_fallback )
+{
+	// every pair is over budget; the cheapest one is merged anyway
+	CSphVector<ChunkMergeStats_t> dChunks;
+	dChunks.Add ( MergeTestChunk ( 0, 1000 ) );
+	dChunks.Add ( MergeTestChunk ( 1, 100 ) );
+	dChunks.Add ( MergeTestChunk ( 2, 10 ) );
+	ASSERT_EQ ( GetBestMergePair ( dChunks, 5 ), std::make_pair ( 1, 2 ) );
+
+	// nothing to merge
+	dChunks.Resize ( 1 );
+	ASSERT_EQ ( GetBestMergePair ( dChunks, 5 ), std::make_pair ( -1, -1 ) );
+}
+
+TEST ( docstore, separate_fields )
+{
+	const int ROWS = 500;
+	const char * dNames[] = { "title", "body", "tags" };
+	CSphString sError;
+
+	DocstoreSettings_t tSettings;
+	tSettings.m_uBlockSize = 1024;
+	tSettings.m_dSeparateFields.Add ( "body" );
+
+	{
+		CSphScopedPtr<DocstoreBuilder_i> pBuilder ( CreateDocstoreBuilder ( DOCSTORE_TEST_FILE, tSettings, sError ) );
+		ASSERT_TRUE ( pBuilder.Ptr() ) << sError.cstr();
+		for ( const char * szName : dNames )
+			pBuilder->AddField ( szName, DOCSTORE_TEXT );
+
+		CSphVector<CSphString> dValues;
+		for ( int iRow=0; iRow<ROWS; ++iRow )
+		{
+			dValues.Resize(0);
+			DocstoreBuilder_i::Doc_t tDoc;
+			for ( int i=0; i<3; ++i )
+				dValues.Add ( DocstoreTestField ( iRow, i ) );
+
+			for ( const auto & sValue : dValues )
+				tDoc.m_dFields.Add ( { (BYTE *)const_cast<char*>( sValue.cstr() ), sValue.Length() } );
+
+			pBuilder->AddDoc ( iRow, tDoc );
+		}
+
+		pBuilder->Finalize();
+	}
+
+	CSphScopedPtr<Docstore_i> pDocstore ( CreateDocstore ( 1, DOCSTORE_TEST_FILE, sError ) );
+	ASSERT_TRUE ( pDocstore.Ptr() ) << sError.cstr();
+
+	// the layout comes back with the settings, so that merge keeps it
+	DocstoreSettings_t tLoaded = pDocstore->GetDocstoreSettings();
+	ASSERT_EQ ( tLoaded.m_dSeparateFields.GetLength(), 1 );
+	ASSERT_STREQ ( tLoaded.m_dSeparateFields[0].cstr(), "body" );
+
+	// all fields, then subsets from one stream and from both of them
+	DocstoreTestCheck ( *pDocstore, ROWS, nullptr, 3 );
+
+	CSphVector<int> dFields;
+	dFields.Add ( pDocstore->GetFieldId ( "body", DOCSTORE_TEXT ) );
+	DocstoreTestCheck ( *pDocstore, ROWS, &dFields, 3 );
+
+	dFields.Resize(0);
+	dFields.Add ( pDocstore->GetFieldId ( "title", DOCSTORE_TEXT ) );
+	dFields.Add ( pDocstore->GetFieldId ( "tags", DOCSTORE_TEXT ) );
+	DocstoreTestCheck ( *pDocstore, ROWS, &dFields, 3 );
+
+	dFields.Resize(0);
+	dFields.Add ( pDocstore->GetFieldId ( "body", DOCSTORE_TEXT ) );
+	dFields.Add ( pDocstore->GetFieldId ( "tags", DOCSTORE_TEXT ) );
+	DocstoreTestCheck ( *pDocstore, ROWS, &dFields, 3 );
+
+	pDocstore.Reset();
+	::unlink ( DOCSTORE_TEST_FILE );
+}
+
+// v.1 files (single stream, no stream layout in the header) are written by hand, as the builder only writes v.2
+TEST ( docstore, read_v1 )
+{
+	const int ROWS = 100;
+	const int DOCS_PER_BLOCK = 16;
+	CSphString sError;
+
+	{
+		CSphWriter tWriter;
+		ASSERT_TRUE ( tWriter.OpenFile ( DOCSTORE_TEST_FILE, sError ) ) << sError.cstr();
+		tWriter.PutDword ( 1 );				// storage version
+		tWriter.PutDword ( 1024 );			// block size
+		tWriter.PutByte ( 0 );				// no compression
+		tWriter.PutDword ( 2 );				// fields
+		tWriter.PutByte ( DOCSTORE_TEXT );
+		tWriter.PutString ( "title" );
+		tWriter.PutByte ( DOCSTORE_TEXT );
+		tWriter.PutString ( "body" );
+
+		SphOffset_t tNumBlocksPos = tWriter.GetPos();
+		tWriter.PutDword ( 0 );
+		tWriter.PutOffset ( 0 );
+
+		CSphVector<BYTE> dHeader, dBlock;
+		MemoryWriter2_c tHeader ( dHeader );
+		RowID_t tPrevRowID = 0;
+		SphOffset_t tPrevOffset = 0;
+		int iBlocks = 0;
+		for ( int iStart=0; iStart<ROWS; iStart+=DOCS_PER_BLOCK, ++iBlocks )
+		{
+			int iDocs = Min ( DOCS_PER_BLOCK, ROWS-iStart );
+			dBlock.Resize(0);
+			MemoryWriter2_c tBlock ( dBlock );
+			for ( int iRow=iStart; iRow<iStart+iDocs; ++iRow )
+			{
+				tBlock.PutByte ( 0 );		// doc flags
+				for ( int iField=0; iField<2; ++iField )
+				{
+					CSphString sValue = DocstoreTestField ( iRow, iField );
+					tBlock.ZipInt ( sValue.Length() );
+					tBlock.PutBytes ( sValue.cstr(), sValue.Length() );
+				}
+			}
+
+			SphOffset_t tOffset = tWriter.GetPos();
+			tWriter.PutByte ( 0 );			// block flags
+			tWriter.ZipInt ( iDocs );
+			tWriter.ZipInt ( dBlock.GetLength() );
+			tWriter.PutBytes ( dBlock.Begin(), dBlock.GetLength() );
+
+			tHeader.ZipInt ( iStart-tPrevRowID );
+			tHeader.PutByte ( 0 );			// small block
+			tHeader.ZipOffset ( tOffset-tPrevOffset );
+			tPrevRowID = iStart;
+			tPrevOffset = tOffset;
+		}
+
+		SphOffset_t tHeaderPos = tWriter.GetPos();
+		tWriter.PutBytes ( dHeader.Begin(), dHeader.GetLength() );
+		tWriter.Flush();
+		tWriter.SeekTo ( tNumBlocksPos );
+		tWriter.PutDword ( iBlocks );
+		tWriter.PutOffset ( tHeaderPos );
+		tWriter.CloseFile();
+	}
+
+	CSphScopedPtr<Docstore_i> pDocstore ( CreateDocstore ( 2, DOCSTORE_TEST_FILE, sError ) );
+	ASSERT_TRUE ( pDocstore.Ptr() ) << sError.cstr();
+	ASSERT_EQ ( pDocstore->GetDocstoreSettings().m_dSeparateFields.GetLength(), 0 );
+
+	DocstoreTestCheck ( *pDocstore, ROWS, nullptr, 2 );
+
+	CSphVector<int> dFields;
+	dFields.Add ( pDocstore->GetFieldId ( "body", DOCSTORE_TEXT ) );
+	DocstoreTestCheck ( *pDocstore, ROWS, &dFields, 2 );
+
+	pDocstore.Reset();
+	::unlink ( DOCSTORE_TEST_FILE );
+}
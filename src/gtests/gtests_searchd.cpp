@@ -343,3 +343,313 @@ TEST_F ( CustomNetloop_c, test_usual_remove_23 )
 	auto dOutdated = RemoveOutdated ( 1, 2 );
 	ARRAY_FOREACH ( i, dOutdated ) SafeDelete ( dOutdated[i] );
 }
+
+//////////////////////////////////////////////////////////////////////////
+// exact distributed top groups, with agents simulated over plain lists of documents
+
+using CountHash_t = CSphOrderedHash<int64_t, SphAttr_t, IdentityHash_fn, 4096>;
+
+class ExactTopKSim_c : public ExactTopK_c
+{
+public:
+	using Doc_t = CSphVector<SphAttr_t>;	///< values of the group-by column of a document
+
+	ExactTopKSim_c ( AggrResult_t & tRes, const CSphQuery & tQuery, SearchFailuresLog_c & tFailures, const CSphSchema & tSchema, const CSphVector<CSphVector<Doc_t>> & dAgents )
+		: ExactTopK_c ( tRes, tQuery, tFailures )
+		, m_tSchema ( tSchema )
+		, m_dDocs ( dAgents )
+	{}
+
+	/// what an agent ships: its groups above the threshold, in the order of counts, limited
+	static void Reply ( OneResultset_t & tChunk, const CSphSchema & tSchema, const CSphVector<Doc_t> & dDocs, const CSphQuery & tQuery, int iLimit )
+	{
+		const CSphFilterSettings * pKeys = tQuery.m_dFilters.GetLength() ? &tQuery.m_dFilters.Last() : nullptr;
+		CountHash_t hCounts;
+		for ( const auto & dDoc : dDocs )
+		{
+			if ( pKeys && !dDoc.any_of ( [pKeys] ( SphAttr_t tValue ) { return pKeys->m_dValues.Contains ( tValue ); } ) )
+				continue;
+
+			for ( SphAttr_t tValue : dDoc )
+			{
+				int64_t * pCount = hCounts ( tValue );
+				if ( pCount )
+					++*pCount;
+				else
+					hCounts.Add ( 1, tValue );
+			}
+		}
+
+		CSphVector<std::pair<int64_t, SphAttr_t>> dGroups;
+		for ( const auto & tCount : hCounts )
+			if ( tCount.second>=tQuery.m_iMinGroupCount )
+				dGroups.Add ( { tCount.second, tCount.first } );
+
+		dGroups.Sort ( Lesser ( [] ( const std::pair<int64_t, SphAttr_t> & a, const std::pair<int64_t, SphAttr_t> & b ) { return a.first>b.first || ( a.first==b.first && a.second<b.second ); } ) );
+		dGroups.Resize ( Min ( dGroups.GetLength(), iLimit ) );
+
+		tChunk.m_tSchema = tSchema;
+		for ( const auto & tGroup : dGroups )
+		{
+			CSphMatch & tMatch = tChunk.m_dMatches.Add();
+			tMatch.Reset ( tSchema.GetDynamicSize() );
+			tMatch.SetAttr ( tSchema.GetAttr ( "@groupby" )->m_tLocator, tGroup.second );
+			tMatch.SetAttr ( tSchema.GetAttr ( "@count" )->m_tLocator, tGroup.first );
+		}
+	}
+
+	int m_iRequests = 0;
+	bool m_bFailFinalFetch = false;	///< agents don't reply to the final fetch (the only round with keys filter)
+
+protected:
+	void RequestAgents ( const CSphVector<int> & dAgents, CSphQuery & tQuery, int iLimit ) override
+	{
+		for ( int iAgent : dAgents )
+		{
+			++m_iRequests;
+			if ( m_bFailFinalFetch && tQuery.m_dFilters.GetLength() )
+				continue;
+
+			OneResultset_t tChunk;
+			Reply ( tChunk, m_tSchema, m_dDocs[iAgent], tQuery, iLimit );
+			CSphString sError;
+			ASSERT_TRUE ( AcceptReply ( iAgent, tChunk, sError ) ) << sError.cstr();
+		}
+	}
+
+private:
+	const CSphSchema &					m_tSchema;
+	const CSphVector<CSphVector<Doc_t>> &	m_dDocs;
+};
+
+
+class ExactTopK : public ::testing::Test
+{
+protected:
+	CSphSchema		m_tSchema;
+	CSphQuery		m_tQuery;
+	CSphRefcountedPtr<AgentConn_t>	m_pConn { new AgentConn_t };
+	CSphVector<CSphVector<ExactTopKSim_c::Doc_t>>	m_dAgents;
+	SearchFailuresLog_c	m_tFailures;
+	int				m_iRequests = 0;
+	bool			m_bFailFinalFetch = false;
+
+	void SetUp() override
+	{
+		m_tQuery.m_sGroupBy = "gid";
+		m_tQuery.m_sGroupSortBy = "@count desc";
+		m_tQuery.m_bExactTopK = true;
+		m_tQuery.m_iLimit = 3;
+		m_tQuery.m_iMaxMatches = 50;
+	}
+
+	void SetupSchema ( ESphAttr eGroupBy )
+	{
+		m_tSchema.AddAttr ( CSphColumnInfo ( "gid", eGroupBy ), true );
+		m_tSchema.AddAttr ( CSphColumnInfo ( "@groupby", SPH_ATTR_BIGINT ), true );
+		m_tSchema.AddAttr ( CSphColumnInfo ( "@count", SPH_ATTR_BIGINT ), true );
+	}
+
+	// runs the rounds and merges what is left in the agent chunks into totals by key
+	CountHash_t Run ( AggrResult_t & tRes )
+	{
+		for ( const auto & dDocs : m_dAgents )
+		{
+			OneResultset_t & tChunk = tRes.m_dResults.Add();
+			ExactTopKSim_c::Reply ( tChunk, m_tSchema, dDocs, m_tQuery, ExactTopK_c::AgentLimit ( m_tQuery ) );
+			tChunk.m_bTag = true;
+			tChunk.m_pAgent = m_pConn;
+		}
+
+		ExactTopKSim_c tTopK ( tRes, m_tQuery, m_tFailures, m_tSchema, m_dAgents );
+		tTopK.m_bFailFinalFetch = m_bFailFinalFetch;
+		tTopK.Run();
+		m_iRequests = tTopK.m_iRequests;
+
+		CountHash_t hTotals;
+		const CSphAttrLocator & tKey = m_tSchema.GetAttr ( "@groupby" )->m_tLocator;
+		const CSphAttrLocator & tCount = m_tSchema.GetAttr ( "@count" )->m_tLocator;
+		for ( const auto & tChunk : tRes.m_dResults )
+			for ( const auto & tMatch : tChunk.m_dMatches )
+			{
+				int64_t * pTotal = hTotals ( tMatch.GetAttr ( tKey ) );
+				if ( pTotal )
+					*pTotal += tMatch.GetAttr ( tCount );
+				else
+					hTotals.Add ( tMatch.GetAttr ( tCount ), tMatch.GetAttr ( tKey ) );
+			}
+
+		return hTotals;
+	}
+
+	// top groups of the merged result must be the real top groups, with their real counts
+	void CheckTop ( const CountHash_t & hMerged )
+	{
+		CountHash_t hReal;
+		for ( const auto & dDocs : m_dAgents )
+			for ( const auto & dDoc : dDocs )
+				for ( SphAttr_t tValue : dDoc )
+				{
+					int64_t * pCount = hReal ( tValue );
+					if ( pCount )
+						++*pCount;
+					else
+						hReal.Add ( 1, tValue );
+				}
+
+		auto fnTop = [this] ( const CountHash_t & hTotals )
+		{
+			CSphVector<std::pair<int64_t, SphAttr_t>> dTop;
+			for ( const auto & tTotal : hTotals )
+				dTop.Add ( { tTotal.second, tTotal.first } );
+			dTop.Sort ( Lesser ( [] ( const std::pair<int64_t, SphAttr_t> & a, const std::pair<int64_t, SphAttr_t> & b ) { return a.first>b.first || ( a.first==b.first && a.second<b.second ); } ) );
+			dTop.Resize ( Min ( dTop.GetLength(), m_tQuery.m_iLimit ) );
+			return dTop;
+		};
+
+		auto dReal = fnTop ( hReal );
+		auto dMerged = fnTop ( hMerged );
+		ASSERT_EQ ( dReal.GetLength(), dMerged.GetLength() );
+		ARRAY_FOREACH ( i, dReal )
+		{
+			ASSERT_EQ ( dReal[i].first, dMerged[i].first );
+			ASSERT_EQ ( dReal[i].second, dMerged[i].second );
+		}
+	}
+
+	void AddDocs ( int iAgent, SphAttr_t tValue, int iCount )
+	{
+		if ( m_dAgents.GetLength()<=iAgent )
+			m_dAgents.Resize ( iAgent+1 );
+		for ( int i = 0; i<iCount; ++i )
+			m_dAgents[iAgent].Add().Add ( tValue );
+	}
+};
+
+
+TEST_F ( ExactTopK, short_replies_prune )
+{
+	SetupSchema ( SPH_ATTR_BIGINT );
+
+	// every agent has less groups than the limit, so no more rounds, and only the groups below the top are dropped
+	m_tQuery.m_iLimit = 4;
+	AddDocs ( 0, 1, 10 );
+	AddDocs ( 0, 2, 3 );
+	AddDocs ( 0, 3, 1 );
+	AddDocs ( 1, 4, 8 );
+	AddDocs ( 1, 5, 2 );
+	AddDocs ( 1, 6, 1 );
+
+	AggrResult_t tRes;
+	auto hMerged = Run ( tRes );
+	ASSERT_EQ ( m_iRequests, 0 );
+	ASSERT_TRUE ( m_tFailures.IsEmpty() );
+	CheckTop ( hMerged );
+
+	// 3 and 6 have 1 each, while the 4th best total is 2
+	ASSERT_EQ ( hMerged.GetLength(), 4 );
+	ASSERT_FALSE ( hMerged.Exists ( 3 ) );
+	ASSERT_FALSE ( hMerged.Exists ( 6 ) );
+}
+
+
+TEST_F ( ExactTopK, threshold_rounds )
+{
+	SetupSchema ( SPH_ATTR_BIGINT );
+
+	// group 100 is never in the local top-3 of any agent, yet it is the best one overall
+	for ( int iAgent = 0; iAgent<4; ++iAgent )
+	{
+		for ( int iGroup = 0; iGroup<3; ++iGroup )
+			AddDocs ( iAgent, iAgent*10+iGroup, 20-iGroup );
+		AddDocs ( iAgent, 100, 15 );
+		for ( int iGroup = 0; iGroup<20; ++iGroup )
+			AddDocs ( iAgent, 1000+iAgent*100+iGroup, 1+iGroup%5 );
+	}
+
+	AggrResult_t tRes;
+	auto hMerged = Run ( tRes );
+	ASSERT_GT ( m_iRequests, 0 );
+	ASSERT_TRUE ( m_tFailures.IsEmpty() );
+	CheckTop ( hMerged );
+	ASSERT_EQ ( *hMerged ( 100 ), 60 );
+}
+
+
+// 2, 3 and 4 come in the final fetch; 7 is shipped by agent 2 in full, and can't get to the top
+class ExactTopKFinal : public ExactTopK
+{
+protected:
+	void SetUp() override
+	{
+		ExactTopK::SetUp();
+		SetupSchema ( SPH_ATTR_BIGINT );
+		m_tQuery.m_iLimit = 2;
+		AddDocs ( 0, 1, 1000 );
+		AddDocs ( 0, 2, 900 );
+		AddDocs ( 1, 3, 950 );
+		AddDocs ( 1, 4, 940 );
+		AddDocs ( 1, 1, 500 );
+		AddDocs ( 1, 2, 300 );
+		AddDocs ( 2, 7, 3 );
+	}
+};
+
+
+TEST_F ( ExactTopKFinal, fetched )
+{
+	AggrResult_t tRes;
+	auto hMerged = Run ( tRes );
+	ASSERT_TRUE ( m_tFailures.IsEmpty() );
+	CheckTop ( hMerged );
+	ASSERT_EQ ( *hMerged ( 2 ), 1200 );
+	ASSERT_FALSE ( hMerged.Exists ( 7 ) );
+}
+
+
+TEST_F ( ExactTopKFinal, agent_failed )
+{
+	m_bFailFinalFetch = true;
+
+	// result may be approximate, but it is reported, and groups which can't get to the top are still pruned
+	AggrResult_t tRes;
+	auto hMerged = Run ( tRes );
+	ASSERT_FALSE ( m_tFailures.IsEmpty() );
+	ASSERT_EQ ( *hMerged ( 1 ), 1500 );
+	ASSERT_EQ ( *hMerged ( 2 ), 900 );
+	ASSERT_FALSE ( hMerged.Exists ( 7 ) );
+}
+
+
+TEST_F ( ExactTopK, mva_final_fetch )
+{
+	SetupSchema ( SPH_ATTR_INT64SET );
+	m_tQuery.m_iLimit = 2;
+
+	// 7 and 8 are the best groups, but agents 1 and 2 have them below the threshold, so they come in the final fetch
+	// documents that have them there also have lots of other values, with higher counts among the matching documents
+	// these must neither push 7 and 8 out of the reply, nor get into the result with partial counts
+	m_dAgents.Resize ( 3 );
+	AddDocs ( 0, 7, 100 );
+	AddDocs ( 0, 8, 100 );
+	for ( int iAgent = 1; iAgent<3; ++iAgent )
+	{
+		AddDocs ( iAgent, iAgent, 40 );
+		AddDocs ( iAgent, 10+iAgent, 35 );
+		for ( SphAttr_t tKey = 7; tKey<=8; ++tKey )
+			for ( int i = 0; i<9; ++i )
+			{
+				auto & dDoc = m_dAgents[iAgent].Add();
+				dDoc.Add ( tKey );
+				for ( int iValue = 0; iValue<10; ++iValue )
+					dDoc.Add ( 500+iValue );
+			}
+	}
+
+	AggrResult_t tRes;
+	auto hMerged = Run ( tRes );
+	ASSERT_TRUE ( m_tFailures.IsEmpty() );
+	CheckTop ( hMerged );
+	ASSERT_EQ ( *hMerged ( 7 ), 118 );
+	ASSERT_FALSE ( hMerged.Exists ( 500 ) );
+}
@@ -16,6 +16,8 @@
 #include "fileutils.h"
 #include "sphinxutils.h"
 #include "sphinxstem.h"
+#include "collation.h"
+#include "indexformat.h"
 #include "stripper/html_stripper.h"
 #include <cmath>
 
@@ -219,6 +221,128 @@ TEST ( Wildcards, recursive_slow )
 		sphWildcardMatch ( "--------------------------this-li--p---", "-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-z-*-" ) );
 }
 
+static CSphVector<BYTE> ExpansionTestBytes ( const char * szText )
+{
+	CSphVector<BYTE> dBytes;
+	dBytes.Append ( szText, (int)strlen ( szText ) );
+	return dBytes;
+}
+
+static CSphVector<BYTE> ExpansionTestKey ( char cType, const char * szWildcard, const ISphWordlist::Args_t & tArgs )
+{
+	CSphVector<BYTE> dKey;
+	ExpansionCacheKey ( cType, szWildcard, (int)strlen ( szWildcard )-1, szWildcard, tArgs, dKey );
+	return dKey;
+}
+
+static bool ExpansionTestFind ( int64_t iIndexId, const CSphVector<BYTE> & dKey, CSphVector<BYTE> & dWords )
+{
+	return ExpansionCacheFind ( iIndexId, ExpansionCacheHash ( dKey ), dKey, dWords );
+}
+
+TEST ( Wildcards, expansion_cache_key )
+{
+	ShutdownExpansionCache();
+	InitExpansionCache ( 1048576 );
+
+	ISphWordlist::Args_t tArgs ( false, 10, false, SPH_HITLESS_NONE, cRefCountedRefPtr_t() );
+	CSphVector<BYTE> dKey = ExpansionTestKey ( 'p', "abc*", tArgs );
+	ExpansionCacheAdd ( 1, ExpansionCacheHash ( dKey ), dKey, ExpansionTestBytes ( "abcd abcde" ) );
+
+	CSphVector<BYTE> dWords;
+	ASSERT_TRUE ( ExpansionTestFind ( 1, dKey, dWords ) );
+	ASSERT_EQ ( dWords.GetLength(), 10 );
+	ASSERT_EQ ( memcmp ( dWords.Begin(), "abcd abcde", 10 ), 0 );
+
+	// expansion_limit is applied after the cache, so it is not a part of the key
+	ISphWordlist::Args_t tLimit ( false, 100, false, SPH_HITLESS_NONE, cRefCountedRefPtr_t() );
+	ASSERT_TRUE ( ExpansionTestFind ( 1, ExpansionTestKey ( 'p', "abc*", tLimit ), dWords ) );
+
+	// other pattern, lookup kind, settings or index
+	ASSERT_FALSE ( ExpansionTestFind ( 1, ExpansionTestKey ( 'p', "abd*", tArgs ), dWords ) );
+	ASSERT_FALSE ( ExpansionTestFind ( 1, ExpansionTestKey ( 'i', "abc*", tArgs ), dWords ) );
+	ISphWordlist::Args_t tPayload ( true, 10, false, SPH_HITLESS_NONE, cRefCountedRefPtr_t() );
+	ASSERT_FALSE ( ExpansionTestFind ( 1, ExpansionTestKey ( 'p', "abc*", tPayload ), dWords ) );
+	ISphWordlist::Args_t tExact ( false, 10, true, SPH_HITLESS_NONE, cRefCountedRefPtr_t() );
+	ASSERT_FALSE ( ExpansionTestFind ( 1, ExpansionTestKey ( 'p', "abc*", tExact ), dWords ) );
+	ISphWordlist::Args_t tHitless ( false, 10, false, SPH_HITLESS_ALL, cRefCountedRefPtr_t() );
+	ASSERT_FALSE ( ExpansionTestFind ( 1, ExpansionTestKey ( 'p', "abc*", tHitless ), dWords ) );
+	ASSERT_FALSE ( ExpansionTestFind ( 2, dKey, dWords ) );
+
+	// wordlists without id are never cached
+	ExpansionCacheAdd ( -1, ExpansionCacheHash ( dKey ), dKey, ExpansionTestBytes ( "abcd" ) );
+	ASSERT_FALSE ( ExpansionTestFind ( -1, dKey, dWords ) );
+
+	ShutdownExpansionCache();
+}
+
+TEST ( Wildcards, expansion_cache_collision )
+{
+	ShutdownExpansionCache();
+	InitExpansionCache ( 1048576 );
+
+	// same hash, different keys; the full key tells them apart
+	const uint64_t uHash = 42;
+	CSphVector<BYTE> dKeyA = ExpansionTestBytes ( "pattern a" );
+	CSphVector<BYTE> dKeyB = ExpansionTestBytes ( "pattern b" );
+	ExpansionCacheAdd ( 1, uHash, dKeyA, ExpansionTestBytes ( "words a" ) );
+
+	CSphVector<BYTE> dWords;
+	ASSERT_FALSE ( ExpansionCacheFind ( 1, uHash, dKeyB, dWords ) );
+	ASSERT_TRUE ( ExpansionCacheFind ( 1, uHash, dKeyA, dWords ) );
+	ASSERT_EQ ( memcmp ( dWords.Begin(), "words a", dWords.GetLength() ), 0 );
+
+	// slot is taken, so the colliding key just doesn't get cached
+	ExpansionCacheAdd ( 1, uHash, dKeyB, ExpansionTestBytes ( "words b" ) );
+	ASSERT_FALSE ( ExpansionCacheFind ( 1, uHash, dKeyB, dWords ) );
+	ASSERT_TRUE ( ExpansionCacheFind ( 1, uHash, dKeyA, dWords ) );
+	ASSERT_EQ ( memcmp ( dWords.Begin(), "words a", dWords.GetLength() ), 0 );
+
+	// prefix of the key is not the key
+	CSphVector<BYTE> dKeyShort = ExpansionTestBytes ( "pattern" );
+	ASSERT_FALSE ( ExpansionCacheFind ( 1, uHash, dKeyShort, dWords ) );
+
+	ShutdownExpansionCache();
+}
+
+TEST ( Wildcards, expansion_cache_eviction )
+{
+	const int64_t iCacheSize = 65536;
+	ShutdownExpansionCache();
+	InitExpansionCache ( iCacheSize );
+
+	CSphVector<BYTE> dWords;
+	dWords.Resize ( 512 );
+	dWords.Fill ( 'a' );
+
+	// twice as many entries as fit; least recently used go first
+	const int iEntries = 2*iCacheSize/dWords.GetLength();
+	for ( int i=0; i<iEntries; ++i )
+	{
+		CSphString sKey;
+		sKey.SetSprintf ( "key%d", i );
+		CSphVector<BYTE> dKey = ExpansionTestBytes ( sKey.cstr() );
+		ExpansionCacheAdd ( 1, ExpansionCacheHash ( dKey ), dKey, dWords );
+	}
+
+	CSphVector<BYTE> dFound;
+	ASSERT_FALSE ( ExpansionTestFind ( 1, ExpansionTestBytes ( "key0" ), dFound ) );
+	CSphString sLast;
+	sLast.SetSprintf ( "key%d", iEntries-1 );
+	ASSERT_TRUE ( ExpansionTestFind ( 1, ExpansionTestBytes ( sLast.cstr() ), dFound ) );
+	ASSERT_EQ ( dFound.GetLength(), dWords.GetLength() );
+
+	// entry larger than 1/64 of the cache is never stored
+	CSphVector<BYTE> dHuge;
+	dHuge.Resize ( iCacheSize/32 );
+	dHuge.Fill ( 'b' );
+	CSphVector<BYTE> dKey = ExpansionTestBytes ( "huge" );
+	ExpansionCacheAdd ( 1, ExpansionCacheHash ( dKey ), dKey, dHuge );
+	ASSERT_FALSE ( ExpansionTestFind ( 1, dKey, dFound ) );
+
+	ShutdownExpansionCache();
+}
+
 TEST ( Wildcards, repeating_character_sequences )
 {
 	// cases with repeating character sequences
@@ -779,3 +903,95 @@ TEST ( Text, sphNormalizeRelativePath )
 	ASSERT_STREQ ( sphNormalizePath( "aaa/bbb/ccc/ddd/../../../../../../../" ).cstr(), "../../.." );
 	ASSERT_STREQ ( sphNormalizePath( "..//bbb" ).cstr(), "../bbb" );
 }
+
+static int CmpSign ( int iRes )
+{
+	return iRes<0 ? -1 : ( iRes>0 ? 1 : 0 );
+}
+
+TEST ( Text, collation_ascii_fast_path )
+{
+	sphCollationInit();
+
+	const char * dStrs[] = {
+		"", "a", "A", "abcdefgh", "ABCDEFGH", "abcdefghijklmnop", "ABCDEFGHIJKLMNOQ", "abcdefghijklmnopq",
+		"Hello world, this is long", "hello WORLD, this is long", "hello world, this is lonG!", "[\\]^_`{|}~",
+		"zzzzzzzzzzzzzzzz", "ZZZZZZZZZZZZZZZZa", "abcdefgh\xC3\x84rger", "ABCDEFGH\xC3\xA4RGER", "abcdefghzrger",
+		"\xC3\x84", "\xC3\xA4" "bc", "@ABCDEFGHIJ", "`abcdefghij"
+	};
+
+	for ( auto eCollation : { SPH_COLLATION_BINARY, SPH_COLLATION_LIBC_CI, SPH_COLLATION_UTF8_GENERAL_CI } )
+	{
+		SphStringCmp_fn fnCmp = GetStringCmpFunc ( eCollation );
+		StrSortKey_fn fnKey = GetStringSortKeyFunc ( eCollation );
+		ASSERT_TRUE ( fnKey );
+
+		for ( const char * sA : dStrs )
+			for ( const char * sB : dStrs )
+			{
+				ByteBlob_t dA { (const BYTE *)sA, (int)strlen(sA) };
+				ByteBlob_t dB { (const BYTE *)sB, (int)strlen(sB) };
+				int iCmp = CmpSign ( fnCmp ( dA, dB, false ) );
+				ASSERT_EQ ( iCmp, -CmpSign ( fnCmp ( dB, dA, false ) ) ) << sA << " vs " << sB;
+
+				// keys must never contradict the full compare
+				uint64_t uKeyA = fnKey ( dA );
+				uint64_t uKeyB = fnKey ( dB );
+				if ( uKeyA!=uKeyB )
+				{
+					ASSERT_EQ ( iCmp, uKeyA<uKeyB ? -1 : 1 ) << sA << " vs " << sB;
+				}
+				if ( !iCmp )
+				{
+					ASSERT_EQ ( uKeyA, uKeyB ) << sA << " vs " << sB;
+				}
+			}
+	}
+
+	auto fnCI = GetStringCmpFunc ( SPH_COLLATION_UTF8_GENERAL_CI );
+	auto fnLibcCI = GetStringCmpFunc ( SPH_COLLATION_LIBC_CI );
+	ByteBlob_t dLower { (const BYTE *)"hello world, this is long", 25 };
+	ByteBlob_t dUpper { (const BYTE *)"HELLO WORLD, THIS IS LONG", 25 };
+	ByteBlob_t dUmlautLower { (const BYTE *)"abcdefgh\xC3\xA4rger", 15 };
+	ByteBlob_t dUmlautUpper { (const BYTE *)"ABCDEFGH\xC3\x84RGER", 15 };
+	ASSERT_EQ ( fnCI ( dLower, dUpper, false ), 0 );
+	ASSERT_EQ ( fnLibcCI ( dLower, dUpper, false ), 0 );
+	ASSERT_EQ ( fnCI ( dUmlautLower, dUmlautUpper, false ), 0 );
+
+	// 'Z'<'[' but 'z'>'[', so folding direction matters
+	ByteBlob_t dZ { (const BYTE *)"zzzzzzzzz", 9 };
+	ByteBlob_t dBracket { (const BYTE *)"[[[[[[[[[", 9 };
+	ASSERT_LT ( fnCI ( dZ, dBracket, false ), 0 );
+	ASSERT_GT ( fnLibcCI ( dZ, dBracket, false ), 0 );
+}
+
+TEST ( Text, collation_hash_vs_cmp )
+{
+	sphCollationInit();
+
+	// same lengths, so only the bytes past the embedded zero differ
+	const ByteBlob_t dStrs[] = {
+		{ (const BYTE *)"abc\0defgh", 8 }, { (const BYTE *)"ABC\0xyzuv", 8 }, { (const BYTE *)"abc\0DEFGH", 8 },
+		{ (const BYTE *)"abcdefghijkl\0mnopqrs", 20 }, { (const BYTE *)"ABCDEFGHIJKL\0MNOPQRS", 20 }, { (const BYTE *)"abcdefghijkl\0zzzzzzz", 20 },
+		{ (const BYTE *)"Hello", 5 }, { (const BYTE *)"hELLO", 5 }
+	};
+
+	for ( auto eCollation : { SPH_COLLATION_BINARY, SPH_COLLATION_LIBC_CI, SPH_COLLATION_UTF8_GENERAL_CI } )
+	{
+		SphStringCmp_fn fnCmp = GetStringCmpFunc ( eCollation );
+		StrHashCalc_fn fnHash = GetStringHashCalcFunc ( eCollation );
+
+		for ( const auto & dA : dStrs )
+			for ( const auto & dB : dStrs )
+				if ( !fnCmp ( dA, dB, false ) )
+				{
+					ASSERT_EQ ( fnHash ( dA.first, dA.second, SPH_FNV64_SEED ), fnHash ( dB.first, dB.second, SPH_FNV64_SEED ) )
+						<< (const char *)dA.first << " vs " << (const char *)dB.first << " collation " << (int)eCollation;
+				}
+	}
+
+	// libc_ci ignores everything past the zero, just like strncasecmp does
+	auto fnLibcCI = GetStringCmpFunc ( SPH_COLLATION_LIBC_CI );
+	ASSERT_EQ ( fnLibcCI ( dStrs[0], dStrs[1], false ), 0 );
+	ASSERT_EQ ( fnLibcCI ( dStrs[3], dStrs[5], false ), 0 );
+}
@@ -12,6 +12,7 @@
 
 #include "threadutils.h"
 #include "coroutine.h"
+#include "numautils.h"
 #include <atomic>
 
 void SetStderrLogger ();
@@ -44,6 +45,38 @@ TEST ( ThreadPool, Counter100 )
 	ASSERT_EQ ( v, 100 );
 }
 
+// secondary queue serves priority classes by weighted round-robin, high class first
+TEST ( ThreadPool, priority_classes )
+{
+	using namespace Threads;
+	auto pPool = MakeThreadPool ( 1, "tp" );
+	CSphVector<int> dRes;
+	std::atomic<bool> bBlocked { true };
+
+	// occupy the only thread, so that all the rest is queued
+	pPool->Schedule ( [&bBlocked] { while ( bBlocked ) sphSleepMsec ( 1 ); }, false );
+	sphSleepMsec ( 10 );
+
+	for ( int i = 0; i<3; ++i )
+		pPool->SchedulePrio ( [i, &dRes] { dRes.Add ( 20+i ); }, Priority_e::LOW );
+	for ( int i = 0; i<3; ++i )
+		pPool->SchedulePrio ( [i, &dRes] { dRes.Add ( 10+i ); }, Priority_e::NORMAL );
+	for ( int i = 0; i<3; ++i )
+		pPool->SchedulePrio ( [i, &dRes] { dRes.Add ( i ); }, Priority_e::HIGH );
+
+	auto tStats = pPool->GetQueueStats();
+	ASSERT_EQ ( tStats.m_dQueued[(int)Priority_e::LOW], 3 );
+	ASSERT_EQ ( tStats.m_dQueued[(int)Priority_e::HIGH], 3 );
+
+	bBlocked = false;
+	pPool->StopAll ();
+
+	ASSERT_EQ ( dRes.GetLength(), 9 );
+	int dExpected[] = { 0, 1, 2, 10, 11, 12, 20, 21, 22 };
+	ARRAY_CONSTFOREACH( i, dRes )
+		ASSERT_EQ ( dRes[i], dExpected[i] );
+}
+
 void Counter100c()
 {
 	using namespace Threads;
@@ -487,3 +520,83 @@ TEST ( ThreadPool, CoroPromiceFutureConcept )
 	});
 }
 
+static int NumaTestSum ( const CSphVector<int> & dThreads )
+{
+	int iSum = 0;
+	for ( int iThreads : dThreads )
+		iSum += iThreads;
+	return iSum;
+}
+
+static CSphVector<int> NumaTestSplit ( int iThreads, std::initializer_list<int> dCpus )
+{
+	CSphVector<int> dNodeCpus;
+	for ( int iCpus : dCpus )
+		dNodeCpus.Add ( iCpus );
+
+	CSphVector<int> dThreads;
+	Numa::SplitNodeThreads ( iThreads, dNodeCpus, dThreads );
+	return dThreads;
+}
+
+TEST ( Numa, common_pool_threads )
+{
+	// no numa - everything goes to the common pool
+	ASSERT_EQ ( Numa::CommonPoolThreads ( 32, 0 ), 32 );
+
+	// share of one node
+	ASSERT_EQ ( Numa::CommonPoolThreads ( 32, 2 ), 10 );
+	ASSERT_EQ ( Numa::CommonPoolThreads ( 30, 2 ), 10 );
+	ASSERT_EQ ( Numa::CommonPoolThreads ( 64, 3 ), 16 );
+
+	// never empty
+	ASSERT_EQ ( Numa::CommonPoolThreads ( 2, 4 ), 1 );
+}
+
+TEST ( Numa, split_node_threads )
+{
+	// symmetric nodes
+	CSphVector<int> dThreads = NumaTestSplit ( 22, { 8, 8 } );
+	ASSERT_EQ ( dThreads.GetLength(), 2 );
+	ASSERT_EQ ( dThreads[0], 11 );
+	ASSERT_EQ ( dThreads[1], 11 );
+
+	// proportional to cpus, the whole budget is used
+	dThreads = NumaTestSplit ( 16, { 4, 12 } );
+	ASSERT_EQ ( dThreads[0], 4 );
+	ASSERT_EQ ( dThreads[1], 12 );
+
+	// leftover of rounding goes to the largest remainders
+	dThreads = NumaTestSplit ( 10, { 3, 3, 3 } );
+	ASSERT_EQ ( NumaTestSum ( dThreads ), 10 );
+	ASSERT_EQ ( dThreads[0], 4 );
+	ASSERT_EQ ( dThreads[1], 3 );
+	ASSERT_EQ ( dThreads[2], 3 );
+
+	dThreads = NumaTestSplit ( 5, { 1, 2 } );
+	ASSERT_EQ ( dThreads[0], 2 );
+	ASSERT_EQ ( dThreads[1], 3 );
+
+	// every node gets a worker, even beyond the budget
+	dThreads = NumaTestSplit ( 10, { 1, 100 } );
+	ASSERT_EQ ( dThreads[0], 1 );
+	ASSERT_EQ ( dThreads[1], 10 );
+}
+
+TEST ( Numa, threads_budget )
+{
+	// common pool and node pools together stay within 'threads'
+	for ( int iNodes = 2; iNodes<=8; ++iNodes )
+		for ( int iThreads = 2*( iNodes+1 ); iThreads<=256; ++iThreads )
+		{
+			CSphVector<int> dCpus;
+			for ( int i = 0; i<iNodes; ++i )
+				dCpus.Add ( 8+i );
+
+			int iCommon = Numa::CommonPoolThreads ( iThreads, iNodes );
+			CSphVector<int> dThreads;
+			Numa::SplitNodeThreads ( iThreads-iCommon, dCpus, dThreads );
+			ASSERT_EQ ( iCommon+NumaTestSum ( dThreads ), iThreads ) << iNodes << " nodes, " << iThreads << " threads";
+			ASSERT_LE ( iCommon, dThreads.Last() );
+		}
+}
@@ -55,11 +55,68 @@ static void ConfigureICU()
 
 //////////////////////////////////////////////////////////////////////////
 
+// creating word break iterator loads and compiles rule data, so we do it only once,
+// and every thread then works with its own clone of that prototype, reset with setText() for each chunk
+static CSphMutex g_tBreakIteratorLock;
+static CSphScopedPtr<icu::BreakIterator> g_pBreakIteratorProto GUARDED_BY ( g_tBreakIteratorLock ) { nullptr };
+
+static icu::BreakIterator * CloneBreakIterator ( CSphString & sError )
+{
+	ScopedMutex_t tLock ( g_tBreakIteratorLock );
+	if ( !g_pBreakIteratorProto )
+	{
+		ConfigureICU();
+
+		UErrorCode tStatus = U_ZERO_ERROR;
+		CSphScopedPtr<icu::BreakIterator> pProto { icu::BreakIterator::createWordInstance ( icu::Locale::getChinese(), tStatus ) };
+		if ( U_FAILURE(tStatus) )
+		{
+			sError.SetSprintf( "Unable to initialize ICU break iterator: %s", u_errorName(tStatus) );
+			if ( tStatus==U_MISSING_RESOURCE_ERROR )
+				sError.SetSprintf ( "%s. Make sure ICU data file is accessible (using '%s' folder)", sError.cstr(), g_sICUDir.cstr() );
+
+			return nullptr;
+		}
+
+		if ( !pProto )
+		{
+			sError = "Unable to initialize ICU break iterator";
+			return nullptr;
+		}
+
+		g_pBreakIteratorProto = pProto.LeakPtr();
+	}
+
+	return g_pBreakIteratorProto->clone();
+}
+
+
+struct ICUThreadCtx_t
+{
+	CSphScopedPtr<icu::BreakIterator>	m_pBreakIterator { nullptr };
+	UText								m_tText = UTEXT_INITIALIZER;
+
+	~ICUThreadCtx_t()
+	{
+		utext_close ( &m_tText );
+	}
+};
+
+
+static ICUThreadCtx_t * GetThreadICUCtx ( CSphString & sError )
+{
+	static thread_local ICUThreadCtx_t tCtx;
+	if ( !tCtx.m_pBreakIterator )
+		tCtx.m_pBreakIterator = CloneBreakIterator ( sError );
+
+	return tCtx.m_pBreakIterator ? &tCtx : nullptr;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
 class ICUPreprocessor_c
 {
 public:
-							~ICUPreprocessor_c();
-
 	bool					Init ( CSphString & sError );
 	bool					Process ( const BYTE * pBuffer, int iLength, CSphVector<BYTE> & dOut, bool bQuery );
 	bool					SetBlendChars ( const char * szBlendChars, CSphString & sError );
@@ -68,7 +125,7 @@ protected:
 	CSphString				m_sBlendChars;
 
 private:
-	icu::BreakIterator *	m_pBreakIterator {nullptr};
+	ICUThreadCtx_t *		m_pCtx {nullptr};	///< per-thread iterator, valid only during Process()
 	const BYTE *			m_pBuffer {nullptr};
 	int						m_iBoundaryIndex {0};
 	int						m_iPrevBoundary {0};
@@ -88,70 +145,71 @@ private:
 };
 
 
-ICUPreprocessor_c::~ICUPreprocessor_c()
+bool ICUPreprocessor_c::Init ( CSphString & sError )
 {
-	SafeDelete(m_pBreakIterator);
+	// just check that iterator can be created; actual ones are created per thread on first use
+	return GetThreadICUCtx ( sError )!=nullptr;
 }
 
 
-bool ICUPreprocessor_c::Init ( CSphString & sError )
+bool ICUPreprocessor_c::Process ( const BYTE * pBuffer, int iLength, CSphVector<BYTE> & dOut, bool bQuery )
 {
-	ConfigureICU();
-
-	assert ( !m_pBreakIterator );
+	if ( !pBuffer || !iLength )
+		return false;
 
-	UErrorCode tStatus = U_ZERO_ERROR;
-	m_pBreakIterator = icu::BreakIterator::createWordInstance ( icu::Locale::getChinese(), tStatus );
-	if ( U_FAILURE(tStatus) )
+	// look for the first chinese code; chinese codes are all multi-byte, so ascii is skipped without decoding
+	const BYTE * pBufferMax = pBuffer+iLength;
+	const BYTE * pCur = pBuffer;
+	const BYTE * pChunkStart = nullptr;
+	while ( pCur<pBufferMax )
 	{
-		sError.SetSprintf( "Unable to initialize ICU break iterator: %s", u_errorName(tStatus) );
-		if ( tStatus==U_MISSING_RESOURCE_ERROR )
-			sError.SetSprintf ( "%s. Make sure ICU data file is accessible (using '%s' folder)", sError.cstr(), g_sICUDir.cstr() );
-
-		return false;			
-	}
+		if ( *pCur<0x80 )
+		{
+			++pCur;
+			continue;
+		}
 
-	if ( !m_pBreakIterator )
-	{
-		sError = "Unable to initialize ICU break iterator";
-		return false;
+		const BYTE * pTmp = pCur;
+		if ( sphIsChineseCode ( sphUTF8Decode ( pCur ) ) )
+		{
+			pChunkStart = pTmp;
+			break;
+		}
 	}
 
-	return true;
-}
-
-
-bool ICUPreprocessor_c::Process ( const BYTE * pBuffer, int iLength, CSphVector<BYTE> & dOut, bool bQuery )
-{
-	if ( !pBuffer || !iLength )
+	if ( !pChunkStart )
 		return false;
 
-	if ( !sphDetectChinese ( pBuffer, iLength ) )
+	CSphString sError;
+	m_pCtx = GetThreadICUCtx ( sError );
+	if ( !m_pCtx )
+	{
+		sphWarning ( "%s", sError.cstr() );
 		return false;
+	}
 
 	dOut.Resize(0);
+	dOut.Reserve ( iLength + iLength/2 );
+	AddTextChunk ( pBuffer, int ( pChunkStart-pBuffer ), dOut, false, bQuery );
 
-	const BYTE * pBufferMax = pBuffer+iLength;
-
-	bool bWasChineseCode = false;
-	const BYTE * pChunkStart = pBuffer;
-	bool bFirstCode = true;
-	while ( pBuffer<pBufferMax )
+	bool bWasChineseCode = true;
+	pCur = pChunkStart;
+	while ( pCur<pBufferMax )
 	{
-		const BYTE * pTmp = pBuffer;
-		int iCode = sphUTF8Decode ( pBuffer );
+		const BYTE * pTmp = pCur;
+		int iCode = sphUTF8Decode ( pCur );
 		bool bIsChineseCode = sphIsChineseCode(iCode);
-		if ( !bFirstCode && bWasChineseCode!=bIsChineseCode )
+		if ( bWasChineseCode!=bIsChineseCode )
 		{
 			AddTextChunk ( pChunkStart, int ( pTmp-pChunkStart ), dOut, bWasChineseCode, bQuery );
 			pChunkStart = pTmp;
 		}
 
 		bWasChineseCode = bIsChineseCode;
-		bFirstCode = false;
 	}
 
-	AddTextChunk ( pChunkStart, int ( pBuffer-pChunkStart ), dOut, bWasChineseCode, bQuery );
+	AddTextChunk ( pChunkStart, int ( pCur-pChunkStart ), dOut, bWasChineseCode, bQuery );
+	m_pCtx = nullptr;
 
 	return true;
 }
@@ -216,31 +274,32 @@ void ICUPreprocessor_c::AddTextChunk ( const BYTE * pStart, int iLen, CSphVector
 
 void ICUPreprocessor_c::ProcessBufferICU ( const BYTE * pBuffer, int iLength )
 {
-	assert ( m_pBreakIterator );
+	assert ( m_pCtx );
+	icu::BreakIterator * pIterator = m_pCtx->m_pBreakIterator.Ptr();
+
+	// reuse thread's UText; iterator keeps its own shallow clone of it
 	UErrorCode tStatus = U_ZERO_ERROR;
-	UText * pUText = nullptr;
-	pUText = utext_openUTF8 ( pUText, (const char*)pBuffer, iLength, &tStatus );
+	UText * pUText = utext_openUTF8 ( &m_pCtx->m_tText, (const char*)pBuffer, iLength, &tStatus );
 	if ( U_FAILURE(tStatus) )
 		sphWarning ( "Error processing buffer (ICU): %s", u_errorName(tStatus) );
 
 	assert ( pUText );
-	m_pBreakIterator->setText ( pUText, tStatus );
+	pIterator->setText ( pUText, tStatus );
 	if ( U_FAILURE(tStatus) )
 		sphWarning ( "Error processing buffer (ICU): %s", u_errorName(tStatus) );
 
-	utext_close ( pUText );
-
 	m_pBuffer = pBuffer;
-	m_iPrevBoundary = m_iBoundaryIndex = m_pBreakIterator->first();
+	m_iPrevBoundary = m_iBoundaryIndex = pIterator->first();
 }
 
 
 const BYTE * ICUPreprocessor_c::GetNextTokenICU ( int & iTokenLen )
 {
-	if ( !m_pBreakIterator || m_iBoundaryIndex==icu::BreakIterator::DONE )
+	if ( !m_pCtx || m_iBoundaryIndex==icu::BreakIterator::DONE )
 		return nullptr;
 
-	while ( ( m_iBoundaryIndex = m_pBreakIterator->next() )!=icu::BreakIterator::DONE )
+	icu::BreakIterator * pIterator = m_pCtx->m_pBreakIterator.Ptr();
+	while ( ( m_iBoundaryIndex = pIterator->next() )!=icu::BreakIterator::DONE )
 	{
 		int iLength = m_iBoundaryIndex-m_iPrevBoundary;
 
@@ -290,6 +349,9 @@ bool ICUPreprocessor_c::IsBlendChar ( int iCode ) const
 
 
 //////////////////////////////////////////////////////////////////////////
+// segmentation stays a field filter rather than a token source inside the tokenizer: tokenizer keeps at most
+// SPH_MAX_WORD_LEN codepoints of a token and drops the rest, and an unsegmented CJK run is one token for it;
+// also query parser and snippets would both need their own hook, while they all get the filtered text already
 class FieldFilterICU_c : public ISphFieldFilter, public ICUPreprocessor_c
 {
 public:
@@ -306,10 +368,14 @@ int FieldFilterICU_c::Apply ( const BYTE * sField, int iLength, CSphVector<BYTE>
 		int iResultLength = m_pParent->Apply ( sField, iLength, dStorage, bQuery );
 		if ( iResultLength ) // can't use dStorage.GetLength() because of the safety gap
 		{
-			CSphFixedVector<BYTE> dTmp ( iResultLength );
-			memcpy ( dTmp.Begin(), dStorage.Begin(), dStorage.GetLength() );
-			if ( !Process ( dTmp.Begin(), iLength, dStorage, bQuery ) )
+			// parent's output becomes our input as is, no copy
+			CSphVector<BYTE> dParentOut;
+			dParentOut.SwapData ( dStorage );
+			if ( !Process ( dParentOut.Begin(), iResultLength, dStorage, bQuery ) )
+			{
+				dStorage.SwapData ( dParentOut );
 				return iResultLength;
+			}
 
 			// add safety gap
 			int iStorageLength = dStorage.GetLength();
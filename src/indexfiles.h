@@ -31,6 +31,7 @@ enum ESphExt {
 	SPH_EXT_SPT,
 	SPH_EXT_SPHI,
 	SPH_EXT_SPDS,
+	SPH_EXT_SPIF,
 	SPH_EXT_SPL,
 	SPH_EXT_SETTINGS,
 
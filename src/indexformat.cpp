@@ -11,6 +11,7 @@
 //
 
 #include "indexformat.h"
+#include "lrucache.h"
 
 // let uDocs be DWORD here to prevent int overflow in case of hitless word (highest bit is 1)
 int DoclistHintUnpack ( DWORD uDocs, BYTE uHint )
@@ -260,6 +261,183 @@ struct DictEntryDiskPayload_t
 
 //////////////////////////////////////////////////////////////////////////
 
+/// disk dictionaries are immutable, so wildcard expansions (before expansion_limit is applied) are cached per index
+struct ExpansionCacheKey_t
+{
+	int64_t		m_iIndexId;
+	uint64_t	m_uHash;
+
+	bool operator == ( const ExpansionCacheKey_t & tKey ) const { return m_iIndexId==tKey.m_iIndexId && m_uHash==tKey.m_uHash; }
+};
+
+
+struct ExpansionCacheEntry_t
+{
+	CSphVector<BYTE>					m_dKey;		///< full key (pattern and expansion settings) to tell apart hash collisions
+	CSphVector<DiskExpandedEntry_t>		m_dWordExpand;
+	CSphVector<DiskExpandedPayload_t>	m_dWordPayload;
+	CSphVector<BYTE>					m_dWordBuf;
+};
+
+
+struct ExpansionCacheUtil_t
+{
+	static DWORD GetHash ( ExpansionCacheKey_t tKey )
+	{
+		DWORD uCRC32 = sphCRC32 ( &tKey.m_iIndexId, sizeof(tKey.m_iIndexId) );
+		return sphCRC32 ( &tKey.m_uHash, sizeof(tKey.m_uHash), uCRC32 );
+	}
+
+	static DWORD GetSize ( ExpansionCacheEntry_t * pValue )
+	{
+		if ( !pValue )
+			return 0;
+
+		return DWORD ( pValue->m_dKey.GetLengthBytes() + pValue->m_dWordExpand.GetLengthBytes() + pValue->m_dWordPayload.GetLengthBytes() + pValue->m_dWordBuf.GetLengthBytes() );
+	}
+
+	static void Reset ( ExpansionCacheEntry_t * & pValue ) { SafeDelete(pValue); }
+};
+
+
+class ExpansionCache_c : public LRUCache_T<ExpansionCacheKey_t, ExpansionCacheEntry_t*, ExpansionCacheUtil_t>
+{
+	using BASE = LRUCache_T<ExpansionCacheKey_t, ExpansionCacheEntry_t*, ExpansionCacheUtil_t>;
+	using BASE::BASE;
+
+public:
+	void						DeleteAll ( int64_t iIndexId ) { BASE::Delete ( [iIndexId]( const ExpansionCacheKey_t & tKey ){ return tKey.m_iIndexId==iIndexId; } ); }
+
+	static void					Init ( int64_t iCacheSize );
+	static void					Done()	{ SafeDelete(m_pExpansionCache); }
+	static ExpansionCache_c *	Get()	{ return m_pExpansionCache; }
+
+private:
+	static ExpansionCache_c *	m_pExpansionCache;
+};
+
+ExpansionCache_c * ExpansionCache_c::m_pExpansionCache = nullptr;
+
+
+void ExpansionCache_c::Init ( int64_t iCacheSize )
+{
+	assert ( !m_pExpansionCache );
+	if ( iCacheSize > 0 )
+		m_pExpansionCache = new ExpansionCache_c(iCacheSize);
+}
+
+
+void InitExpansionCache ( int64_t iCacheSize )
+{
+	ExpansionCache_c::Init(iCacheSize);
+}
+
+
+void ShutdownExpansionCache()
+{
+	ExpansionCache_c::Done();
+}
+
+
+void ExpansionCacheKey ( char cType, const char * sSubstring, int iSubLen, const char * sWildcard, const ISphWordlist::Args_t & tArgs, CSphVector<BYTE> & dKey )
+{
+	dKey.Add ( cType );
+	dKey.Add ( tArgs.m_bPayload );
+	dKey.Add ( tArgs.m_bHasExactForms );
+	dKey.Add ( (BYTE)tArgs.m_eHitless );
+	dKey.Append ( sSubstring, iSubLen );
+	dKey.Add ( 0 );
+	dKey.Append ( sWildcard, (int)strlen ( sWildcard ) );
+}
+
+
+uint64_t ExpansionCacheHash ( const VecTraits_T<BYTE> & dKey )
+{
+	return sphFNV64 ( dKey.Begin(), dKey.GetLength() );
+}
+
+/// hash only picks the slot; full key is compared as well, so that colliding patterns don't share expansions
+template <typename FN>
+static bool ExpansionFromCache ( int64_t iIndexId, uint64_t uHash, const VecTraits_T<BYTE> & dKey, FN && fnCopyOut )
+{
+	ExpansionCache_c * pCache = ExpansionCache_c::Get();
+	if ( !pCache || iIndexId<0 )
+		return false;
+
+	ExpansionCacheKey_t tKey { iIndexId, uHash };
+	ExpansionCacheEntry_t * pEntry = nullptr;
+	if ( !pCache->Find ( tKey, pEntry ) )
+		return false;
+
+	bool bHit = pEntry->m_dKey.GetLength()==dKey.GetLength() && !memcmp ( pEntry->m_dKey.Begin(), dKey.Begin(), dKey.GetLengthBytes() );
+	if ( bHit )
+		fnCopyOut ( *pEntry );
+
+	pCache->Release ( tKey );
+	return bHit;
+}
+
+
+static void ExpansionToCache ( int64_t iIndexId, uint64_t uHash, ExpansionCacheEntry_t * pEntry )
+{
+	ExpansionCache_c * pCache = ExpansionCache_c::Get();
+	if ( !pCache || iIndexId<0 || sphInterrupted() )
+	{
+		SafeDelete ( pEntry );
+		return;
+	}
+
+	ExpansionCacheKey_t tKey { iIndexId, uHash };
+	if ( pCache->Add ( tKey, pEntry ) )
+		pCache->Release ( tKey );
+	else
+		SafeDelete ( pEntry );
+}
+
+
+static bool ExpansionFromCache ( int64_t iIndexId, const CSphVector<BYTE> & dKey, DictEntryDiskPayload_t & tDict2Payload )
+{
+	return ExpansionFromCache ( iIndexId, ExpansionCacheHash ( dKey ), dKey, [&tDict2Payload] ( const ExpansionCacheEntry_t & tEntry )
+	{
+		// copy out; expansion_limit is applied by Convert() and modifies the lists
+		tDict2Payload.m_dWordExpand = tEntry.m_dWordExpand;
+		tDict2Payload.m_dWordPayload = tEntry.m_dWordPayload;
+		tDict2Payload.m_dWordBuf = tEntry.m_dWordBuf;
+	} );
+}
+
+
+static void ExpansionToCache ( int64_t iIndexId, CSphVector<BYTE> & dKey, const DictEntryDiskPayload_t & tDict2Payload )
+{
+	if ( !ExpansionCache_c::Get() || iIndexId<0 || sphInterrupted() )
+		return;
+
+	uint64_t uHash = ExpansionCacheHash ( dKey );
+	auto * pEntry = new ExpansionCacheEntry_t;
+	pEntry->m_dKey.SwapData ( dKey );
+	pEntry->m_dWordExpand = tDict2Payload.m_dWordExpand;
+	pEntry->m_dWordPayload = tDict2Payload.m_dWordPayload;
+	pEntry->m_dWordBuf = tDict2Payload.m_dWordBuf;
+	ExpansionToCache ( iIndexId, uHash, pEntry );
+}
+
+
+bool ExpansionCacheFind ( int64_t iIndexId, uint64_t uHash, const VecTraits_T<BYTE> & dKey, CSphVector<BYTE> & dWords )
+{
+	return ExpansionFromCache ( iIndexId, uHash, dKey, [&dWords] ( const ExpansionCacheEntry_t & tEntry ) { dWords = tEntry.m_dWordBuf; } );
+}
+
+
+void ExpansionCacheAdd ( int64_t iIndexId, uint64_t uHash, const VecTraits_T<BYTE> & dKey, const VecTraits_T<BYTE> & dWords )
+{
+	auto * pEntry = new ExpansionCacheEntry_t;
+	pEntry->m_dKey.Append ( dKey );
+	pEntry->m_dWordBuf.Append ( dWords );
+	ExpansionToCache ( iIndexId, uHash, pEntry );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
 CWordlist::~CWordlist ()
 {
 	Reset();
@@ -268,6 +446,11 @@ CWordlist::~CWordlist ()
 
 void CWordlist::Reset ()
 {
+	ExpansionCache_c * pExpansionCache = ExpansionCache_c::Get();
+	if ( pExpansionCache && m_iExpansionCacheId>=0 )
+		pExpansionCache->DeleteAll ( m_iExpansionCacheId );
+	m_iExpansionCacheId = -1;
+
 	m_tBuf.Reset ();
 	m_dCheckpoints.Reset ( 0 );
 	m_pWords.Reset ( 0 );
@@ -514,6 +697,14 @@ void CWordlist::GetPrefixedWords ( const char * sSubstring, int iSubLen, const c
 
 	DictEntryDiskPayload_t tDict2Payload ( tArgs.m_bPayload, tArgs.m_eHitless );
 
+	CSphVector<BYTE> dCacheKey;
+	ExpansionCacheKey ( 'p', sSubstring, iSubLen, sWildcard, tArgs, dCacheKey );
+	if ( ExpansionFromCache ( m_iExpansionCacheId, dCacheKey, tDict2Payload ) )
+	{
+		tDict2Payload.Convert ( tArgs );
+		return;
+	}
+
 	int dWildcard [ SPH_MAX_WORD_LEN + 1 ];
 	int * pWildcard = ( sphIsUTF8 ( sWildcard ) && sphUTF8ToWideChar ( sWildcard, dWildcard, SPH_MAX_WORD_LEN ) ) ? dWildcard : NULL;
 
@@ -551,6 +742,7 @@ void CWordlist::GetPrefixedWords ( const char * sSubstring, int iSubLen, const c
 			break;
 	}
 
+	ExpansionToCache ( m_iExpansionCacheId, dCacheKey, tDict2Payload );
 	tDict2Payload.Convert ( tArgs );
 }
 
@@ -564,6 +756,16 @@ void CWordlist::GetInfixedWords ( const char * sSubstring, int iSubLen, const ch
 
 	assert ( !m_pCpReader );
 
+	DictEntryDiskPayload_t tDict2Payload ( tArgs.m_bPayload, tArgs.m_eHitless );
+
+	CSphVector<BYTE> dCacheKey;
+	ExpansionCacheKey ( 'i', sSubstring, iSubLen, sWildcard, tArgs, dCacheKey );
+	if ( ExpansionFromCache ( m_iExpansionCacheId, dCacheKey, tDict2Payload ) )
+	{
+		tDict2Payload.Convert ( tArgs );
+		return;
+	}
+
 	// extract key1, upto 6 chars from infix start
 	int iBytes1 = sphGetInfixLength ( sSubstring, iSubLen, m_iInfixCodepointBytes );
 
@@ -573,7 +775,6 @@ void CWordlist::GetInfixedWords ( const char * sSubstring, int iSubLen, const ch
 	if ( !sphLookupInfixCheckpoints ( sSubstring, iBytes1, m_tBuf.GetWritePtr(), m_dInfixBlocks, m_iInfixCodepointBytes, dPoints ) )
 		return;
 
-	DictEntryDiskPayload_t tDict2Payload ( tArgs.m_bPayload, tArgs.m_eHitless );
 	const int iSkipMagic = ( tArgs.m_bHasExactForms ? 1 : 0 ); // whether to skip heading magic chars in the prefix, like NONSTEMMED maker
 
 	int dWildcard [ SPH_MAX_WORD_LEN + 1 ];
@@ -601,6 +802,7 @@ void CWordlist::GetInfixedWords ( const char * sSubstring, int iSubLen, const ch
 			break;
 	}
 
+	ExpansionToCache ( m_iExpansionCacheId, dCacheKey, tDict2Payload );
 	tDict2Payload.Convert ( tArgs );
 }
 
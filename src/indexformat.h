@@ -40,6 +40,10 @@ public:
 	FileBlockReaderPtr_c	m_rdDoclist;	///< my doclist accessor
 	FileBlockReaderPtr_c	m_rdHitlist;	///< my hitlist accessor
 
+	SphOffset_t		m_iDoclistOffset = 0;	///< doclist start and size hint, to rewind after decoding it into a bitmap
+	int				m_iDoclistHint = 0;
+	RowID_t			m_iRowsCount = 0;		///< total rows in the index (the bitmap size)
+
 
 					DiskIndexQwordTraits_c ( bool bUseMini, bool bExcluded );
 
@@ -123,6 +127,7 @@ public:
 	SphOffset_t							GetWordsEnd() const { return m_iWordsEnd; }
 
 	void								DebugPopulateCheckpoints();
+	void								SetExpansionCacheId ( int64_t iIndexId ) { m_iExpansionCacheId = iIndexId; }
 
 private:
 	bool								m_bWordDict = false;
@@ -133,8 +138,15 @@ private:
 
 	SphOffset_t							m_iWordsEnd = 0;		///< end of wordlist
 	CheckpointReader_c *				m_pCpReader = nullptr;
+	int64_t								m_iExpansionCacheId = -1;	///< key of this wordlist in the expansion cache; -1 means not cached
 };
 
+// expansion cache internals, exposed for testing; the cached words are just the raw expansion buffer here
+void		ExpansionCacheKey ( char cType, const char * sSubstring, int iSubLen, const char * sWildcard, const ISphWordlist::Args_t & tArgs, CSphVector<BYTE> & dKey );
+uint64_t	ExpansionCacheHash ( const VecTraits_T<BYTE> & dKey );
+bool		ExpansionCacheFind ( int64_t iIndexId, uint64_t uHash, const VecTraits_T<BYTE> & dKey, CSphVector<BYTE> & dWords );
+void		ExpansionCacheAdd ( int64_t iIndexId, uint64_t uHash, const VecTraits_T<BYTE> & dKey, const VecTraits_T<BYTE> & dWords );
+
 
 /// dict=keywords block reader
 class KeywordsBlockReader_c : public CSphDictEntry
@@ -271,6 +271,12 @@ void DocstoreSettings_t::Format ( SettingsFormatter_c & tOut, FilenameBuilder_i
 	tOut.Add ( "docstore_compression",			CompressionToStr(m_eCompression), m_eCompression!=tDefault.m_eCompression );
 	tOut.Add ( "docstore_compression_level",	m_iCompressionLevel,	m_iCompressionLevel!=tDefault.m_iCompressionLevel );
 	tOut.Add ( "docstore_block_size",			m_uBlockSize,			m_uBlockSize!=tDefault.m_uBlockSize );
+
+	StringBuilder_c sSeparateFields(",");
+	for ( const auto & i : m_dSeparateFields )
+		sSeparateFields << i;
+
+	tOut.Add ( "docstore_separate_fields",		sSeparateFields.cstr(),	!m_dSeparateFields.IsEmpty() );
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -759,6 +765,11 @@ bool CSphIndexSettings::ParseDocstoreSettings ( const CSphConfigSection & hIndex
 	m_uBlockSize = hIndex.GetSize ( "docstore_block_size", DEFAULT_DOCSTORE_BLOCK );
 	m_iCompressionLevel = hIndex.GetInt ( "docstore_compression_level", DEFAULT_COMPRESSION_LEVEL );
 
+	CSphString sSeparateFields = hIndex.GetStr ( "docstore_separate_fields" );
+	sSeparateFields.ToLower();
+	sphSplit ( m_dSeparateFields, sSeparateFields.cstr() );
+	m_dSeparateFields.Uniq();
+
 	if ( !hIndex.Exists("docstore_compression") )
 		return true;
 
@@ -1977,6 +1988,7 @@ enum class MutableName_e
 	ACCESS_HITLISTS,
 	READ_BUFFER_DOCS,
 	READ_BUFFER_HITS,
+	ROLLUP,
 
 	TOTAL
 };
@@ -1994,6 +2006,7 @@ const char * GetMutableName ( MutableName_e eName )
 		case MutableName_e::ACCESS_HITLISTS: return "access_hitlists";
 		case MutableName_e::READ_BUFFER_DOCS: return "read_buffer_docs";
 		case MutableName_e::READ_BUFFER_HITS: return "read_buffer_hits";
+		case MutableName_e::ROLLUP: return "rollup";
 		default: assert ( 0 && "Invalid mutable option" ); return "";
 	}
 }
@@ -2178,6 +2191,17 @@ bool MutableIndexSettings_c::Load ( const char * sFileName, const char * sIndexN
 		sError = "";
 	}
 
+	JsonObj_c tRollup = tParser.GetStrItem ( "rollup", sError, true );
+	if ( tRollup )
+	{
+		m_sRollup = tRollup.StrVal();
+		m_dLoaded.BitSet ( (int)MutableName_e::ROLLUP );
+	} else if ( !sError.IsEmpty() )
+	{
+		sphWarning ( "index %s: %s", sIndexName, sError.cstr() );
+		sError = "";
+	}
+
 	m_bNeedSave = true;
 
 	return true;
@@ -2248,6 +2272,12 @@ void MutableIndexSettings_c::Load ( const CSphConfigSection & hIndex, bool bNeed
 		m_tFileAccess.m_iReadBufferHitList = GetReadBuffer ( hIndex.GetInt ( "read_buffer_hits", m_tFileAccess.m_iReadBufferHitList ) );
 		m_dLoaded.BitSet ( (int)MutableName_e::READ_BUFFER_HITS );
 	}
+
+	if ( hIndex.Exists ( "rollup" ) )
+	{
+		m_sRollup = hIndex.GetStr ( "rollup" );
+		m_dLoaded.BitSet ( (int)MutableName_e::ROLLUP );
+	}
 }
 
 static void AddStr ( const CSphBitvec & dLoaded, MutableName_e eName, JsonObj_c & tRoot, const char * sVal )
@@ -2300,6 +2330,7 @@ bool MutableIndexSettings_c::Save ( CSphString & sBuf ) const
 
 	AddInt ( m_dLoaded, MutableName_e::READ_BUFFER_DOCS, tRoot, m_tFileAccess.m_iReadBufferDocList );
 	AddInt ( m_dLoaded, MutableName_e::READ_BUFFER_HITS, tRoot, m_tFileAccess.m_iReadBufferHitList );
+	AddStr ( m_dLoaded, MutableName_e::ROLLUP, tRoot, m_sRollup.cstr() );
 
 	sBuf = tRoot.AsString ( true );
 
@@ -2357,6 +2388,12 @@ void MutableIndexSettings_c::Combine ( const MutableIndexSettings_c & tOther )
 		m_tFileAccess.m_iReadBufferHitList = tOther.m_tFileAccess.m_iReadBufferHitList;
 		m_dLoaded.BitSet ( (int)MutableName_e::READ_BUFFER_HITS );
 	}
+
+	if ( tOther.m_dLoaded.BitGet ( (int)MutableName_e::ROLLUP ) )
+	{
+		m_sRollup = tOther.m_sRollup;
+		m_dLoaded.BitSet ( (int)MutableName_e::ROLLUP );
+	}
 }
 
 static MutableIndexSettings_c g_tMutableDefaults;
@@ -2394,6 +2431,8 @@ void MutableIndexSettings_c::Format ( SettingsFormatter_c & tOut, FilenameBuilde
 		FormatCond ( m_bNeedSave, m_dLoaded, MutableName_e::READ_BUFFER_DOCS, m_tFileAccess.m_iReadBufferDocList!=tDefaults.m_tFileAccess.m_iReadBufferDocList ) );
 	tOut.Add ( GetMutableName ( MutableName_e::READ_BUFFER_HITS ), m_tFileAccess.m_iReadBufferHitList,
 		FormatCond ( m_bNeedSave, m_dLoaded, MutableName_e::READ_BUFFER_HITS, m_tFileAccess.m_iReadBufferHitList!=tDefaults.m_tFileAccess.m_iReadBufferHitList ) );
+	tOut.Add ( GetMutableName ( MutableName_e::ROLLUP ), m_sRollup.cstr(),
+		FormatCond ( m_bNeedSave, m_dLoaded, MutableName_e::ROLLUP, !m_sRollup.IsEmpty() ) );
 }
 
 void SaveMutableSettings ( const MutableIndexSettings_c & tSettings, const CSphString & sPath )
@@ -216,6 +216,7 @@ struct DocstoreSettings_t : public SettingsWriter_c
 	Compression_e	m_eCompression		= Compression_e::LZ4;
 	int				m_iCompressionLevel	= DEFAULT_COMPRESSION_LEVEL;
 	DWORD			m_uBlockSize		= DEFAULT_DOCSTORE_BLOCK;
+	StrVec_t		m_dSeparateFields;	///< stored fields that get block streams of their own
 
 	void			Format ( SettingsFormatter_c & tOut, FilenameBuilder_i * pFilenameBuilder ) const override;
 };
@@ -315,6 +316,7 @@ public:
 	int64_t		m_iMemLimit;
 	bool		m_bPreopen = false;
 	FileAccessSettings_t m_tFileAccess;
+	CSphString	m_sRollup;		///< declared rollups of RT index, see rollup.h
 	
 	MutableIndexSettings_c();
 
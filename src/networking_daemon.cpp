@@ -33,6 +33,7 @@ using namespace Threads;
 int g_tmWait = -1;
 int	g_iThrottleAction = 0;
 const char * g_sMaxedOutMessage = "maxed out, dismissing client";
+const char * g_sQueueOverloadedMessage = "server is overloaded, query would not start in time; try again later";
 
 /////////////////////////////////////////////////////////////////////////////
 /// CSphWakeupEvent - used to kick poller from outside
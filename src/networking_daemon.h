@@ -20,6 +20,7 @@ extern int g_iThrottleAction;
 extern int g_iThrottleAccept;
 
 extern const char* g_sMaxedOutMessage;
+extern const char* g_sQueueOverloadedMessage;
 
 struct Listener_t
 {
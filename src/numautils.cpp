@@ -0,0 +1,331 @@
+//
+// Copyright (c) 2022, Manticore Software LTD (https://manticoresearch.com)
+// All rights reserved
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License. You should have
+// received a copy of the GPL license along with this program; if you
+// did not, you can find it at http://www.gnu.org/
+//
+
+#include "numautils.h"
+#include "coroutine.h"
+#include "fileutils.h"
+
+#if HAVE_SCHED_SETAFFINITY
+#include <sched.h>
+#endif
+
+namespace {
+
+struct NumaNode_t
+{
+	int							m_iId = 0;		///< os node id
+	CSphVector<int>				m_dCpus;
+	CSphString					m_sPoolName;
+	Threads::WorkerSharedPtr_t	m_pPool;
+	std::atomic<int>			m_iIndexes { 0 };
+	std::atomic<int64_t>		m_iMass { 0 };
+	std::atomic<int64_t>		m_iQueries { 0 };
+};
+
+CSphVector<NumaNode_t *> g_dNodes;
+bool g_bNumaEnabled = false;
+CSphMutex g_tAssignLock;
+
+
+// parse kernel cpu/node list like "0-3,8,10-11"
+CSphVector<int> ParseList ( const CSphString & sList )
+{
+	CSphVector<int> dRes;
+	StrVec_t dRanges;
+	sphSplit ( dRanges, sList.cstr(), "," );
+	for ( auto & sRange : dRanges )
+	{
+		sRange.Trim();
+		if ( sRange.IsEmpty() )
+			continue;
+
+		int iFrom = atoi ( sRange.cstr() );
+		int iTo = iFrom;
+		const char * szDash = strchr ( sRange.cstr(), '-' );
+		if ( szDash )
+			iTo = atoi ( szDash+1 );
+
+		for ( int i = iFrom; i<=iTo; ++i )
+			dRes.Add(i);
+	}
+
+	return dRes;
+}
+
+
+CSphString ReadSysFile ( const char * szFile )
+{
+	CSphString sRes;
+	CSphAutofile tFile;
+	CSphString sError;
+	if ( tFile.Open ( szFile, SPH_O_READ, sError )<0 )
+		return sRes;
+
+	char dBuf[4096];
+	auto iRead = sphRead ( tFile.GetFD(), dBuf, sizeof(dBuf)-1 );
+	if ( iRead<=0 )
+		return sRes;
+
+	dBuf[iRead] = '\0';
+	sRes = dBuf;
+	sRes.Trim();
+	return sRes;
+}
+
+
+void DetectNodes ()
+{
+	CSphString sOnline = ReadSysFile ( "/sys/devices/system/node/online" );
+	for ( int iNode : ParseList ( sOnline ) )
+	{
+		CSphString sFile;
+		sFile.SetSprintf ( "/sys/devices/system/node/node%d/cpulist", iNode );
+		CSphVector<int> dCpus = ParseList ( ReadSysFile ( sFile.cstr() ) );
+		if ( dCpus.IsEmpty() ) // memory-only node
+			continue;
+
+		auto * pNode = new NumaNode_t;
+		pNode->m_iId = iNode;
+		pNode->m_dCpus = std::move ( dCpus );
+		pNode->m_sPoolName.SetSprintf ( "work_n%d", iNode );
+		g_dNodes.Add ( pNode );
+	}
+}
+
+} // namespace
+
+
+void Numa::Configure ( bool bEnabled )
+{
+	if ( !bEnabled )
+		return;
+
+#if HAVE_SCHED_SETAFFINITY
+	DetectNodes();
+#endif
+
+	if ( g_dNodes.GetLength()<2 )
+	{
+		sphInfo ( "numa_aware: %d node(s) with cpus found, NUMA awareness is not enabled", g_dNodes.GetLength() );
+		for ( auto * pNode : g_dNodes )
+			SafeDelete ( pNode );
+		g_dNodes.Reset();
+		return;
+	}
+
+	g_bNumaEnabled = true;
+	sphInfo ( "numa_aware: using %d nodes", g_dNodes.GetLength() );
+}
+
+
+bool Numa::IsEnabled()
+{
+	return g_bNumaEnabled;
+}
+
+
+int Numa::NodesCount()
+{
+	return g_bNumaEnabled ? g_dNodes.GetLength() : 1;
+}
+
+
+bool Numa::PinCurrentThread ( int iNode )
+{
+#if HAVE_SCHED_SETAFFINITY
+	if ( !g_bNumaEnabled || iNode<0 || iNode>=g_dNodes.GetLength() )
+		return false;
+
+	cpu_set_t tSet;
+	CPU_ZERO ( &tSet );
+	for ( int iCpu : g_dNodes[iNode]->m_dCpus )
+		if ( iCpu<CPU_SETSIZE )
+			CPU_SET ( iCpu, &tSet );
+
+	if ( sched_setaffinity ( 0, sizeof(tSet), &tSet )!=0 )
+	{
+		sphWarning ( "numa_aware: failed to bind thread to node %d: %s", g_dNodes[iNode]->m_iId, strerrorm(errno) );
+		return false;
+	}
+
+	return true;
+#else
+	return false;
+#endif
+}
+
+
+void Numa::StartNodePools ( int iThreads )
+{
+	if ( !g_bNumaEnabled )
+		return;
+
+	CSphVector<int> dNodeCpus;
+	for ( const auto * pNode : g_dNodes )
+		dNodeCpus.Add ( pNode->m_dCpus.GetLength() );
+
+	CSphVector<int> dNodeThreads;
+	SplitNodeThreads ( iThreads, dNodeCpus, dNodeThreads );
+
+	ARRAY_FOREACH ( i, g_dNodes )
+	{
+		NumaNode_t & tNode = *g_dNodes[i];
+		tNode.m_pPool = Threads::MakeThreadPool ( dNodeThreads[i], tNode.m_sPoolName.cstr(), i );
+		WipeSchedulerOnFork ( tNode.m_pPool );
+	}
+}
+
+
+int Numa::CommonPoolThreads ( int iThreads, int iNodes )
+{
+	if ( iNodes<=0 )
+		return iThreads;
+
+	return Max ( 1, iThreads / ( iNodes+1 ) );
+}
+
+
+void Numa::SplitNodeThreads ( int iThreads, const VecTraits_T<int> & dNodeCpus, CSphVector<int> & dNodeThreads )
+{
+	dNodeThreads.Resize ( dNodeCpus.GetLength() );
+	if ( dNodeCpus.IsEmpty() )
+		return;
+
+	int iTotalCpus = 0;
+	for ( int iCpus : dNodeCpus )
+		iTotalCpus += iCpus;
+	iTotalCpus = Max ( iTotalCpus, 1 );
+
+	// proportional shares rounded down; the leftover goes one by one to the nodes with the largest remainders
+	CSphVector<std::pair<int64_t,int>> dRemainders;
+	int iLeft = iThreads;
+	ARRAY_FOREACH ( i, dNodeCpus )
+	{
+		int64_t iShare = (int64_t)iThreads * dNodeCpus[i];
+		dNodeThreads[i] = int ( iShare / iTotalCpus );
+		iLeft -= dNodeThreads[i];
+		dRemainders.Add ( { iShare % iTotalCpus, i } );
+	}
+
+	dRemainders.Sort ( Lesser ( [] ( const std::pair<int64_t,int> & tA, const std::pair<int64_t,int> & tB ) { return tA.first>tB.first || ( tA.first==tB.first && tA.second<tB.second ); } ) );
+	for ( int i = 0; i<iLeft && i<dRemainders.GetLength(); ++i )
+		++dNodeThreads[dRemainders[i].second];
+
+	for ( auto & iNodeThreads : dNodeThreads )
+		iNodeThreads = Max ( 1, iNodeThreads );
+}
+
+
+Threads::Worker_i * Numa::NodeWorkPool ( int iNode )
+{
+	if ( !g_bNumaEnabled || iNode<0 || iNode>=g_dNodes.GetLength() )
+		return nullptr;
+
+	return g_dNodes[iNode]->m_pPool;
+}
+
+
+int Numa::AssignIndexNode()
+{
+	if ( !g_bNumaEnabled )
+		return -1;
+
+	ScopedMutex_t tLock ( g_tAssignLock );
+	int iBest = 0;
+	ARRAY_FOREACH ( i, g_dNodes )
+	{
+		const NumaNode_t & tNode = *g_dNodes[i];
+		const NumaNode_t & tBest = *g_dNodes[iBest];
+		if ( tNode.m_iMass<tBest.m_iMass || ( tNode.m_iMass==tBest.m_iMass && tNode.m_iIndexes<tBest.m_iIndexes ) )
+			iBest = i;
+	}
+
+	++g_dNodes[iBest]->m_iIndexes;
+	return iBest;
+}
+
+
+void Numa::AddIndexMass ( int iNode, int64_t iMass )
+{
+	if ( !g_bNumaEnabled || iNode<0 || iNode>=g_dNodes.GetLength() )
+		return;
+
+	g_dNodes[iNode]->m_iMass += iMass;
+}
+
+
+void Numa::RunOnNode ( int iNode, Threads::Handler fnHandler )
+{
+	if ( !g_bNumaEnabled || iNode<0 || iNode>=g_dNodes.GetLength() )
+	{
+		fnHandler();
+		return;
+	}
+
+	SphThread_t tThd;
+	bool bStarted = Threads::Create ( &tThd, [iNode, &fnHandler] {
+		PinCurrentThread ( iNode );
+		fnHandler();
+	}, false, "numa_touch", iNode );
+
+	if ( !bStarted )
+	{
+		fnHandler();
+		return;
+	}
+
+	Threads::Join ( &tThd );
+}
+
+
+Numa::ScopedNode_c::ScopedNode_c ( int iNode )
+{
+	Threads::Worker_i * pPool = NodeWorkPool ( iNode );
+	if ( !pPool || !Threads::IsInsideCoroutine() )
+		return;
+
+	g_dNodes[iNode]->m_iQueries.fetch_add ( 1, std::memory_order_relaxed );
+	m_pOrigin = Threads::Coro::CurrentScheduler();
+	if ( !m_pOrigin || m_pOrigin==pPool )
+	{
+		m_pOrigin = nullptr;
+		return;
+	}
+
+	Threads::Coro::MoveTo ( pPool );
+}
+
+
+Numa::ScopedNode_c::~ScopedNode_c()
+{
+	if ( m_pOrigin )
+		Threads::Coro::MoveTo ( m_pOrigin );
+}
+
+
+Numa::NodeStatus_t Numa::GetNodeStatus ( int iNode )
+{
+	NodeStatus_t tStatus;
+	if ( !g_bNumaEnabled || iNode<0 || iNode>=g_dNodes.GetLength() )
+		return tStatus;
+
+	const NumaNode_t & tNode = *g_dNodes[iNode];
+	tStatus.m_iId = tNode.m_iId;
+	if ( tNode.m_pPool )
+	{
+		tStatus.m_iThreads = tNode.m_pPool->WorkingThreads();
+		tStatus.m_iWorks = tNode.m_pPool->Works();
+	}
+
+	tStatus.m_iIndexes = tNode.m_iIndexes;
+	tStatus.m_iMass = tNode.m_iMass;
+	tStatus.m_iQueries = tNode.m_iQueries.load ( std::memory_order_relaxed );
+	return tStatus;
+}
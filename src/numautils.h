@@ -0,0 +1,67 @@
+//
+// Copyright (c) 2022, Manticore Software LTD (https://manticoresearch.com)
+// All rights reserved
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License. You should have
+// received a copy of the GPL license along with this program; if you
+// did not, you can find it at http://www.gnu.org/
+//
+
+/// @file numautils.h
+/// Optional NUMA awareness: per-node worker pools with pinned threads, index-to-node assignment and query routing
+
+#pragma once
+
+#include "threadutils.h"
+
+namespace Numa
+{
+	/// detect nodes and enable NUMA awareness (only if bEnabled and there are at least 2 nodes with cpus)
+	void Configure ( bool bEnabled );
+	bool IsEnabled();
+	int NodesCount();
+
+	/// bind calling thread to the cpus of given node
+	bool PinCurrentThread ( int iNode );
+
+	/// create per-node pools; iThreads is their total (at least one per node), it is distributed according to cpus on nodes
+	void StartNodePools ( int iThreads );
+
+	/// threads budget arithmetic, exposed for testing
+	/// common pool gets a share of one node out of iThreads; with no nodes it gets all of them
+	int CommonPoolThreads ( int iThreads, int iNodes );
+	/// split iThreads between nodes proportionally to their cpus; every node gets at least one
+	void SplitNodeThreads ( int iThreads, const VecTraits_T<int> & dNodeCpus, CSphVector<int> & dNodeThreads );
+	Threads::Worker_i * NodeWorkPool ( int iNode );
+
+	/// choose node for an index (least loaded one by mass), and account index mass there
+	int AssignIndexNode();
+	void AddIndexMass ( int iNode, int64_t iMass );
+
+	/// run handler on a temporary thread pinned to the node, so that pages it first touches are allocated there
+	void RunOnNode ( int iNode, Threads::Handler fnHandler );
+
+	/// move current coroutine to the pool of the node for its lifetime, then back
+	class ScopedNode_c : public ISphNoncopyable
+	{
+	public:
+		explicit ScopedNode_c ( int iNode );
+		~ScopedNode_c();
+
+	private:
+		Threads::Scheduler_i * m_pOrigin = nullptr;
+	};
+
+	struct NodeStatus_t
+	{
+		int		m_iId = 0;
+		int		m_iThreads = 0;
+		int		m_iIndexes = 0;
+		int64_t	m_iMass = 0;
+		int64_t	m_iQueries = 0;
+		int		m_iWorks = 0;
+	};
+
+	NodeStatus_t GetNodeStatus ( int iNode );
+}
@@ -0,0 +1,296 @@
+//
+// Copyright (c) 2022, Manticore Software LTD (https://manticoresearch.com)
+// All rights reserved
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License. You should have
+// received a copy of the GPL license along with this program; if you
+// did not, you can find it at http://www.gnu.org/
+//
+
+#include "resultcache.h"
+#include "attribute.h"
+
+class RcacheEntry_c;
+
+/// entry link in one of the cache lists
+struct RcacheNode_t : public ListNode_t
+{
+	RcacheEntry_c * m_pEntry = nullptr;
+};
+
+/// cached result set; never changes once it is in the cache, so it is copied out without the cache lock
+class RcacheEntry_c : public ISphRefcountedMT
+{
+	~RcacheEntry_c() override {}
+
+public:
+	AggrResult_t	m_tRes;
+	uint64_t		m_uLocalVersion = 0;
+	uint64_t		m_uRemoteVersion = 0;
+	int64_t			m_iSize = 0;
+
+	// guarded by the cache lock
+	CSphString		m_sKey;
+	int64_t			m_tmAdded = 0;
+	RcacheNode_t	m_tUsed;	///< in the list of the entries by use, most recent first
+	RcacheNode_t	m_tAdded;	///< in the list of the entries by addition, newest first
+
+	RcacheEntry_c()
+	{
+		m_tUsed.m_pEntry = this;
+		m_tAdded.m_pEntry = this;
+	}
+};
+
+using RcacheEntryRefPtr_t = CSphRefcountedPtr<RcacheEntry_c>;
+
+
+class Rcache_c
+{
+public:
+	void					Setup ( int64_t iMaxBytes, int iThreshMsec, int iTtlSec ) EXCLUDES ( m_tLock );
+	RcacheEntryRefPtr_t		Find ( const CSphString & sKey, uint64_t uLocalVersion ) EXCLUDES ( m_tLock );
+	void					Add ( const CSphString & sKey, RcacheEntry_c * pEntry ) EXCLUDES ( m_tLock );
+	RcacheStatus_t			GetStatus() const EXCLUDES ( m_tLock );
+	void					CountHit() { m_iHitsCount.fetch_add ( 1, std::memory_order_relaxed ); }
+	int64_t					GetMaxBytes() const { return m_iMaxBytes.load ( std::memory_order_relaxed ); }
+
+private:
+	mutable CSphMutex		m_tLock;
+	SmallStringHash_T<RcacheEntryRefPtr_t>	m_hEntries GUARDED_BY ( m_tLock );
+	List_t					m_tUsed GUARDED_BY ( m_tLock );
+	List_t					m_tAdded GUARDED_BY ( m_tLock );
+	int64_t					m_iBytes GUARDED_BY ( m_tLock ) = 0;
+	std::atomic<int64_t>	m_iHitsCount { 0 };
+
+	// disabled by default; cached results keep whole match rows, so the memory has to be given explicitly
+	// max bytes is changed under the lock, but also read without it to skip the disabled cache cheaply
+	std::atomic<int64_t>	m_iMaxBytes { 0 };
+	int						m_iThreshMs GUARDED_BY ( m_tLock ) = 3000;
+	int						m_iTtlS GUARDED_BY ( m_tLock ) = 60;
+
+	void					Delete ( const CSphString & sKey ) REQUIRES ( m_tLock );
+	void					Evict ( const ListNode_t * pNode ) REQUIRES ( m_tLock );
+	void					EnforceLimits ( int64_t iReserve ) REQUIRES ( m_tLock );
+};
+
+
+void Rcache_c::Setup ( int64_t iMaxBytes, int iThreshMsec, int iTtlSec )
+{
+	ScopedMutex_t tLock ( m_tLock );
+	m_iMaxBytes.store ( Max ( iMaxBytes, 0 ), std::memory_order_relaxed );
+	m_iThreshMs = Max ( iThreshMsec, 0 );
+	m_iTtlS = Max ( iTtlSec, 1 );
+	EnforceLimits(0);
+}
+
+
+RcacheStatus_t Rcache_c::GetStatus() const
+{
+	ScopedMutex_t tLock ( m_tLock );
+	RcacheStatus_t tRes;
+	tRes.m_iMaxBytes = GetMaxBytes();
+	tRes.m_iThreshMs = m_iThreshMs;
+	tRes.m_iTtlS = m_iTtlS;
+	tRes.m_iCachedQueries = m_hEntries.GetLength();
+	tRes.m_iUsedBytes = m_iBytes;
+	tRes.m_iHits = m_iHitsCount.load ( std::memory_order_relaxed );
+	return tRes;
+}
+
+
+void Rcache_c::Delete ( const CSphString & sKey )
+{
+	RcacheEntryRefPtr_t * ppEntry = m_hEntries ( sKey );
+	if ( !ppEntry )
+		return;
+
+	RcacheEntry_c * pEntry = *ppEntry;
+	m_tUsed.Remove ( &pEntry->m_tUsed );
+	m_tAdded.Remove ( &pEntry->m_tAdded );
+	m_iBytes -= pEntry->m_iSize;
+	m_hEntries.Delete ( sKey );
+}
+
+
+void Rcache_c::Evict ( const ListNode_t * pNode )
+{
+	// the key is a part of the entry that goes away
+	CSphString sKey = ( (const RcacheNode_t *)pNode )->m_pEntry->m_sKey;
+	Delete ( sKey );
+}
+
+
+void Rcache_c::EnforceLimits ( int64_t iReserve )
+{
+	// expired ones go first, then the least recently used ones; both are at the tails of the lists
+	int64_t tmMin = sphMicroTimer() - (int64_t)m_iTtlS*1000000;
+	while ( m_tAdded.GetLength() && ( (const RcacheNode_t *)m_tAdded.End()->m_pPrev )->m_pEntry->m_tmAdded<tmMin )
+		Evict ( m_tAdded.End()->m_pPrev );
+
+	while ( m_tUsed.GetLength() && m_iBytes+iReserve>GetMaxBytes() )
+		Evict ( m_tUsed.End()->m_pPrev );
+}
+
+
+RcacheEntryRefPtr_t Rcache_c::Find ( const CSphString & sKey, uint64_t uLocalVersion )
+{
+	ScopedMutex_t tLock ( m_tLock );
+	RcacheEntryRefPtr_t * ppEntry = m_hEntries ( sKey );
+	if ( !ppEntry )
+		return RcacheEntryRefPtr_t();
+
+	// stale entry is of no use to anyone; the fresh result will replace it anyway
+	RcacheEntryRefPtr_t pEntry = *ppEntry;
+	int64_t tmNow = sphMicroTimer();
+	if ( pEntry->m_uLocalVersion!=uLocalVersion || pEntry->m_tmAdded<tmNow-(int64_t)m_iTtlS*1000000 )
+	{
+		Delete ( sKey );
+		return RcacheEntryRefPtr_t();
+	}
+
+	m_tUsed.Remove ( &pEntry->m_tUsed );
+	m_tUsed.Add ( &pEntry->m_tUsed );
+	return pEntry;
+}
+
+
+void Rcache_c::Add ( const CSphString & sKey, RcacheEntry_c * pEntry )
+{
+	RcacheEntryRefPtr_t pNew { pEntry };
+
+	ScopedMutex_t tLock ( m_tLock );
+	if ( pNew->m_iSize>GetMaxBytes() )
+		return;
+
+	Delete ( sKey );
+	EnforceLimits ( pNew->m_iSize );
+
+	// stamped under the lock, so that the list by addition is also ordered by time
+	pNew->m_sKey = sKey;
+	pNew->m_tmAdded = sphMicroTimer();
+	m_tUsed.Add ( &pNew->m_tUsed );
+	m_tAdded.Add ( &pNew->m_tAdded );
+	m_iBytes += pNew->m_iSize;
+	m_hEntries.Add ( pNew, sKey );
+}
+
+static Rcache_c g_Rcache;
+
+//////////////////////////////////////////////////////////////////////////
+
+/// deep copy of a finalized result; that is one result set with standalone matches
+static void CopyResult ( AggrResult_t & tDst, const AggrResult_t & tSrc )
+{
+	assert ( tSrc.m_dResults.GetLength()==1 );
+
+	(CSphQueryResultMeta &)tDst = tSrc;
+	tDst.m_pProfile = nullptr;
+	tDst.m_tSchema = tSrc.m_tSchema;
+	tDst.m_dZeroCount = tSrc.m_dZeroCount;
+	tDst.m_iOffset = tSrc.m_iOffset;
+	tDst.m_iCount = tSrc.m_iCount;
+	tDst.m_iSuccesses = tSrc.m_iSuccesses;
+	tDst.m_bTagsAssigned = tSrc.m_bTagsAssigned;
+	Debug ( tDst.m_bSingle = tSrc.m_bSingle; )
+	Debug ( tDst.m_bOneSchema = tSrc.m_bOneSchema; )
+	Debug ( tDst.m_bTagsCompacted = tSrc.m_bTagsCompacted; )
+	Debug ( tDst.m_bIdxByTag = tSrc.m_bIdxByTag; )
+
+	const OneResultset_t & tSrcChunk = tSrc.m_dResults.First();
+	tDst.m_dResults.Reset();
+	OneResultset_t & tDstChunk = tDst.m_dResults.Add();
+	tDstChunk.m_tSchema = tSrcChunk.m_tSchema;
+	tDstChunk.m_bTagsAssigned = tSrcChunk.m_bTagsAssigned;
+	tDstChunk.m_iTag = tSrcChunk.m_iTag;
+	tDstChunk.m_bTag = tSrcChunk.m_bTag;
+	tDstChunk.m_pDocstore = nullptr;
+
+	tDstChunk.m_dMatches.Resize ( tSrcChunk.m_dMatches.GetLength() );
+	ARRAY_FOREACH ( i, tSrcChunk.m_dMatches )
+		tDstChunk.m_tSchema.CloneMatch ( tDstChunk.m_dMatches[i], tSrcChunk.m_dMatches[i] );
+}
+
+
+static int64_t GetResultSize ( const AggrResult_t & tRes )
+{
+	const OneResultset_t & tChunk = tRes.m_dResults.First();
+	const CSphSchema & tSchema = tChunk.m_tSchema;
+	int64_t iSize = sizeof(RcacheEntry_c) + tRes.m_hWordStats.GetLength()*( sizeof(CSphQueryResultMeta::WordStat_t)+32 );
+	iSize += 2*(int64_t)tSchema.GetAttrsCount()*sizeof(CSphColumnInfo);
+	iSize += (int64_t)tChunk.m_dMatches.GetLength()*( sizeof(CSphMatch) + tSchema.GetDynamicSize()*sizeof(CSphRowitem) );
+
+	for ( int i = 0; i < tSchema.GetAttrsCount(); ++i )
+	{
+		const CSphColumnInfo & tAttr = tSchema.GetAttr(i);
+		if ( sphIsDataPtrAttr ( tAttr.m_eAttrType ) )
+			for ( const auto & tMatch : tChunk.m_dMatches )
+				iSize += sphUnpackPtrAttr ( (const BYTE *)tMatch.GetAttr ( tAttr.m_tLocator ) ).second;
+	}
+
+	return iSize;
+}
+
+
+bool RcachePeek ( const CSphString & sKey, uint64_t uLocalVersion, uint64_t & uRemoteVersion )
+{
+	if ( g_Rcache.GetMaxBytes()<=0 || !uLocalVersion )
+		return false;
+
+	RcacheEntryRefPtr_t pEntry = g_Rcache.Find ( sKey, uLocalVersion );
+	if ( !pEntry )
+		return false;
+
+	uRemoteVersion = pEntry->m_uRemoteVersion;
+	return true;
+}
+
+
+bool RcacheFind ( const CSphString & sKey, uint64_t uLocalVersion, uint64_t uRemoteVersion, AggrResult_t & tRes )
+{
+	if ( g_Rcache.GetMaxBytes()<=0 || !uLocalVersion )
+		return false;
+
+	RcacheEntryRefPtr_t pEntry = g_Rcache.Find ( sKey, uLocalVersion );
+	if ( !pEntry || pEntry->m_uRemoteVersion!=uRemoteVersion )
+		return false;
+
+	CopyResult ( tRes, pEntry->m_tRes );
+	g_Rcache.CountHit();
+	return true;
+}
+
+
+void RcacheAdd ( const CSphString & sKey, uint64_t uLocalVersion, uint64_t uRemoteVersion, const AggrResult_t & tRes )
+{
+	if ( g_Rcache.GetMaxBytes()<=0 || !uLocalVersion || tRes.m_dResults.GetLength()!=1 )
+		return;
+
+	// matches still pointing into index rows can not outlive the query
+	if ( tRes.m_dResults.First().m_dMatches.any_of ( [] ( const CSphMatch & tMatch ) { return tMatch.m_pStatic!=nullptr; } ) )
+		return;
+
+	int64_t iSize = GetResultSize ( tRes );
+	if ( iSize>g_Rcache.GetMaxBytes() )
+		return;
+
+	auto * pEntry = new RcacheEntry_c;
+	CopyResult ( pEntry->m_tRes, tRes );
+	pEntry->m_uLocalVersion = uLocalVersion;
+	pEntry->m_uRemoteVersion = uRemoteVersion;
+	pEntry->m_iSize = iSize;
+	g_Rcache.Add ( sKey, pEntry );
+}
+
+
+RcacheStatus_t RcacheGetStatus()
+{
+	return g_Rcache.GetStatus();
+}
+
+
+void RcacheSetup ( int64_t iMaxBytes, int iThreshMsec, int iTtlSec )
+{
+	g_Rcache.Setup ( iMaxBytes, iThreshMsec, iTtlSec );
+}
@@ -0,0 +1,38 @@
+//
+// Copyright (c) 2022, Manticore Software LTD (https://manticoresearch.com)
+// All rights reserved
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License. You should have
+// received a copy of the GPL license along with this program; if you
+// did not, you can find it at http://www.gnu.org/
+//
+
+/// @file resultcache.h
+/// Cache of final (merged, sorted and limited) result sets, validated by the versions of the data they were computed from
+
+#pragma once
+
+#include "searchdaemon.h"
+
+/// result cache status
+struct RcacheStatus_t
+{
+	// settings that can be changed
+	int64_t		m_iMaxBytes = 0;		///< max RAM bytes; 0 disables the cache
+	int			m_iThreshMs = 0;		///< minimum wall time to cache, in msec
+	int			m_iTtlS = 0;			///< cached result TTL, in sec
+
+	// report-only statistics
+	int			m_iCachedQueries = 0;	///< cached results count
+	int64_t		m_iUsedBytes = 0;		///< used RAM bytes
+	int64_t		m_iHits = 0;			///< cache hits
+};
+
+/// results are keyed by the normalized query text; an entry only serves while the data behind it is at the same version
+/// local version covers the local indexes, remote one the agents; both are never 0 in the cache, as 0 means unknown
+bool					RcachePeek ( const CSphString & sKey, uint64_t uLocalVersion, uint64_t & uRemoteVersion );
+bool					RcacheFind ( const CSphString & sKey, uint64_t uLocalVersion, uint64_t uRemoteVersion, AggrResult_t & tRes );
+void					RcacheAdd ( const CSphString & sKey, uint64_t uLocalVersion, uint64_t uRemoteVersion, const AggrResult_t & tRes );
+RcacheStatus_t			RcacheGetStatus();
+void					RcacheSetup ( int64_t iMaxBytes, int iThreshMsec, int iTtlSec );
@@ -0,0 +1,523 @@
+//
+// Copyright (c) 2022, Manticore Software LTD (https://manticoresearch.com)
+// All rights reserved
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License. You should have
+// received a copy of the GPL license along with this program; if you
+// did not, you can find it at http://www.gnu.org/
+//
+
+#include "rollup.h"
+#include "sphinxint.h"
+#include "sphinxsort.h"
+
+static bool ParseAggr ( const CSphString & sAggr, RollupDesc_t::Aggr_t & tAggr )
+{
+	const char * szAggr = sAggr.cstr();
+	const char * pOpen = strchr ( szAggr, '(' );
+	int iLen = sAggr.Length();
+	if ( !pOpen || szAggr[iLen-1]!=')' )
+		return false;
+
+	int iOpen = int ( pOpen-szAggr );
+	CSphString sFunc = sAggr.SubString ( 0, iOpen );
+	tAggr.m_sAttr = sAggr.SubString ( iOpen+1, iLen-iOpen-2 );
+	if ( tAggr.m_sAttr.IsEmpty() )
+		return false;
+
+	if ( sFunc=="sum" )
+		tAggr.m_eFunc = SPH_AGGR_SUM;
+	else if ( sFunc=="min" )
+		tAggr.m_eFunc = SPH_AGGR_MIN;
+	else if ( sFunc=="max" )
+		tAggr.m_eFunc = SPH_AGGR_MAX;
+	else
+		return false;
+
+	return true;
+}
+
+
+bool ParseRollups ( const CSphString & sRollups, CSphVector<RollupDesc_t> & dRollups, CSphString & sError )
+{
+	dRollups.Reset();
+
+	CSphVector<char> dClean;
+	for ( const char * s = sRollups.cstr(); s && *s; ++s )
+		if ( !sphIsSpace(*s) )
+			dClean.Add ( (char)tolower(*s) );
+
+	StrVec_t dDecls;
+	sphSplit ( dDecls, dClean.Begin(), dClean.GetLength(), ";" );
+	for ( const auto & sDecl : dDecls )
+	{
+		if ( sDecl.IsEmpty() )
+			continue;
+
+		const char * pColon = strchr ( sDecl.cstr(), ':' );
+		if ( !pColon || pColon==sDecl.cstr() )
+		{
+			sError.SetSprintf ( "rollup '%s': expected 'key: aggregates' declaration", sDecl.cstr() );
+			return false;
+		}
+
+		RollupDesc_t & tDesc = dRollups.Add();
+		tDesc.m_sKey = sDecl.SubString ( 0, int ( pColon-sDecl.cstr() ) );
+		tDesc.m_sSpec = sDecl;
+
+		StrVec_t dAggrs;
+		sphSplit ( dAggrs, pColon+1, "," );
+		for ( const auto & sAggr : dAggrs )
+		{
+			// count is kept anyway
+			if ( sAggr.IsEmpty() || sAggr=="count(*)" )
+				continue;
+
+			RollupDesc_t::Aggr_t tAggr;
+			if ( !ParseAggr ( sAggr, tAggr ) )
+			{
+				sError.SetSprintf ( "rollup '%s': unsupported aggregate '%s' (only sum, min and max of attributes are)", sDecl.cstr(), sAggr.cstr() );
+				return false;
+			}
+
+			tDesc.m_dAggrs.Add ( tAggr );
+		}
+	}
+
+	return true;
+}
+
+
+static bool IsRollupAttr ( const CSphColumnInfo * pAttr, bool bKey )
+{
+	if ( !pAttr || pAttr->IsColumnar() || pAttr->m_tLocator.IsBlobAttr() )
+		return false;
+
+	switch ( pAttr->m_eAttrType )
+	{
+	case SPH_ATTR_INTEGER:
+	case SPH_ATTR_TIMESTAMP:
+	case SPH_ATTR_BIGINT:
+	case SPH_ATTR_BOOL:
+		return true;
+
+	case SPH_ATTR_FLOAT:
+		return !bKey;
+
+	default:
+		return false;
+	}
+}
+
+
+bool CheckRollups ( const VecTraits_T<RollupDesc_t> & dRollups, const ISphSchema & tSchema, CSphString & sError )
+{
+	for ( const auto & tDesc : dRollups )
+	{
+		if ( !IsRollupAttr ( tSchema.GetAttr ( tDesc.m_sKey.cstr() ), true ) )
+		{
+			sError.SetSprintf ( "rollup '%s': key '%s' must be a row-wise integer attribute", tDesc.m_sSpec.cstr(), tDesc.m_sKey.cstr() );
+			return false;
+		}
+
+		for ( const auto & tAggr : tDesc.m_dAggrs )
+			if ( !IsRollupAttr ( tSchema.GetAttr ( tAggr.m_sAttr.cstr() ), false ) )
+			{
+				sError.SetSprintf ( "rollup '%s': '%s' must be a row-wise integer or float attribute", tDesc.m_sSpec.cstr(), tAggr.m_sAttr.cstr() );
+				return false;
+			}
+	}
+
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+static bool IsGroupMagic ( const CSphString & sName )
+{
+	return sName=="@groupby" || sName=="groupby()" || sName=="@count" || sName=="count(*)";
+}
+
+
+template <typename FN>
+static bool IsSortedBy ( const CSphString & sSortBy, FN && fnAllowed )
+{
+	StrVec_t dTokens;
+	sphSplit ( dTokens, sSortBy.cstr(), ", \t\r\n" );
+	for ( auto & sToken : dTokens )
+	{
+		sToken.ToLower();
+		if ( !sToken.IsEmpty() && sToken!="asc" && sToken!="desc" && !fnAllowed ( sToken ) )
+			return false;
+	}
+
+	return true;
+}
+
+
+static bool MapQuery ( const CSphQuery & tQuery, const ISphSchema & tSorterSchema, const ISphSchema & tIndexSchema, const RollupDesc_t & tDesc, RollupQuery_t & tRollupQuery )
+{
+	const CSphColumnInfo * pKey = tIndexSchema.GetAttr ( tDesc.m_sKey.cstr() );
+	if ( !IsRollupAttr ( pKey, true ) )
+		return false;
+
+	tRollupQuery.m_pDesc = &tDesc;
+	tRollupQuery.m_tLocKey = pKey->m_tLocator;
+	tRollupQuery.m_dLocAggrs.Resize(0);
+	tRollupQuery.m_dFloat.Resize(0);
+	tRollupQuery.m_dColumns.Resize(0);
+
+	for ( const auto & tAggr : tDesc.m_dAggrs )
+	{
+		const CSphColumnInfo * pAttr = tIndexSchema.GetAttr ( tAggr.m_sAttr.cstr() );
+		if ( !IsRollupAttr ( pAttr, false ) )
+			return false;
+
+		tRollupQuery.m_dLocAggrs.Add ( pAttr->m_tLocator );
+		tRollupQuery.m_dFloat.Add ( pAttr->m_eAttrType==SPH_ATTR_FLOAT );
+	}
+
+	// only the key, the count and the declared aggregates can be selected
+	StrVec_t dAliases;
+	for ( const auto & tItem : tQuery.m_dItems )
+	{
+		CSphString sExpr = tItem.m_sExpr;
+		sExpr.ToLower();
+
+		if ( tItem.m_eAggrFunc==SPH_AGGR_NONE )
+		{
+			if ( sExpr==tDesc.m_sKey || IsGroupMagic ( sExpr ) )
+				continue;
+
+			return false;
+		}
+
+		int iAggr = -1;
+		ARRAY_FOREACH_COND ( i, tDesc.m_dAggrs, iAggr<0 )
+			if ( tDesc.m_dAggrs[i].m_eFunc==tItem.m_eAggrFunc && tDesc.m_dAggrs[i].m_sAttr==sExpr )
+				iAggr = i;
+
+		const CSphColumnInfo * pColumn = tSorterSchema.GetAttr ( tItem.m_sAlias.cstr() );
+		if ( iAggr<0 || !pColumn || !pColumn->m_tLocator.m_bDynamic )
+			return false;
+
+		tRollupQuery.m_dColumns.Add ( { iAggr, pColumn->m_tLocator } );
+		dAliases.Add ( tItem.m_sAlias );
+		dAliases.Last().ToLower();
+	}
+
+	// no expressions are evaluated for the pre-aggregated matches, so every computed column has to come from the rollup
+	bool bGotGroupby = false;
+	bool bGotCount = false;
+	for ( int i=0; i<tSorterSchema.GetAttrsCount(); ++i )
+	{
+		const CSphColumnInfo & tColumn = tSorterSchema.GetAttr(i);
+		if ( !tColumn.m_tLocator.m_bDynamic )
+			continue;
+
+		CSphString sName = tColumn.m_sName;
+		sName.ToLower();
+		if ( sName=="@groupby" )
+		{
+			tRollupQuery.m_tLocGroupby = tColumn.m_tLocator;
+			bGotGroupby = true;
+		} else if ( sName=="@count" )
+		{
+			tRollupQuery.m_tLocCount = tColumn.m_tLocator;
+			bGotCount = true;
+		} else if ( !dAliases.Contains ( sName ) )
+			return false;
+	}
+
+	if ( !bGotGroupby || !bGotCount )
+		return false;
+
+	auto fnGroupColumn = [&tDesc, &dAliases] ( const CSphString & sName ) { return sName==tDesc.m_sKey || IsGroupMagic ( sName ) || dAliases.Contains ( sName ); };
+	if ( !IsSortedBy ( tQuery.m_sGroupSortBy, fnGroupColumn ) )
+		return false;
+
+	// in-group order only picks the row to represent the group, and all the rows of a full-scan weigh the same
+	auto fnWeight = [] ( const CSphString & sName ) { return sName=="@weight" || sName=="weight()"; };
+	return tQuery.m_eSort==SPH_SORT_RELEVANCE || IsSortedBy ( tQuery.m_sSortBy, fnWeight );
+}
+
+
+bool SetupRollupQuery ( const CSphQuery & tQuery, const ISphSchema & tSorterSchema, const ISphSchema & tIndexSchema, const VecTraits_T<RollupDesc_t> & dRollups, RollupQuery_t & tRollupQuery )
+{
+	if ( tQuery.m_sGroupBy.IsEmpty() || tQuery.m_eGroupFunc!=SPH_GROUPBY_ATTR || tQuery.m_iGroupbyLimit!=1 || !tQuery.m_sGroupDistinct.IsEmpty() )
+		return false;
+
+	if ( !tQuery.m_dFilters.IsEmpty() || !tQuery.m_dFilterTree.IsEmpty() || tQuery.m_iCutoff>0 || !tQuery.m_dSearchAfter.IsEmpty() || tQuery.m_fSampleRate<1.0f )
+		return false;
+
+	CSphString sGroupBy = tQuery.m_sGroupBy;
+	sGroupBy.ToLower();
+
+	for ( const auto & tDesc : dRollups )
+		if ( tDesc.m_sKey==sGroupBy && MapQuery ( tQuery, tSorterSchema, tIndexSchema, tDesc, tRollupQuery ) )
+			return true;
+
+	return false;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+class RollupState_c
+{
+public:
+	explicit	RollupState_c ( const RollupQuery_t & tQuery );
+
+	const CSphString &	GetSpec() const { return m_sSpec; }
+	bool		Involves ( const CSphString & sAttr ) const { return sAttr==m_sKey || m_dAttrs.Contains ( sAttr ); }
+
+	void		Add ( const CSphRowitem * pRow, RowID_t tRowID );
+	bool		Retract ( const CSphRowitem * pRow );
+	void		Push ( const RollupQuery_t & tQuery, const CSphRowitem * pRows, int iStride, ISphMatchSorter * pSorter, CSphMatch & tMatch ) const;
+
+private:
+	union Value_u
+	{
+		int64_t	m_iValue;
+		double	m_fValue;
+	};
+
+	struct Group_t
+	{
+		SphAttr_t	m_tKey;
+		int64_t		m_iCount;
+		RowID_t		m_tRowID;	///< row to represent the group in the matches
+	};
+
+	CSphString					m_sSpec;
+	CSphString					m_sKey;
+	StrVec_t					m_dAttrs;
+	CSphAttrLocator				m_tLocKey;
+	CSphVector<ESphAggrFunc>	m_dFuncs;
+	CSphVector<CSphAttrLocator>	m_dLocAggrs;
+	CSphVector<bool>			m_dFloat;
+
+	OpenHash_T<int, SphAttr_t>	m_hGroups;		///< key to index in m_dGroups
+	CSphVector<Group_t>			m_dGroups;		///< groups emptied by kills stay, with zero count
+	CSphVector<Value_u>			m_dValues;		///< aggregates of the groups, m_dFuncs.GetLength() per group
+
+	Value_u		ReadValue ( const CSphRowitem * pRow, int iAggr ) const;
+	bool		IsLess ( const Value_u & tA, const Value_u & tB, int iAggr ) const;
+};
+
+
+RollupState_c::RollupState_c ( const RollupQuery_t & tQuery )
+	: m_sSpec ( tQuery.m_pDesc->m_sSpec )
+	, m_sKey ( tQuery.m_pDesc->m_sKey )
+	, m_tLocKey ( tQuery.m_tLocKey )
+	, m_dLocAggrs ( tQuery.m_dLocAggrs )
+	, m_dFloat ( tQuery.m_dFloat )
+{
+	for ( const auto & tAggr : tQuery.m_pDesc->m_dAggrs )
+	{
+		m_dFuncs.Add ( tAggr.m_eFunc );
+		m_dAttrs.Add ( tAggr.m_sAttr );
+	}
+}
+
+
+RollupState_c::Value_u RollupState_c::ReadValue ( const CSphRowitem * pRow, int iAggr ) const
+{
+	Value_u tValue;
+	SphAttr_t tAttr = sphGetRowAttr ( pRow, m_dLocAggrs[iAggr] );
+	if ( m_dFloat[iAggr] )
+		tValue.m_fValue = sphDW2F ( (DWORD)tAttr );
+	else
+		tValue.m_iValue = tAttr;
+
+	return tValue;
+}
+
+
+bool RollupState_c::IsLess ( const Value_u & tA, const Value_u & tB, int iAggr ) const
+{
+	return m_dFloat[iAggr] ? tA.m_fValue<tB.m_fValue : tA.m_iValue<tB.m_iValue;
+}
+
+
+void RollupState_c::Add ( const CSphRowitem * pRow, RowID_t tRowID )
+{
+	SphAttr_t tKey = sphGetRowAttr ( pRow, m_tLocKey );
+	int iAggrs = m_dFuncs.GetLength();
+
+	int * pGroup = m_hGroups.Find ( tKey );
+	if ( !pGroup )
+	{
+		m_hGroups.Add ( tKey, m_dGroups.GetLength() );
+		m_dGroups.Add ( { tKey, 1, tRowID } );
+		for ( int i=0; i<iAggrs; ++i )
+			m_dValues.Add ( ReadValue ( pRow, i ) );
+
+		return;
+	}
+
+	++m_dGroups[*pGroup].m_iCount;
+	Value_u * pValues = m_dValues.Begin() + (int64_t)(*pGroup)*iAggrs;
+	for ( int i=0; i<iAggrs; ++i )
+	{
+		Value_u tValue = ReadValue ( pRow, i );
+		switch ( m_dFuncs[i] )
+		{
+		case SPH_AGGR_SUM:
+			if ( m_dFloat[i] )
+				pValues[i].m_fValue += tValue.m_fValue;
+			else
+				pValues[i].m_iValue += tValue.m_iValue;
+			break;
+
+		case SPH_AGGR_MIN:
+			if ( IsLess ( tValue, pValues[i], i ) )
+				pValues[i] = tValue;
+			break;
+
+		case SPH_AGGR_MAX:
+			if ( IsLess ( pValues[i], tValue, i ) )
+				pValues[i] = tValue;
+			break;
+
+		default:
+			assert ( 0 && "unexpected rollup aggregate" );
+			break;
+		}
+	}
+}
+
+// returns false when the killed row might have held a min or max, as these can't be retracted
+bool RollupState_c::Retract ( const CSphRowitem * pRow )
+{
+	int * pGroup = m_hGroups.Find ( sphGetRowAttr ( pRow, m_tLocKey ) );
+	if ( !pGroup )
+		return false;
+
+	Group_t & tGroup = m_dGroups[*pGroup];
+	if ( !tGroup.m_iCount )
+		return false;
+
+	if ( !--tGroup.m_iCount )
+		return true;
+
+	int iAggrs = m_dFuncs.GetLength();
+	Value_u * pValues = m_dValues.Begin() + (int64_t)(*pGroup)*iAggrs;
+	for ( int i=0; i<iAggrs; ++i )
+	{
+		Value_u tValue = ReadValue ( pRow, i );
+		if ( m_dFuncs[i]!=SPH_AGGR_SUM )
+		{
+			if ( !IsLess ( tValue, pValues[i], i ) && !IsLess ( pValues[i], tValue, i ) )
+				return false;
+
+			continue;
+		}
+
+		if ( m_dFloat[i] )
+			pValues[i].m_fValue -= tValue.m_fValue;
+		else
+			pValues[i].m_iValue -= tValue.m_iValue;
+	}
+
+	return true;
+}
+
+
+void RollupState_c::Push ( const RollupQuery_t & tQuery, const CSphRowitem * pRows, int iStride, ISphMatchSorter * pSorter, CSphMatch & tMatch ) const
+{
+	int iAggrs = m_dFuncs.GetLength();
+	ARRAY_FOREACH ( iGroup, m_dGroups )
+	{
+		const Group_t & tGroup = m_dGroups[iGroup];
+		if ( !tGroup.m_iCount )
+			continue;
+
+		tMatch.m_tRowID = tGroup.m_tRowID;
+		tMatch.m_pStatic = pRows + (int64_t)tGroup.m_tRowID*iStride;
+		tMatch.SetAttr ( tQuery.m_tLocGroupby, tGroup.m_tKey );
+		tMatch.SetAttr ( tQuery.m_tLocCount, tGroup.m_iCount );
+
+		const Value_u * pValues = m_dValues.Begin() + (int64_t)iGroup*iAggrs;
+		for ( const auto & tColumn : tQuery.m_dColumns )
+		{
+			const Value_u & tValue = pValues[tColumn.m_iAggr];
+			if ( m_dFloat[tColumn.m_iAggr] )
+				tMatch.SetAttrFloat ( tColumn.m_tLoc, (float)tValue.m_fValue );
+			else
+				tMatch.SetAttr ( tColumn.m_tLoc, tValue.m_iValue );
+		}
+
+		pSorter->PushGrouped ( tMatch, false, true );
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+RollupCache_c::~RollupCache_c()
+{
+	Reset();
+}
+
+
+void RollupCache_c::Retract ( const CSphRowitem * pRow )
+{
+	ARRAY_FOREACH ( i, m_dStates )
+		if ( !m_dStates[i]->Retract ( pRow ) )
+		{
+			SafeDelete ( m_dStates[i] );
+			m_dStates.RemoveFast ( i-- );
+		}
+}
+
+
+void RollupCache_c::Invalidate ( const CSphAttrUpdate & tUpd )
+{
+	ScopedMutex_t tLock ( m_tLock );
+	ARRAY_FOREACH ( i, m_dStates )
+	{
+		RollupState_c * pState = m_dStates[i];
+		if ( tUpd.m_dAttributes.any_of ( [pState] ( const TypedAttribute_t & tAttr ) { return pState->Involves ( tAttr.m_sName ); } ) )
+		{
+			SafeDelete ( m_dStates[i] );
+			m_dStates.RemoveFast ( i-- );
+		}
+	}
+}
+
+
+void RollupCache_c::Reset()
+{
+	ScopedMutex_t tLock ( m_tLock );
+	for ( auto & pState : m_dStates )
+		SafeDelete ( pState );
+
+	m_dStates.Reset();
+}
+
+
+RollupState_c * RollupCache_c::GetState ( const RollupQuery_t & tQuery, bool & bCreated )
+{
+	for ( auto * pState : m_dStates )
+		if ( pState->GetSpec()==tQuery.m_pDesc->m_sSpec )
+		{
+			bCreated = false;
+			return pState;
+		}
+
+	bCreated = true;
+	m_dStates.Add ( new RollupState_c ( tQuery ) );
+	return m_dStates.Last();
+}
+
+
+void RollupCache_c::AddRow ( RollupState_c * pState, const CSphRowitem * pRow, RowID_t tRowID )
+{
+	pState->Add ( pRow, tRowID );
+}
+
+
+void RollupCache_c::PushState ( const RollupState_c * pState, const RollupQuery_t & tQuery, const CSphRowitem * pRows, int iStride, ISphMatchSorter * pSorter, CSphMatch & tMatch )
+{
+	pState->Push ( tQuery, pRows, iStride, pSorter, tMatch );
+}
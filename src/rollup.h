@@ -0,0 +1,103 @@
+//
+// Copyright (c) 2022, Manticore Software LTD (https://manticoresearch.com)
+// All rights reserved
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License. You should have
+// received a copy of the GPL license along with this program; if you
+// did not, you can find it at http://www.gnu.org/
+//
+
+/// @file rollup.h
+/// Per-group aggregates of RT segments and disk chunks, to answer grouped full-scans without scanning the rows
+
+#pragma once
+
+#include "sphinx.h"
+
+class ISphMatchSorter;
+
+/// declared rollup: group-by key attribute and attributes aggregated per group (count is always kept)
+struct RollupDesc_t
+{
+	struct Aggr_t
+	{
+		ESphAggrFunc	m_eFunc = SPH_AGGR_NONE;	///< SPH_AGGR_SUM, SPH_AGGR_MIN or SPH_AGGR_MAX
+		CSphString		m_sAttr;
+	};
+
+	CSphString			m_sKey;
+	CSphVector<Aggr_t>	m_dAggrs;
+	CSphString			m_sSpec;	///< normalized declaration; identifies the rollup in the caches
+};
+
+/// parses 'key: sum(attr), min(attr), max(attr); key2: ...' declarations
+bool ParseRollups ( const CSphString & sRollups, CSphVector<RollupDesc_t> & dRollups, CSphString & sError );
+
+/// checks that all the attributes of the rollups are present in the schema and can be aggregated
+bool CheckRollups ( const VecTraits_T<RollupDesc_t> & dRollups, const ISphSchema & tSchema, CSphString & sError );
+
+/// grouped query mapped onto a rollup: where the values come from in the index rows, and where they go in the sorter matches
+struct RollupQuery_t
+{
+	struct Column_t
+	{
+		int					m_iAggr;	///< index of the aggregate in the rollup
+		CSphAttrLocator		m_tLoc;		///< aggregate column in the sorter schema
+	};
+
+	const RollupDesc_t *		m_pDesc = nullptr;
+	CSphAttrLocator				m_tLocKey;
+	CSphVector<CSphAttrLocator>	m_dLocAggrs;	///< aggregated attributes in the index rows, in the rollup order
+	CSphVector<bool>			m_dFloat;		///< whether an aggregated attribute is float, in the rollup order
+
+	CSphAttrLocator				m_tLocGroupby;
+	CSphAttrLocator				m_tLocCount;
+	CSphVector<Column_t>		m_dColumns;
+};
+
+/// whether the query is a plain grouped full-scan which one of the rollups answers; fills tRollupQuery if so
+bool SetupRollupQuery ( const CSphQuery & tQuery, const ISphSchema & tSorterSchema, const ISphSchema & tIndexSchema, const VecTraits_T<RollupDesc_t> & dRollups, RollupQuery_t & tRollupQuery );
+
+class RollupState_c;
+
+/// rollup states of a RAM segment or a disk chunk
+/// a state is built over the alive rows on its first use; kills retract from it, updates of its attributes drop it
+class RollupCache_c : public ISphNoncopyable
+{
+public:
+	CSphMutex	m_tLock;	///< held while rows are marked dead and retracted, so that a state being built never misses or doubles a kill
+
+				~RollupCache_c();
+
+	/// pushes the pre-aggregated groups into the group sorter as grouped matches
+	template <typename DEADROWS>
+	void		Push ( const RollupQuery_t & tQuery, const CSphRowitem * pRows, int iStride, DWORD uRows, const DEADROWS & tDeadRows, ISphMatchSorter * pSorter, CSphMatch & tMatch );
+
+	void		Retract ( const CSphRowitem * pRow ) REQUIRES ( m_tLock );
+	void		Invalidate ( const CSphAttrUpdate & tUpd );
+	void		Reset();
+
+private:
+	CSphVector<RollupState_c *>	m_dStates GUARDED_BY ( m_tLock );
+
+	RollupState_c *	GetState ( const RollupQuery_t & tQuery, bool & bCreated ) REQUIRES ( m_tLock );
+	static void		AddRow ( RollupState_c * pState, const CSphRowitem * pRow, RowID_t tRowID );
+	static void		PushState ( const RollupState_c * pState, const RollupQuery_t & tQuery, const CSphRowitem * pRows, int iStride, ISphMatchSorter * pSorter, CSphMatch & tMatch );
+};
+
+
+template <typename DEADROWS>
+void RollupCache_c::Push ( const RollupQuery_t & tQuery, const CSphRowitem * pRows, int iStride, DWORD uRows, const DEADROWS & tDeadRows, ISphMatchSorter * pSorter, CSphMatch & tMatch )
+{
+	ScopedMutex_t tLock ( m_tLock );
+
+	bool bCreated = false;
+	RollupState_c * pState = GetState ( tQuery, bCreated );
+	if ( bCreated )
+		for ( RowID_t tRowID = 0; tRowID<uRows; ++tRowID )
+			if ( !tDeadRows.IsSet ( tRowID ) )
+				AddRow ( pState, pRows + (int64_t)tRowID*iStride, tRowID );
+
+	PushState ( pState, tQuery, pRows, iStride, pSorter, tMatch );
+}
@@ -44,15 +44,20 @@
 #include "tokenizer/charset_definition_parser.h"
 #include "client_session.h"
 #include "sphinx_alter.h"
+#include "numautils.h"
+#include "civiltime.h"
+#include "resultcache.h"
 
 // services
 #include "taskping.h"
 #include "taskmalloctrim.h"
+#include "taskqcache.h"
 #include "taskoptimize.h"
 #include "taskglobalidf.h"
 #include "tasksavestate.h"
 #include "taskflushbinlog.h"
 #include "taskflushattrs.h"
+#include "taskminmax.h"
 #include "taskflushmutable.h"
 #include "taskpreread.h"
 #include "coroutine.h"
@@ -149,6 +154,7 @@ static int				g_iExpansionLimit	= 0;
 static int				g_iShutdownTimeoutUs	= 3000000; // default timeout on daemon shutdown and stopwait is 3 seconds
 static int				g_iBacklog			= SEARCHD_BACKLOG;
 static int				g_iThdQueueMax		= 0;
+static int64_t			g_dQueueMaxWaitUS[PRIORITY_CLASSES] = {0};	// admission deadline per priority class, 0 means no limit
 static bool				g_bGroupingInUtc	= false;
 static auto&			g_iTFO = sphGetTFO ();
 static CSphString		g_sShutdownToken;
@@ -157,6 +163,8 @@ static bool				g_bServerID = false;
 static bool				g_bJsonConfigLoadedOk = false;
 static auto&			g_iAutoOptimizeCutoffMultiplier = AutoOptimizeCutoffMultiplier();
 static auto&			g_iAutoOptimizeCutoff = AutoOptimizeCutoff();
+static auto&			g_iOptimizeDeadPercent = OptimizeDeadPercent();
+static auto&			g_iOptimizeWriteAmplification = OptimizeWriteAmplification();
 static constexpr bool	AUTOOPTIMIZE_NEEDS_VIP = false; // whether non-VIP can issue 'SET GLOBAL auto_optimize = X'
 
 static bool				g_bSplit = false;
@@ -179,6 +187,8 @@ static int				g_iMaxBatchQueries	= 32;
 
 static int64_t			g_iDocstoreCache = 0;
 static int64_t			g_iSkipCache = 0;
+static int64_t			g_iExpansionCache = 0;
+static int64_t			g_iDocBitmapCache = 0;
 
 static auto &	g_iDistThreads		= getDistThreads();
 int				g_iAgentConnectTimeoutMs = 1000;
@@ -770,6 +780,12 @@ void Shutdown () REQUIRES ( MainThread ) NO_THREAD_SAFETY_ANALYSIS
 	SHUTINFO << "Shutdown skip cache ...";
 	ShutdownSkipCache();
 
+	SHUTINFO << "Shutdown expansion cache ...";
+	ShutdownExpansionCache();
+
+	SHUTINFO << "Shutdown doclist bitmap cache ...";
+	ShutdownDocBitmapCache();
+
 	SHUTINFO << "Shutdown wordforms ...";
 	sphShutdownWordforms ();
 
@@ -1528,13 +1544,13 @@ public:
 	{}
 
 	void		BuildRequest ( const AgentConn_t & tAgent, ISphOutputBuffer & tOut ) const final;
-
-protected:
+	void		SetAgentLimit ( int iLimit ) { m_iAgentLimit = iLimit; }	///< ship at most that many matches (agents still sort max_matches)
 	void		SendQuery ( const char * sIndexes, ISphOutputBuffer & tOut, const CSphQuery & q, int iWeight, int iAgentQueryTimeout ) const;
 
 protected:
 	const VecTraits_T<CSphQuery> &		m_dQueries;
 	const int							m_iDivideLimits;
+	int									m_iAgentLimit = 0;
 };
 
 
@@ -1588,6 +1604,53 @@ void operator>> ( InputBuffer_c & dIn, CSphNamedInt & tValue )
 	tValue.second = dIn.GetInt ();
 }
 
+static void SendFilter ( ISphOutputBuffer & tOut, const CSphFilterSettings & tFilter )
+{
+	tOut.SendString ( tFilter.m_sAttrName.cstr() );
+	tOut.SendInt ( tFilter.m_eType );
+	switch ( tFilter.m_eType )
+	{
+		case SPH_FILTER_VALUES:
+			tOut.SendInt ( tFilter.GetNumValues () );
+			for ( int k = 0; k < tFilter.GetNumValues (); k++ )
+				tOut.SendUint64 ( tFilter.GetValue ( k ) );
+			break;
+
+		case SPH_FILTER_RANGE:
+			tOut.SendUint64 ( tFilter.m_iMinValue );
+			tOut.SendUint64 ( tFilter.m_iMaxValue );
+			break;
+
+		case SPH_FILTER_FLOATRANGE:
+			tOut.SendFloat ( tFilter.m_fMinValue );
+			tOut.SendFloat ( tFilter.m_fMaxValue );
+			break;
+
+		case SPH_FILTER_USERVAR:
+		case SPH_FILTER_STRING:
+			tOut.SendString ( tFilter.m_dStrings.GetLength()==1 ? tFilter.m_dStrings[0].cstr() : nullptr );
+			break;
+
+		case SPH_FILTER_NULL:
+			tOut.SendByte ( tFilter.m_bIsNull );
+			break;
+
+		case SPH_FILTER_STRING_LIST:
+			tOut.SendInt ( tFilter.m_dStrings.GetLength() );
+			ARRAY_FOREACH ( iString, tFilter.m_dStrings )
+				tOut.SendString ( tFilter.m_dStrings[iString].cstr() );
+			break;
+		case SPH_FILTER_EXPRESSION: // need only name and type
+			break;
+	}
+	tOut.SendInt ( tFilter.m_bExclude );
+	tOut.SendInt ( tFilter.m_bHasEqualMin );
+	tOut.SendInt ( tFilter.m_bHasEqualMax );
+	tOut.SendInt ( tFilter.m_bOpenLeft );
+	tOut.SendInt ( tFilter.m_bOpenRight );
+	tOut.SendInt ( tFilter.m_eMvaFunc );
+}
+
 void SearchRequestBuilder_c::SendQuery ( const char * sIndexes, ISphOutputBuffer & tOut, const CSphQuery & q, int iWeight, int iAgentQueryTimeout ) const
 {
 	bool bAgentWeight = ( iWeight!=-1 );
@@ -1615,7 +1678,9 @@ void SearchRequestBuilder_c::SendQuery ( const char * sIndexes, ISphOutputBuffer
 	tOut.SendInt ( 0 ); // offset is 0
 	if ( !q.m_bHasOuter )
 	{
-		if ( m_iDivideLimits==1 )
+		if ( m_iAgentLimit )
+			tOut.SendInt ( m_iAgentLimit );
+		else if ( m_iDivideLimits==1 )
 			tOut.SendInt ( q.m_iMaxMatches ); // OPTIMIZE? normally, agent limit is max_matches, even if master limit is less
 		else // FIXME!!! that is broken with offset + limit
 			tOut.SendInt ( 1 + ( ( q.m_iOffset + q.m_iLimit )/m_iDivideLimits) );
@@ -1649,53 +1714,8 @@ void SearchRequestBuilder_c::SendQuery ( const char * sIndexes, ISphOutputBuffer
 	tOut.SendUint64 ( uint64_t(0) ); // default full id range (any client range must be in filters at this stage)
 	tOut.SendUint64 ( UINT64_MAX );
 	tOut.SendInt ( q.m_dFilters.GetLength() );
-	ARRAY_FOREACH ( j, q.m_dFilters )
-	{
-		const CSphFilterSettings & tFilter = q.m_dFilters[j];
-		tOut.SendString ( tFilter.m_sAttrName.cstr() );
-		tOut.SendInt ( tFilter.m_eType );
-		switch ( tFilter.m_eType )
-		{
-			case SPH_FILTER_VALUES:
-				tOut.SendInt ( tFilter.GetNumValues () );
-				for ( int k = 0; k < tFilter.GetNumValues (); k++ )
-					tOut.SendUint64 ( tFilter.GetValue ( k ) );
-				break;
-
-			case SPH_FILTER_RANGE:
-				tOut.SendUint64 ( tFilter.m_iMinValue );
-				tOut.SendUint64 ( tFilter.m_iMaxValue );
-				break;
-
-			case SPH_FILTER_FLOATRANGE:
-				tOut.SendFloat ( tFilter.m_fMinValue );
-				tOut.SendFloat ( tFilter.m_fMaxValue );
-				break;
-
-			case SPH_FILTER_USERVAR:
-			case SPH_FILTER_STRING:
-				tOut.SendString ( tFilter.m_dStrings.GetLength()==1 ? tFilter.m_dStrings[0].cstr() : nullptr );
-				break;
-
-			case SPH_FILTER_NULL:
-				tOut.SendByte ( tFilter.m_bIsNull );
-				break;
-
-			case SPH_FILTER_STRING_LIST:
-				tOut.SendInt ( tFilter.m_dStrings.GetLength() );
-				ARRAY_FOREACH ( iString, tFilter.m_dStrings )
-					tOut.SendString ( tFilter.m_dStrings[iString].cstr() );
-				break;
-			case SPH_FILTER_EXPRESSION: // need only name and type
-				break;
-		}
-		tOut.SendInt ( tFilter.m_bExclude );
-		tOut.SendInt ( tFilter.m_bHasEqualMin );
-		tOut.SendInt ( tFilter.m_bHasEqualMax );
-		tOut.SendInt ( tFilter.m_bOpenLeft );
-		tOut.SendInt ( tFilter.m_bOpenRight );
-		tOut.SendInt ( tFilter.m_eMvaFunc );
-	}
+	for ( const auto & tFilter : q.m_dFilters )
+		SendFilter ( tOut, tFilter );
 	tOut.SendInt ( q.m_eGroupFunc );
 	tOut.SendString ( q.m_sGroupBy.cstr() );
 	if ( m_iDivideLimits==1 )
@@ -1787,6 +1807,18 @@ void SearchRequestBuilder_c::SendQuery ( const char * sIndexes, ISphOutputBuffer
 		tOut.SendDword ( i.m_eHint );
 		tOut.SendString ( i.m_sIndex.cstr() );
 	}
+
+	tOut.SendInt ( q.m_dSearchAfter.GetLength() );
+	for ( const auto & sKey : q.m_dSearchAfter )
+		tOut.SendString ( sKey.cstr() );
+
+	// the threshold only holds for counts of the whole agent, so it is not passed further down
+	tOut.SendUint64 ( q.m_bAgent ? 0 : q.m_iMinGroupCount );
+	tOut.SendDword ( q.m_bVersionProbe ? 1 : 0 );
+
+	// agents sample with the master's seed, so that a document is either in the sample or not for the whole cluster
+	tOut.SendFloat ( q.m_fSampleRate );
+	tOut.SendUint64 ( q.m_fSampleRate<1.0f ? q.m_iRandSeed : -1 );
 }
 
 
@@ -2042,6 +2074,8 @@ bool SearchReplyParser_c::ParseReply ( MemInputBuffer_c & tReq, AgentConn_t & tA
 			tRes.AddStat ( sWord, iDocs, iHits );
 		}
 
+		tRes.m_uDataVersion = tReq.GetUint64();
+
 		// mark this result as ok
 		auto& tNewChunk = tRes.m_dResults.Add ();
 		::Swap ( tNewChunk, tChunk );
@@ -2605,6 +2639,27 @@ bool ParseSearchQuery ( InputBuffer_c & tReq, ISphOutputBuffer & tOut, CSphQuery
 		}
 	}
 
+	if ( uMasterVer>=19 )
+	{
+		tQuery.m_dSearchAfter.Resize ( tReq.GetInt() );
+		for ( auto & sKey : tQuery.m_dSearchAfter )
+			sKey = tReq.GetString();
+	}
+
+	if ( uMasterVer>=20 )
+		tQuery.m_iMinGroupCount = (int64_t)tReq.GetUint64();
+
+	if ( uMasterVer>=21 )
+		tQuery.m_bVersionProbe = !!tReq.GetDword();
+
+	if ( uMasterVer>=22 )
+	{
+		tQuery.m_fSampleRate = tReq.GetFloat();
+		int64_t iSeed = (int64_t)tReq.GetUint64();
+		if ( tQuery.m_fSampleRate<1.0f )
+			tQuery.m_iRandSeed = iSeed;
+	}
+
 	/////////////////////
 	// additional checks
 	/////////////////////
@@ -2900,6 +2955,19 @@ static void FormatOption ( const CSphQuery & tQuery, StringBuilder_c & tBuf )
 	if ( tQuery.m_iRandSeed!=g_tDefaultQuery.m_iRandSeed )
 		tBuf.Appendf ( "rand_seed=" INT64_FMT, tQuery.m_iRandSeed );
 
+	if ( tQuery.m_dSearchAfter.GetLength() )
+	{
+		QuotationEscapedBuilder tCursor;
+		tCursor.AppendEscaped ( sphFormatSearchAfter ( tQuery.m_dSearchAfter ).cstr(), EscBld::eEscape | EscBld::eSkipComma );
+		tBuf.Appendf ( "search_after=%s", tCursor.cstr() );
+	}
+
+	if ( tQuery.m_bExactTopK )
+		tBuf << "exact_topk=1";
+
+	if ( tQuery.m_fSampleRate<1.0f )
+		tBuf.Appendf ( "sample=%f", tQuery.m_fSampleRate );
+
 	if ( !tQuery.m_sQueryTokenFilterLib.IsEmpty() )
 	{
 		if ( tQuery.m_sQueryTokenFilterOpts.IsEmpty() )
@@ -3557,6 +3625,9 @@ void SendResult ( int iVer, ISphOutputBuffer & tOut, const AggrResult_t& tRes, b
 		if ( bAgentMode )
 			tOut.SendByte ( 0 ); // statistics have no expanded terms for now
 	}
+
+	if ( bAgentMode && uMasterVer>=21 )
+		tOut.SendUint64 ( tRes.m_uDataVersion );
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -5005,6 +5076,54 @@ bool MinimizeAggrResult ( AggrResult_t & tRes, const CSphQuery & tQuery, bool bH
 	return true;
 }
 
+
+/// sampled query saw roughly fSampleRate of the rows; scale the total and the additive aggregates (counts, sums) back up
+/// averages and min/max need no scaling, and distinct counts can not be scaled linearly, so they stay as sampled
+static void ScaleSampledResult ( AggrResult_t & tRes, const CSphQuery & tQuery )
+{
+	double fRate = tQuery.m_fSampleRate;
+	double fFound = (double)tRes.m_iTotalMatches;
+	tRes.m_fSampleRate = tQuery.m_fSampleRate;
+	tRes.m_iTotalMatches = (int64_t)round ( fFound/fRate );
+	tRes.m_iTotalMatchesError = (int64_t)round ( sqrt ( fFound*( 1.0-fRate ) )/fRate );
+
+	auto fnIsCount = [&tQuery] ( const CSphString & sName )
+	{
+		return sName=="@count" || tQuery.m_dItems.any_of ( [&sName] ( const CSphQueryItem & tItem ) { return tItem.m_sAlias==sName && ( tItem.m_sExpr=="count(*)" || tItem.m_sExpr=="@count" ); } );
+	};
+
+	const CSphSchema & tSchema = tRes.m_tSchema;
+	CSphVector<CSphAttrLocator> dScaled;
+	for ( int i = 0; i < tSchema.GetAttrsCount(); ++i )
+	{
+		const CSphColumnInfo & tCol = tSchema.GetAttr(i);
+		if ( tCol.m_eAggrFunc!=SPH_AGGR_SUM && !fnIsCount ( tCol.m_sName ) )
+			continue;
+
+		// several select items may share the same column
+		if ( dScaled.Contains ( tCol.m_tLocator ) )
+			continue;
+
+		dScaled.Add ( tCol.m_tLocator );
+		for ( auto & tChunk : tRes.m_dResults )
+			for ( auto & tMatch : tChunk.m_dMatches )
+				switch ( tCol.m_eAttrType )
+				{
+				case SPH_ATTR_FLOAT:
+					tMatch.SetAttrFloat ( tCol.m_tLocator, float ( tMatch.GetAttrFloat ( tCol.m_tLocator )/fRate ) );
+					break;
+
+				case SPH_ATTR_INTEGER:
+				case SPH_ATTR_BIGINT:
+					tMatch.SetAttr ( tCol.m_tLocator, (SphAttr_t)round ( tMatch.GetAttr ( tCol.m_tLocator )/fRate ) );
+					break;
+
+				default:
+					break;
+				}
+	}
+}
+
 /////////////////////////////////////////////////////////////////////////////
 
 struct LocalIndex_t
@@ -5014,6 +5133,7 @@ struct LocalIndex_t
 	int			m_iOrderTag = 0;
 	int			m_iWeight = 1;
 	int64_t		m_iMass = 0;
+	int			m_iNumaNode = -1;
 };
 
 
@@ -5140,6 +5260,8 @@ private:
 	void							CalcTimeStats ( int64_t tmCpu, int64_t tmSubset, const CSphVector<DistrServedByAgent_t> & dDistrServedByAgent );
 	void							CalcPerIndexStats ( const CSphVector<DistrServedByAgent_t> & dDistrServedByAgent ) const;
 	void							CalcGlobalStats ( int64_t tmCpu, int64_t tmSubset, int64_t tmLocal, const CSphIOStats & tIO, const VecRefPtrsAgentConn_t & dRemotes ) const;
+	uint64_t						GetLocalDataVersion() const;
+	CSphVector<uint64_t>			ProbeDataVersions ( const CSphVector<DistrServedByAgent_t> & dDistrServedByAgent ) const;
 	int								CreateSorters ( const CSphIndex * pIndex, VecTraits_T<ISphMatchSorter*> & dSorters, VecTraits_T<CSphString> & dErrors, StrVec_t * pExtra, SphQueueRes_t & tQueueRes, ISphExprHook * pHook ) const;
 	int								CreateSingleSorters ( const CSphIndex * pIndex, VecTraits_T<ISphMatchSorter*> & dSorters, VecTraits_T<CSphString> & dErrors, StrVec_t * pExtra, SphQueueRes_t & tQueueRes, ISphExprHook * pHook ) const;
 	int								CreateMultiQueryOrFacetSorters ( const CSphIndex * pIndex, VecTraits_T<ISphMatchSorter*> & dSorters, VecTraits_T<CSphString> & dErrors, StrVec_t * pExtra, SphQueueRes_t & tQueueRes, ISphExprHook * pHook ) const;
@@ -6023,10 +6145,14 @@ void SearchHandler_c::RunLocalSearches ()
 			CSphQueryResult tMqRes;
 			tMqRes.m_pMeta = &tMqMeta;
 			dNAggrResults.First().m_tIOStats.Start ();
-			if ( m_bMultiQueue )
-				bResult = pIndex->MultiQuery ( tMqRes, m_dNQueries.First(), dSorters, tMultiArgs );
-			else
-				bResult = pIndex->MultiQueryEx ( iQueries, &m_dNQueries[0], &dNResults[0], &dSorters[0], tMultiArgs );
+			{
+				// run on workers of the node holding the index (no-op unless numa_aware)
+				Numa::ScopedNode_c tNode ( dLocal.m_iNumaNode );
+				if ( m_bMultiQueue )
+					bResult = pIndex->MultiQuery ( tMqRes, m_dNQueries.First(), dSorters, tMultiArgs );
+				else
+					bResult = pIndex->MultiQueryEx ( iQueries, &m_dNQueries[0], &dNResults[0], &dSorters[0], tMultiArgs );
+			}
 			dNAggrResults.First ().m_tIOStats.Stop ();
 
 			iCpuTime += sphTaskCpuTimer ();
@@ -6321,6 +6447,13 @@ static uint64_t GetIndexMass ( const CSphString & sName )
 	return ServedDesc_t::GetIndexMass ( ServedDescRPtr_c ( GetServed ( sName ) ) );
 }
 
+static int GetIndexNumaNode ( const CSphString & sName )
+{
+	if ( !Numa::IsEnabled() )
+		return -1;
+	return ServedDesc_t::GetNumaNode ( ServedDescRPtr_c ( GetServed ( sName ) ) );
+}
+
 // declared to be used in ParseSysVar
 void HandleMysqlShowThreads ( RowBuffer_i & tOut, const SqlStmt_t * pStmt );
 void HandleMysqlShowTables ( RowBuffer_i & tOut, const SqlStmt_t * pStmt );
@@ -6724,7 +6857,9 @@ static CSphVector<LocalIndex_t> CollectAllLocalIndexes ( const CSphVector<CSphNa
 		dLocal.m_sName = it.GetName ();
 		dLocal.m_iOrderTag = iOrderTag++;
 		dLocal.m_iWeight = GetIndexWeight ( it.GetName (), dIndexWeights, 1 );
-		dLocal.m_iMass = ServedDescRPtr_c ( it.Get () )->m_iMass;
+		ServedDescRPtr_c pServed ( it.Get () );
+		dLocal.m_iMass = pServed->m_iMass;
+		dLocal.m_iNumaNode = pServed->m_iNumaNode;
 	}
 	return dIndexes;
 }
@@ -6769,6 +6904,7 @@ bool SearchHandler_c::BuildIndexList ( int & iDivideLimits, VecRefPtrsAgentConn_
 			dLocal.m_iOrderTag = iOrderTag++;
 			dLocal.m_iWeight = GetIndexWeight ( sIndex, tQuery.m_dIndexWeights, 1 );
 			dLocal.m_iMass = GetIndexMass ( sIndex );
+			dLocal.m_iNumaNode = GetIndexNumaNode ( sIndex );
 		} else
 		{
 			++iDistCount;
@@ -6800,6 +6936,7 @@ bool SearchHandler_c::BuildIndexList ( int & iDivideLimits, VecRefPtrsAgentConn_
 				if ( iWeight!=-1 )
 					dLocal.m_iWeight = iWeight;
 				dLocal.m_iMass = GetIndexMass ( sLocalAgent );
+				dLocal.m_iNumaNode = GetIndexNumaNode ( sLocalAgent );
 				dLocal.m_sParentIndex = sIndex;
 				bHasLocalsAgents = true;
 			}
@@ -6850,6 +6987,629 @@ DEFINE_RENDER ( QueryInfo_t )
 }
 
 // one or more queries against one and same set of indexes
+/////////////////////////////////////////////////////////////////////////////
+// EXACT DISTRIBUTED TOP GROUPS
+/////////////////////////////////////////////////////////////////////////////
+
+/// whether the query is GROUP BY ... ORDER BY COUNT(*) DESC that may get its top groups from agents in threshold rounds
+static bool IsExactTopK ( const CSphQuery & tQuery )
+{
+	if ( !tQuery.m_bExactTopK || tQuery.m_sGroupBy.IsEmpty() || tQuery.m_eGroupFunc!=SPH_GROUPBY_ATTR )
+		return false;
+
+	// outer selects, N best per group, facets and HAVING all change what a group's rank depends on
+	if ( tQuery.m_bHasOuter || tQuery.m_iGroupbyLimit>1 || tQuery.m_bFacet || tQuery.m_bFacetHead || !tQuery.m_tHaving.m_sAttrName.IsEmpty() )
+		return false;
+
+	if ( sphJsonNameSplit ( tQuery.m_sGroupBy.cstr() ) )
+		return false;
+
+	// counts are never negative and add up over agents, that is what makes the thresholds hold
+	CSphString sSort = tQuery.m_sGroupSortBy;
+	sSort.ToLower();
+	StrVec_t dSort;
+	sphSplit ( dSort, sSort.cstr(), " \t" );
+	if ( dSort.GetLength()!=2 || dSort[1]!="desc" )
+		return false;
+
+	if ( dSort[0]=="@count" || dSort[0]=="count(*)" )
+		return true;
+
+	return tQuery.m_dItems.any_of ( [&dSort] ( const CSphQueryItem & tItem )
+	{
+		CSphString sAlias = tItem.m_sAlias;
+		sAlias.ToLower();
+		return sAlias==dSort[0] && tItem.m_sExpr=="count(*)";
+	});
+}
+
+
+/// gets top groups by count over agents exactly, while agents ship only a small part of their groups
+/// 1st round: every agent ships its local top-K (that is set up when the query is sent)
+/// 2nd round: K-th best partial total is a lower bound of the K-th best real total, so a group from the top
+/// has at least bound/agents on some agent; agents that might have unshipped groups above that ship all of them
+/// final fetch: groups that still may get to the top, but miss counts from some agents, are fetched by keys
+class ExactTopK_c
+{
+public:
+	ExactTopK_c ( AggrResult_t & tRes, const CSphQuery & tQuery, SearchFailuresLog_c & tFailures )
+		: m_tRes ( tRes )
+		, m_tQuery ( tQuery )
+		, m_tFailures ( tFailures )
+		, m_iK ( AgentLimit ( tQuery ) )
+	{}
+
+	virtual		~ExactTopK_c() = default;
+
+	void Run();
+
+	static int AgentLimit ( const CSphQuery & tQuery ) { return Min ( tQuery.m_iOffset+tQuery.m_iLimit, tQuery.m_iMaxMatches ); }
+
+protected:
+	/// sends the query to the agents; every reply goes to AcceptReply
+	virtual void	RequestAgents ( const CSphVector<int> & dAgents, CSphQuery & tQuery, int iLimit );
+	bool			AcceptReply ( int iAgent, OneResultset_t & tChunk, CSphString & sError );
+
+private:
+	struct Group_t
+	{
+		int64_t		m_iCount = 0;
+		int			m_iMatch = -1;	///< index of the group's match in the agent's chunk
+	};
+
+	struct Total_t
+	{
+		int64_t		m_iTotal = 0;	///< sum of the known counts
+		int64_t		m_iMissing = 0;	///< sum of the bounds of the agents that did not ship the group
+	};
+
+	struct Agent_t
+	{
+		OneResultset_t *				m_pChunk = nullptr;
+		OpenHash_T<Group_t, SphAttr_t>	m_hGroups;		///< groups shipped by the agent so far
+		int64_t							m_iBound = 0;	///< no group that the agent did not ship counts more than that there
+		bool							m_bReplied = false;
+		int								m_iShipped = 0;	///< groups in the last reply
+		int64_t							m_iLowest = 0;	///< lowest count in the last reply
+	};
+
+	AggrResult_t &				m_tRes;
+	const CSphQuery &			m_tQuery;
+	SearchFailuresLog_c &		m_tFailures;
+	int							m_iK;
+	CSphFixedVector<Agent_t>	m_dAgents { 0 };
+	CSphAttrLocator				m_tKey;
+	CSphAttrLocator				m_tCount;
+	CSphVector<SphAttr_t>		m_dWanted;		///< keys asked for in the final fetch (sorted); other groups in the replies are dropped
+
+	bool		Setup();
+	void		AddGroups ( Agent_t & tAgent, OneResultset_t & tChunk );
+	void		FetchRound ( const CSphVector<int> & dAgents, CSphQuery & tQuery, int iLimit );
+	int64_t		CalcTotals ( OpenHash_T<Total_t, SphAttr_t> & hTotals ) const;
+	bool		KeysFilter ( CSphVector<SphAttr_t> & dKeys, CSphFilterSettings & tFilter ) const;
+	void		Prune ( const OpenHash_T<Total_t, SphAttr_t> & hTotals, int64_t iKth );
+	void		Warning ( const char * szReason ) const;
+};
+
+
+bool ExactTopK_c::Setup()
+{
+	if ( m_tRes.m_dResults.GetLength()<2 )
+		return false;
+
+	const CSphSchema & tSchema = m_tRes.m_dResults.First().m_tSchema;
+	const CSphColumnInfo * pKey = tSchema.GetAttr ( "@groupby" );
+	const CSphColumnInfo * pCount = tSchema.GetAttr ( "@count" );
+	if ( !pKey || !pCount )
+		return false;
+
+	m_tKey = pKey->m_tLocator;
+	m_tCount = pCount->m_tLocator;
+
+	CSphString sError;
+	for ( const auto & tChunk : m_tRes.m_dResults )
+		if ( !tChunk.Agent() || !tChunk.m_tSchema.CompareTo ( tSchema, sError, false ) )
+			return false;
+
+	int iLimit = AgentLimit ( m_tQuery );
+	m_dAgents.Reset ( m_tRes.m_dResults.GetLength() );
+	ARRAY_FOREACH ( i, m_dAgents )
+	{
+		Agent_t & tAgent = m_dAgents[i];
+		tAgent.m_pChunk = &m_tRes.m_dResults[i];
+
+		int64_t iLowest = 0;
+		ARRAY_FOREACH ( iMatch, tAgent.m_pChunk->m_dMatches )
+		{
+			const CSphMatch & tMatch = tAgent.m_pChunk->m_dMatches[iMatch];
+			Group_t & tGroup = tAgent.m_hGroups.Acquire ( tMatch.GetAttr ( m_tKey ) );
+			tGroup.m_iCount = tMatch.GetAttr ( m_tCount );
+			tGroup.m_iMatch = iMatch;
+			iLowest = iMatch ? Min ( iLowest, tGroup.m_iCount ) : tGroup.m_iCount;
+		}
+
+		// short reply means the agent has shipped all of its groups
+		tAgent.m_iBound = tAgent.m_pChunk->m_dMatches.GetLength()<iLimit ? 0 : iLowest;
+	}
+
+	return true;
+}
+
+
+void ExactTopK_c::AddGroups ( Agent_t & tAgent, OneResultset_t & tChunk )
+{
+	tAgent.m_iShipped = tChunk.m_dMatches.GetLength();
+	tAgent.m_iLowest = INT64_MAX;
+
+	auto & dMatches = tAgent.m_pChunk->m_dMatches;
+	for ( auto & tMatch : tChunk.m_dMatches )
+	{
+		int64_t iCount = tMatch.GetAttr ( m_tCount );
+		tAgent.m_iLowest = Min ( tAgent.m_iLowest, iCount );
+
+		if ( !m_dWanted.IsEmpty() && !m_dWanted.BinarySearch ( tMatch.GetAttr ( m_tKey ) ) )
+			continue;
+
+		// groups that were shipped before come again in the later rounds; counts are the same
+		int64_t iGroups = tAgent.m_hGroups.GetLength();
+		Group_t & tGroup = tAgent.m_hGroups.Acquire ( tMatch.GetAttr ( m_tKey ) );
+		if ( iGroups==tAgent.m_hGroups.GetLength() )
+			continue;
+
+		tGroup.m_iCount = iCount;
+		tGroup.m_iMatch = dMatches.GetLength();
+		Swap ( dMatches.Add(), tMatch );
+	}
+}
+
+
+void ExactTopK_c::FetchRound ( const CSphVector<int> & dAgents, CSphQuery & tQuery, int iLimit )
+{
+	for ( int iAgent : dAgents )
+		m_dAgents[iAgent].m_bReplied = false;
+
+	RequestAgents ( dAgents, tQuery, iLimit );
+}
+
+
+bool ExactTopK_c::AcceptReply ( int iAgent, OneResultset_t & tChunk, CSphString & sError )
+{
+	Agent_t & tAgent = m_dAgents[iAgent];
+	if ( !tChunk.m_tSchema.CompareTo ( tAgent.m_pChunk->m_tSchema, sError, false ) )
+		return false;
+
+	AddGroups ( tAgent, tChunk );
+	tAgent.m_bReplied = true;
+	return true;
+}
+
+
+void ExactTopK_c::RequestAgents ( const CSphVector<int> & dAgents, CSphQuery & tQuery, int iLimit )
+{
+	VecRefPtrsAgentConn_t dConns;
+	for ( int iAgent : dAgents )
+	{
+		const AgentConn_t * pDesc = m_dAgents[iAgent].m_pChunk->Agent();
+		auto * pConn = new AgentConn_t;
+		pConn->m_tDesc.CloneFrom ( pDesc->m_tDesc );
+		pConn->m_iMyConnectTimeoutMs = pDesc->m_iMyConnectTimeoutMs;
+		pConn->m_iMyQueryTimeoutMs = pDesc->m_iMyQueryTimeoutMs;
+		pConn->m_iWeight = pDesc->m_iWeight;
+		pConn->m_iStoreTag = iAgent;
+		dConns.Add ( pConn );
+	}
+
+	VecTraits_T<CSphQuery> dQueries ( &tQuery, 1 );
+	SearchRequestBuilder_c tBuilder ( dQueries, 1 );
+	tBuilder.SetAgentLimit ( iLimit );
+	SearchReplyParser_c tParser ( 1 );
+	PerformRemoteTasks ( dConns, &tBuilder, &tParser );
+
+	CSphString sError;
+	for ( const AgentConn_t * pConn : dConns )
+	{
+		auto pResult = (cSearchResult *)pConn->m_pResult.Ptr();
+		if ( !pConn->m_bSuccess || !pResult )
+		{
+			m_tFailures.SubmitEx ( m_tQuery.m_sIndexes, nullptr, "agent %s: top groups round: %s", pConn->m_tDesc.GetMyUrl().cstr(), pConn->m_sFailure.cstr() );
+			continue;
+		}
+
+		AggrResult_t & tRemote = pResult->m_dResults.First();
+		if ( tRemote.m_iSuccesses<=0 || tRemote.m_dResults.GetLength()!=1 )
+		{
+			m_tFailures.SubmitEx ( m_tQuery.m_sIndexes, nullptr, "agent %s: top groups round: %s", pConn->m_tDesc.GetMyUrl().cstr(), tRemote.m_sError.cstr() );
+			continue;
+		}
+
+		if ( !AcceptReply ( pConn->m_iStoreTag, tRemote.m_dResults.First(), sError ) )
+			m_tFailures.SubmitEx ( m_tQuery.m_sIndexes, nullptr, "agent %s: top groups round: %s", pConn->m_tDesc.GetMyUrl().cstr(), sError.cstr() );
+	}
+}
+
+
+int64_t ExactTopK_c::CalcTotals ( OpenHash_T<Total_t, SphAttr_t> & hTotals ) const
+{
+	int64_t iUnseen = 0;
+	for ( const auto & tAgent : m_dAgents )
+		iUnseen += tAgent.m_iBound;
+
+	for ( const auto & tAgent : m_dAgents )
+	{
+		int64_t iIterator = 0;
+		std::pair<SphAttr_t, Group_t *> tGroup;
+		while ( ( tGroup = tAgent.m_hGroups.Iterate ( &iIterator ) ).second )
+		{
+			Total_t & tTotal = hTotals.FindOrAdd ( tGroup.first, { 0, iUnseen } );
+			tTotal.m_iTotal += tGroup.second->m_iCount;
+			tTotal.m_iMissing -= tAgent.m_iBound;
+		}
+	}
+
+	CSphVector<int64_t> dTotals;
+	dTotals.Reserve ( hTotals.GetLength() );
+	int64_t iIterator = 0;
+	std::pair<SphAttr_t, Total_t *> tTotal;
+	while ( ( tTotal = hTotals.Iterate ( &iIterator ) ).second )
+		dTotals.Add ( tTotal.second->m_iTotal );
+
+	if ( dTotals.GetLength()<m_iK )
+		return 0;
+
+	dTotals.RSort();
+	return dTotals[m_iK-1];
+}
+
+
+bool ExactTopK_c::KeysFilter ( CSphVector<SphAttr_t> & dKeys, CSphFilterSettings & tFilter ) const
+{
+	const OneResultset_t & tFirst = *m_dAgents.First().m_pChunk;
+	const CSphColumnInfo * pCol = tFirst.m_tSchema.GetAttr ( m_tQuery.m_sGroupBy.cstr() );
+	if ( !pCol )
+		return false;
+
+	tFilter.m_sAttrName = m_tQuery.m_sGroupBy;
+	switch ( pCol->m_eAttrType )
+	{
+	case SPH_ATTR_UINT32SET:
+	case SPH_ATTR_INT64SET:
+	case SPH_ATTR_UINT32SET_PTR:
+	case SPH_ATTR_INT64SET_PTR:
+		tFilter.m_eMvaFunc = SPH_MVAFUNC_ANY;
+		// no break
+	case SPH_ATTR_INTEGER:
+	case SPH_ATTR_BIGINT:
+	case SPH_ATTR_TIMESTAMP:
+	case SPH_ATTR_BOOL:
+		// group key is the value itself
+		dKeys.Uniq();
+		tFilter.m_eType = SPH_FILTER_VALUES;
+		tFilter.m_dValues.SwapData ( dKeys );
+		return true;
+
+	case SPH_ATTR_STRINGPTR:
+		// group key is a hash of the string, so take the string from any agent that shipped the group
+		tFilter.m_eType = SPH_FILTER_STRING_LIST;
+		for ( SphAttr_t tKey : dKeys )
+			for ( const auto & tAgent : m_dAgents )
+			{
+				const Group_t * pGroup = tAgent.m_hGroups.Find ( tKey );
+				if ( !pGroup )
+					continue;
+
+				const CSphMatch & tMatch = tAgent.m_pChunk->m_dMatches[pGroup->m_iMatch];
+				ByteBlob_t tBlob = sphUnpackPtrAttr ( (const BYTE *)tMatch.GetAttr ( pCol->m_tLocator ) );
+				tFilter.m_dStrings.Add().SetBinary ( (const char *)tBlob.first, tBlob.second );
+				break;
+			}
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+
+void ExactTopK_c::Prune ( const OpenHash_T<Total_t, SphAttr_t> & hTotals, int64_t iKth )
+{
+	// groups that can not get to the top only cost master merge time
+	for ( auto & tAgent : m_dAgents )
+	{
+		OneResultset_t & tChunk = *tAgent.m_pChunk;
+		int iKept = 0;
+		for ( auto & tMatch : tChunk.m_dMatches )
+		{
+			const Total_t * pTotal = hTotals.Find ( tMatch.GetAttr ( m_tKey ) );
+			if ( pTotal && pTotal->m_iTotal+pTotal->m_iMissing>=iKth )
+			{
+				Swap ( tChunk.m_dMatches[iKept++], tMatch );
+				continue;
+			}
+
+			tChunk.m_tSchema.FreeDataPtrs ( tMatch );
+			tMatch.ResetDynamic();
+		}
+
+		tChunk.m_dMatches.Resize ( iKept );
+	}
+}
+
+
+void ExactTopK_c::Warning ( const char * szReason ) const
+{
+	m_tFailures.SubmitEx ( m_tQuery.m_sIndexes, nullptr, "exact_topk: %s; top groups may be approximate", szReason );
+}
+
+
+void ExactTopK_c::Run()
+{
+	if ( !Setup() )
+		return;
+
+	int iAgents = m_dAgents.GetLength();
+
+	// second round
+	{
+		OpenHash_T<Total_t, SphAttr_t> hTotals;
+		int64_t iThreshold = Max ( ( CalcTotals ( hTotals ) + iAgents - 1 ) / iAgents, (int64_t)1 );
+
+		CSphVector<int> dAgents;
+		ARRAY_FOREACH ( i, m_dAgents )
+			if ( m_dAgents[i].m_iBound>=iThreshold )
+				dAgents.Add(i);
+
+		if ( !dAgents.IsEmpty() )
+		{
+			CSphQuery tQuery = m_tQuery;
+			tQuery.m_iMinGroupCount = iThreshold;
+			FetchRound ( dAgents, tQuery, m_tQuery.m_iMaxMatches );
+
+			for ( int iAgent : dAgents )
+			{
+				Agent_t & tAgent = m_dAgents[iAgent];
+				if ( tAgent.m_bReplied )
+					tAgent.m_iBound = tAgent.m_iShipped<m_tQuery.m_iMaxMatches ? iThreshold-1 : tAgent.m_iLowest;
+			}
+		}
+	}
+
+	// final fetch
+	OpenHash_T<Total_t, SphAttr_t> hTotals;
+	int64_t iKth = CalcTotals ( hTotals );
+
+	int64_t iUnseen = 0;
+	for ( const auto & tAgent : m_dAgents )
+		iUnseen += tAgent.m_iBound;
+
+	if ( iUnseen>0 && iUnseen>=iKth )
+	{
+		Warning ( "agents have more groups above the threshold than max_matches" );
+		return;
+	}
+
+	CSphVector<SphAttr_t> dKeys;
+	int64_t iIterator = 0;
+	std::pair<SphAttr_t, Total_t *> tTotal;
+	while ( ( tTotal = hTotals.Iterate ( &iIterator ) ).second )
+		if ( tTotal.second->m_iMissing>0 && tTotal.second->m_iTotal+tTotal.second->m_iMissing>=iKth )
+			dKeys.Add ( tTotal.first );
+
+	if ( !dKeys.IsEmpty() )
+	{
+		if ( dKeys.GetLength()>m_tQuery.m_iMaxMatches )
+		{
+			Warning ( "too many candidate groups, raise max_matches" );
+			return;
+		}
+
+		m_dWanted = dKeys;
+		m_dWanted.Uniq();
+
+		CSphQuery tQuery = m_tQuery;
+		if ( !KeysFilter ( dKeys, tQuery.m_dFilters.Add() ) )
+		{
+			Warning ( "group by column is not available for the final fetch" );
+			return;
+		}
+
+		// AND the keys with the filter tree, if any; its root is the last node
+		if ( tQuery.m_dFilterTree.GetLength() )
+		{
+			int iRoot = tQuery.m_dFilterTree.GetLength()-1;
+			tQuery.m_dFilterTree.Add().m_iFilterItem = tQuery.m_dFilters.GetLength()-1;
+			FilterTreeItem_t & tAnd = tQuery.m_dFilterTree.Add();
+			tAnd.m_iLeft = iRoot;
+			tAnd.m_iRight = iRoot+1;
+		}
+
+		// documents matching any of the keys of a multi-value column also make groups of their other values
+		// these take places in the reply and are dropped on receive, so the reply is not limited by the keys count
+		const CSphFilterSettings & tKeys = tQuery.m_dFilters.Last();
+		bool bMva = tKeys.m_eMvaFunc==SPH_MVAFUNC_ANY;
+		int iLimit = bMva ? m_tQuery.m_iMaxMatches : Max ( m_dWanted.GetLength(), 1 );
+		CSphVector<int> dAgents;
+		ARRAY_FOREACH ( i, m_dAgents )
+			if ( m_dAgents[i].m_iBound>0 )
+				dAgents.Add(i);
+
+		// totals are still valid upper bounds if the fetch fails, so the groups below the k-th are pruned anyway
+		FetchRound ( dAgents, tQuery, iLimit );
+		for ( int iAgent : dAgents )
+		{
+			const Agent_t & tAgent = m_dAgents[iAgent];
+			if ( !tAgent.m_bReplied )
+			{
+				Warning ( "agent failed to reply to the final fetch" );
+				break;
+			}
+
+			// full reply might have cut off some of the asked groups
+			if ( tAgent.m_iShipped>=iLimit && m_dWanted.any_of ( [&tAgent] ( SphAttr_t tKey ) { return !tAgent.m_hGroups.Find ( tKey ); } ) )
+			{
+				Warning ( "too many groups in the final fetch, raise max_matches" );
+				break;
+			}
+		}
+
+		m_dWanted.Reset();
+	}
+
+	Prune ( hTotals, iKth );
+}
+
+
+// results of expressions over the clock or random numbers differ from call to call
+static const char * g_dVolatileFuncs[] = { "rand(", "@random", "now(", "curtime(", "utc_time(", "utc_timestamp(", "connection_id(", "last_insert_id(" };
+
+static bool HasVolatileFunc ( const CSphString & sExpr )
+{
+	if ( sExpr.IsEmpty() )
+		return false;
+
+	CSphString sLower = sExpr;
+	sLower.ToLower();
+	for ( const char * szFunc : g_dVolatileFuncs )
+		if ( strstr ( sLower.cstr(), szFunc ) )
+			return true;
+
+	return false;
+}
+
+/// key of the final result of the query in the result cache; false if the query gives a different result on the same data
+static bool GetResultCacheKey ( const CSphQuery & tQuery, QueryType_e eQueryType, bool bFederatedUser, CSphString & sKey )
+{
+	if ( tQuery.m_uMaxQueryMsec || tQuery.m_iMaxPredictedMsec || tQuery.m_bVersionProbe )
+		return false;
+
+	if ( tQuery.m_dFilters.any_of ( [] ( const CSphFilterSettings & tFilter ) { return tFilter.m_eType==SPH_FILTER_USERVAR; } ) )
+		return false;
+
+	if ( HasVolatileFunc ( tQuery.m_sSelect ) || HasVolatileFunc ( tQuery.m_sSortBy ) || HasVolatileFunc ( tQuery.m_sGroupSortBy )
+		|| HasVolatileFunc ( tQuery.m_sOuterOrderBy ) || HasVolatileFunc ( tQuery.m_sRankerExpr ) || HasVolatileFunc ( tQuery.m_tHaving.m_sAttrName )
+		|| tQuery.m_dItems.any_of ( [] ( const CSphQueryItem & tItem ) { return HasVolatileFunc ( tItem.m_sExpr ); } )
+		|| tQuery.m_dFilters.any_of ( [] ( const CSphFilterSettings & tFilter ) { return HasVolatileFunc ( tFilter.m_sAttrName ); } ) )
+		return false;
+
+	// same bytes as the query sent to an agent; then the settings which only the master applies to the final result
+	VecTraits_T<CSphQuery> dQuery ( const_cast<CSphQuery *> ( &tQuery ), 1 );
+	SearchRequestBuilder_c tBuilder ( dQuery, 1 );
+	ISphOutputBuffer tOut;
+	tBuilder.SendQuery ( tQuery.m_sIndexes.cstr(), tOut, tQuery, -1, 0 );
+
+	tOut.SendInt ( eQueryType );
+	tOut.SendInt ( bFederatedUser );
+	tOut.SendInt ( tQuery.m_iOffset );
+	tOut.SendInt ( tQuery.m_iLimit );
+	tOut.SendInt ( tQuery.m_iOuterOffset );
+	tOut.SendInt ( tQuery.m_iOuterLimit );
+	tOut.SendUint64 ( tQuery.m_iRandSeed );
+	tOut.SendString ( tQuery.m_sFacetBy.cstr() );
+	tOut.SendInt ( tQuery.m_bExactTopK );
+	tOut.SendInt ( tQuery.m_iAgentQueryTimeoutMs );
+	tOut.SendDword ( tQuery.m_uDebugFlags );
+	tOut.SendInt ( tQuery.m_bStrict );
+	tOut.SendInt ( tQuery.m_bIgnoreNonexistent );
+	tOut.SendInt ( tQuery.m_bIgnoreNonexistentIndexes );
+	SendFilter ( tOut, tQuery.m_tHaving );
+
+	tOut.SendInt ( tQuery.m_dIncludeItems.GetLength() );
+	for ( const auto & sItem : tQuery.m_dIncludeItems )
+		tOut.SendString ( sItem.cstr() );
+	tOut.SendInt ( tQuery.m_dExcludeItems.GetLength() );
+	for ( const auto & sItem : tQuery.m_dExcludeItems )
+		tOut.SendString ( sItem.cstr() );
+
+	// the cache hashes keys as zero-terminated strings
+	sKey = BinToHex ( tOut.m_dBuf );
+	return true;
+}
+
+/// version of the data of the agents; replies come in no particular order (blackholes are dropped out of order), so versions are sorted first
+static uint64_t GetRemoteDataVersion ( CSphVector<uint64_t> & dVersions )
+{
+	if ( dVersions.Contains ( 0 ) )
+		return 0;
+
+	dVersions.Sort();
+	uint64_t uVersion = SPH_FNV64_SEED;
+	for ( uint64_t uAgent : dVersions )
+		uVersion = sphFNV64 ( &uAgent, sizeof(uAgent), uVersion );
+
+	return uVersion;
+}
+
+
+static uint64_t CombineDataVersions ( uint64_t uLocal, uint64_t uRemote )
+{
+	if ( !uLocal || !uRemote )
+		return 0;
+
+	return sphFNV64 ( &uRemote, sizeof(uRemote), uLocal );
+}
+
+/// 0 if any of the local indexes has no notion of a data version
+uint64_t SearchHandler_c::GetLocalDataVersion() const
+{
+	uint64_t uVersion = SPH_FNV64_SEED;
+	for ( const auto & tLocal : m_dLocal )
+	{
+		const ServedDesc_t * pServed = m_dLocked.Get ( tLocal.m_sName );
+		if ( !pServed || !pServed->m_pIndex || ( pServed->m_eType!=IndexType_e::PLAIN && pServed->m_eType!=IndexType_e::RT ) )
+			return 0;
+
+		int64_t dVersion[2] = { pServed->m_pIndex->GetIndexId(), pServed->m_pIndex->GetDataVersion() };
+		uVersion = sphFNV64cont ( tLocal.m_sName.cstr(), uVersion );
+		uVersion = sphFNV64 ( dVersion, sizeof(dVersion), uVersion );
+	}
+
+	return uVersion;
+}
+
+/// asks the agents for the versions of their data, without searching; 0 for the ones which did not tell
+CSphVector<uint64_t> SearchHandler_c::ProbeDataVersions ( const CSphVector<DistrServedByAgent_t> & dDistrServedByAgent ) const
+{
+	VecRefPtrsAgentConn_t dConns;
+	for ( const auto & tDistr : dDistrServedByAgent )
+	{
+		auto pDist = GetDistr ( tDistr.m_sIndex );
+		if ( !pDist )
+			continue;
+
+		for ( auto * pAgent : pDist->m_dAgents )
+		{
+			auto * pConn = new AgentConn_t;
+			pConn->SetMultiAgent ( pAgent );
+			pConn->m_iStoreTag = dConns.GetLength();
+			pConn->m_iMyConnectTimeoutMs = pDist->m_iAgentConnectTimeoutMs;
+			pConn->m_iMyQueryTimeoutMs = pDist->m_iAgentQueryTimeoutMs;
+			dConns.Add ( pConn );
+		}
+	}
+
+	CSphVector<uint64_t> dVersions;
+	if ( dConns.IsEmpty() )
+		return dVersions;
+
+	CSphQuery tProbe = m_dNQueries.First();
+	tProbe.m_bVersionProbe = true;
+	VecTraits_T<CSphQuery> dQueries ( &tProbe, 1 );
+	SearchRequestBuilder_c tBuilder ( dQueries, 1 );
+	SearchReplyParser_c tParser ( 1 );
+	PerformRemoteTasks ( dConns, &tBuilder, &tParser );
+
+	for ( const AgentConn_t * pConn : dConns )
+	{
+		auto pResult = (cSearchResult *)pConn->m_pResult.Ptr();
+		if ( !pConn->m_bSuccess || !pResult || pResult->m_dResults.First().m_iSuccesses<=0 )
+			dVersions.Add ( 0 );
+		else
+			dVersions.Add ( pResult->m_dResults.First().m_uDataVersion );
+	}
+
+	return dVersions;
+}
+
+
 void SearchHandler_c::RunSubset ( int iStart, int iEnd )
 {
 	int iQueries = iEnd - iStart;
@@ -6932,6 +7692,57 @@ void SearchHandler_c::RunSubset ( int iStart, int iEnd )
 	if ( !m_bMultiQueue )
 		m_bFacetQueue = false;
 
+	// taken before the search, so that a change racing with it can only make the result look older than it is
+	uint64_t uLocalVersion = GetLocalDataVersion();
+
+	// agent only tells the version of its data, so that master could check its cached result
+	if ( !m_bMaster && tFirst.m_bVersionProbe )
+	{
+		CSphVector<uint64_t> dVersions = ProbeDataVersions ( dDistrServedByAgent );
+		uint64_t uVersion = CombineDataVersions ( uLocalVersion, GetRemoteDataVersion ( dVersions ) );
+		for ( auto & tRes : m_dNAggrResults )
+		{
+			tRes.m_uDataVersion = uVersion;
+			tRes.m_iSuccesses = 1;
+			tRes.m_dResults.Add();
+			Debug ( tRes.m_bSingle = true; )
+			Debug ( tRes.m_bOneSchema = true; )
+		}
+		return;
+	}
+
+	//////////////////////////////
+	// final results cache lookup
+	//////////////////////////////
+
+	CSphString sCacheKey;
+	bool bResultCache = m_bMaster && iQueries==1 && !m_pProfile && !m_dTables[iStart] && uLocalVersion && tFirst.m_dStringSubkeys.IsEmpty()
+		&& RcacheGetStatus().m_iMaxBytes>0 && GetResultCacheKey ( tFirst, m_eQueryType, m_bFederatedUser, sCacheKey );
+
+	uint64_t uCachedRemoteVersion = 0;
+	if ( bResultCache && RcachePeek ( sCacheKey, uLocalVersion, uCachedRemoteVersion ) )
+	{
+		// cached result is only good while every agent is still at the version it was computed from
+		CSphVector<uint64_t> dVersions = ProbeDataVersions ( dDistrServedByAgent );
+		uint64_t uRemoteVersion = GetRemoteDataVersion ( dVersions );
+
+		AggrResult_t & tRes = m_dNAggrResults.First();
+		if ( uRemoteVersion==uCachedRemoteVersion && RcacheFind ( sCacheKey, uLocalVersion, uRemoteVersion, tRes ) )
+		{
+			tmSubset += sphMicroTimer();
+			tmCpu += sphTaskCpuTimer();
+
+			tRes.m_iQueryTime = (int)( tmSubset/1000 );
+			tRes.m_iRealQueryTime = (int)( tmSubset/1000 );
+			tRes.m_iCpuTime = tmCpu;
+			tRes.m_iAgentCpuTime = 0;
+			tRes.m_tIOStats = CSphIOStats();
+			tRes.m_tAgentIOStats = CSphIOStats();
+			CalcGlobalStats ( tmCpu, tmSubset, 0, tRes.m_tIOStats, VecRefPtrsAgentConn_t() );
+			return;
+		}
+	}
+
 	///////////////////////////////////////////////////////////
 	// main query loop (with multiple retries for distributed)
 	///////////////////////////////////////////////////////////
@@ -6940,10 +7751,16 @@ void SearchHandler_c::RunSubset ( int iStart, int iEnd )
 	CSphScopedPtr<SearchRequestBuilder_c> tReqBuilder { nullptr };
 	CSphRefcountedPtr<RemoteAgentsObserver_i> tReporter { nullptr };
 	CSphScopedPtr<ReplyParser_i> tParser { nullptr };
+
+	// top groups by count over agents only need a few groups from each of them to start with
+	bool bExactTopK = m_bMaster && iQueries==1 && m_dLocal.IsEmpty() && dRemotes.GetLength()>1 && iDivideLimits==1 && IsExactTopK ( tFirst );
+
 	if ( !dRemotes.IsEmpty() )
 	{
 		SwitchProfile(m_pProfile, SPH_QSTATE_DIST_CONNECT);
 		tReqBuilder = new SearchRequestBuilder_c ( m_dNQueries, iDivideLimits );
+		if ( bExactTopK )
+			tReqBuilder->SetAgentLimit ( ExactTopK_c::AgentLimit ( tFirst ) );
 		tParser = new SearchReplyParser_c ( iQueries );
 		tReporter = GetObserver();
 
@@ -6954,6 +7771,10 @@ void SearchHandler_c::RunSubset ( int iStart, int iEnd )
 			tReporter, tFirst.m_iRetryCount, tFirst.m_iRetryDelay );
 	}
 
+	// blackholes are out of dRemotes by now
+	CSphVector<uint64_t> dRemoteVersions ( dRemotes.GetLength() );
+	dRemoteVersions.ZeroVec();
+
 	/////////////////////
 	// run local queries
 	//////////////////////
@@ -7032,6 +7853,9 @@ void SearchHandler_c::RunSubset ( int iStart, int iEnd )
 					AggrResult_t & tRes = m_dNAggrResults[iRes];
 					++tRes.m_iSuccesses;
 
+					if ( !iRes )
+						dRemoteVersions[iAgent] = tRemoteResult.m_uDataVersion;
+
 					assert ( tRemoteResult.m_dResults.GetLength() == 1 ); // by design remotes return one chunk
 					auto & dRemoteChunk = tRes.m_dResults.Add ();
 					::Swap ( dRemoteChunk, *tRemoteResult.m_dResults.begin () );
@@ -7086,6 +7910,12 @@ void SearchHandler_c::RunSubset ( int iStart, int iEnd )
 					m_dNFailuresSet[j].SubmitEx ( tFirst.m_sIndexes, nullptr, "agent %s: %s",
 						pAgent->m_tDesc.GetMyUrl().cstr(), pAgent->m_sFailure.cstr() );
 		}
+
+		if ( bExactTopK )
+		{
+			ExactTopK_c tTopK ( m_dNAggrResults.First(), tFirst, m_dNFailuresSet.First() );
+			tTopK.Run();
+		}
 	}
 
 	/////////////////////
@@ -7129,6 +7959,17 @@ void SearchHandler_c::RunSubset ( int iStart, int iEnd )
 		if ( m_bMaster && !tQuery.m_tHaving.m_sAttrName.IsEmpty() )
 			pAggrFilter = &tQuery.m_tHaving;
 
+		// agent in the top groups rounds ships only the groups above the master's threshold
+		CSphFilterSettings tMinCount;
+		if ( !m_bMaster && tQuery.m_iMinGroupCount>0 && !tQuery.m_sGroupBy.IsEmpty() )
+		{
+			tMinCount.m_sAttrName = "@count";
+			tMinCount.m_eType = SPH_FILTER_RANGE;
+			tMinCount.m_iMinValue = tQuery.m_iMinGroupCount;
+			tMinCount.m_iMaxValue = INT64_MAX;
+			pAggrFilter = &tMinCount;
+		}
+
 		const CSphVector<CSphQueryItem> & dItems = ( tQuery.m_dRefItems.GetLength() ? tQuery.m_dRefItems : tQuery.m_dItems );
 
 		if ( tRes.m_iSuccesses>1 || dItems.GetLength() || pAggrFilter )
@@ -7166,6 +8007,9 @@ void SearchHandler_c::RunSubset ( int iStart, int iEnd )
 		// finalize
 		////////////
 
+		if ( m_bMaster && tQuery.m_fSampleRate<1.0f )
+			ScaleSampledResult ( tRes, tQuery );
+
 		tRes.m_iOffset = Max ( tQuery.m_iOffset, tQuery.m_iOuterOffset );
 		auto iLimit = ( tQuery.m_iOuterLimit ? tQuery.m_iOuterLimit : tQuery.m_iLimit );
 		tRes.m_iCount = Max ( Min ( iLimit, tRes.GetLength()-tRes.m_iOffset ), 0 );
@@ -7199,6 +8043,17 @@ void SearchHandler_c::RunSubset ( int iStart, int iEnd )
 	CalcTimeStats ( tmCpu, tmSubset, dDistrServedByAgent );
 	CalcPerIndexStats ( dDistrServedByAgent );
 	CalcGlobalStats ( tmCpu, tmSubset, tmLocal, tIO, dRemotes );
+
+	uint64_t uRemoteVersion = GetRemoteDataVersion ( dRemoteVersions );
+	if ( !m_bMaster )
+		m_dNAggrResults.Apply ( [uLocalVersion, uRemoteVersion] ( AggrResult_t & tRes ) { tRes.m_uDataVersion = CombineDataVersions ( uLocalVersion, uRemoteVersion ); } );
+
+	if ( bResultCache && uRemoteVersion && tmSubset/1000>=RcacheGetStatus().m_iThreshMs )
+	{
+		const AggrResult_t & tRes = m_dNAggrResults.First();
+		if ( tRes.m_iSuccesses && tRes.m_sError.IsEmpty() && tRes.m_sWarning.IsEmpty() )
+			RcacheAdd ( sCacheKey, uLocalVersion, uRemoteVersion, tRes );
+	}
 }
 
 
@@ -7219,6 +8074,22 @@ bool CheckCommandVersion ( WORD uVer, WORD uDaemonVersion, ISphOutputBuffer & tO
 	return true;
 }
 
+// predicted wait of new work of current priority class exceeds the deadline - better to refuse it right now,
+// as it will not be served in time anyway
+bool IsQueueOverloaded ()
+{
+	if ( session::GetVip () )
+		return false;
+
+	auto ePrio = Coro::GetPriority();
+	auto iMaxWaitUS = g_dQueueMaxWaitUS[(int)ePrio];
+	if ( !iMaxWaitUS || GlobalWorkPool()->EstimatedWaitUS ( ePrio )<=iMaxWaitUS )
+		return false;
+
+	gStats().m_iQueueShed.fetch_add ( 1, std::memory_order_relaxed );
+	return true;
+}
+
 bool IsMaxedOut ()
 {
 	if ( session::GetVip () )
@@ -7298,6 +8169,13 @@ void HandleCommandSearch ( ISphOutputBuffer & tOut, WORD uVer, InputBuffer_c & t
 		if ( !ParseSearchQuery ( tReq, tOut, dQuery, uVer, uMasterVer ) )
 			return;
 
+	// admission control: don't start search which is predicted to wait in queue longer than allowed
+	if ( IsQueueOverloaded() )
+	{
+		SendErrorReply ( tOut, "%s", g_sQueueOverloadedMessage );
+		return;
+	}
+
 	if ( !tHandler.m_dQueries.IsEmpty() )
 	{
 		QueryType_e eQueryType = tHandler.m_dQueries[0].m_eQueryType;
@@ -8727,6 +9605,50 @@ void BuildStatus ( VectorLike & dStatus )
 	dStatus.MatchTupletf ( "workers_active", "%d", myinfo::CountAll () );
 	dStatus.MatchTupletf ( "workers_clients", "%d", myinfo::CountClients () );
 	dStatus.MatchTupletf ( "work_queue_length", "%d", GlobalWorkPool ()->Works () );
+	{
+		auto tQueue = GlobalWorkPool ()->GetQueueStats ();
+		StringBuilder_c sKey;
+		dStatus.MatchTupletf ( "work_queue_vip", "%d", tQueue.m_iVip );
+		for ( int i = 0; i<PRIORITY_CLASSES; ++i )
+		{
+			const char * szClass = PriorityName ( (Priority_e)i );
+			sKey.Clear();
+			sKey.Sprintf ( "work_queue_%s", szClass );
+			dStatus.MatchTupletf ( sKey.cstr(), "%d", tQueue.m_dQueued[i] );
+			sKey.Clear();
+			sKey.Sprintf ( "work_served_%s", szClass );
+			dStatus.MatchTupletf ( sKey.cstr(), "%l", tQueue.m_dServed[i] );
+		}
+		dStatus.MatchTupletf ( "work_avg_op_us", "%l", tQueue.m_iAvgOpUS );
+		dStatus.MatchTupletf ( "work_queue_shed", "%l", g_tStats.m_iQueueShed.load ( std::memory_order_relaxed ) );
+	}
+	if ( Numa::IsEnabled() )
+	{
+		StringBuilder_c sKey;
+		auto fnNodeTuple = [&dStatus, &sKey] ( int iNode, const char * szName, const char * szFmt, int64_t iValue ) {
+			sKey.Clear();
+			sKey.Sprintf ( "numa_node%d_%s", iNode, szName );
+			dStatus.MatchTupletf ( sKey.cstr(), szFmt, iValue );
+		};
+
+		for ( int i = 0; i<Numa::NodesCount(); ++i )
+		{
+			auto tNode = Numa::GetNodeStatus ( i );
+			fnNodeTuple ( tNode.m_iId, "workers", "%l", tNode.m_iThreads );
+			fnNodeTuple ( tNode.m_iId, "work_queue_length", "%l", tNode.m_iWorks );
+			fnNodeTuple ( tNode.m_iId, "indexes", "%l", tNode.m_iIndexes );
+			fnNodeTuple ( tNode.m_iId, "indexes_mass", "%l", tNode.m_iMass );
+			fnNodeTuple ( tNode.m_iId, "queries", "%l", tNode.m_iQueries );
+		}
+	}
+
+	if ( GetHugePages()!=HugePages_e::NONE )
+	{
+		auto tHuge = GetHugePagesStats();
+		dStatus.MatchTupletf ( "huge_pages_advised", "%l", tHuge.m_iAdvised );
+		dStatus.MatchTupletf ( "huge_pages_fallbacks", "%l", tHuge.m_iFallbacks );
+		dStatus.MatchTupletf ( "huge_pages_explicit_bytes", "%l", tHuge.m_iExplicitBytes );
+	}
 
 	for ( RLockedDistrIt_c it ( g_pDistIndexes ); it.Next (); )
 	{
@@ -8818,6 +9740,14 @@ void BuildStatus ( VectorLike & dStatus )
 	dStatus.MatchTupletf ( "qcache_used_bytes", "%l", s.m_iUsedBytes );
 	dStatus.MatchTupletf ( "qcache_hits", "%l", s.m_iHits );
 
+	const RcacheStatus_t & r = RcacheGetStatus();
+	dStatus.MatchTupletf ( "rcache_max_bytes", "%l", r.m_iMaxBytes );
+	dStatus.MatchTupletf ( "rcache_thresh_msec", "%d", r.m_iThreshMs );
+	dStatus.MatchTupletf ( "rcache_ttl_sec", "%d", r.m_iTtlS );
+	dStatus.MatchTupletf ( "rcache_cached_queries", "%d", r.m_iCachedQueries );
+	dStatus.MatchTupletf ( "rcache_used_bytes", "%l", r.m_iUsedBytes );
+	dStatus.MatchTupletf ( "rcache_hits", "%l", r.m_iHits );
+
 	// clusters
 	ReplicateClustersStatus ( dStatus );
 }
@@ -9012,6 +9942,11 @@ void BuildMeta ( VectorLike & dStatus, const CSphQueryResultMeta & tMeta )
 
 	dStatus.MatchTupletf ( "total", "%d", tMeta.m_iMatches );
 	dStatus.MatchTupletf ( "total_found", "%l", tMeta.m_iTotalMatches );
+	if ( tMeta.m_fSampleRate<1.0f )
+	{
+		dStatus.MatchTupletf ( "total_found_error", "%l", tMeta.m_iTotalMatchesError );
+		dStatus.MatchTupletf ( "sample_rate", "%f", tMeta.m_fSampleRate );
+	}
 	dStatus.MatchTupletf ( "time", "%.3F", tMeta.m_iQueryTime );
 
 	if ( tMeta.m_iMultiplier>1 )
@@ -13537,6 +14472,19 @@ void HandleMysqlSet ( RowBuffer_i & tOut, SqlStmt_t & tStmt, CSphSessionAccum &
 			break;
 		}
 
+		if ( tStmt.m_sSetName=="priority" )
+		{
+			Priority_e ePrio;
+			tStmt.m_sSetValue.ToLower();
+			if ( !PriorityFromName ( tStmt.m_sSetValue, ePrio ) )
+			{
+				tOut.ErrorEx ( tStmt.m_sStmt, "Unknown priority '%s', expected 'high', 'normal' or 'low'", tStmt.m_sSetValue.cstr () );
+				return;
+			}
+			Coro::SetPriority ( ePrio );
+			break;
+		}
+
 		if ( tStmt.m_sSetName == "ro" )
 		{
 			if ( !tSess.GetVip() )
@@ -13669,6 +14617,18 @@ void HandleMysqlSet ( RowBuffer_i & tOut, SqlStmt_t & tStmt, CSphSessionAccum &
 		{
 			const QcacheStatus_t & s = QcacheGetStatus();
 			QcacheSetup ( s.m_iMaxBytes, s.m_iThreshMs, (int)tStmt.m_iSetValue );
+		} else if ( tStmt.m_sSetName=="rcache_max_bytes" )
+		{
+			const RcacheStatus_t & s = RcacheGetStatus();
+			RcacheSetup ( tStmt.m_iSetValue, s.m_iThreshMs, s.m_iTtlS );
+		} else if ( tStmt.m_sSetName=="rcache_thresh_msec" )
+		{
+			const RcacheStatus_t & s = RcacheGetStatus();
+			RcacheSetup ( s.m_iMaxBytes, (int)tStmt.m_iSetValue, s.m_iTtlS );
+		} else if ( tStmt.m_sSetName=="rcache_ttl_sec" )
+		{
+			const RcacheStatus_t & s = RcacheGetStatus();
+			RcacheSetup ( s.m_iMaxBytes, s.m_iThreshMs, (int)tStmt.m_iSetValue );
 		} else if ( tStmt.m_sSetName=="log_debug_filter" )
 		{
 			int iLen = tStmt.m_sSetValue.Length();
@@ -13735,6 +14695,17 @@ void HandleMysqlSet ( RowBuffer_i & tOut, SqlStmt_t & tStmt, CSphSessionAccum &
 		} else if ( tStmt.m_sSetName=="optimize_cutoff")
 		{
 			g_iAutoOptimizeCutoff = tStmt.m_iSetValue;
+		} else if ( tStmt.m_sSetName=="optimize_dead_percent" )
+		{
+			g_iOptimizeDeadPercent = Max ( Min ( (int)tStmt.m_iSetValue, 100 ), 0 );
+		} else if ( tStmt.m_sSetName=="optimize_write_amplification" )
+		{
+			if ( tStmt.m_iSetValue<0 || ( tStmt.m_iSetValue>0 && tStmt.m_iSetValue<OPTIMIZE_MIN_WRITE_AMPLIFICATION ) )
+			{
+				tOut.ErrorEx ( tStmt.m_sStmt, "optimize_write_amplification should be 0 or at least %d", OPTIMIZE_MIN_WRITE_AMPLIFICATION );
+				return;
+			}
+			g_iOptimizeWriteAmplification = (int)tStmt.m_iSetValue;
 		} else if ( tStmt.m_sSetName=="pseudo_sharding")
 		{
 			g_bSplit = !!tStmt.m_iSetValue;
@@ -14701,9 +15672,12 @@ void HandleMysqlShowVariables ( RowBuffer_i & dRows, const SqlStmt_t & tStmt )
 		dTable.MatchTuplet ( "autocommit", pVars->m_bAutoCommit ? "1" : "0" );
 		dTable.MatchTupletf ( "auto_optimize", "%d", g_iAutoOptimizeCutoffMultiplier );
 		dTable.MatchTupletf ( "optimize_cutoff", "%d", g_iAutoOptimizeCutoff );
+		dTable.MatchTupletf ( "optimize_dead_percent", "%d", g_iOptimizeDeadPercent );
+		dTable.MatchTupletf ( "optimize_write_amplification", "%d", g_iOptimizeWriteAmplification );
 		dTable.MatchTuplet ( "collation_connection", sphCollationToName ( session::GetCollation() ) );
 		dTable.MatchTuplet ( "query_log_format", g_eLogFormat==LOG_FORMAT_PLAIN ? "plain" : "sphinxql" );
 		dTable.MatchTuplet ( "session_read_only", session::GetReadOnly() ? "1" : "0" );
+		dTable.MatchTuplet ( "priority", PriorityName ( Coro::GetPriority() ) );
 		dTable.MatchTuplet ( "log_level", LogLevelName ( g_eLogLevel ) );
 		dTable.MatchTupletf ( "max_allowed_packet", "%d", g_iMaxPacketSize );
 		dTable.MatchTuplet ( "character_set_client", "utf8" );
@@ -14880,6 +15854,7 @@ static void AddDiskIndexStatus ( VectorLike & dStatus, const CSphIndex * pIndex,
 			sPercent << "100%";
 		return CSphString ( sPercent.cstr () );
 	} );
+	dStatus.MatchTupletf ( "stale_minmax_blocks", "%l", tStatus.m_iStaleMinMaxBlocks );
 	if ( bMutable )
 	{
 		dStatus.MatchTupletf ( "ram_chunk", "%l", tStatus.m_iRamChunkSize );
@@ -15981,6 +16956,14 @@ bool ClientSession_c::Execute ( Str_t sQuery, RowBuffer_i & tOut )
 		}
 	}
 
+	// admission control: don't start search which is predicted to wait in queue longer than allowed
+	if ( bParsedOK && eStmt==STMT_SELECT && IsQueueOverloaded() )
+	{
+		FreezeLastMeta();
+		tOut.Error ( sQuery.first, g_sQueueOverloadedMessage );
+		return true;
+	}
+
 	// handle multi SQL query
 	if ( bParsedOK && dStmt.GetLength()>1 )
 	{
@@ -18939,6 +19922,18 @@ static void ConfigureDaemonLog ( const CSphString & sMode )
 		sphWarning ( "query_log_statements invalid values: %s", sWrongModes.cstr() );
 }
 
+static void ConfigureHugePages ( const CSphString & sMode )
+{
+	if ( sMode=="none" || sMode=="0" )
+		SetHugePages ( HugePages_e::NONE );
+	else if ( sMode=="transparent" || sMode=="1" )
+		SetHugePages ( HugePages_e::TRANSPARENT );
+	else if ( sMode=="explicit" )
+		SetHugePages ( HugePages_e::EXPLICIT );
+	else
+		sphWarning ( "unknown huge_pages value '%s', expected none, transparent or explicit; huge pages are not used", sMode.cstr() );
+}
+
 void ConfigureSearchd ( const CSphConfig & hConf, bool bOptPIDFile, bool bTestMode ) REQUIRES ( MainThread )
 {
 	if ( !hConf.Exists ( "searchd" ) || !hConf["searchd"].Exists ( "searchd" ) )
@@ -18964,7 +19959,11 @@ void ConfigureSearchd ( const CSphConfig & hConf, bool bOptPIDFile, bool bTestMo
 	g_iMaxConnection = hSearchd.GetInt ( "max_connections", g_iMaxConnection );
 	g_iThreads = hSearchd.GetInt ( "threads", sphCpuThreadsCount() );
 	SetMaxChildrenThreads ( g_iThreads );
+	Numa::Configure ( hSearchd.GetBool ( "numa_aware" ) );
+	ConfigureHugePages ( hSearchd.GetStr ( "huge_pages", "none" ) );
 	g_iThdQueueMax = hSearchd.GetInt ( "jobs_queue_size", g_iThdQueueMax );
+	g_dQueueMaxWaitUS[(int)Priority_e::NORMAL] = hSearchd.GetUsTime64Ms ( "queue_max_wait", 0 );
+	g_dQueueMaxWaitUS[(int)Priority_e::LOW] = hSearchd.GetUsTime64Ms ( "queue_max_wait_low", g_dQueueMaxWaitUS[(int)Priority_e::NORMAL] );
 
 	g_iPersistentPoolSize = hSearchd.GetInt ("persistent_connections_limit");
 	MutableIndexSettings_c::GetDefaults().m_bPreopen = hSearchd.GetBool ( "preopen_indexes" );
@@ -19009,6 +20008,7 @@ void ConfigureSearchd ( const CSphConfig & hConf, bool bOptPIDFile, bool bTestMo
 		sphWarning ( "preopen_indexes=1 has no effect with seamless_rotate=0" );
 
 	SetAttrFlushPeriod ( hSearchd.GetUsTime64S ( "attr_flush_period", 0 ));
+	SetMinMaxRefreshPeriod ( hSearchd.GetUsTime64S ( "minmax_refresh_period", DEFAULT_MINMAX_REFRESH_PERIOD ));
 	g_iMaxPacketSize = hSearchd.GetSize ( "max_packet_size", g_iMaxPacketSize );
 	g_iMaxFilters = hSearchd.GetInt ( "max_filters", g_iMaxFilters );
 	g_iMaxFilterValues = hSearchd.GetInt ( "max_filter_values", g_iMaxFilterValues );
@@ -19073,6 +20073,8 @@ void ConfigureSearchd ( const CSphConfig & hConf, bool bOptPIDFile, bool bTestMo
 
 	g_iDocstoreCache = hSearchd.GetSize64 ( "docstore_cache_size", 16777216 );
 	g_iSkipCache = hSearchd.GetSize64 ( "skiplist_cache_size", 67108864 );
+	g_iExpansionCache = hSearchd.GetSize64 ( "expansion_cache_size", 16777216 );
+	g_iDocBitmapCache = hSearchd.GetSize64 ( "doclist_bitmap_cache_size", 134217728 );
 
 	if ( hSearchd.Exists ( "max_open_files" ) )
 	{
@@ -19110,6 +20112,12 @@ void ConfigureSearchd ( const CSphConfig & hConf, bool bOptPIDFile, bool bTestMo
 	s.m_iTtlS = hSearchd.GetSTimeS ( "qcache_ttl_sec", s.m_iTtlS );
 	QcacheSetup ( s.m_iMaxBytes, s.m_iThreshMs, s.m_iTtlS );
 
+	RcacheStatus_t r = RcacheGetStatus();
+	r.m_iMaxBytes = hSearchd.GetSize64 ( "rcache_max_bytes", r.m_iMaxBytes );
+	r.m_iThreshMs = hSearchd.GetMsTimeMs ( "rcache_thresh_msec", r.m_iThreshMs );
+	r.m_iTtlS = hSearchd.GetSTimeS ( "rcache_ttl_sec", r.m_iTtlS );
+	RcacheSetup ( r.m_iMaxBytes, r.m_iThreshMs, r.m_iTtlS );
+
 	// hostname_lookup = {config_load | request}
 	g_bHostnameLookup = ( hSearchd.GetStr ( "hostname_lookup" ) == "request" );
 
@@ -19145,6 +20153,14 @@ void ConfigureSearchd ( const CSphConfig & hConf, bool bOptPIDFile, bool bTestMo
 	ConfigureDaemonLog ( hSearchd.GetStr ( "query_log_commands" ) );
 	g_iAutoOptimizeCutoffMultiplier = hSearchd.GetInt ( "auto_optimize", 1 );
 	g_iAutoOptimizeCutoff = hSearchd.GetInt ( "optimize_cutoff", g_iAutoOptimizeCutoff );
+	g_iOptimizeDeadPercent = Max ( Min ( hSearchd.GetInt ( "optimize_dead_percent", g_iOptimizeDeadPercent ), 100 ), 0 );
+	int iWriteAmp = hSearchd.GetInt ( "optimize_write_amplification", g_iOptimizeWriteAmplification );
+	if ( iWriteAmp<0 || ( iWriteAmp>0 && iWriteAmp<OPTIMIZE_MIN_WRITE_AMPLIFICATION ) )
+	{
+		sphWarning ( "optimize_write_amplification=%d is out of range (should be 0 or at least %d), ignored", iWriteAmp, OPTIMIZE_MIN_WRITE_AMPLIFICATION );
+		iWriteAmp = 0;
+	}
+	g_iOptimizeWriteAmplification = iWriteAmp;
 
 	g_bSplit = hSearchd.GetInt ( "pseudo_sharding", 0 )!=0;
 }
@@ -19571,6 +20587,7 @@ int WINAPI ServiceMain ( int argc, char **argv ) REQUIRES (!MainThread)
 #endif
 
 	tzset();
+	CivilTime::InitLocalZone();
 
 	CSphString sError;
 	// initialize it before other code to fetch version string for banner
@@ -19940,6 +20957,7 @@ int WINAPI ServiceMain ( int argc, char **argv ) REQUIRES (!MainThread)
 		Ping::Start();
 
 	ScheduleMallocTrim();
+	ScheduleQcacheSweep();
 
 	// initialize timeouts since hook will use them
 	auto iRtFlushPeriodUs = hSearchd.GetUsTime64S ( "rt_flush_period", 36000000000ll ); // 10h
@@ -20027,6 +21045,8 @@ int WINAPI ServiceMain ( int argc, char **argv ) REQUIRES (!MainThread)
 	SetUidShort ( bTestMode );
 	InitDocstore ( g_iDocstoreCache );
 	InitSkipCache ( g_iSkipCache );
+	InitExpansionCache ( g_iExpansionCache );
+	InitDocBitmapCache ( g_iDocBitmapCache );
 	InitParserOption();
 
 	if ( bOptPIDFile )
@@ -20132,6 +21152,7 @@ int WINAPI ServiceMain ( int argc, char **argv ) REQUIRES (!MainThread)
 	StartRtBinlogFlushing();
 
 	ScheduleFlushAttrs();
+	ScheduleMinMaxRefresh();
 
 	gStats().m_uStarted = (DWORD)time(NULL);
 
@@ -160,7 +160,7 @@ const char* szCommand ( int );
 /// master-agent API SEARCH command protocol extensions version
 enum
 {
-	VER_COMMAND_SEARCH_MASTER = 18
+	VER_COMMAND_SEARCH_MASTER = 22
 };
 
 
@@ -661,6 +661,7 @@ struct ServedDesc_t
 	bool		m_bOnlyNew		= false; ///< load new clean index - no previous valid files, no .old backups possible, no way to serve if loading failed.
 	CSphString	m_sGlobalIDFPath;
 	int64_t		m_iMass			= 0; // relative weight (by access speed) of the index
+	mutable int	m_iNumaNode		= -1; // NUMA node the index was placed on at preread; -1 if none. Set once, under read lock
 	int			m_iRotationPriority = 0;	// rotation priority (for proper rotation of indexes chained by killlist_target). 0==high priority
 	StrVec_t	m_dKilllistTargets;
 	mutable CSphString	m_sUnlink;
@@ -731,6 +732,20 @@ struct ServedDesc_t
 		return pServed->m_iMass;
 	}
 
+	static int GetNumaNode ( const ServedDesc_t* pServed )
+	{
+		if ( !pServed )
+			return -1;
+		return pServed->m_iNumaNode;
+	}
+
+	// placement is not a part of index definition, so it is set on already served (read-locked) index
+	static void SetNumaNode ( const ServedDesc_t* pServed, int iNode )
+	{
+		if ( pServed )
+			pServed->m_iNumaNode = iNode;
+	}
+
 	virtual                ~ServedDesc_t ();
 };
 
@@ -1129,6 +1144,7 @@ struct AggrResult_t final: CSphQueryResultMeta
 	int						m_iOffset = 0;		///< requested offset into matches array
 	int						m_iCount = 0;		///< count which will be actually served (computed from total, offset and limit)
 	int						m_iSuccesses = 0;
+	uint64_t				m_uDataVersion = 0;	///< version of the data the result was computed from (agent reports it to master); 0 if unknown
 	bool					m_bTagsAssigned = false; // if matches in chunk(s) have assigned tags
 	Debug (bool 			m_bSingle = false;) // single = only one chunk. False = many chunks
 	Debug (bool				m_bOneSchema = false;) // either chunk's schemas are valid, or single result's schema in game.
@@ -1245,6 +1261,7 @@ enum ESphHttpEndpoint
 
 bool CheckCommandVersion ( WORD uVer, WORD uDaemonVersion, ISphOutputBuffer & tOut );
 bool IsMaxedOut ();
+bool IsQueueOverloaded ();
 bool IsReadOnly ();
 void sphFormatFactors ( StringBuilder_c& dOut, const unsigned int * pFactors, bool bJson );
 void sphHandleMysqlInsert ( StmtErrorReporter_i & tOut, SqlStmt_t & tStmt );
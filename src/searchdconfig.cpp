@@ -17,6 +17,7 @@
 #include "sphinxint.h"
 #include "coroutine.h"
 #include "sphinxpq.h"
+#include "binlog.h"
 
 // description of clusters and indexes loaded from internal config
 static CSphVector<ClusterDesc_t> g_dCfgClusters;
@@ -1130,6 +1131,7 @@ static void CleanupOnError ( const CSphString & sIndex, RtIndex_i * pRt )
 	}
 
 	pRt->IndexDeleted();
+	Binlog::ForgetIndex ( sIndex.cstr() );
 	DeleteExtraIndexFiles(pRt);
 	g_pLocalIndexes->Delete(sIndex);
 }
@@ -1163,6 +1165,9 @@ bool CreateNewIndexInt ( const CSphString & sIndex, const CreateTableSettings_t
 		tSettingsContainer.Add ( "path", sIndexPath );
 		if ( !CopyExternalIndexFiles ( tSettingsContainer.GetFiles(), sPath, dCopied, sError ) )
 			return false;
+
+		// new index starts from TID 0, so logs left under its name (if any) are not its own
+		Binlog::ForgetIndex ( sIndex.cstr() );
 	}
 
 	const CSphConfigSection & hCfg = tSettingsContainer.AsCfg();
@@ -1301,6 +1306,7 @@ static bool DropLocalIndex ( const CSphString & sIndex, CSphString & sError )
 		return false;
 
 	pRt->IndexDeleted();
+	Binlog::ForgetIndex ( sIndex.cstr() );
 
 	DeleteExtraIndexFiles(pRt);
 
@@ -895,6 +895,7 @@ SearchdStats_t::SearchdStats_t()
 	m_uStarted = 0;
 	m_iConnections = 0;
 	m_iMaxedOut = 0;
+	m_iQueueShed = 0;
 	m_iAgentConnect = 0;
 	m_iAgentConnectTFO = 0;
 
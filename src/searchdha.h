@@ -737,6 +737,7 @@ struct SearchdStats_t
 	DWORD					m_uStarted;
 	std::atomic<int64_t>	m_iConnections;
 	std::atomic<int64_t>	m_iMaxedOut;
+	std::atomic<int64_t>	m_iQueueShed;		///< requests refused by queue admission control
 	std::atomic<int64_t>	m_iCommandCount[SEARCHD_COMMAND_TOTAL];
 	std::atomic<int64_t>	m_iAgentConnect;
 	std::atomic<int64_t>	m_iAgentConnectTFO;
@@ -19,6 +19,7 @@
 #include "searchdha.h"
 #include "searchdreplication.h"
 #include "accumulator.h"
+#include "networking_daemon.h"
 
 static const char * g_dHttpStatus[] = { "200 OK", "206 Partial Content", "400 Bad Request", "403 Forbidden", "500 Internal Server Error",
 								 "501 Not Implemented", "503 Service Unavailable", "526 Invalid SSL Certificate" };
@@ -623,6 +624,14 @@ public:
 		if ( !pQueryParser )
 			return false;
 
+		// admission control: don't start search which is predicted to wait in queue longer than allowed
+		if ( IsQueueOverloaded() )
+		{
+			SafeDelete ( pQueryParser );
+			ReportError ( g_sQueueOverloadedMessage, SPH_HTTP_STATUS_503 );
+			return false;
+		}
+
 		int iQueries = ( 1 + m_tQuery.m_dAggs.GetLength() );
 
 		CSphScopedPtr<PubSearchHandler_c> tHandler { CreateMsearchHandler ( pQueryParser, m_eQueryType, m_tQuery )};
@@ -15,6 +15,7 @@
 #include "sphinxplugin.h"
 #include "searchdaemon.h"
 #include "searchdddl.h"
+#include "sortsetup.h"
 
 extern int g_iAgentQueryTimeoutMs;	// global (default). May be override by index-scope values, if one specified
 
@@ -119,6 +120,7 @@ public:
 
 	bool			AddOption ( const SqlNode_t & tIdent );
 	bool			AddOption ( const SqlNode_t & tIdent, const SqlNode_t & tValue );
+	bool			AddFloatOption ( const SqlNode_t & tIdent, const SqlNode_t & tValue );
 	bool			AddOption ( const SqlNode_t & tIdent, const SqlNode_t & tValue, const SqlNode_t & sArg );
 	bool			AddOption ( const SqlNode_t & tIdent, CSphVector<CSphNamedInt> & dNamed );
 	void			AddIndexHint ( IndexHint_e eHint, const SqlNode_t & tValue );
@@ -361,6 +363,9 @@ enum class Option_e : BYTE
 	NOT_ONLY_ALLOWED,
 	STORE,
 	PSEUDO_SHARDING,
+	SEARCH_AFTER,
+	EXACT_TOPK,
+	SAMPLE,
 
 	INVALID_OPTION
 };
@@ -374,7 +379,7 @@ void InitParserOption()
 		"idf", "ignore_nonexistent_columns", "ignore_nonexistent_indexes", "index_weights", "local_df", "low_priority",
 		"max_matches", "max_predicted_time", "max_query_time", "morphology", "rand_seed", "ranker", "retry_count",
 		"retry_delay", "reverse_scan", "sort_method", "strict", "sync", "threads", "token_filter", "token_filter_options",
-		"not_terms_only_allowed", "store", "pseudo_sharding" };
+		"not_terms_only_allowed", "store", "pseudo_sharding", "search_after", "exact_topk", "sample" };
 
 	for ( BYTE i = 0u; i<(BYTE) Option_e::INVALID_OPTION; ++i )
 		g_hParseOption.Add ( (Option_e) i, dOptions[i] );
@@ -406,7 +411,8 @@ static bool CheckOption ( SqlStmt_e eStmt, Option_e eOption )
 			Option_e::LOCAL_DF, Option_e::LOW_PRIORITY, Option_e::MAX_MATCHES, Option_e::MAX_PREDICTED_TIME,
 			Option_e::MAX_QUERY_TIME, Option_e::MORPHOLOGY, Option_e::RAND_SEED, Option_e::RANKER,
 			Option_e::RETRY_COUNT, Option_e::RETRY_DELAY, Option_e::REVERSE_SCAN, Option_e::SORT_METHOD,
-			Option_e::THREADS, Option_e::TOKEN_FILTER, Option_e::NOT_ONLY_ALLOWED, Option_e::PSEUDO_SHARDING };
+			Option_e::THREADS, Option_e::TOKEN_FILTER, Option_e::NOT_ONLY_ALLOWED, Option_e::PSEUDO_SHARDING,
+			Option_e::SEARCH_AFTER, Option_e::EXACT_TOPK, Option_e::SAMPLE };
 
 	static Option_e dInsertOptions[] = { Option_e::TOKEN_FILTER_OPTIONS };
 
@@ -742,6 +748,31 @@ bool SqlParser_c::AddOption ( const SqlNode_t & tIdent, const SqlNode_t & tValue
 		m_pStmt->m_sStringParam = sVal;
 		break;
 
+	case Option_e::SEARCH_AFTER: //} else if ( sOpt=="search_after" )
+		if ( !sphParseSearchAfter ( ToStringUnescape ( tValue ).cstr(), m_pQuery->m_dSearchAfter, *m_pParseError ) )
+			return false;
+		break;
+
+	case Option_e::EXACT_TOPK: //} else if ( sOpt=="exact_topk" )
+		if ( !CheckInteger ( sOpt, sVal ) )
+			return false;
+
+		m_pQuery->m_bExactTopK = ( tValue.m_iValue!=0 );
+		break;
+
+	case Option_e::SAMPLE: //} else if ( sOpt=="sample" )
+		{
+			double fRate = strtod ( sVal.cstr(), nullptr );
+			if ( !( fRate>0.0 && fRate<=1.0 ) )
+			{
+				m_pParseError->SetSprintf ( "sample=%s is out of range (must be greater than 0 and at most 1)", sVal.cstr() );
+				return false;
+			}
+
+			m_pQuery->m_fSampleRate = (float)fRate;
+		}
+		break;
+
 	default: //} else
 		m_pParseError->SetSprintf ( "unknown option '%s' (or bad argument type)", sOpt.cstr() );
 		return false;
@@ -750,6 +781,24 @@ bool SqlParser_c::AddOption ( const SqlNode_t & tIdent, const SqlNode_t & tValue
 }
 
 
+/// only the options that are shares take fractions; the rest would silently truncate them
+bool SqlParser_c::AddFloatOption ( const SqlNode_t & tIdent, const SqlNode_t & tValue )
+{
+	CSphString sOpt, sVal;
+	ToString ( sOpt, tIdent ).ToLower();
+	ToString ( sVal, tValue );
+
+	auto eOpt = ParseOption ( sOpt );
+	if ( CheckOption ( eOpt ) && eOpt!=Option_e::SAMPLE )
+	{
+		m_pParseError->SetSprintf ( "%s value should be an integer: '%s'", sOpt.cstr(), sVal.cstr() );
+		return false;
+	}
+
+	return AddOption ( tIdent, tValue );
+}
+
+
 bool SqlParser_c::AddOption ( const SqlNode_t & tIdent, const SqlNode_t & tValue, const SqlNode_t & tArg )
 {
 	CSphString sOpt, sVal;
@@ -16,6 +16,7 @@
 #include "sphinxplugin.h"
 #include "sphinxqcache.h"
 #include "attribute.h"
+#include "secondaryindex.h"
 #include "mini_timer.h"
 
 #include <math.h>
@@ -279,6 +280,147 @@ const ExtDoc_t * ExtRowIdRange_c::FilterTail ( const ExtDoc_t * pDocStart )
 
 //////////////////////////////////////////////////////////////////////////
 
+/// intersects the tree with the rows that pass selective attribute filters (secondary indexes, columnar prefilters)
+/// rare rows drive the tree via HintRowID, so frequent keywords skip their doclists instead of decoding them
+class ExtRowIdIterator_c : public ExtNode_c
+{
+public:
+						ExtRowIdIterator_c ( ExtNode_i * pNode, RowidIterator_i * pIterator, bool bOrdered );
+						~ExtRowIdIterator_c() { SafeDelete(m_pNode); }
+
+	const ExtDoc_t *	GetDocsChunk() override;
+	const ExtHit_t *	GetHits ( const ExtDoc_t * pDocs ) final { return m_pNode->GetHits(pDocs); }
+	void				Reset ( const ISphQwordSetup & tSetup ) final;
+	void				HintRowID ( RowID_t tRowID ) final				{ m_pNode->HintRowID(tRowID); }
+	int					GetQwords ( ExtQwordsHash_t & hQwords ) final	{ return m_pNode->GetQwords(hQwords); }
+	void				SetQwordsIDF ( const ExtQwordsHash_t & hQwords ) final { m_pNode->SetQwordsIDF(hQwords); }
+	void				GetTerms ( const ExtQwordsHash_t & hQwords, CSphVector<TermPos_t> & dTermDupes ) const final { m_pNode->GetTerms ( hQwords, dTermDupes ); }
+	bool				GotHitless() final								{ return m_pNode->GotHitless(); }
+	uint64_t			GetWordID() const final							{ return m_pNode->GetWordID(); }
+
+protected:
+	void				CollectHits ( const ExtDoc_t * pDocs ) final	{ assert ( 0 && "ExtRowIdIterator_c doesn't collect hits" ); }
+
+private:
+	ExtNode_i *						m_pNode = nullptr;
+	CSphScopedPtr<RowidIterator_i>	m_pIterator;
+	bool							m_bOrdered = false;
+	CSphVector<RowID_t>				m_dCollected;	///< rows of an unordered iterator, sorted
+	RowIdBlock_t					m_dRowIDs;		///< current rows; a block of an ordered iterator or all the collected ones
+	int								m_iRowID = 0;	///< next filtered row to look for
+
+	bool				HaveRowID();
+	void				SkipTo ( RowID_t tRowID );
+	void				CollectRowIDs();
+};
+
+
+ExtRowIdIterator_c::ExtRowIdIterator_c ( ExtNode_i * pNode, RowidIterator_i * pIterator, bool bOrdered )
+	: m_pNode ( pNode )
+	, m_pIterator ( pIterator )
+	, m_bOrdered ( bOrdered )
+{
+	assert ( pNode && pIterator );
+	if ( !m_bOrdered )
+		CollectRowIDs();
+}
+
+
+void ExtRowIdIterator_c::CollectRowIDs()
+{
+	// docid lookups return rows in docid order (and maybe duplicates), but doclists can't go back
+	RowIdBlock_t dRowIdBlock;
+	while ( m_pIterator->GetNextRowIdBlock(dRowIdBlock) )
+		for ( auto tRowID : dRowIdBlock )
+			m_dCollected.Add(tRowID);
+
+	m_dCollected.Uniq();
+	m_dRowIDs = m_dCollected;
+	m_pIterator.Reset();
+}
+
+
+bool ExtRowIdIterator_c::HaveRowID()
+{
+	if ( m_iRowID<m_dRowIDs.GetLength() )
+		return true;
+
+	if ( !m_pIterator )
+		return false;
+
+	// the block stays valid until the next call to the iterator
+	RowIdBlock_t dRowIdBlock;
+	while ( m_pIterator->GetNextRowIdBlock(dRowIdBlock) )
+		if ( !dRowIdBlock.IsEmpty() )
+		{
+			m_dRowIDs = dRowIdBlock;
+			m_iRowID = 0;
+			return true;
+		}
+
+	m_pIterator.Reset();
+	m_dRowIDs = RowIdBlock_t();
+	m_iRowID = 0;
+	return false;
+}
+
+
+void ExtRowIdIterator_c::SkipTo ( RowID_t tRowID )
+{
+	while ( HaveRowID() && m_dRowIDs[m_iRowID]<tRowID )
+	{
+		// the whole block is behind the doc; let the iterator skip the rest too
+		if ( m_pIterator && m_dRowIDs.Last()<tRowID )
+		{
+			m_iRowID = m_dRowIDs.GetLength();
+			m_pIterator->HintRowID(tRowID);
+			continue;
+		}
+
+		m_iRowID++;
+	}
+}
+
+
+const ExtDoc_t * ExtRowIdIterator_c::GetDocsChunk()
+{
+	// docs of a chunk are returned at once, so that the tree could still provide hits for them
+	int iDoc = 0;
+	while ( !iDoc && HaveRowID() )
+	{
+		m_pNode->HintRowID ( m_dRowIDs[m_iRowID] );
+		const ExtDoc_t * pDoc = m_pNode->GetDocsChunk();
+		if ( !pDoc )
+			break;
+
+		for ( ; HasDocs(pDoc); pDoc++ )
+		{
+			SkipTo ( pDoc->m_tRowID );
+			if ( !HaveRowID() )
+				break;
+
+			if ( m_dRowIDs[m_iRowID]==pDoc->m_tRowID )
+			{
+				m_dDocs[iDoc++] = *pDoc;
+				m_iRowID++;
+			}
+		}
+	}
+
+	return ReturnDocsChunk ( iDoc, "rowid-iterator" );
+}
+
+
+void ExtRowIdIterator_c::Reset ( const ISphQwordSetup & tSetup )
+{
+	m_pNode->Reset(tSetup);
+
+	// same as ExtRowIdRange_c, the original root is restored by the ranker
+	m_pNode = nullptr;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
 /// single keyword streamer
 template<bool USE_BM25>
 class ExtTerm_T : public ExtNode_c, ISphNoncopyable
@@ -479,6 +621,7 @@ public:
 
 	const ExtDoc_t *	GetDocsChunk() override;
 	void				CollectHits ( const ExtDoc_t * pDocs ) override;
+	int					GetDocsCount() override { return Min ( m_pLeft->GetDocsCount(), m_pRight->GetDocsCount() ); }
 	void				DebugDump ( int iLevel ) override;
 };
 
@@ -498,6 +641,7 @@ public:
 	void				GetTerms ( const ExtQwordsHash_t & hQwords, CSphVector<TermPos_t> & dTermDupes ) const override;
 	uint64_t			GetWordID () const override;
 	bool				GotHitless () override { return false; }
+	int					GetDocsCount () override { return m_dNodes.GetLength() ? m_dNodes[0].m_pQword->m_iDocs : 0; }
 	void				HintRowID ( RowID_t tRowID ) override;
 	void				SetCollectHits() override;
 	void				DebugDump ( int iLevel ) override;
@@ -508,6 +652,8 @@ private:
 		ISphQword *		m_pQword {nullptr};
 		RowID_t			m_tRowID {INVALID_ROWID};
 		bool			m_bHitsOver {false};
+		const CSphBitvec * m_pDocBitmap {nullptr};	///< set for frequent terms; probed instead of advancing the doclist
+		bool			m_bProbeOnly {false};		///< doclist is never decoded, so qword fields and tf are not about the current doc
 
 		float			m_fIDF {0.0f};
 		WORD			m_uNodepos {0};
@@ -557,6 +703,7 @@ private:
 
 	bool							m_bFirstChunk {true};
 	bool							m_bCollectHits {false};
+	bool							m_bRowidsOnly {false};
 	CSphVector<NodeInfo_t>			m_dNodes;
 	CSphVector<StoredMultiHit_t>	m_dStoredHits;
 	int								m_iNodesSet {0};
@@ -570,6 +717,7 @@ private:
 	CSphQueue<HitWithQpos_t, HitWithQpos_t > m_tQueue;
 
 	bool				AdvanceQwords();
+	void				SetupDocBitmaps();
 	RowID_t				Advance ( int iNode );
 	RowID_t				Advance ( int iNode, RowID_t tRowID );
 	bool				FitsFields ( const NodeInfo_t & tNode ) const;
@@ -2898,6 +3046,7 @@ ExtMultiAnd_T<USE_BM25,TEST_FIELDS>::ExtMultiAnd_T ( const VecTraits_T<XQNode_t*
 	m_dNodes.Sort ( SelectivitySorter_t() );
 	m_iNodesSet = m_dNodes.GetLength();
 
+	m_bRowidsOnly = tSetup.m_bRowidsOnly && !USE_BM25 && !TEST_FIELDS;
 	m_pWarning = tSetup.m_pWarning;
 	m_iMaxTimer = tSetup.m_iMaxTimer;
 	m_pStats = tSetup.m_pStats;
@@ -2918,7 +3067,8 @@ inline DWORD ExtMultiAnd_T<USE_BM25,TEST_FIELDS>::GetDocFieldsMask() const
 {
 	DWORD uMask = 0;
 	for ( const auto & i : m_dNodes )
-		uMask |= i.m_pQword->m_dQwordFields.GetMask32() & i.m_dQueriedFields.GetMask32();
+		if ( !i.m_bProbeOnly )
+			uMask |= i.m_pQword->m_dQwordFields.GetMask32() & i.m_dQueriedFields.GetMask32();
 
 	return uMask;
 }
@@ -2968,6 +3118,23 @@ inline RowID_t ExtMultiAnd_T<USE_BM25,TEST_FIELDS>::Advance ( int iNode, RowID_t
 }
 
 
+template <bool USE_BM25,bool TEST_FIELDS>
+void ExtMultiAnd_T<USE_BM25,TEST_FIELDS>::SetupDocBitmaps()
+{
+	// the first (rarest) node drives the iteration; others might be probed by bitmaps
+	// only rowids are left to ranker=none, so there its bitmap terms are not advanced at all
+	bool bProbeOnly = m_bRowidsOnly && !m_bCollectHits;
+	assert ( !bProbeOnly || ( !USE_BM25 && !TEST_FIELDS ) );
+
+	for ( int i=1; i < m_dNodes.GetLength(); i++ )
+	{
+		NodeInfo_t & tNode = m_dNodes[i];
+		tNode.m_pDocBitmap = tNode.m_pQword->GetDocBitmap();
+		tNode.m_bProbeOnly = bProbeOnly && tNode.m_pDocBitmap;
+	}
+}
+
+
 template <bool USE_BM25,bool TEST_FIELDS>
 inline bool ExtMultiAnd_T<USE_BM25,TEST_FIELDS>::AdvanceQwords()
 {
@@ -2977,7 +3144,27 @@ inline bool ExtMultiAnd_T<USE_BM25,TEST_FIELDS>::AdvanceQwords()
 		NodeInfo_t & tCurNode = m_dNodes[i];
 		if ( tCurNode.m_tRowID==tMaxRowID )
 			continue;
-		
+
+		if ( tCurNode.m_pDocBitmap )
+		{
+			if ( !tCurNode.m_pDocBitmap->BitGet ( tMaxRowID ) )
+			{
+				if ( Advance(0)==INVALID_ROWID )
+					return false;
+
+				tMaxRowID = m_dNodes[0].m_tRowID;
+				i = 0;
+				continue;
+			}
+
+			// no hits, fields or tf required from this term; the bit is all we need
+			if ( tCurNode.m_bProbeOnly )
+			{
+				tCurNode.m_tRowID = tMaxRowID;
+				continue;
+			}
+		}
+
 		Advance ( i, tMaxRowID );
 		
 		if ( tCurNode.m_tRowID==INVALID_ROWID )
@@ -3029,6 +3216,7 @@ const ExtDoc_t * ExtMultiAnd_T<USE_BM25,TEST_FIELDS>::GetDocsChunk()
 		if ( m_iNodesSet!=m_dNodes.GetLength() || !m_dNodes[0].m_pQword->m_iDocs )
 			return nullptr;
 
+		SetupDocBitmaps();
 		Advance(0);
 		m_bFirstChunk = false;
 	}
@@ -3340,6 +3528,8 @@ void ExtMultiAnd_T<USE_BM25,TEST_FIELDS>::Reset ( const ISphQwordSetup & tSetup
 	{
 		i.m_tRowID = INVALID_ROWID;
 		i.m_bHitsOver = false;
+		i.m_pDocBitmap = nullptr;
+		i.m_bProbeOnly = false;
 		i.m_pQword->Reset ();
 		// need to track active nodes for every segment
 		// however AND requires all nodes that is why can use fast reject
@@ -3447,6 +3637,9 @@ void ExtMultiAnd_T<USE_BM25,TEST_FIELDS>::HintRowID ( RowID_t tRowID )
 		if ( m_bFirstChunk && m_iNodesSet!=m_dNodes.GetLength() )
 			return;
 
+		if ( m_bFirstChunk )
+			SetupDocBitmaps();
+
 		Advance ( 0, tRowID );
 		m_bFirstChunk = false;
 	}
@@ -3456,6 +3649,8 @@ void ExtMultiAnd_T<USE_BM25,TEST_FIELDS>::HintRowID ( RowID_t tRowID )
 template <bool USE_BM25,bool TEST_FIELDS>
 void ExtMultiAnd_T<USE_BM25,TEST_FIELDS>::SetCollectHits()
 {
+	// bitmap probing mode is chosen on the first chunk
+	assert ( m_bFirstChunk );
 	m_bCollectHits = true;
 }
 
@@ -6001,6 +6196,11 @@ ExtNode_i * CreateRowIdFilterNode ( ExtNode_i * pNode, const RowIdBoundaries_t &
 	return new ExtRowIdRange_c ( pNode, tBoundaries );
 }
 
+ExtNode_i * CreateRowIdIteratorNode ( ExtNode_i * pNode, RowidIterator_i * pIterator, bool bOrdered )
+{
+	return new ExtRowIdIterator_c ( pNode, pIterator, bOrdered );
+}
+
 /// Immediately interrupt current operation
 void sphInterruptNow()
 {
@@ -92,6 +92,18 @@ public:
 struct RowIdBoundaries_t;
 ExtNode_i * CreateRowIdFilterNode ( ExtNode_i * pNode, const RowIdBoundaries_t & tBoundaries );
 
+class RowidIterator_i;
+ExtNode_i * CreateRowIdIteratorNode ( ExtNode_i * pNode, RowidIterator_i * pIterator, bool bOrdered );
+
+/// rows of selective attribute filters, offered to the ranker to drive the full-text tree
+struct RowIdIteratorSetup_t
+{
+	RowidIterator_i *	m_pIterator = nullptr;	///< passed to the tree if accepted
+	int64_t				m_iRsetEstimate = 0;	///< expected rows that pass the filters
+	int64_t				m_iTotalDocs = 0;
+	bool				m_bOrdered = false;		///< iterator returns rows in rowid order, so they can be fetched block by block
+};
+
 class NodeCacheContainer_c;
 
 /// intra-batch node cache
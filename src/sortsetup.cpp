@@ -35,6 +35,42 @@ bool CSphMatchComparatorState::UsesBitfields() const
 	return false;
 }
 
+
+template <typename T>
+static FORCE_INLINE int CmpCursorValues ( T tValue, T tCursor )
+{
+	return tValue<tCursor ? -1 : ( tValue>tCursor ? 1 : 0 );
+}
+
+
+bool CSphMatchComparatorState::FollowsCursor ( const CSphMatch & tMatch ) const
+{
+	assert ( m_pAfter );
+	const SearchAfter_t & tAfter = *m_pAfter;
+	for ( int i = 0; i<tAfter.m_iKeys; i++ )
+	{
+		int iCmp = 0;
+		switch ( m_eKeypart[i] )
+		{
+		case SPH_KEYPART_WEIGHT:	iCmp = CmpCursorValues ( (SphAttr_t)tMatch.m_iWeight, tAfter.m_dInts[i] ); break;
+		case SPH_KEYPART_INT:		iCmp = CmpCursorValues ( tMatch.GetAttr ( m_tLocator[i] ), tAfter.m_dInts[i] ); break;
+		case SPH_KEYPART_FLOAT:		iCmp = CmpCursorValues ( tMatch.GetAttrFloat ( m_tLocator[i] ), tAfter.m_dFloats[i] ); break;
+		case SPH_KEYPART_STRINGPTR:
+			assert ( m_fnStrCmp );
+			iCmp = m_fnStrCmp ( { (const BYTE *)tMatch.GetAttr ( m_tLocator[i] ), 0 }, { tAfter.m_dStrings[i].Begin(), 0 }, true );
+			break;
+		default:					break; // other keyparts can't be used in a cursor
+		}
+
+		// desc order means that smaller values come after the cursor
+		if ( iCmp )
+			return ( ( m_uAttrDesc>>i ) & 1 ) ? iCmp<0 : iCmp>0;
+	}
+
+	// equal to the cursor on all keys means the match was already returned
+	return false;
+}
+
 //////////////////////////////////////////////////////////////////////////
 
 class SortClauseTokenizer_c
@@ -455,6 +491,153 @@ bool SortStateSetup_c::Setup ( CSphString & sError )
 
 //////////////////////////////////////////////////////////////////////////
 
+bool sphParseSearchAfter ( const char * szCursor, StrVec_t & dKeys, CSphString & sError )
+{
+	dKeys.Reset();
+	const char * p = szCursor;
+	while ( p && sphIsSpace(*p) )
+		++p;
+
+	if ( !p || !*p )
+		return true;
+
+	while ( true )
+	{
+		while ( sphIsSpace(*p) )
+			++p;
+
+		CSphString & sKey = dKeys.Add();
+		if ( *p=='"' )
+		{
+			StringBuilder_c sValue;
+			++p;
+			while ( true )
+			{
+				if ( !*p )
+				{
+					sError.SetSprintf ( "search_after: unterminated quoted value at %d", dKeys.GetLength() );
+					return false;
+				}
+
+				if ( *p=='"' )
+				{
+					if ( p[1]!='"' )
+						break;
+					++p;
+				}
+
+				sValue.AppendRawChunk ( { p, 1 } );
+				++p;
+			}
+
+			++p;
+			while ( sphIsSpace(*p) )
+				++p;
+
+			if ( *p && *p!=',' )
+			{
+				sError.SetSprintf ( "search_after: unexpected '%c' after quoted value %d", *p, dKeys.GetLength() );
+				return false;
+			}
+
+			sKey = sValue.cstr();
+		} else
+		{
+			const char * szStart = p;
+			while ( *p && *p!=',' )
+				++p;
+
+			sKey.SetBinary ( szStart, int ( p-szStart ) );
+			sKey.Trim();
+		}
+
+		if ( !*p )
+			return true;
+
+		++p; // comma
+	}
+}
+
+
+CSphString sphFormatSearchAfter ( const StrVec_t & dKeys )
+{
+	StringBuilder_c sCursor ( "," );
+	for ( const auto & sKey : dKeys )
+	{
+		const char * szKey = sKey.cstr();
+		int iLen = sKey.Length();
+		bool bQuote = !iLen || ( strpbrk ( szKey, ",\"" ) || sphIsSpace ( szKey[0] ) || sphIsSpace ( szKey[iLen-1] ) );
+		if ( !bQuote )
+		{
+			sCursor << sKey;
+			continue;
+		}
+
+		StringBuilder_c sQuoted;
+		sQuoted.AppendRawChunk ( { "\"", 1 } );
+		for ( const char * p = szKey; *p; ++p )
+		{
+			if ( *p=='"' )
+				sQuoted.AppendRawChunk ( { "\"", 1 } );
+			sQuoted.AppendRawChunk ( { p, 1 } );
+		}
+		sQuoted.AppendRawChunk ( { "\"", 1 } );
+		sCursor << sQuoted.cstr();
+	}
+
+	return sCursor.cstr();
+}
+
+
+bool sphSetupSearchAfterFilter ( const CSphQuery & tQuery, const ISphSchema & tSchema, CSphFilterSettings & tFilter )
+{
+	if ( tQuery.m_dSearchAfter.IsEmpty() || tQuery.m_eSort!=SPH_SORT_EXTENDED || !tQuery.m_sGroupBy.IsEmpty() )
+		return false;
+
+	SortClauseTokenizer_c tTok ( tQuery.m_sSortBy.cstr() );
+	const char * szAttr = tTok.GetToken();
+	const char * szOrder = tTok.GetToken();
+	if ( !szAttr || !szOrder )
+		return false;
+
+	// expressions are computed after filtering, so only plain attributes are eligible
+	const CSphColumnInfo * pAttr = tSchema.GetAttr ( szAttr );
+	if ( !pAttr || ( pAttr->m_pExpr && !pAttr->IsColumnarExpr() ) )
+		return false;
+
+	const char * szValue = tQuery.m_dSearchAfter[0].cstr();
+	char * szEnd = nullptr;
+	switch ( pAttr->m_eAttrType )
+	{
+	case SPH_ATTR_INTEGER:
+	case SPH_ATTR_BIGINT:
+	case SPH_ATTR_TIMESTAMP:
+	case SPH_ATTR_BOOL:
+		tFilter.m_eType = SPH_FILTER_RANGE;
+		tFilter.m_iMinValue = tFilter.m_iMaxValue = strtoll ( szValue, &szEnd, 10 );
+		break;
+
+	case SPH_ATTR_FLOAT:
+		tFilter.m_eType = SPH_FILTER_FLOATRANGE;
+		tFilter.m_fMinValue = tFilter.m_fMaxValue = (float)strtod ( szValue, &szEnd );
+		break;
+
+	default:
+		return false;
+	}
+
+	if ( !szEnd || szEnd==szValue || *szEnd )
+		return false;
+
+	// keep the rows equal to the cursor on the leading key; the sorter resolves them by the rest of the keys
+	bool bDesc = !strcmp ( szOrder, "desc" );
+	tFilter.m_sAttrName = pAttr->m_sName;
+	tFilter.m_bOpenLeft = bDesc;
+	tFilter.m_bOpenRight = !bDesc;
+	return true;
+}
+
+
 ESortClauseParseResult sphParseSortClause ( const CSphQuery & tQuery, const char * szClause, const ISphSchema & tSchema, ESphSortFunc & eFunc, CSphMatchComparatorState & tState,
 	CSphVector<ExtraSortExpr_t> & dExtraExprs, bool bComputeItems, CSphString & sError )
 {
@@ -16,10 +16,21 @@
 #include "match.h"
 #include "sphinx.h"
 
+/// keyset pagination cursor, ie. leading sort key values of the last row of the previous page
+struct SearchAfter_t
+{
+	static const int	MAX_KEYS = 5;
+
+	int					m_iKeys = 0;				///< how many leading sort keys the cursor covers
+	SphAttr_t			m_dInts[MAX_KEYS] {};		///< int and weight keys
+	float				m_dFloats[MAX_KEYS] {};		///< float keys
+	CSphVector<BYTE>	m_dStrings[MAX_KEYS];		///< string keys, packed as data ptr attrs
+};
+
 /// match comparator state
 struct CSphMatchComparatorState
 {
-	static const int	MAX_ATTRS = 5;
+	static const int	MAX_ATTRS = SearchAfter_t::MAX_KEYS;
 
 	ESphSortKeyPart		m_eKeypart[MAX_ATTRS];		///< sort-by key part type
 	CSphAttrLocator		m_tLocator[MAX_ATTRS];		///< sort-by attr locator
@@ -29,6 +40,9 @@ struct CSphMatchComparatorState
 	DWORD				m_iNow = 0;					///< timestamp (for timesegments sorting mode)
 	SphStringCmp_fn		m_fnStrCmp = nullptr;		///< string comparator
 	CSphBitvec			m_dRemapped { CSphMatchComparatorState::MAX_ATTRS };
+	CSphAttrLocator		m_tKeyLocator[MAX_ATTRS];	///< precomputed string sort key locator (valid if i-th bit of m_uKeyedAttrs is set)
+	DWORD				m_uKeyedAttrs = 0;			///< string keyparts that have precomputed sort keys
+	SharedPtr_t<SearchAfter_t> m_pAfter;			///< keyset pagination cursor (if any)
 
 						CSphMatchComparatorState();
 
@@ -36,6 +50,10 @@ struct CSphMatchComparatorState
 	bool				UsesBitfields() const;
 	void				FixupLocators ( const ISphSchema * pOldSchema, const ISphSchema * pNewSchema, bool bRemapKeyparts );
 
+	/// whether the match sorts strictly after the search_after cursor (always true if there's no cursor)
+	FORCE_INLINE bool	IsAfterCursor ( const CSphMatch & tMatch ) const { return !m_pAfter || FollowsCursor ( tMatch ); }
+	bool				FollowsCursor ( const CSphMatch & tMatch ) const;
+
 	FORCE_INLINE int CmpStrings ( const CSphMatch & a, const CSphMatch & b, int iAttr ) const
 	{
 		assert ( iAttr>=0 && iAttr<MAX_ATTRS );
@@ -53,6 +71,15 @@ struct CSphMatchComparatorState
 			return 1;
 		}
 
+		// keys hold (biased) collated prefixes; only equal keys need a full compare
+		if ( m_uKeyedAttrs & ( 1<<iAttr ) )
+		{
+			SphAttr_t uKeyA = a.GetAttr ( m_tKeyLocator[iAttr] );
+			SphAttr_t uKeyB = b.GetAttr ( m_tKeyLocator[iAttr] );
+			if ( uKeyA!=uKeyB )
+				return uKeyA<uKeyB ? -1 : 1;
+		}
+
 		return m_fnStrCmp ( {aa, 0}, {bb, 0}, m_eKeypart[iAttr]==SPH_KEYPART_STRINGPTR );
 	}
 };
@@ -65,6 +92,17 @@ struct ExtraSortExpr_t
 	ESphAttr					m_eType = SPH_ATTR_NONE;
 };
 
+/// builds an inclusive range filter on the leading sort key from the search_after cursor of the query
+/// returns false if the leading key is not a plain numeric attribute (the sorter still applies the full cursor)
+bool sphSetupSearchAfterFilter ( const CSphQuery & tQuery, const ISphSchema & tSchema, CSphFilterSettings & tFilter );
+
+/// splits search_after cursor into key values; values are comma-separated, and might be enclosed in double quotes
+/// (then they may contain commas, and a double quote is written twice); spaces around values are trimmed
+bool sphParseSearchAfter ( const char * szCursor, StrVec_t & dKeys, CSphString & sError );
+
+/// inverse of sphParseSearchAfter(); quotes only the values that need it
+CSphString sphFormatSearchAfter ( const StrVec_t & dKeys );
+
 /// parses sort clause, using a given schema
 /// fills eFunc and tState and optionally sError, returns result code
 ESortClauseParseResult sphParseSortClause ( const CSphQuery & tQuery, const char * sClause, const ISphSchema & tSchema, ESphSortFunc & eFunc, CSphMatchComparatorState & tState,
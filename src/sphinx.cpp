@@ -46,6 +46,8 @@
 #include "chunksearchctx.h"
 #include "lrucache.h"
 #include "indexfiles.h"
+#include "termfilter.h"
+#include "rollup.h"
 
 #include <errno.h>
 #include <ctype.h>
@@ -342,6 +344,60 @@ void ShutdownSkipCache()
 
 /////////////////////////////////////////////////////////////////////
 
+struct DocBitmapCacheUtil_t
+{
+	static DWORD GetHash ( SkipCacheKey_t tKey )		{ return SkipCacheUtil_t::GetHash(tKey); }
+	static DWORD GetSize ( CSphBitvec * pValue )		{ return pValue ? pValue->GetByteSize() : 0; }
+	static void Reset ( CSphBitvec * & pValue )		{ SafeDelete(pValue); }
+};
+
+/// doclists of frequent terms decoded into bitmaps; doclists of disk indexes never change, so bitmaps live until index unload
+class DocBitmapCache_c : public LRUCache_T<SkipCacheKey_t, CSphBitvec*, DocBitmapCacheUtil_t>
+{
+	using BASE = LRUCache_T<SkipCacheKey_t, CSphBitvec*, DocBitmapCacheUtil_t>;
+	using BASE::BASE;
+
+public:
+	void						DeleteAll ( int64_t iIndexId ) { BASE::Delete ( [iIndexId]( const SkipCacheKey_t & tKey ){ return tKey.m_iIndexId==iIndexId; } ); }
+
+	// same limit as Add() applies, checked before decoding the doclist
+	bool						Fits ( RowID_t iRows ) const { return ( iRows/8 + sizeof(LinkedEntry_t) ) <= uint64_t ( m_iCacheSize/64 ); }
+
+	static void					Init ( int64_t iCacheSize );
+	static void					Done()	{ SafeDelete(m_pDocBitmapCache); }
+	static DocBitmapCache_c *	Get()	{ return m_pDocBitmapCache; }
+
+private:
+	static DocBitmapCache_c *	m_pDocBitmapCache;
+};
+
+DocBitmapCache_c * DocBitmapCache_c::m_pDocBitmapCache = nullptr;
+
+
+void DocBitmapCache_c::Init ( int64_t iCacheSize )
+{
+	assert ( !m_pDocBitmapCache );
+	if ( iCacheSize > 0 )
+		m_pDocBitmapCache = new DocBitmapCache_c(iCacheSize);
+}
+
+
+void InitDocBitmapCache ( int64_t iCacheSize )
+{
+	DocBitmapCache_c::Init(iCacheSize);
+}
+
+
+void ShutdownDocBitmapCache()
+{
+	DocBitmapCache_c::Done();
+}
+
+// terms present in at least that part of the rows get bitmaps
+static const int DOC_BITMAP_DENSITY = 16;
+
+/////////////////////////////////////////////////////////////////////
+
 /// everything required to setup search term
 class DiskIndexQwordSetup_c : public ISphQwordSetup
 {
@@ -394,6 +450,8 @@ public:
 			m_pSkipData = nullptr;
 			m_bSkipFromCache = false;
 		}
+
+		ReleaseDocBitmap();
 	}
 
 	void Reset () final
@@ -403,6 +461,37 @@ public:
 		if ( m_rdHitlist )
 			m_rdHitlist->Reset ();
 		ResetDecoderState();
+		ReleaseDocBitmap();
+	}
+
+	const CSphBitvec * GetDocBitmap() final
+	{
+		if ( m_pDocBitmap )
+			return m_pDocBitmap;
+
+		DocBitmapCache_c * pCache = DocBitmapCache_c::Get();
+		if ( !pCache || !m_rdDoclist || int64_t(m_iDocs)*DOC_BITMAP_DENSITY < m_iRowsCount || !pCache->Fits ( m_iRowsCount ) )
+			return nullptr;
+
+		m_bDocBitmapFromCache = pCache->Find ( { m_iIndexId, m_uWordID }, m_pDocBitmap );
+		if ( m_bDocBitmapFromCache )
+			return m_pDocBitmap;
+
+		// decode the whole doclist once, then rewind it for the regular iteration
+		m_pDocBitmap = new CSphBitvec ( m_iRowsCount );
+		for ( RowID_t tRowID = GetNextDoc().m_tRowID; tRowID!=INVALID_ROWID; tRowID = GetNextDoc().m_tRowID )
+			m_pDocBitmap->BitSet ( tRowID );
+
+		int iDocs = m_iDocs;
+		int iHits = m_iHits;
+		ResetDecoderState();
+		m_iDocs = iDocs;
+		m_iHits = iHits;
+		m_iSkipListBlock = -1;
+		m_rdDoclist->SeekTo ( m_iDoclistOffset, m_iDoclistHint );
+
+		m_bDocBitmapFromCache = pCache->Add ( { m_iIndexId, m_uWordID }, m_pDocBitmap );
+		return m_pDocBitmap;
 	}
 
 	void GetHitlistEntry ()
@@ -592,7 +681,20 @@ private:
 	}
 
 private:
-	int64_t m_iIndexId = 0;
+	int64_t			m_iIndexId = 0;
+	CSphBitvec *	m_pDocBitmap = nullptr;
+	bool			m_bDocBitmapFromCache = false;
+
+	void ReleaseDocBitmap()
+	{
+		if ( m_bDocBitmapFromCache )
+			DocBitmapCache_c::Get()->Release ( { m_iIndexId, m_uWordID } );
+		else
+			SafeDelete ( m_pDocBitmap );
+
+		m_pDocBitmap = nullptr;
+		m_bDocBitmapFromCache = false;
+	}
 };
 
 
@@ -1305,6 +1407,8 @@ public:
 
 	bool				MultiQuery ( CSphQueryResult & pResult, const CSphQuery & tQuery, const VecTraits_T<ISphMatchSorter *> & dSorters, const CSphMultiQueryArgs & tArgs ) const final;
 	bool				MultiQueryEx ( int iQueries, const CSphQuery * pQueries, CSphQueryResult* pResults, ISphMatchSorter ** ppSorters, const CSphMultiQueryArgs & tArgs ) const final;
+	void				PushRollup ( const RollupQuery_t & tRollup, ISphMatchSorter * pSorter, CSphMatch & tMatch, CSphQueryResult & tResult ) const final;
+	void				ResetRollups() const final { m_tRollups.Reset(); }
 	bool				GetKeywords ( CSphVector <CSphKeywordInfo> & dKeywords, const char * szQuery, const GetKeywordsSettings_t & tSettings, CSphString * pError ) const final;
 	template <class Qword> bool		DoGetKeywords ( CSphVector <CSphKeywordInfo> & dKeywords, const char * szQuery, const GetKeywordsSettings_t & tSettings, bool bFillOnly, CSphString * pError ) const;
 	bool 				FillKeywords ( CSphVector <CSphKeywordInfo> & dKeywords ) const final;
@@ -1320,12 +1424,15 @@ public:
 	static bool			DeleteField ( const CSphIndex_VLN * pIndex, CSphHitBuilder * pHitBuilder, CSphString & sError, CSphSourceStats & tStat, int iKillField );
 
 	int					UpdateAttributes ( AttrUpdateInc_t & tUpd, bool & bCritical, CSphString & sError, CSphString & sWarning ) final;
+	RowIdsToUpdate_t	CollectRowsToUpdate ( const AttrUpdateInc_t & tUpd, const VecTraits_T<int> & dSorted ) const final;
+	int					UpdateCollectedRows ( const RowIdsToUpdate_t & dRowIDs, AttrUpdateInc_t & tUpd, bool & bCritical, CSphString & sError, CSphString & sWarning ) final;
 	void				UpdateAttributesOffline ( VecTraits_T<PostponedUpdate_t> & dUpdates, IndexSegment_c * /*pSeg*/) final;
 
 	// the only txn we can replay is 'update attributes', but it is processed by dedicated branch in binlog, so we have nothing to do here.
 	Binlog::CheckTnxResult_t ReplayTxn (Binlog::Blop_e, CSphReader&, CSphString & , Binlog::CheckTxn_fn&&) final { return {}; }
 	bool				SaveAttributes ( CSphString & sError ) const final;
 	DWORD				GetAttributeStatus () const final;
+	int					RefreshStaleMinMax ( int iMaxBlocks ) final;
 
 	bool				AddRemoveAttribute ( bool bAddAttr, const AttrAddRemoveCtx_t & tCtx, CSphString & sError ) final;
 	bool				AddRemoveField ( bool bAdd, const CSphString & sFieldName, DWORD uFieldFlags, CSphString & sError ) final;
@@ -1352,6 +1459,7 @@ public:
 	bool				PreallocDocidLookup();
 	bool				PreallocKilllist();
 	bool				PreallocHistograms ( StrVec_t & dWarnings );
+	void				PreallocTermFilter ( StrVec_t & dWarnings );
 	bool				PreallocDocstore();
 	bool				PreallocColumnar();
 	bool				PreallocSkiplist();
@@ -1367,7 +1475,7 @@ public:
 	bool				CopyExternalFiles ( int iPostfix, StrVec_t & dCopied ) final;
 	void				CollectFiles ( StrVec_t & dFiles, StrVec_t & dExt ) const final;
 
-	bool				CheckEarlyReject ( const CSphVector<CSphFilterSettings> & dFilters, ISphFilter * pFilter, ESphCollation eCollation, const ISphSchema & tSchema ) const;
+	bool				CheckEarlyReject ( const CSphQuery & tQuery, const CSphVector<CSphFilterSettings> & dFilters, ISphFilter * pFilter, const ISphSchema & tSchema ) const;
 
 private:
 	static const int			MIN_WRITE_BUFFER		= 262144;	///< min write buffer size
@@ -1387,6 +1495,13 @@ private:
 	DWORD *						m_pDocinfoIndex;		///< docinfo "index", to accelerate filtering during full-scan (2x rows for each block, and 2x rows for the whole index, 1+m_uDocinfoIndex entries)
 	int64_t						m_iMinMaxIndex;			///< stored min/max cache offset (counted in DWORDs)
 
+	CSphMutex					m_tStaleMinMaxLock;		///< serializes min/max widening by updates and kills vs. refreshing
+	CSphBitvec					m_tStaleMinMax GUARDED_BY ( m_tStaleMinMaxLock );	///< blocks whose min/max might be wider than their alive rows
+	bool						m_bStaleIndexMinMax GUARDED_BY ( m_tStaleMinMaxLock ) = false;	///< whole index range was not yet tightened after refreshing blocks
+	std::atomic<int64_t>		m_iStaleMinMaxBlocks { 0 };
+
+	mutable RollupCache_c		m_tRollups;				///< per-group aggregates of the rollups declared by the owning RT index
+
 	// !COMMIT slow setup data
 	CSphMappedBuffer<DWORD>		m_tAttr;
 	CSphMappedBuffer<BYTE>		m_tBlobAttrs;
@@ -1408,13 +1523,14 @@ private:
 	bool						m_bDebugCheck;
 	bool						m_bCheckIdDups = false;
 
-	mutable DWORD				m_uAttrsStatus = 0;
+	mutable std::atomic<DWORD>	m_uAttrsStatus { 0 };	///< or-ed by updates, kills and background min/max refresh
 
 	DataReaderFactoryPtr_c		m_pDoclistFile;			///< doclist file
 	DataReaderFactoryPtr_c		m_pHitlistFile;			///< hitlist file
 	DataReaderFactoryPtr_c		m_pColumnarFile;			///< columnar file
 
 	HistogramContainer_c *		m_pHistograms {nullptr};
+	CSphScopedPtr<TermFilter_c>	m_pTermFilter {nullptr};	///< checked before dictionary lookups; absent in older indexes
 
 private:
 	CSphString					GetIndexFileName ( ESphExt eExt, bool bTemp=false ) const;
@@ -1455,7 +1571,11 @@ private:
 	RowsToUpdate_t				Update_PrepareGatheredRowPtrs ( RowsToUpdate_t & dWRows, const VecTraits_T<DocID_t> & dDocids );
 	bool						Update_WriteBlobRow ( UpdateContext_t & tCtx, CSphRowitem * pDocinfo, const BYTE * pBlob, int iLength, int nBlobAttrs, const CSphAttrLocator & tBlobRowLoc, bool & bCritical, CSphString & sError ) override;
 	void						Update_MinMax ( const RowsToUpdate_t& dRows, const UpdateContext_t & tCtx );
+	void						MarkStaleMinMax ( int64_t iBlock ) REQUIRES ( m_tStaleMinMaxLock );
+	bool						RefreshBlockMinMax ( int64_t iBlock );
+	void						RefreshIndexMinMax ();
 	bool						DoUpdateAttributes ( const RowsToUpdate_t& dRows, UpdateContext_t& tCtx, bool & bCritical, CSphString & sError );
+	int							Update_Rows ( RowsToUpdateData_t & dRows, UpdateContext_t & tCtx, bool & bCritical, CSphString & sError, CSphString & sWarning );
 
 	bool						Alter_IsMinMax ( const CSphRowitem * pDocinfo, int iStride ) const override;
 	bool						AddRemoveColumnarAttr ( bool bAddAttr, const CSphString & sAttrName, ESphAttr eAttrType, const ISphSchema & tOldSchema, const ISphSchema & tNewSchema, CSphString & sError );
@@ -1479,7 +1599,8 @@ private:
 	RowidIterator_i *			CreateColumnarAnalyzerOrPrefilter ( const CSphVector<CSphFilterSettings> & dFilters, CSphVector<CSphFilterSettings> & dModifiedFilters, bool & bFiltersChanged, const CSphVector<FilterTreeItem_t> & dFilterTree, const ISphFilter * pFilter, ESphCollation eCollation, const ISphSchema & tSchema, CSphString & sWarning ) const;
 
 	bool						SplitQuery ( CSphQueryResult & tResult, const CSphQuery & tQuery, const VecTraits_T<ISphMatchSorter *> & dAllSorters, const CSphMultiQueryArgs & tArgs, int64_t tmMaxTimer ) const;
-	RowidIterator_i *			SpawnIterators ( const CSphQuery & tQuery, CSphVector<CSphFilterSettings> & dModifiedFilters, CSphQueryContext & tCtx, CreateFilterContext_t & tFlx, const ISphSchema & tMaxSorterSchema, CSphQueryResultMeta & tMeta ) const;
+	RowidIterator_i *			SpawnIterators ( const CSphQuery & tQuery, CSphVector<CSphFilterSettings> & dModifiedFilters, CSphQueryContext & tCtx, CreateFilterContext_t & tFlx, const ISphSchema & tMaxSorterSchema, CSphQueryResultMeta & tMeta, bool * pOrdered=nullptr ) const;
+	bool						SetupFulltextIterator ( const CSphQuery & tQuery, CSphVector<CSphFilterSettings> & dModifiedFilters, CSphQueryContext & tCtx, CreateFilterContext_t & tFlx, const ISphSchema & tMaxSorterSchema, CSphQueryResultMeta & tMeta, ISphRanker & tRanker ) const;
 };
 
 class AttrMerger_c
@@ -2437,6 +2558,10 @@ CSphIndex::~CSphIndex ()
 	SkipCache_c * pSkipCache = SkipCache_c::Get();
 	if ( pSkipCache )
 		pSkipCache->DeleteAll(m_iIndexId);
+
+	DocBitmapCache_c * pDocBitmapCache = DocBitmapCache_c::Get();
+	if ( pDocBitmapCache )
+		pDocBitmapCache->DeleteAll(m_iIndexId);
 }
 
 
@@ -2669,18 +2794,29 @@ RowsToUpdateData_t CSphIndex_VLN::Update_CollectRowPtrs ( const UpdateContext_t
 		return dRowsToUpdate;
 
 	dSorted.Sort ( Lesser ( [&dDocids] ( int a, int b ) { return dDocids[a]<dDocids[b]; } ) );
-	DocIdIndexReader_c tSortedReader ( dSorted, dDocids );
-	LookupReaderIterator_c tLookupReader ( m_tDocidLookup.GetReadPtr() );
-	Intersect ( tLookupReader, tSortedReader, [&dRowsToUpdate, this] ( RowID_t tRowID, int iIdx )
+	for ( const auto & tRow : CollectRowsToUpdate ( tCtx.m_tUpd, dSorted ) )
 	{
 		auto& dUpd = dRowsToUpdate.Add();
-		dUpd.m_pRow = GetDocinfoByRowID ( tRowID );
-		dUpd.m_iIdx = iIdx;
+		dUpd.m_pRow = GetDocinfoByRowID ( tRow.m_tRowID );
+		dUpd.m_iIdx = tRow.m_iIdx;
 		assert ( dUpd.m_pRow );
-	} );
+	}
+
 	return dRowsToUpdate;
 }
 
+RowIdsToUpdate_t CSphIndex_VLN::CollectRowsToUpdate ( const AttrUpdateInc_t & tUpd, const VecTraits_T<int> & dSorted ) const
+{
+	RowIdsToUpdate_t dRowIDs;
+	if ( !m_iDocinfo || dSorted.IsEmpty() )
+		return dRowIDs;
+
+	DocIdIndexReader_c tSortedReader ( dSorted, tUpd.m_pUpdate->m_dDocids );
+	LookupReaderIterator_c tLookupReader ( m_tDocidLookup.GetReadPtr() );
+	Intersect ( tLookupReader, tSortedReader, [&dRowIDs] ( RowID_t tRowID, int iIdx ) { dRowIDs.Add ( { tRowID, iIdx } ); } );
+	return dRowIDs;
+}
+
 // We fill docinfo ptr for actual rows, and move out non-actual (the ones which doesn't point to existing document)
 // note, it actually changes (rearranges) rows!
 RowsToUpdate_t CSphIndex_VLN::Update_PrepareGatheredRowPtrs ( RowsToUpdate_t & dWRows, const VecTraits_T<DocID_t>& dDocids )
@@ -2779,6 +2915,8 @@ void CSphIndex_VLN::Update_MinMax ( const RowsToUpdate_t& dRows, const UpdateCon
 {
 	int iRowStride = tCtx.m_tSchema.GetRowSize();
 
+	// ranges are only widened here, so the old value of a row might still hold the block's bound; refresh does the tightening
+	ScopedMutex_t tLock ( m_tStaleMinMaxLock );
 	for ( const auto & tRow : dRows )
 	{
 		int64_t iBlock = int64_t ( tRow.m_pRow-tCtx.m_pAttrPool ) / ( iRowStride*DOCINFO_INDEX_FREQ );
@@ -2796,6 +2934,7 @@ void CSphIndex_VLN::Update_MinMax ( const RowsToUpdate_t& dRows, const UpdateCon
 			if ( tLoc.IsBlobAttr() )
 				continue;
 
+			MarkStaleMinMax ( iBlock );
 			SphAttr_t uValue = sphGetRowAttr ( tRow.m_pRow, tLoc );
 
 			// update block and index ranges
@@ -2825,6 +2964,98 @@ void CSphIndex_VLN::Update_MinMax ( const RowsToUpdate_t& dRows, const UpdateCon
 	}
 }
 
+void CSphIndex_VLN::MarkStaleMinMax ( int64_t iBlock )
+{
+	if ( !m_tStaleMinMax.GetBits() )
+		m_tStaleMinMax.Init ( (int)m_iDocinfoIndex );
+
+	if ( m_tStaleMinMax.BitGet ( (int)iBlock ) )
+		return;
+
+	m_tStaleMinMax.BitSet ( (int)iBlock );
+	m_iStaleMinMaxBlocks.fetch_add ( 1, std::memory_order_relaxed );
+}
+
+// returns false if the block has no alive rows (its min/max is left as is then)
+bool CSphIndex_VLN::RefreshBlockMinMax ( int64_t iBlock )
+{
+	int iStride = m_tSchema.GetRowSize();
+	auto tStart = RowID_t ( iBlock*DOCINFO_INDEX_FREQ );
+	auto tEnd = RowID_t ( Min ( ( iBlock+1 )*DOCINFO_INDEX_FREQ, m_iDocinfo ) );
+
+	AttrIndexBuilder_c tMinMax ( m_tSchema );
+	bool bAlive = false;
+	const CSphRowitem * pRow = m_tAttr.GetWritePtr() + int64_t(tStart)*iStride;
+	for ( RowID_t tRowID = tStart; tRowID<tEnd; ++tRowID, pRow += iStride )
+		if ( !m_tDeadRowMap.IsSet ( tRowID ) )
+		{
+			tMinMax.Collect ( pRow );
+			bAlive = true;
+		}
+
+	if ( !bAlive )
+		return false;
+
+	tMinMax.FinishCollect();
+
+	// first entry is the block itself, the second one is the (same) total
+	memcpy ( m_pDocinfoIndex + iBlock*iStride*2, tMinMax.GetCollected().Begin(), sizeof(DWORD)*iStride*2 );
+	return true;
+}
+
+// whole index range is a union of the block ranges
+void CSphIndex_VLN::RefreshIndexMinMax()
+{
+	int iStride = m_tSchema.GetRowSize();
+	AttrIndexBuilder_c tMinMax ( m_tSchema );
+	const DWORD * pEntry = m_pDocinfoIndex;
+	for ( int64_t i=0; i<m_iDocinfoIndex*2; ++i, pEntry += iStride )
+		tMinMax.Collect ( pEntry );
+
+	tMinMax.FinishCollect();
+
+	const auto & dCollected = tMinMax.GetCollected();
+	memcpy ( m_pDocinfoIndex + m_iDocinfoIndex*iStride*2, dCollected.End() - iStride*2, sizeof(DWORD)*iStride*2 );
+}
+
+int CSphIndex_VLN::RefreshStaleMinMax ( int iMaxBlocks )
+{
+	// attributes are being saved or merged; refresh later
+	if ( m_bAttrsBusy.load ( std::memory_order_acquire ) )
+		return 0;
+
+	ScopedMutex_t tLock ( m_tStaleMinMaxLock );
+	if ( !m_iStaleMinMaxBlocks.load ( std::memory_order_relaxed ) && !m_bStaleIndexMinMax )
+		return 0;
+
+	int iRefreshed = 0;
+	bool bTightened = false;
+	for ( int iBlock = 0; iBlock<m_tStaleMinMax.GetBits() && iRefreshed<iMaxBlocks; ++iBlock )
+	{
+		if ( !m_tStaleMinMax.BitGet ( iBlock ) )
+			continue;
+
+		bTightened |= RefreshBlockMinMax ( iBlock );
+		m_tStaleMinMax.BitClear ( iBlock );
+		++iRefreshed;
+	}
+
+	m_iStaleMinMaxBlocks.fetch_sub ( iRefreshed, std::memory_order_relaxed );
+	m_bStaleIndexMinMax |= bTightened;
+
+	// total range is only worth a pass over all the blocks once the stale ones are done
+	if ( m_bStaleIndexMinMax && iRefreshed<iMaxBlocks )
+	{
+		RefreshIndexMinMax();
+		m_bStaleIndexMinMax = false;
+	}
+
+	if ( bTightened )
+		m_uAttrsStatus.fetch_or ( IndexUpdateHelper_c::ATTRS_UPDATED, std::memory_order_relaxed );
+
+	return iRefreshed;
+}
+
 bool CSphIndex_VLN::DoUpdateAttributes ( const RowsToUpdate_t& dRows, UpdateContext_t& tCtx, bool& bCritical, CSphString& sError )
 {
 	if ( dRows.IsEmpty() )
@@ -2857,6 +3088,10 @@ bool CSphIndex_VLN::DoUpdateAttributes ( const RowsToUpdate_t& dRows, UpdateCont
 
 	Update_Plain ( dRows, tCtx );
 	Update_MinMax ( dRows, tCtx );
+
+	// after the rows are written, so that no state gets built over half-updated rows and survives
+	m_tRollups.Invalidate ( *tCtx.m_tUpd.m_pUpdate );
+	BumpDataVersion();
 	return true;
 }
 
@@ -2869,9 +3104,40 @@ int CSphIndex_VLN::UpdateAttributes ( AttrUpdateInc_t & tUpd, bool & bCritical,
 		return 0;
 
 	UpdateContext_t tCtx ( tUpd, m_tSchema );
+	auto dRowsToUpdate = Update_CollectRowPtrs ( tCtx );
+	return Update_Rows ( dRowsToUpdate, tCtx, bCritical, sError, sWarning );
+}
+
+int CSphIndex_VLN::UpdateCollectedRows ( const RowIdsToUpdate_t & dRowIDs, AttrUpdateInc_t & tUpd, bool & bCritical, CSphString & sError, CSphString & sWarning )
+{
+	if ( !m_iDocinfo )
+		return 0;
+
+	// rows were collected in advance; the ones updated since then in fresher segments or chunks are not ours anymore
+	// attributes might have been remapped since then too (ALTER), so row pointers are only taken now, under the lock
+	RowsToUpdateData_t dRows;
+	dRows.Reserve ( dRowIDs.GetLength() );
+	for ( const auto & tRow : dRowIDs )
+		if ( !tUpd.m_dUpdated.BitGet ( tRow.m_iIdx ) )
+		{
+			auto & dUpd = dRows.Add();
+			dUpd.m_pRow = GetDocinfoByRowID ( tRow.m_tRowID );
+			dUpd.m_iIdx = tRow.m_iIdx;
+			assert ( dUpd.m_pRow );
+		}
+
+	if ( dRows.IsEmpty() )
+		return 0;
+
+	UpdateContext_t tCtx ( tUpd, m_tSchema );
+	return Update_Rows ( dRows, tCtx, bCritical, sError, sWarning );
+}
+
+int CSphIndex_VLN::Update_Rows ( RowsToUpdateData_t & dRowsToUpdate, UpdateContext_t & tCtx, bool & bCritical, CSphString & sError, CSphString & sWarning )
+{
+	auto & tUpd = tCtx.m_tUpd;
 	int iUpdated = tUpd.m_iAffected;
 
-	auto dRowsToUpdate = Update_CollectRowPtrs ( tCtx );
 	if ( !DoUpdateAttributes ( dRowsToUpdate, tCtx, bCritical, sError ))
 		return -1;
 
@@ -2883,7 +3149,7 @@ int CSphIndex_VLN::UpdateAttributes ( AttrUpdateInc_t & tUpd, bool & bCritical,
 	if ( tCtx.m_uUpdateMask && m_bBinlog )
 		Binlog::CommitUpdateAttributes ( &m_iTID, m_sIndexName.cstr(), *tUpd.m_pUpdate );
 
-	m_uAttrsStatus |= tCtx.m_uUpdateMask; // FIXME! add lock/atomic?
+	m_uAttrsStatus.fetch_or ( tCtx.m_uUpdateMask, std::memory_order_relaxed );
 
 	if ( m_bAttrsBusy.load ( std::memory_order_acquire ) )
 	{
@@ -2913,7 +3179,7 @@ void CSphIndex_VLN::UpdateAttributesOffline ( VecTraits_T<PostponedUpdate_t> & d
 			sphWarning ("UpdateAttributesOffline: %s", sError.cstr() );
 			break;
 		}
-		m_uAttrsStatus |= tCtx.m_uUpdateMask; // FIXME! add lock/atomic?
+		m_uAttrsStatus.fetch_or ( tCtx.m_uUpdateMask, std::memory_order_relaxed );
 	}
 }
 
@@ -2958,11 +3224,10 @@ bool CSphIndex_VLN::JuggleFile ( ESphExt eExt, CSphString & sError, bool bNeedSr
 
 bool CSphIndex_VLN::SaveAttributes ( CSphString & sError ) const
 {
-	if ( !m_uAttrsStatus || !m_iDocinfo )
+	DWORD uAttrStatus = m_uAttrsStatus.load ( std::memory_order_relaxed );
+	if ( !uAttrStatus || !m_iDocinfo )
 		return true;
 
-	DWORD uAttrStatus = m_uAttrsStatus;
-
 	sphLogDebugvv ( "index '%s' attrs (%u) saving...", m_sIndexName.cstr(), uAttrStatus );
 
 	if ( uAttrStatus & IndexUpdateHelper_c::ATTRS_UPDATED )
@@ -2989,17 +3254,17 @@ bool CSphIndex_VLN::SaveAttributes ( CSphString & sError ) const
 	if ( m_bBinlog )
 		Binlog::NotifyIndexFlush ( m_sIndexName.cstr(), m_iTID, false );
 
-	if ( m_uAttrsStatus==uAttrStatus )
-		m_uAttrsStatus = 0;
+	// only clear if nobody marked new changes while we were saving
+	m_uAttrsStatus.compare_exchange_strong ( uAttrStatus, 0, std::memory_order_relaxed );
 
-	sphLogDebugvv ( "index '%s' attrs (%u) saved", m_sIndexName.cstr(), m_uAttrsStatus );
+	sphLogDebugvv ( "index '%s' attrs (%u) saved", m_sIndexName.cstr(), m_uAttrsStatus.load ( std::memory_order_relaxed ) );
 
 	return true;
 }
 
 DWORD CSphIndex_VLN::GetAttributeStatus () const
 {
-	return m_uAttrsStatus;
+	return m_uAttrsStatus.load ( std::memory_order_relaxed );
 }
 
 
@@ -3172,6 +3437,7 @@ bool CSphIndex_VLN::AddRemoveAttribute ( bool bAddAttr, const AttrAddRemoveCtx_t
 	bool bHaveNonColumnar = tNewSchema.HasNonColumnarAttrs();
 
 	m_tAttr.Reset();
+	m_tRollups.Reset();
 
 	if ( bColumnar )
 	{
@@ -3240,6 +3506,7 @@ bool CSphIndex_VLN::AddRemoveAttribute ( bool bAddAttr, const AttrAddRemoveCtx_t
 	if ( bBlobsModified )
 		PrereadMapping ( m_sIndexName.cstr(), "blob attributes", IsMlock ( m_tMutableSettings.m_tFileAccess.m_eBlob ), IsOndisk ( m_tMutableSettings.m_tFileAccess.m_eBlob ), m_tBlobAttrs );
 
+	BumpDataVersion();
 	return true;
 }
 
@@ -3366,20 +3633,69 @@ void CSphIndex_VLN::KillExistingDocids ( CSphIndex * pTarget )
 }
 
 
+// dead row map which also collects the blocks of just killed rows, and retracts the rows from the rollups
+class KilledBlocksCollector_c
+{
+public:
+	KilledBlocksCollector_c ( DeadRowMap_Disk_c & tDeadRowMap, CSphVector<int64_t> & dBlocks, RollupCache_c & tRollups, const CSphRowitem * pRows, int iStride )
+		: m_tDeadRowMap ( tDeadRowMap )
+		, m_dBlocks ( dBlocks )
+		, m_tRollups ( tRollups )
+		, m_pRows ( pRows )
+		, m_iStride ( iStride )
+	{}
+
+	// rollups are locked by the caller
+	bool Set ( RowID_t tRowID ) NO_THREAD_SAFETY_ANALYSIS
+	{
+		if ( !m_tDeadRowMap.Set ( tRowID ) )
+			return false;
+
+		m_tRollups.Retract ( m_pRows + (int64_t)tRowID*m_iStride );
+
+		int64_t iBlock = tRowID / DOCINFO_INDEX_FREQ;
+		if ( m_dBlocks.IsEmpty() || m_dBlocks.Last()!=iBlock )
+			m_dBlocks.Add ( iBlock );
+
+		return true;
+	}
+
+private:
+	DeadRowMap_Disk_c &		m_tDeadRowMap;
+	CSphVector<int64_t> &	m_dBlocks;
+	RollupCache_c &			m_tRollups;
+	const CSphRowitem *		m_pRows;
+	int						m_iStride;
+};
+
+
 int CSphIndex_VLN::KillMulti ( const VecTraits_T<DocID_t> & dKlist )
 {
 	LookupReaderIterator_c tTargetReader ( m_tDocidLookup.GetWritePtr() );
 	DocidListReader_c tKillerReader ( dKlist );
 
+	CSphVector<int64_t> dKilledBlocks;
+	KilledBlocksCollector_c tDeadRowMap ( m_tDeadRowMap, dKilledBlocks, m_tRollups, m_tAttr.GetWritePtr(), m_tSchema.GetRowSize() );
+
 	int iTotalKilled;
+	ScopedMutex_t tRollupLock ( m_tRollups.m_tLock );
 	if ( !m_pKillHook )
-		iTotalKilled = KillByLookup ( tTargetReader, tKillerReader, m_tDeadRowMap, [] ( DocID_t ) {} );
+		iTotalKilled = KillByLookup ( tTargetReader, tKillerReader, tDeadRowMap, [] ( DocID_t ) {} );
 	else
-		iTotalKilled = KillByLookup ( tTargetReader, tKillerReader, m_tDeadRowMap,
+		iTotalKilled = KillByLookup ( tTargetReader, tKillerReader, tDeadRowMap,
 				[this] ( DocID_t tDoc ) { m_pKillHook->Kill ( tDoc ); } );
 
 	if ( iTotalKilled )
-		m_uAttrsStatus |= IndexUpdateHelper_c::ATTRS_ROWMAP_UPDATED;
+	{
+		m_uAttrsStatus.fetch_or ( IndexUpdateHelper_c::ATTRS_ROWMAP_UPDATED, std::memory_order_relaxed );
+
+		// killed rows still hold the bounds of their blocks
+		ScopedMutex_t tLock ( m_tStaleMinMaxLock );
+		for ( auto iBlock : dKilledBlocks )
+			MarkStaleMinMax ( iBlock );
+
+		BumpDataVersion();
+	}
 
 	return iTotalKilled;
 }
@@ -3475,6 +3791,7 @@ public:
 	bool			IsError () const { return ( m_pDict->DictIsError() || m_wrDoclist.IsError() || m_wrHitlist.IsError() ); }
 	void			HitblockBegin () { m_pDict->HitblockBegin(); }
 	bool			IsWordDict () const { return m_pDict->GetSettings().m_bWordDict; }
+	bool			SaveTermFilter ( const CSphString & sFile, const CSphString & sDictFile, int64_t iDictCheckpointsOffset ) const { return m_tTermFilter.Save ( sFile, sDictFile, iDictCheckpointsOffset, *m_pLastError ); }
 
 private:
 	void	DoclistBeginEntry ( RowID_t tDocid );
@@ -3502,6 +3819,7 @@ private:
 	DWORD						m_uLastDocHits = 0;			///< doclist entry
 
 	CSphDictEntry				m_tWord;				///< dictionary entry
+	TermFilterBuilder_c			m_tTermFilter;			///< keys of all the emitted dictionary entries
 
 	ESphHitFormat				m_eHitFormat;
 	ESphHitless					m_eHitless;
@@ -3767,6 +4085,11 @@ void CSphHitBuilder::cidxHit ( CSphAggregateHit * pHit )
 			m_tWord.m_iDoclistLength = m_wrDoclist.GetPos() - m_tWord.m_iDoclistOffset;
 			m_pDict->DictEntry ( m_tWord );
 
+			if ( IsWordDict() )
+				m_tTermFilter.Add ( TermFilterKey ( m_tWord.m_sKeyword, (int) strlen ( (const char*)m_tWord.m_sKeyword ) ) );
+			else
+				m_tTermFilter.Add ( m_tWord.m_uWordID );
+
 			// reset trackers
 			m_tWord.m_iDocs = 0;
 			m_tWord.m_iHits = 0;
@@ -6208,6 +6531,9 @@ int CSphIndex_VLN::Build ( const CSphVector<CSphSource*> & dSources, int iMemory
 	if ( !tHitBuilder.cidxDone ( iMemoryLimit, m_tSettings.m_iMinInfixLen, m_pTokenizer->GetMaxCodepointLength(), &tBuildHeader ) )
 		return 0;
 
+	if ( !tHitBuilder.SaveTermFilter ( GetIndexFileName(SPH_EXT_SPIF), GetIndexFileName(SPH_EXT_SPI), tBuildHeader.m_iDictCheckpointsOffset ) )
+		return 0;
+
 	dRelocationBuffer.Reset(0);
 
 	tBuildHeader.m_iDocinfo = m_tStats.m_iTotalDocuments;
@@ -7148,6 +7474,9 @@ bool CSphIndex_VLN::DoMerge ( const CSphIndex_VLN * pDstIndex, const CSphIndex_V
 	if ( !tHitBuilder.cidxDone ( iHitBufferSize, iMinInfixLen, pSettings->m_pTokenizer->GetMaxCodepointLength(), &tBuildHeader ) )
 		return false;
 
+	if ( !tHitBuilder.SaveTermFilter ( pDstIndex->GetIndexFileName ( SPH_EXT_SPIF, true ), pDstIndex->GetIndexFileName ( SPH_EXT_SPI, true ), tBuildHeader.m_iDictCheckpointsOffset ) )
+		return false;
+
 	CSphString sHeaderName = pDstIndex->GetIndexFileName ( SPH_EXT_SPH, true );
 
 	WriteHeader_t tWriteHeader;
@@ -7312,6 +7641,9 @@ bool CSphIndex_VLN::DeleteFieldFromDict ( int iFieldId, BuildHeader_t & tBuildHe
 	if ( !tHitBuilder.cidxDone ( iHitBufferSize, iMinInfixLen, m_pTokenizer->GetMaxCodepointLength(), &tBuildHeader ) )
 		return false;
 
+	if ( !tHitBuilder.SaveTermFilter ( GetIndexFileName ( SPH_EXT_SPIF, true ), GetIndexFileName ( SPH_EXT_SPI, true ), tBuildHeader.m_iDictCheckpointsOffset ) )
+		return false;
+
 	/// as index is w-locked, we can also detach doclist/hitlist/dictionary and juggle them.
 	tTmpDict.Close();
 	tNewDict.Close();
@@ -7326,6 +7658,10 @@ bool CSphIndex_VLN::DeleteFieldFromDict ( int iFieldId, BuildHeader_t & tBuildHe
 	m_tWordlist.m_dCheckpoints.Reset ( m_tWordlist.m_iDictCheckpoints );
 	if ( !PreallocWordlist() )					return false;
 
+	StrVec_t dWarnings;
+	if ( !JuggleFile ( SPH_EXT_SPIF, sError, false, false ) )	return false;
+	PreallocTermFilter(dWarnings);
+
 	m_tSkiplists.Reset ();
 	if ( !JuggleFile ( SPH_EXT_SPE, sError ) )	return false;
 	if ( !PreallocSkiplist() )					return false;
@@ -7419,6 +7755,7 @@ bool CSphIndex_VLN::AddRemoveField ( bool bAddField, const CSphString & sFieldNa
 	if ( !IndexBuildDone ( tBuildHeader, tWriteHeader, sHeaderName, sError ) ) 	return false;
 	if ( !JuggleFile ( SPH_EXT_SPH, sError ) )		return false;
 
+	BumpDataVersion();
 	return true;
 }
 
@@ -7605,6 +7942,8 @@ void CSphMatchComparatorState::FixupLocators ( const ISphSchema * pOldSchema, co
 	for ( int i = 0; i < CSphMatchComparatorState::MAX_ATTRS; ++i )
 	{
 		sphFixupLocator ( m_tLocator[i], pOldSchema, pNewSchema );
+		if ( m_uKeyedAttrs & ( 1<<i ) )
+			sphFixupLocator ( m_tKeyLocator[i], pOldSchema, pNewSchema );
 
 		// update string keypart into str_ptr
 		if ( bRemapKeyparts && m_eKeypart[i]==SPH_KEYPART_STRING )
@@ -7618,6 +7957,10 @@ void CSphMatchComparatorState::FixupLocators ( const ISphSchema * pOldSchema, co
 				m_dAttrs[i] = pNewSchema->GetAttrIndex ( pOldSchema->GetAttr(iOldAttrId).m_sName.cstr() );
 		}
 	}
+
+	// remapped (standalone) matches might not carry the sort keys anymore
+	if ( bRemapKeyparts )
+		m_uKeyedAttrs = 0;
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -7700,11 +8043,19 @@ RowID_t CSphIndex_VLN::GetRowidByDocid ( DocID_t tDocID ) const
 int	CSphIndex_VLN::Kill ( DocID_t tDocID )
 {
 	// FIXME! docid might not be unique
-	if ( m_tDeadRowMap.Set ( GetRowidByDocid ( tDocID ) ) )
+	RowID_t tRowID = GetRowidByDocid ( tDocID );
+	ScopedMutex_t tRollupLock ( m_tRollups.m_tLock );
+	if ( m_tDeadRowMap.Set ( tRowID ) )
 	{
-		m_uAttrsStatus |= IndexUpdateHelper_c::ATTRS_ROWMAP_UPDATED;
+		m_tRollups.Retract ( GetDocinfoByRowID ( tRowID ) );
+		m_uAttrsStatus.fetch_or ( IndexUpdateHelper_c::ATTRS_ROWMAP_UPDATED, std::memory_order_relaxed );
+		{
+			ScopedMutex_t tLock ( m_tStaleMinMaxLock );
+			MarkStaleMinMax ( tRowID / DOCINFO_INDEX_FREQ );
+		}
 		if ( m_pKillHook )
 			m_pKillHook->Kill ( tDocID );
+		BumpDataVersion();
 		return 1;
 	}
 
@@ -8502,7 +8853,7 @@ static void UpdateSpawnedIterators ( bool bChanged, bool & bRecreateFilters, CSp
 }
 
 
-RowidIterator_i * CSphIndex_VLN::SpawnIterators ( const CSphQuery & tQuery, CSphVector<CSphFilterSettings> & dModifiedFilters, CSphQueryContext & tCtx, CreateFilterContext_t & tFlx, const ISphSchema & tMaxSorterSchema, CSphQueryResultMeta & tMeta ) const
+RowidIterator_i * CSphIndex_VLN::SpawnIterators ( const CSphQuery & tQuery, CSphVector<CSphFilterSettings> & dModifiedFilters, CSphQueryContext & tCtx, CreateFilterContext_t & tFlx, const ISphSchema & tMaxSorterSchema, CSphQueryResultMeta & tMeta, bool * pOrdered ) const
 {
 	CSphVector<CSphFilterSettings> dOriginalFilters;
 	const CSphVector<CSphFilterSettings> * pOriginalFilters = &tQuery.m_dFilters;
@@ -8514,6 +8865,11 @@ RowidIterator_i * CSphIndex_VLN::SpawnIterators ( const CSphQuery & tQuery, CSph
 	{
 		bool bChanged = false;
 		RowidIterator_i * pIterator = m_pHistograms ? CreateFilteredIterator ( *pOriginalFilters, dModifiedFilters, bChanged, tQuery.m_dFilterTree, tQuery.m_dIndexHints, *m_pHistograms, m_tDocidLookup.GetWritePtr(), RowID_t(m_iDocinfo) ) : nullptr;
+
+		// docid lookups return rows in docid order; columnar iterators go in rowid order
+		if ( pOrdered )
+			*pOrdered = !pIterator;
+
 		UpdateSpawnedIterators ( bChanged, bRecreateFilters, dOriginalFilters, dModifiedFilters, pOriginalFilters, dIterators, pIterator );
 	}
 
@@ -8642,7 +8998,7 @@ bool CSphIndex_VLN::MultiScan ( CSphQueryResult & tResult, const CSphQuery & tQu
 	if ( !tCtx.CreateFilters ( tFlx, tMeta.m_sError, tMeta.m_sWarning ) )
 		return false;
 
-	if ( CheckEarlyReject ( tQuery.m_dFilters, tCtx.m_pFilter, tQuery.m_eCollation, tMaxSorterSchema ) )
+	if ( CheckEarlyReject ( tQuery, tQuery.m_dFilters, tCtx.m_pFilter, tMaxSorterSchema ) )
 	{
 		tMeta.m_iQueryTime += (int)( ( sphMicroTimer()-tmQueryStart )/1000 );
 		tMeta.m_iCpuTime += sphTaskCpuTimer ()-tmCpuQueryStart;
@@ -8808,6 +9164,10 @@ bool DiskIndexQwordSetup_c::SetupWithWrd ( const DiskIndexQwordTraits_c& tWord,
 			return false;
 	}
 
+	// surely absent terms don't touch the dictionary at all
+	if ( pIndex->m_pTermFilter && !pIndex->m_pTermFilter->MayContain ( TermFilterKey ( (const BYTE *)sWord, iWordLen ) ) )
+		return false;
+
 	const CSphWordlistCheckpoint * pCheckpoint = pIndex->m_tWordlist.FindCheckpointWrd ( sWord, iWordLen, false );
 	if ( !pCheckpoint )
 		return false;
@@ -8838,6 +9198,9 @@ bool DiskIndexQwordSetup_c::SetupWithWrd ( const DiskIndexQwordTraits_c& tWord,
 bool DiskIndexQwordSetup_c::SetupWithCrc ( const DiskIndexQwordTraits_c& tWord, CSphDictEntry& tRes ) const
 {
 	auto * pIndex = (CSphIndex_VLN *)const_cast<CSphIndex *>(m_pIndex);
+	if ( pIndex->m_pTermFilter && !pIndex->m_pTermFilter->MayContain ( tWord.m_uWordID ) )
+		return false;
+
 	const CSphWordlistCheckpoint * pCheckpoint = pIndex->m_tWordlist.FindCheckpointCrc ( tWord.m_uWordID );
 	if ( !pCheckpoint )
 		return false;
@@ -8913,6 +9276,9 @@ bool DiskIndexQwordSetup_c::Setup ( ISphQword * pWord ) const
 		}
 
 		tWord.m_rdDoclist->SeekTo ( tRes.m_iDoclistOffset, tRes.m_iDoclistHint );
+		tWord.m_iDoclistOffset = tRes.m_iDoclistOffset;
+		tWord.m_iDoclistHint = tRes.m_iDoclistHint;
+		tWord.m_iRowsCount = m_iRowsCount;
 		tWord.SetHitReader ( m_pHitlist );
 	}
 
@@ -9007,6 +9373,10 @@ void CSphIndex_VLN::Dealloc ()
 	if ( pSkipCache )
 		pSkipCache->DeleteAll(m_iIndexId);
 
+	DocBitmapCache_c * pDocBitmapCache = DocBitmapCache_c::Get();
+	if ( pDocBitmapCache )
+		pDocBitmapCache->DeleteAll(m_iIndexId);
+
 	m_iIndexId = m_tIdGenerator.fetch_add ( 1, std::memory_order_relaxed );
 }
 
@@ -9642,6 +10012,8 @@ bool CSphIndex_VLN::PreallocWordlist()
 	if ( !m_tWordlist.Preread ( GetIndexFileName(SPH_EXT_SPI), bWordDict, m_tSettings.m_iSkiplistBlockSize, m_sLastError ) )
 		return false;
 
+	m_tWordlist.SetExpansionCacheId ( m_iIndexId );
+
 	if ( ( m_tWordlist.m_tBuf.GetLengthBytes()<=1 )!=( m_tWordlist.m_dCheckpoints.GetLength()==0 ) )
 		sphWarning ( "wordlist size mismatch (size=%zu, checkpoints=%d)", m_tWordlist.m_tBuf.GetLengthBytes(), m_tWordlist.m_dCheckpoints.GetLength() );
 
@@ -9730,6 +10102,25 @@ bool CSphIndex_VLN::PreallocHistograms ( StrVec_t & dWarnings )
 }
 
 
+void CSphIndex_VLN::PreallocTermFilter ( StrVec_t & dWarnings )
+{
+	m_pTermFilter.Reset();
+
+	CSphString sTermFilterFile = GetIndexFileName(SPH_EXT_SPIF);
+	if ( m_bDebugCheck || !sphIsReadable ( sTermFilterFile.cstr() ) )
+		return;
+
+	// the filter only saves lookups, so the index works without it just fine
+	CSphString sError;
+	m_pTermFilter = new TermFilter_c;
+	if ( !m_pTermFilter->Load ( sTermFilterFile, GetIndexFileName(SPH_EXT_SPI), m_tWordlist.m_iDictCheckpointsOffset, sError ) )
+	{
+		m_pTermFilter.Reset();
+		dWarnings.Add(sError);
+	}
+}
+
+
 bool CSphIndex_VLN::PreallocDocstore()
 {
 	if ( m_uVersion<57 )
@@ -9807,6 +10198,7 @@ bool CSphIndex_VLN::Prealloc ( bool bStripPath, FilenameBuilder_i * pFilenameBui
 	if ( !PreallocDocidLookup() )	return false;
 	if ( !PreallocKilllist() )		return false;
 	if ( !PreallocHistograms(dWarnings) ) return false;
+	PreallocTermFilter(dWarnings);
 	if ( !PreallocDocstore() )		return false;
 	if ( !PreallocColumnar() )		return false;
 	if ( !PreallocSkiplist() )		return false;
@@ -10258,16 +10650,38 @@ bool CSphIndex_VLN::FillKeywords ( CSphVector <CSphKeywordInfo> & dKeywords ) co
 
 bool CSphQueryContext::CreateFilters ( CreateFilterContext_t & tCtx, CSphString & sError, CSphString & sWarning )
 {
-	if ( !tCtx.m_pFilters || tCtx.m_pFilters->IsEmpty () )
-		return true;
-	if ( !sphCreateFilters ( tCtx, sError, sWarning ) )
-		return false;
+	if ( tCtx.m_pFilters && !tCtx.m_pFilters->IsEmpty () )
+	{
+		if ( !sphCreateFilters ( tCtx, sError, sWarning ) )
+			return false;
 
-	m_pFilter = tCtx.m_pFilter;
-	m_pWeightFilter = tCtx.m_pWeightFilter;
-	m_dUserVals.SwapData ( tCtx.m_dUserVals );
-	tCtx.m_pFilter = nullptr;
-	tCtx.m_pWeightFilter = nullptr;
+		m_pFilter = tCtx.m_pFilter;
+		m_pWeightFilter = tCtx.m_pWeightFilter;
+		m_dUserVals.SwapData ( tCtx.m_dUserVals );
+		tCtx.m_pFilter = nullptr;
+		tCtx.m_pWeightFilter = nullptr;
+	}
+
+	// search_after cursor also bounds the leading sort key, so that blocks entirely before it get rejected by min/max
+	CSphFilterSettings tAfter;
+	if ( tCtx.m_pSchema && sphSetupSearchAfterFilter ( m_tQuery, *tCtx.m_pSchema, tAfter ) )
+	{
+		CSphString sAfterError; // not fatal, sorters check the cursor anyway
+		ISphFilter * pAfter = sphCreateFilter ( tAfter, tCtx, sAfterError, sWarning );
+		if ( pAfter )
+			m_pFilter = sphJoinFilters ( m_pFilter, pAfter );
+	}
+
+	// sampling has no filter settings of its own, so it has to be rejoined every time the filters get recreated
+	// it goes first: the docid hash is cheaper than most filters, and dropped rows then skip the rest of them
+	if ( m_tQuery.m_fSampleRate<1.0f )
+	{
+		ISphFilter * pSample = sphCreateSampleFilter ( m_tQuery.m_fSampleRate, Max ( m_tQuery.m_iRandSeed, 0 ), tCtx, sError );
+		if ( !pSample )
+			return false;
+
+		m_pFilter = sphJoinFilters ( pSample, m_pFilter );
+	}
 
 	return true;
 }
@@ -11251,6 +11665,16 @@ bool CSphIndex_VLN::SplitQuery ( CSphQueryResult & tResult, const CSphQuery & tQ
 }
 
 /// one regular query vs many sorters (like facets, or similar for common-tree optimization)
+void CSphIndex_VLN::PushRollup ( const RollupQuery_t & tRollup, ISphMatchSorter * pSorter, CSphMatch & tMatch, CSphQueryResult & tResult ) const
+{
+	m_tRollups.Push ( tRollup, m_tAttr.GetWritePtr(), m_tSchema.GetRowSize(), (DWORD)m_iDocinfo, m_tDeadRowMap, pSorter, tMatch );
+
+	// the groups are represented by rows of this chunk
+	tResult.m_pBlobPool = m_tBlobAttrs.GetWritePtr();
+	tResult.m_pColumnar = m_pColumnar.Ptr();
+}
+
+
 bool CSphIndex_VLN::MultiQuery ( CSphQueryResult & tResult, const CSphQuery & tQuery, const VecTraits_T<ISphMatchSorter *> & dAllSorters, const CSphMultiQueryArgs & tArgs ) const
 {
 	auto & tMeta = *tResult.m_pMeta;
@@ -11518,8 +11942,19 @@ bool CSphIndex_VLN::MultiQueryEx ( int iQueries, const CSphQuery * pQueries, CSp
 }
 
 
-bool CSphIndex_VLN::CheckEarlyReject ( const CSphVector<CSphFilterSettings> & dFilters, ISphFilter * pFilter, ESphCollation eCollation, const ISphSchema & tSchema ) const
+bool CSphIndex_VLN::CheckEarlyReject ( const CSphQuery & tQuery, const CSphVector<CSphFilterSettings> & dQueryFilters, ISphFilter * pFilter, const ISphSchema & tSchema ) const
 {
+	// search_after bound is joined into pFilter, so it has to be accounted for in the columnar checks too
+	CSphVector<CSphFilterSettings> dFiltersWithAfter;
+	CSphFilterSettings tAfter;
+	if ( sphSetupSearchAfterFilter ( tQuery, tSchema, tAfter ) )
+	{
+		dFiltersWithAfter = dQueryFilters;
+		dFiltersWithAfter.Add ( tAfter );
+	}
+
+	const CSphVector<CSphFilterSettings> & dFilters = dFiltersWithAfter.IsEmpty() ? dQueryFilters : dFiltersWithAfter;
+	ESphCollation eCollation = tQuery.m_eCollation;
 	if ( !pFilter || dFilters.IsEmpty() )
 		return false;
 
@@ -11571,6 +12006,41 @@ bool CSphIndex_VLN::CheckEarlyReject ( const CSphVector<CSphFilterSettings> & dF
 }
 
 
+bool CSphIndex_VLN::SetupFulltextIterator ( const CSphQuery & tQuery, CSphVector<CSphFilterSettings> & dModifiedFilters, CSphQueryContext & tCtx, CreateFilterContext_t & tFlx, const ISphSchema & tMaxSorterSchema, CSphQueryResultMeta & tMeta, ISphRanker & tRanker ) const
+{
+	if ( tQuery.m_dFilters.IsEmpty() )
+		return false;
+
+	bool bOrdered = false;
+	CSphScopedPtr<RowidIterator_i> pIterator ( SpawnIterators ( tQuery, dModifiedFilters, tCtx, tFlx, tMaxSorterSchema, tMeta, &bOrdered ) );
+	if ( !pIterator )
+		return false;
+
+	// filters handled by the iterator are gone from the modified ones; the rows that pass all of them can't outnumber the most selective one
+	RowIdIteratorSetup_t tSetup;
+	tSetup.m_iTotalDocs = m_iDocinfo;
+	tSetup.m_iRsetEstimate = m_iDocinfo;
+	for ( const auto & tFilter : tQuery.m_dFilters )
+		if ( tFilter.m_sAttrName!="@rowid" && !dModifiedFilters.any_of ( [&tFilter]( const CSphFilterSettings & tLeft ){ return tLeft.m_sAttrName==tFilter.m_sAttrName; } ) )
+			tSetup.m_iRsetEstimate = Min ( tSetup.m_iRsetEstimate, EstimateFilterSelectivity ( tFilter, m_pHistograms ) );
+
+	tSetup.m_pIterator = pIterator.Ptr();
+	tSetup.m_bOrdered = bOrdered;
+	if ( tRanker.ExtraData ( EXTRA_SET_ROWID_ITERATOR, (void**)&tSetup ) )
+	{
+		pIterator.LeakPtr();
+		return true;
+	}
+
+	// not worth it; back to the full-text tree with every filter checked per match
+	dModifiedFilters.Resize(0);
+	SafeDelete ( tCtx.m_pFilter );
+	tFlx.m_pFilters = &tQuery.m_dFilters;
+	tCtx.CreateFilters ( tFlx, tMeta.m_sError, tMeta.m_sWarning );
+	return false;
+}
+
+
 static const CSphVector<CSphFilterSettings> * SetupRowIdBoundaries ( const CSphVector<CSphFilterSettings> & dFilters, CSphVector<CSphFilterSettings> & dModifiedFilters, RowID_t uTotalDocs, ISphRanker & tRanker )
 {
 	const CSphFilterSettings * pRowIdFilter = nullptr;
@@ -11723,12 +12193,9 @@ bool CSphIndex_VLN::ParsedMultiQuery ( const CSphQuery & tQuery, CSphQueryResult
 	if ( m_bIsEmpty )
 		return true;
 
-	CSphVector<CSphFilterSettings> dModifiedFilters;
-	const CSphVector<CSphFilterSettings> * pFilters = SetupRowIdBoundaries ( tQuery.m_dFilters, dModifiedFilters, RowID_t(m_iDocinfo), *pRanker );
-
 	// setup filters
  	CreateFilterContext_t tFlx;
-	tFlx.m_pFilters = pFilters;
+	tFlx.m_pFilters = &tQuery.m_dFilters;
 	tFlx.m_pFilterTree = &tQuery.m_dFilterTree;
 	tFlx.m_pSchema = &tMaxSorterSchema;
 	tFlx.m_pBlobPool = m_tBlobAttrs.GetWritePtr();
@@ -11740,7 +12207,22 @@ bool CSphIndex_VLN::ParsedMultiQuery ( const CSphQuery & tQuery, CSphQueryResult
 	if ( !tCtx.CreateFilters ( tFlx, tMeta.m_sError, tMeta.m_sWarning ) )
 		return false;
 
-	if ( CheckEarlyReject ( *pFilters, tCtx.m_pFilter, tQuery.m_eCollation, tMaxSorterSchema ) )
+	// we don't modify the original filters because iterators may use some data from them (to avoid copying)
+	CSphVector<CSphFilterSettings> dModifiedFilters;
+	const CSphVector<CSphFilterSettings> * pFilters = &dModifiedFilters;
+	if ( !SetupFulltextIterator ( tQuery, dModifiedFilters, tCtx, tFlx, tMaxSorterSchema, tMeta, *pRanker ) )
+	{
+		pFilters = SetupRowIdBoundaries ( tQuery.m_dFilters, dModifiedFilters, RowID_t(m_iDocinfo), *pRanker );
+		if ( pFilters!=&tQuery.m_dFilters )
+		{
+			SafeDelete ( tCtx.m_pFilter );
+			tFlx.m_pFilters = pFilters;
+			if ( !tCtx.CreateFilters ( tFlx, tMeta.m_sError, tMeta.m_sWarning ) )
+				return false;
+		}
+	}
+
+	if ( CheckEarlyReject ( tQuery, *pFilters, tCtx.m_pFilter, tMaxSorterSchema ) )
 	{
 		tMeta.m_iQueryTime += (int)( ( sphMicroTimer()-tmQueryStart )/1000 );
 		tMeta.m_iCpuTime += sphTaskCpuTimer ()-tmCpuQueryStart;
@@ -11941,6 +12423,7 @@ void CSphIndex_VLN::GetStatus ( CSphIndexStatus* pRes ) const
 			+m_tSkiplists.GetCoreSize ();
 
 	pRes->m_iDead = m_tDeadRowMap.GetNumDeads();
+	pRes->m_iStaleMinMaxBlocks = m_iStaleMinMaxBlocks.load ( std::memory_order_relaxed );
 
 	if ( m_pDoclistFile )
 	{
@@ -11959,6 +12442,8 @@ void CSphIndex_VLN::GetStatus ( CSphIndexStatus* pRes ) const
 	}
 
 	pRes->m_iRamUse = sizeof(CSphIndex_VLN) + m_dFieldLens.GetLengthBytes() + pRes->m_iMappedResident;
+	if ( m_pTermFilter )
+		pRes->m_iRamUse += m_pTermFilter->GetLengthBytes();
 	pRes->m_iDiskUse = 0;
 
 	CSphVector<IndexFileExt_t> dExts = sphGetExts();
@@ -12338,6 +12823,10 @@ void CSphIndex_VLN::CollectFiles ( StrVec_t & dFiles, StrVec_t & dExt ) const
 	CSphString sPath = GetIndexFileName ( SPH_EXT_SPK );
 	if ( sphIsReadable ( sPath ) )
 		dFiles.Add ( sPath );
+
+	sPath = GetIndexFileName ( SPH_EXT_SPIF );
+	if ( sphIsReadable ( sPath ) )
+		dFiles.Add ( sPath );
 }
 
 //////////////////////////////////////////////////////////////////////////
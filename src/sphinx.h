@@ -713,6 +713,8 @@ struct CSphQuery
 	ESphSortOrder	m_eSort = SPH_SORT_RELEVANCE;		///< sort mode
 	CSphString		m_sSortBy;			///< attribute to sort by
 	int64_t			m_iRandSeed = -1;	///< random seed for ORDER BY RAND(), -1 means do not set
+	float			m_fSampleRate = 1.0f;	///< share of documents to process; 1 means all of them, less gives approximate (scaled) results
+	StrVec_t		m_dSearchAfter;		///< keyset pagination cursor (sort key values of the last row on the previous page)
 	int				m_iMaxMatches = DEFAULT_MAX_MATCHES;	///< max matches to retrieve, default is 1000. more matches use more memory and CPU time to hold and sort them
 	bool			m_bExplicitMaxMatches = false; ///< did we specify the max_matches explicitly?
 
@@ -779,6 +781,9 @@ struct CSphQuery
 	int				m_iSQLSelectEnd = -1;	///< SQL parser helper
 
 	int				m_iGroupbyLimit = 1;	///< number of elems within group
+	bool			m_bExactTopK = false;	///< distributed group by count: fetch exact top groups from agents in threshold rounds
+	int64_t			m_iMinGroupCount = 0;	///< agent side: ship only groups counting at least that (set by master in the top groups rounds)
+	bool			m_bVersionProbe = false;	///< agent side: do not search, only report the version of the data (set by master to validate a cached result)
 
 	CSphVector<CSphQueryItem>	m_dItems;		///< parsed select-list
 	CSphVector<CSphQueryItem>	m_dRefItems;	///< select-list prior replacing by facet
@@ -833,6 +838,8 @@ public:
 
 	int						m_iMatches = 0;			///< total matches returned (upto MAX_MATCHES)
 	int64_t					m_iTotalMatches = 0;	///< total matches found (unlimited)
+	float					m_fSampleRate = 1.0f;	///< sample rate the totals and aggregates were scaled by
+	int64_t					m_iTotalMatchesError = 0;	///< standard error of the scaled total (sampled queries only)
 
 	CSphIOStats				m_tIOStats;				///< i/o stats for the query
 	int64_t					m_iAgentCpuTime = 0;	///< agent cpu time (for distributed searches)
@@ -1082,6 +1089,7 @@ struct CSphIndexStatus
 	int64_t			m_iTID = 0;
 	int64_t			m_iSavedTID = 0;
 	int64_t 		m_iDead = 0;
+	int64_t			m_iStaleMinMaxBlocks = 0; // attr blocks whose min/max is wider than their alive rows
 	double			m_fSaveRateLimit {0.0};	 // not used for plain. Part of m_iMemLimit to be achieved before flushing
 };
 
@@ -1111,6 +1119,15 @@ struct RowToUpdateData_t
 using RowsToUpdateData_t = CSphVector<RowToUpdateData_t>;
 using RowsToUpdate_t = VecTraits_T<RowToUpdateData_t>;
 
+/// row resolved in advance, before the write lock; row pointer is only taken under it, as attributes may be remapped meanwhile
+struct RowIdToUpdate_t
+{
+	RowID_t				m_tRowID;	/// row in the index
+	int					m_iIdx;		/// idx in updateset
+};
+
+using RowIdsToUpdate_t = CSphVector<RowIdToUpdate_t>;
+
 struct PostponedUpdate_t
 {
 	AttrUpdateSharedPtr_t	m_pUpdate;
@@ -1258,6 +1275,7 @@ class CSphSource;
 struct CSphSourceStats;
 class DebugCheckError_i;
 struct AttrAddRemoveCtx_t;
+struct RollupQuery_t;
 
 /// generic fulltext index interface
 class CSphIndex : public ISphKeywordsStat, public IndexSegment_c, public DocstoreReader_i
@@ -1291,6 +1309,7 @@ public:
 	virtual int64_t *			GetFieldLens() const { return NULL; }
 	virtual bool				IsStarDict ( bool bWordDict ) const;
 	int64_t						GetIndexId() const { return m_iIndexId; }
+	virtual int64_t				GetDataVersion() const { return m_iDataVersion.load ( std::memory_order_acquire ); }	///< changes along with the searchable data
 	void						SetMutableSettings ( const MutableIndexSettings_c & tSettings );
 	const MutableIndexSettings_c & GetMutableSettings () const { return m_tMutableSettings; }
 	virtual int64_t				GetPseudoShardingMetric() const;
@@ -1344,6 +1363,10 @@ public:
 	/// many regular queries with one sorter attached to each query.
 	/// returns true if at least one query succeeded. The failed queries indicated with pResult->m_iMultiplier==-1
 	virtual bool				MultiQueryEx ( int iQueries, const CSphQuery * pQueries, CSphQueryResult* pResults, ISphMatchSorter ** ppSorters, const CSphMultiQueryArgs & tArgs ) const = 0;
+
+	/// grouped full-scan answered from the per-group aggregates of a rollup (for RT disk chunks), instead of MultiQuery
+	virtual void				PushRollup ( const RollupQuery_t & tRollup, ISphMatchSorter * pSorter, CSphMatch & tMatch, CSphQueryResult & tResult ) const { assert ( 0 && "rollups are only kept by disk chunks" ); }
+	virtual void				ResetRollups() const {}
 	virtual bool				GetKeywords ( CSphVector <CSphKeywordInfo> & dKeywords, const char * szQuery, const GetKeywordsSettings_t & tSettings, CSphString * pError ) const = 0;
 	virtual void				GetSuggest ( const SuggestArgs_t & , SuggestResult_t & ) const {}
 	virtual Bson_t				ExplainQuery ( const CSphString & sQuery ) const { return EmptyBson(); }
@@ -1356,6 +1379,14 @@ public:
 	/// update accumulating state
 	virtual int					UpdateAttributes ( AttrUpdateInc_t & tUpd, bool & bCritical, CSphString & sError, CSphString & sWarning ) = 0;
 
+	/// resolve docids of the update to rows of this index; dSorted are indexes of the docids to look for, ordered by docid
+	/// does not modify anything, so may run concurrently for several indexes
+	virtual RowIdsToUpdate_t	CollectRowsToUpdate ( const AttrUpdateInc_t & tUpd, const VecTraits_T<int> & dSorted ) const { return {}; }
+
+	/// update accumulating state, using rows resolved by CollectRowsToUpdate; rows updated meanwhile elsewhere are skipped
+	/// caller must hold the write lock, and rowids must still be valid (ie. no merge of the index happened in between)
+	virtual int					UpdateCollectedRows ( const RowIdsToUpdate_t & dRowIDs, AttrUpdateInc_t & tUpd, bool & bCritical, CSphString & sError, CSphString & sWarning ) { return UpdateAttributes ( tUpd, bCritical, sError, sWarning ); }
+
 	/// apply serie of updates, assuming them prepared (no need to full-scan attributes), and index is offline, i.e. no concurrency
 	virtual void				UpdateAttributesOffline ( VecTraits_T<PostponedUpdate_t> & dUpdates, IndexSegment_c * pSeg ) = 0;
 
@@ -1366,6 +1397,10 @@ public:
 
 	virtual DWORD				GetAttributeStatus () const = 0;
 
+	/// recalculates exact min/max of the attr blocks gone stale after updates and kills
+	/// returns number of refreshed blocks; less than iMaxBlocks means nothing stale left
+	virtual int					RefreshStaleMinMax ( int iMaxBlocks ) { return 0; }
+
 	virtual bool				AddRemoveAttribute ( bool bAddAttr, const AttrAddRemoveCtx_t & tCtx, CSphString & sError ) = 0;
 
 	virtual bool				AddRemoveField ( bool bAdd, const CSphString & sFieldName, DWORD, CSphString & sError ) = 0;
@@ -1427,6 +1462,9 @@ protected:
 	static std::atomic<long>	m_tIdGenerator;
 
 	int64_t						m_iIndexId;				///< internal (per daemon) unique index id, introduced for caching
+	std::atomic<int64_t>		m_iDataVersion { 0 };	///< bumped once a change of the searchable data is in place; results computed over one version stay valid while it holds
+
+	void						BumpDataVersion() { m_iDataVersion.fetch_add ( 1, std::memory_order_acq_rel ); }
 
 	CSphSchema					m_tSchema;
 	CSphString					m_sLastError;
@@ -1577,6 +1615,10 @@ void				SetPseudoShardingThresh ( int iThresh );
 
 void				InitSkipCache ( int64_t iCacheSize );
 void				ShutdownSkipCache();
+void				InitDocBitmapCache ( int64_t iCacheSize );
+void				ShutdownDocBitmapCache();
+void				InitExpansionCache ( int64_t iCacheSize );
+void				ShutdownExpansionCache();
 
 //////////////////////////////////////////////////////////////////////////
 
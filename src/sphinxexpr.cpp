@@ -24,6 +24,7 @@
 #include "exprtraits.h"
 #include "columnarexpr.h"
 #include "conversion.h"
+#include "civiltime.h"
 #include <time.h>
 #include <math.h>
 
@@ -3295,41 +3296,39 @@ DECLARE_TERNARY ( Expr_Mul3_c,	FIRST*SECOND*THIRD,					INTFIRST*INTSECOND*INTTHI
 		float Eval ( const CSphMatch & tMatch ) const final { return (float)Int64Eval(tMatch); } \
 		int64_t Int64Eval ( const CSphMatch & tMatch ) const final \
 		{ \
-			time_t ts = (time_t)INT64FIRST;	\
-			struct tm s = {0}; \
-			localtime_r ( &ts, &s ); \
+			CivilTime_t s; \
+			CivilTime::FromLocal ( INT64FIRST, s ); \
 			return _expr; \
 		} \
 		int IntEval ( const CSphMatch & tMatch ) const final { return (int)Int64Eval(tMatch); } \
 	};
 
-DECLARE_TIMESTAMP ( Expr_Day_c,				(int64_t)s.tm_mday )
-DECLARE_TIMESTAMP ( Expr_Month_c,			(int64_t)s.tm_mon + 1 )
-DECLARE_TIMESTAMP ( Expr_Year_c,			(int64_t)s.tm_year + 1900 )
-DECLARE_TIMESTAMP ( Expr_YearMonth_c,		((int64_t)s.tm_year + 1900) * 100 + (int64_t)s.tm_mon + 1 )
-DECLARE_TIMESTAMP ( Expr_YearMonthDay_c,	((int64_t)s.tm_year + 1900) * 10000 + ((int64_t)s.tm_mon + 1) * 100 + (int64_t)s.tm_mday )
-DECLARE_TIMESTAMP ( Expr_Hour_c,			(int64_t)s.tm_hour )
-DECLARE_TIMESTAMP ( Expr_Minute_c,			(int64_t)s.tm_min )
-DECLARE_TIMESTAMP ( Expr_Second_c,			(int64_t)s.tm_sec )
+DECLARE_TIMESTAMP ( Expr_Day_c,				(int64_t)s.m_iDay )
+DECLARE_TIMESTAMP ( Expr_Month_c,			(int64_t)s.m_iMonth )
+DECLARE_TIMESTAMP ( Expr_Year_c,			(int64_t)s.m_iYear )
+DECLARE_TIMESTAMP ( Expr_YearMonth_c,		(int64_t)s.m_iYear * 100 + (int64_t)s.m_iMonth )
+DECLARE_TIMESTAMP ( Expr_YearMonthDay_c,	(int64_t)s.m_iYear * 10000 + (int64_t)s.m_iMonth * 100 + (int64_t)s.m_iDay )
+DECLARE_TIMESTAMP ( Expr_Hour_c,			(int64_t)s.m_iHour )
+DECLARE_TIMESTAMP ( Expr_Minute_c,			(int64_t)s.m_iMinute )
+DECLARE_TIMESTAMP ( Expr_Second_c,			(int64_t)s.m_iSecond )
 
 #define DECLARE_TIMESTAMP_UTC( _classname, _expr ) \
 	DECLARE_UNARY_TRAITS ( _classname ) \
 		float Eval ( const CSphMatch & tMatch ) const final { return (float)Int64Eval(tMatch); } \
 		int64_t Int64Eval ( const CSphMatch & tMatch ) const final \
 		{ \
-			time_t ts = (time_t)INT64FIRST;    \
-			struct tm s = {0}; \
-			gmtime_r ( &ts, &s ); \
+			CivilTime_t s; \
+			CivilTime::FromUTC ( INT64FIRST, s ); \
 			return _expr; \
 		} \
 		int IntEval ( const CSphMatch & tMatch ) const final { return (int)Int64Eval(tMatch); } \
 	};
 
-DECLARE_TIMESTAMP_UTC ( Expr_Day_utc_c,				(int64_t)s.tm_mday )
-DECLARE_TIMESTAMP_UTC ( Expr_Month_utc_c,			(int64_t)s.tm_mon + 1 )
-DECLARE_TIMESTAMP_UTC ( Expr_Year_utc_c,			(int64_t)s.tm_year + 1900 )
-DECLARE_TIMESTAMP_UTC ( Expr_YearMonth_utc_c,		((int64_t)s.tm_year + 1900) * 100 + (int64_t)s.tm_mon + 1 )
-DECLARE_TIMESTAMP_UTC ( Expr_YearMonthDay_utc_c,	((int64_t)s.tm_year + 1900) * 10000 + ((int64_t)s.tm_mon + 1) * 100 + (int64_t)s.tm_mday )
+DECLARE_TIMESTAMP_UTC ( Expr_Day_utc_c,				(int64_t)s.m_iDay )
+DECLARE_TIMESTAMP_UTC ( Expr_Month_utc_c,			(int64_t)s.m_iMonth )
+DECLARE_TIMESTAMP_UTC ( Expr_Year_utc_c,			(int64_t)s.m_iYear )
+DECLARE_TIMESTAMP_UTC ( Expr_YearMonth_utc_c,		(int64_t)s.m_iYear * 100 + (int64_t)s.m_iMonth )
+DECLARE_TIMESTAMP_UTC ( Expr_YearMonthDay_utc_c,	(int64_t)s.m_iYear * 10000 + (int64_t)s.m_iMonth * 100 + (int64_t)s.m_iDay )
 
 static bool g_bExprGroupingInUtc = false;
 
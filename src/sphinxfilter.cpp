@@ -43,7 +43,7 @@ struct IFilter_Values : virtual ISphFilter
 	const SphAttr_t *	m_pValues = nullptr;
 	int					m_iValueCount = 0;
 
-	void SetValues ( const SphAttr_t * pStorage, int iCount ) final
+	void SetValues ( const SphAttr_t * pStorage, int iCount ) override
 	{
 		assert ( pStorage );
 		assert ( iCount > 0 );
@@ -92,17 +92,88 @@ bool IFilter_Values::EvalValues ( SphAttr_t uValue ) const
 }
 
 
-// OPTIMIZE: use binary search
 bool IFilter_Values::EvalBlockValues ( SphAttr_t uBlockMin, SphAttr_t uBlockMax ) const
 {
-	// is any of our values inside the block?
-	for ( int i = 0; i < m_iValueCount; ++i )
-		if ( GetValue(i)>=uBlockMin && GetValue(i)<=uBlockMax )
-			return true;
-	return false;
+	if ( !m_pValues )
+		return true;
+
+	// is any of our values inside the block? find the first value that is not less than block min
+	const SphAttr_t * pLast = m_pValues + m_iValueCount - 1;
+	if ( uBlockMax<*m_pValues || uBlockMin>*pLast )
+		return false;
+
+	const SphAttr_t * pFound = sphBinarySearchFirst ( m_pValues, pLast, SphIdentityFunctor_T<SphAttr_t>(), uBlockMin );
+	return *pFound>=uBlockMin && *pFound<=uBlockMax;
 }
 
 
+/// values with a per-row lookup structure chosen by list size and density
+/// small lists are binary-searched, compact integer ranges go to a bitmap, large sparse lists go to a hash
+struct IFilter_ValuesLookup : IFilter_Values
+{
+	void SetValues ( const SphAttr_t * pStorage, int iCount ) final
+	{
+		IFilter_Values::SetValues ( pStorage, iCount );
+
+		m_eLookup = Lookup_e::BINARY;
+		if ( iCount<LOOKUP_MIN_VALUES )
+			return;
+
+		m_tMin = m_pValues[0];
+		uint64_t uRange = uint64_t ( m_pValues[iCount-1] ) - uint64_t ( m_tMin );
+		if ( uRange<BITMAP_MAX_BITS && uRange<(uint64_t)iCount*BITMAP_BITS_PER_VALUE )
+		{
+			m_eLookup = Lookup_e::BITMAP;
+			m_dBitmap.Init ( int(uRange+1) );
+			for ( int i = 0; i < iCount; i++ )
+				m_dBitmap.BitSet ( int ( uint64_t ( m_pValues[i] ) - uint64_t ( m_tMin ) ) );
+
+			return;
+		}
+
+		m_eLookup = Lookup_e::HASH;
+		m_hValues.Reset ( iCount*2 );
+		for ( int i = 0; i < iCount; i++ )
+			m_hValues.Add ( m_pValues[i], 1 );
+	}
+
+	inline bool EvalValues ( SphAttr_t uValue ) const
+	{
+		switch ( m_eLookup )
+		{
+		case Lookup_e::BITMAP:
+		{
+			uint64_t uOffset = uint64_t(uValue) - uint64_t(m_tMin);
+			return uOffset<(uint64_t)m_dBitmap.GetBits() && m_dBitmap.BitGet ( (int)uOffset );
+		}
+
+		case Lookup_e::HASH:
+			return !!m_hValues.Find ( uValue );
+
+		default:
+			return IFilter_Values::EvalValues ( uValue );
+		}
+	}
+
+private:
+	enum class Lookup_e
+	{
+		BINARY,
+		BITMAP,
+		HASH
+	};
+
+	static const int		LOOKUP_MIN_VALUES = 64;
+	static const uint64_t	BITMAP_BITS_PER_VALUE = 64;
+	static const uint64_t	BITMAP_MAX_BITS = 1ULL<<27;
+
+	Lookup_e					m_eLookup = Lookup_e::BINARY;
+	SphAttr_t					m_tMin = 0;
+	CSphBitvec					m_dBitmap;
+	OpenHash_T<BYTE,SphAttr_t>	m_hValues {0};
+};
+
+
 /// range
 struct IFilter_Range: virtual ISphFilter
 {
@@ -121,7 +192,7 @@ struct IFilter_Range: virtual ISphFilter
 
 // attr
 
-class Filter_Values : public IFilter_Attr, public IFilter_Values
+class Filter_Values : public IFilter_Attr, public IFilter_ValuesLookup
 {
 public:
 	bool Eval ( const CSphMatch & tMatch ) const final
@@ -253,7 +324,7 @@ struct Filter_FloatRange : public IFilter_Attr
 	}
 };
 
-struct Filter_WeightValues: public IFilter_Values
+struct Filter_WeightValues: public IFilter_ValuesLookup
 {
 	bool Eval ( const CSphMatch & tMatch ) const final
 	{
@@ -312,6 +383,65 @@ RowIdBoundaries_t GetFilterRowIdBoundaries ( const CSphFilterSettings & tFilter,
 	return { tMinRowID, tMaxRowID };
 }
 
+
+bool sphSampleKeepsDoc ( DocID_t tDocID, float fRate, int64_t iSeed )
+{
+	// splitmix64 finalizer; a document is kept or dropped the same way by every chunk, segment, shard and agent that holds it
+	uint64_t uHash = uint64_t(tDocID) ^ ( uint64_t(iSeed)*0x9E3779B97F4A7C15ULL );
+	uHash = ( uHash ^ ( uHash>>30 ) ) * 0xBF58476D1CE4E5B9ULL;
+	uHash = ( uHash ^ ( uHash>>27 ) ) * 0x94D049BB133111EBULL;
+	uHash ^= uHash>>31;
+	return double ( uHash>>32 ) < fRate*4294967296.0;
+}
+
+
+class Filter_Sample_c : public ISphFilter
+{
+public:
+	Filter_Sample_c ( ISphExpr * pDocID, float fRate, int64_t iSeed )
+		: m_pDocID ( pDocID )
+		, m_fRate ( fRate )
+		, m_iSeed ( iSeed )
+	{
+		SafeAddRef ( pDocID );
+	}
+
+	void SetColumnar ( const columnar::Columnar_i * pColumnar ) final
+	{
+		m_pDocID->Command ( SPH_EXPR_SET_COLUMNAR, (void*)pColumnar );
+	}
+
+	bool Eval ( const CSphMatch & tMatch ) const final
+	{
+		return sphSampleKeepsDoc ( m_pDocID->Int64Eval ( tMatch ), m_fRate, m_iSeed );
+	}
+
+private:
+	CSphRefcountedPtr<ISphExpr>	m_pDocID;
+	float						m_fRate;
+	int64_t						m_iSeed;
+};
+
+
+ISphFilter * sphCreateSampleFilter ( float fRate, int64_t iSeed, const CreateFilterContext_t & tCtx, CSphString & sError )
+{
+	if ( !tCtx.m_pSchema )
+	{
+		sError = "sampling requires document ids";
+		return nullptr;
+	}
+
+	// docid may be columnar, so it is read through an expression
+	ExprParseArgs_t tExprArgs;
+	CSphRefcountedPtr<ISphExpr> pDocID { sphExprParse ( sphGetDocidName(), *tCtx.m_pSchema, sError, tExprArgs ) };
+	if ( !pDocID )
+		return nullptr;
+
+	ISphFilter * pFilter = new Filter_Sample_c ( pDocID, fRate, iSeed );
+	pFilter->SetColumnar ( tCtx.m_pColumnar );
+	return pFilter;
+}
+
 //////////////////////////////////////////////////////////////////////////
 // MVA
 //////////////////////////////////////////////////////////////////////////
@@ -432,6 +562,7 @@ class Filter_StringValues_c : public FilterString_c
 public:
 	Filter_StringValues_c ( ESphCollation eCollation )
 		: FilterString_c ( eCollation, false )
+		, m_fnHashCalc ( GetStringHashCalcFunc ( eCollation ) )
 	{}
 
 	void SetRefString ( const CSphString * pRef, int iCount ) final
@@ -448,11 +579,36 @@ public:
 			m_dValues[i].Resize ( iLen );
 			memcpy ( m_dValues[i].Begin(), sRef, iLen );
 		}
+
+		// collation hash is equal for strings that compare equal, so a hash hit only needs one confirming compare
+		m_bHashed = iCount>=HASH_MIN_VALUES;
+		if ( !m_bHashed )
+			return;
+
+		m_hValues.Reset ( iCount*2 );
+		ARRAY_FOREACH ( i, m_dValues )
+		{
+			uint64_t uHash = CalcHash ( m_dValues[i] );
+			int & iStored = m_hValues.FindOrAdd ( uHash, i );
+			if ( iStored!=i && m_fnStrCmp ( m_dValues[iStored], m_dValues[i], false )!=0 )
+			{
+				// collision between different values; just fall back to plain compares
+				m_bHashed = false;
+				m_hValues.Reset(0);
+				return;
+			}
+		}
 	}
 
 	bool Eval ( const CSphMatch & tMatch ) const final
 	{
 		auto dStr = tMatch.FetchAttrData ( m_tLocator, m_pBlobPool );
+		if ( m_bHashed )
+		{
+			const int * pFound = m_hValues.Find ( CalcHash ( dStr ) );
+			return pFound && m_fnStrCmp ( dStr, m_dValues[*pFound], false )==0;
+		}
+
 		return m_dValues.any_of( [this, &dStr] ( const VecTraits_T<BYTE>& i )
 		{
 			return m_fnStrCmp ( dStr, i, false )==0;
@@ -460,7 +616,17 @@ public:
 	}
 
 private:
+	static const int HASH_MIN_VALUES = 8;
+
 	CSphTightVector<CSphTightVector<BYTE>> m_dValues;
+	StrHashCalc_fn				m_fnHashCalc = nullptr;
+	OpenHash_T<int,uint64_t>	m_hValues {0};
+	bool						m_bHashed = false;
+
+	inline uint64_t CalcHash ( ByteBlob_t dStr ) const
+	{
+		return IsFilled ( dStr ) ? m_fnHashCalc ( dStr.first, dStr.second, SPH_FNV64_SEED ) : 0;
+	}
 };
 
 struct Filter_StringTags_c : IFilter_Str
@@ -1111,11 +1277,11 @@ public:
 };
 
 
-class ExprFilterValues_c : public ExprFilter_c<IFilter_Values>
+class ExprFilterValues_c : public ExprFilter_c<IFilter_ValuesLookup>
 {
 public:
 	explicit ExprFilterValues_c ( ISphExpr * pExpr )
-		: ExprFilter_c<IFilter_Values> ( pExpr )
+		: ExprFilter_c<IFilter_ValuesLookup> ( pExpr )
 	{}
 
 	bool Eval ( const CSphMatch & tMatch ) const final
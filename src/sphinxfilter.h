@@ -93,6 +93,10 @@ ISphFilter * sphCreateFilter ( const CSphFilterSettings &tSettings, const Create
 ISphFilter * sphCreateAggrFilter ( const CSphFilterSettings * pSettings, const CSphString & sAttrName, const ISphSchema & tSchema, CSphString & sError );
 ISphFilter * sphJoinFilters ( ISphFilter *, ISphFilter * );
 
+/// sampled queries only process a pseudo-random share of the documents; the choice depends on the docid and the seed only
+bool sphSampleKeepsDoc ( DocID_t tDocID, float fRate, int64_t iSeed );
+ISphFilter * sphCreateSampleFilter ( float fRate, int64_t iSeed, const CreateFilterContext_t & tCtx, CSphString & sError );
+
 bool sphCreateFilters ( CreateFilterContext_t & tCtx, CSphString & sError, CSphString & sWarning );
 
 void FormatFilterQL ( const CSphFilterSettings & tFilter, StringBuilder_c & tBuf, int iCompactIN );
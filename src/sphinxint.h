@@ -119,7 +119,8 @@ enum ExtraData_e
 	EXTRA_SET_RANKER_PLUGIN_OPTS,
 
 	EXTRA_GET_POOL_SIZE,
-	EXTRA_SET_BOUNDARIES
+	EXTRA_SET_BOUNDARIES,
+	EXTRA_SET_ROWID_ITERATOR
 };
 
 /// generic COM-like interface
@@ -245,6 +245,33 @@ namespace // static unnamed
 		}
 	}
 
+	// same encoding as PackInt(), but into a raw buffer (at least 5 bytes); returns number of bytes written
+	int PackIntTo ( BYTE * pOut, DWORD v )
+	{
+		if ( v<0x000000FC )
+		{
+			pOut[0] = BYTE ( v );
+			return 1;
+		} else if ( v<0x00010000 )
+		{
+			pOut[0] = 252;
+			pOut[1] = BYTE ( v & 255 );
+			pOut[2] = BYTE ( v >> 8 );
+			return 3;
+		} else if ( v<0x1000000 )
+		{
+			pOut[0] = 253;
+			pOut[1] = BYTE ( v & 255 );
+			pOut[2] = BYTE ( ( v >> 8 ) & 255 );
+			pOut[3] = BYTE ( v >> 16 );
+			return 4;
+		}
+
+		pOut[0] = 254;
+		StoreNUM32LE ( pOut+1, v );
+		return 5;
+	}
+
 	inline void PackStr ( CSphVector<BYTE> & dBsonBuffer, const char * s, int iLen )
 	{
 		assert ( iLen<=0x00FFFFFF );
@@ -843,7 +870,522 @@ bool sphJsonParse ( CSphVector<BYTE> & dData, char * sData, bool bAutoconv, bool
 	return bResult;
 }
 
-bool sphJsonParse ( CSphVector<BYTE> &dData, char * sData, bool bAutoconv, bool bToLowercase, bool bCheckSize, StringBuilder_c &sMsg )
+/// hand-written single pass JSON to SphinxBSON packer
+/// accepts exactly what the grammar above accepts (case-insensitive literals, unquoted keys, single quotes, comments)
+/// and writes the very same bytes, but straight into the output with no intermediate nodes
+/// on any error it just fails; the grammar parser is then run to produce the error message
+class JsonPacker_c : public BsonHelper
+{
+public:
+	JsonPacker_c ( CSphVector<BYTE> & dBuffer, const char * sData, int iLen, bool bAutoconv, bool bToLowercase )
+		: BsonHelper ( dBuffer )
+		, m_pCur ( sData )
+		, m_pEnd ( sData+iLen )
+		, m_bAutoconv ( bAutoconv )
+		, m_bToLowercase ( bToLowercase )
+	{}
+
+	bool Pack()
+	{
+		SkipSpaces();
+		if ( m_pCur==m_pEnd )
+			return true;
+
+		if ( *m_pCur=='{' )
+		{
+			++m_pCur;
+			DWORD uMask = 0;
+			if ( !PackObjectBody ( uMask ) )
+				return false;
+
+			StoreMask ( 0, uMask );
+		} else if ( *m_pCur=='[' )
+		{
+			ESphJsonType eType;
+			if ( !PackValue ( nullptr, 0, eType ) )
+				return false;
+		} else
+			return false;
+
+		SkipSpaces();
+		return m_pCur==m_pEnd;
+	}
+
+private:
+	static const int MAX_DEPTH = 64; // deeper documents are left to the grammar parser, which has a heap stack
+
+	const char *	m_pCur;
+	const char *	m_pEnd;
+	bool			m_bAutoconv;
+	bool			m_bToLowercase;
+	int				m_iDepth = 0;
+
+	static inline bool IsIdentStart ( char c )
+	{
+		return ( c>='a' && c<='z' ) || ( c>='A' && c<='Z' ) || c=='_';
+	}
+
+	static inline bool IsIdent ( char c )
+	{
+		return IsIdentStart(c) || ( c>='0' && c<='9' );
+	}
+
+	static inline bool IsDigit ( char c )
+	{
+		return c>='0' && c<='9';
+	}
+
+	// whitespace and '//' or '#' comments up to the end of line
+	void SkipSpaces()
+	{
+		while ( m_pCur<m_pEnd )
+		{
+			char c = *m_pCur;
+			if ( c==' ' || c=='\t' || c=='\n' || c=='\r' )
+			{
+				++m_pCur;
+				continue;
+			}
+
+			if ( c=='#' || ( c=='/' && m_pCur+1<m_pEnd && m_pCur[1]=='/' ) )
+			{
+				auto * pEol = (const char *) memchr ( m_pCur, '\n', m_pEnd-m_pCur );
+				m_pCur = pEol ? pEol+1 : m_pEnd;
+				continue;
+			}
+
+			break;
+		}
+	}
+
+	// position of the first cQuote or backslash at or after p; tests 8 bytes at once while far from the end
+	const char * FindQuoteOrEscape ( const char * p, char cQuote ) const
+	{
+		const uint64_t LOW = 0x0101010101010101ULL;
+		const uint64_t HIGH = 0x8080808080808080ULL;
+		const uint64_t uQuotes = LOW * (BYTE)cQuote;
+		const uint64_t uEscapes = LOW * (BYTE)'\\';
+
+		while ( p+8<=m_pEnd )
+		{
+			uint64_t uWord;
+			memcpy ( &uWord, p, sizeof(uWord) );
+			uint64_t uQ = uWord ^ uQuotes;
+			uint64_t uE = uWord ^ uEscapes;
+			if ( ( ( ( uQ-LOW ) & ~uQ ) | ( ( uE-LOW ) & ~uE ) ) & HIGH )
+				break;
+			p += 8;
+		}
+
+		for ( ; p<m_pEnd; ++p )
+			if ( *p==cQuote || *p=='\\' )
+				return p;
+
+		return nullptr;
+	}
+
+	// quoted string token, including the quotes; escaped newline is not a valid escape (same as in the lexer)
+	bool ScanString ( const char * & sRaw, int & iRawLen )
+	{
+		char cQuote = *m_pCur;
+		const char * p = m_pCur+1;
+		while ( true )
+		{
+			p = FindQuoteOrEscape ( p, cQuote );
+			if ( !p )
+				return false;
+
+			if ( *p==cQuote )
+				break;
+
+			if ( p+1>=m_pEnd || p[1]=='\n' )
+				return false;
+
+			p += 2;
+		}
+
+		sRaw = m_pCur;
+		iRawLen = int ( p+1-m_pCur );
+		m_pCur = p+1;
+		return true;
+	}
+
+	// [+-]? then int, float or exp constant; sign or dot alone is not a number
+	bool ScanNumber ( ESphJsonType & eType, int64_t & iValue, double & fValue )
+	{
+		const char * sStart = m_pCur;
+		const char * p = m_pCur;
+		if ( *p=='+' || *p=='-' )
+			++p;
+
+		const char * sDigits = p;
+		while ( p<m_pEnd && IsDigit(*p) )
+			++p;
+		bool bIntPart = p>sDigits;
+
+		bool bFloat = false;
+		if ( p<m_pEnd && *p=='.' )
+		{
+			const char * sFrac = p+1;
+			const char * q = sFrac;
+			while ( q<m_pEnd && IsDigit(*q) )
+				++q;
+
+			if ( bIntPart || q>sFrac )
+			{
+				bFloat = true;
+				p = q;
+			}
+		}
+
+		if ( !bFloat && !bIntPart )
+			return false;
+
+		if ( p<m_pEnd && ( *p=='e' || *p=='E' ) )
+		{
+			const char * q = p+1;
+			if ( q<m_pEnd && ( *q=='+' || *q=='-' ) )
+				++q;
+
+			const char * sExp = q;
+			while ( q<m_pEnd && IsDigit(*q) )
+				++q;
+
+			if ( q>sExp )
+			{
+				bFloat = true;
+				p = q;
+			}
+		}
+
+		// the token is maximal, so strtod/strtoll stop exactly at its end
+		if ( bFloat )
+		{
+			eType = JSON_DOUBLE;
+			fValue = strtod ( sStart, nullptr );
+		} else
+		{
+			eType = JSON_INT64;
+			iValue = strtoll ( sStart, nullptr, 10 );
+		}
+
+		m_pCur = p;
+		return true;
+	}
+
+	static bool IsLiteral ( const char * sIdent, int iLen, const char * sLiteral )
+	{
+		if ( iLen!=(int)strlen ( sLiteral ) )
+			return false;
+
+		for ( int i = 0; i<iLen; ++i )
+			if ( Mytolower ( sIdent[i] )!=sLiteral[i] )
+				return false;
+
+		return true;
+	}
+
+	// same as JsonParser_c::WriteKeyUnescaped(); returns bloom mask of the key
+	// (empty key is fine here, its packed string points right at the end of the buffer)
+	DWORD WriteKey ( const char * sKey, int iLen )
+	{
+		BYTE * pPacked = PackStrUnescaped ( sKey, iLen );
+		auto iPackedLen = int ( m_dBsonBuffer.end() - pPacked );
+		if ( m_bToLowercase )
+			for ( auto & c : VecTraits_T<char> ( (char *)pPacked, iPackedLen ) )
+				c = Mytolower(c);
+
+		return sphJsonKeyMask ( (const char *)pPacked, iPackedLen );
+	}
+
+	void WriteHead ( ESphJsonType eType, const char * sKey, int iKeyLen, DWORD * pMask )
+	{
+		m_dBsonBuffer.Add ( eType );
+		if ( sKey )
+		{
+			DWORD uMask = WriteKey ( sKey, iKeyLen );
+			if ( pMask )
+				*pMask = uMask;
+		}
+	}
+
+	// writes [type][key][value] for the value at cursor; eType receives the value type the way array optimizer sees it
+	bool PackValue ( const char * sKey, int iKeyLen, ESphJsonType & eType, DWORD * pMask = nullptr )
+	{
+		if ( m_pCur>=m_pEnd )
+			return false;
+
+		char c = *m_pCur;
+		switch ( c )
+		{
+		case '{':
+		{
+			if ( ++m_iDepth>MAX_DEPTH )
+				return false;
+
+			++m_pCur;
+			eType = JSON_OBJECT;
+			WriteHead ( eType, sKey, iKeyLen, pMask );
+
+			DWORD uMask = 0;
+			int iOfs = ReserveSize();
+			StoreInt ( 0 );
+			if ( !PackObjectBody ( uMask ) )
+				return false;
+
+			StoreMask ( iOfs+1, uMask );
+			PackSize ( iOfs ); // MUST be in this order, because PackSize() might move the data!
+			--m_iDepth;
+			return true;
+		}
+
+		case '[':
+		{
+			if ( ++m_iDepth>MAX_DEPTH )
+				return false;
+
+			++m_pCur;
+			int iTypeOfs = m_dBsonBuffer.GetLength();
+			WriteHead ( JSON_MIXED_VECTOR, sKey, iKeyLen, pMask );
+			if ( !PackArrayBody ( iTypeOfs ) )
+				return false;
+
+			eType = JSON_MIXED_VECTOR;
+			--m_iDepth;
+			return true;
+		}
+
+		case '"':
+		case '\'':
+		{
+			const char * sRaw;
+			int iRawLen;
+			if ( !ScanString ( sRaw, iRawLen ) )
+				return false;
+
+			int64_t iValue = 0;
+			double fValue = 0.0;
+			eType = JSON_STRING;
+			if ( m_bAutoconv && sphJsonStringToNumber ( sRaw+1, iRawLen-2, eType, iValue, fValue ) )
+				return PackNumber ( sKey, iKeyLen, eType, iValue, fValue, pMask );
+
+			WriteHead ( eType, sKey, iKeyLen, pMask );
+			PackStrUnescaped ( sRaw, iRawLen );
+			return true;
+		}
+
+		default:
+			break;
+		}
+
+		if ( IsIdentStart(c) )
+		{
+			const char * sIdent = m_pCur;
+			while ( m_pCur<m_pEnd && IsIdent ( *m_pCur ) )
+				++m_pCur;
+
+			int iLen = int ( m_pCur-sIdent );
+			if ( IsLiteral ( sIdent, iLen, "true" ) )
+				eType = JSON_TRUE;
+			else if ( IsLiteral ( sIdent, iLen, "false" ) )
+				eType = JSON_FALSE;
+			else if ( IsLiteral ( sIdent, iLen, "null" ) )
+				eType = JSON_NULL;
+			else
+				return false; // bare identifiers are only good as keys
+
+			WriteHead ( eType, sKey, iKeyLen, pMask );
+			return true;
+		}
+
+		int64_t iValue = 0;
+		double fValue = 0.0;
+		if ( !ScanNumber ( eType, iValue, fValue ) )
+			return false;
+
+		return PackNumber ( sKey, iKeyLen, eType, iValue, fValue, pMask );
+	}
+
+	bool PackNumber ( const char * sKey, int iKeyLen, ESphJsonType & eType, int64_t iValue, double fValue, DWORD * pMask )
+	{
+		if ( eType==JSON_INT64 && iValue==int64_t ( int ( iValue ) ) )
+			eType = JSON_INT32;
+
+		WriteHead ( eType, sKey, iKeyLen, pMask );
+		switch ( eType )
+		{
+		case JSON_INT32:	StoreInt ( (int)iValue ); break;
+		case JSON_INT64:	StoreBigint ( iValue ); break;
+		default:			StoreBigint ( sphD2QW ( fValue ) ); break;
+		}
+
+		return true;
+	}
+
+	// key: value pairs up to the closing brace (opening one is already consumed), then EOF marker
+	bool PackObjectBody ( DWORD & uMask )
+	{
+		SkipSpaces();
+		if ( m_pCur<m_pEnd && *m_pCur=='}' )
+		{
+			++m_pCur;
+			m_dBsonBuffer.Add ( JSON_EOF );
+			return true;
+		}
+
+		while ( true )
+		{
+			SkipSpaces();
+			if ( m_pCur>=m_pEnd )
+				return false;
+
+			const char * sKey = m_pCur;
+			int iKeyLen;
+			if ( *m_pCur=='"' || *m_pCur=='\'' )
+			{
+				if ( !ScanString ( sKey, iKeyLen ) )
+					return false;
+			} else if ( IsIdentStart ( *m_pCur ) )
+			{
+				while ( m_pCur<m_pEnd && IsIdent ( *m_pCur ) )
+					++m_pCur;
+
+				iKeyLen = int ( m_pCur-sKey );
+				if ( IsLiteral ( sKey, iKeyLen, "true" ) || IsLiteral ( sKey, iKeyLen, "false" ) || IsLiteral ( sKey, iKeyLen, "null" ) )
+					return false;
+			} else
+				return false;
+
+			SkipSpaces();
+			if ( m_pCur>=m_pEnd || *m_pCur!=':' )
+				return false;
+
+			++m_pCur;
+			SkipSpaces();
+
+			ESphJsonType eType;
+			DWORD uKeyMask = 0;
+			if ( !PackValue ( sKey, iKeyLen, eType, &uKeyMask ) )
+				return false;
+
+			uMask |= uKeyMask;
+
+			SkipSpaces();
+			if ( m_pCur>=m_pEnd )
+				return false;
+
+			if ( *m_pCur==',' )
+			{
+				++m_pCur;
+				continue;
+			}
+
+			if ( *m_pCur!='}' )
+				return false;
+
+			++m_pCur;
+			m_dBsonBuffer.Add ( JSON_EOF );
+			return true;
+		}
+	}
+
+	// values are written as a mixed vector first (type byte per value); once the closing bracket is met,
+	// the vector is converted to an optimized one if all values are of the same scalar type, and the header is inserted
+	bool PackArrayBody ( int iTypeOfs )
+	{
+		int iStart = m_dBsonBuffer.GetLength();
+		int iCount = 0;
+		ESphJsonType eBase = JSON_TOTAL;
+		bool bAllSame = true;
+
+		SkipSpaces();
+		if ( m_pCur<m_pEnd && *m_pCur==']' )
+			++m_pCur;
+		else
+		{
+			while ( true )
+			{
+				SkipSpaces();
+				ESphJsonType eType;
+				if ( !PackValue ( nullptr, 0, eType ) )
+					return false;
+
+				if ( !iCount )
+					eBase = eType;
+				bAllSame &= ( eType==eBase );
+				++iCount;
+
+				SkipSpaces();
+				if ( m_pCur>=m_pEnd )
+					return false;
+
+				if ( *m_pCur==',' )
+				{
+					++m_pCur;
+					continue;
+				}
+
+				if ( *m_pCur!=']' )
+					return false;
+
+				++m_pCur;
+				break;
+			}
+		}
+
+		ESphJsonType eType = JSON_MIXED_VECTOR;
+		if ( iCount && bAllSame )
+			switch ( eBase )
+			{
+			case JSON_INT32:	eType = JSON_INT32_VECTOR; break;
+			case JSON_INT64:	eType = JSON_INT64_VECTOR; break;
+			case JSON_DOUBLE:	eType = JSON_DOUBLE_VECTOR; break;
+			case JSON_STRING:	eType = JSON_STRING_VECTOR; break;
+			default: break;
+			}
+
+		// drop per-value type bytes
+		if ( eType!=JSON_MIXED_VECTOR )
+		{
+			BYTE * pBase = m_dBsonBuffer.Begin();
+			const BYTE * pSrc = pBase + iStart;
+			BYTE * pDst = pBase + iStart;
+			for ( int i = 0; i<iCount; ++i )
+			{
+				++pSrc;
+				const BYTE * pValue = pSrc;
+				if ( eBase==JSON_STRING )
+				{
+					int iLen = sphJsonUnpackInt ( &pSrc );
+					pSrc += iLen;
+				} else
+					pSrc += ( eBase==JSON_INT32 ? 4 : 8 );
+
+				memmove ( pDst, pValue, pSrc-pValue );
+				pDst += pSrc-pValue;
+			}
+			m_dBsonBuffer.Resize ( pDst-pBase );
+		}
+
+		int iValuesLen = m_dBsonBuffer.GetLength() - iStart;
+		BYTE dHeader[10];
+		int iHeader = 0;
+		if ( eType==JSON_MIXED_VECTOR || eType==JSON_STRING_VECTOR )
+			iHeader += PackIntTo ( dHeader, PackedLen ( iCount ) + iValuesLen );
+		iHeader += PackIntTo ( dHeader+iHeader, iCount );
+
+		m_dBsonBuffer.AddN ( iHeader );
+		BYTE * pStart = m_dBsonBuffer.Begin() + iStart;
+		memmove ( pStart+iHeader, pStart, iValuesLen );
+		memcpy ( pStart, dHeader, iHeader );
+		m_dBsonBuffer[iTypeOfs] = (BYTE)eType;
+		return true;
+	}
+};
+
+
+// grammar-driven parser; reports errors, and serves as a reference for JsonPacker_c
+bool sphJsonParseGrammar ( CSphVector<BYTE> & dData, char * sData, bool bAutoconv, bool bToLowercase, bool bCheckSize, StringBuilder_c & sMsg )
 {
 	auto iLen = (int) strlen ( sData );
 	if ( sData[iLen+1]!=0 )
@@ -882,6 +1424,37 @@ bool sphJsonParse ( CSphVector<BYTE> &dData, char * sData, bool bAutoconv, bool
 	return ( iRes==0 );
 }
 
+
+bool sphJsonParse ( CSphVector<BYTE> &dData, char * sData, bool bAutoconv, bool bToLowercase, bool bCheckSize, StringBuilder_c &sMsg )
+{
+	auto iLen = (int) strlen ( sData );
+	if ( sData[iLen+1]!=0 )
+	{
+		sMsg << "internal error: input data passed to sphJsonParse() must be terminated with a double zero";
+		return false;
+	}
+
+	int iStart = dData.GetLength();
+	JsonPacker_c tPacker ( dData, sData, iLen, bAutoconv, bToLowercase );
+	if ( !tPacker.Pack() )
+	{
+		// malformed (or too deeply nested) input; let the grammar parser have its say
+		dData.Resize ( iStart );
+		return sphJsonParseGrammar ( dData, sData, bAutoconv, bToLowercase, bCheckSize, sMsg );
+	}
+
+	tPacker.Finalize();
+
+	if ( bCheckSize && dData.AllocatedBytes()>=0x400000 )
+	{
+		sMsg << "data exceeds 0x400000 bytes";
+		dData.Reset();
+		return false;
+	}
+
+	return true;
+}
+
 //////////////////////////////////////////////////////////////////////////
 
 DWORD sphJsonKeyMask ( const char * sKey, int iLen )
@@ -72,6 +72,14 @@ public:
 
 static FileAccessSettings_t g_tDummyFASettings;
 
+// per-worker tokenizers and dict to compile stored queries
+struct PqCompileContext_t
+{
+	TokenizerRefPtr_c	m_pTokenizer;
+	TokenizerRefPtr_c	m_pTokenizerJson;
+	DictRefPtr_c		m_pDict;
+};
+
 class PercolateIndex_c : public PercolateIndex_i
 {
 public:
@@ -90,8 +98,10 @@ public:
 	RtAccum_t * CreateAccum ( RtAccum_t * pAccExt, CSphString & sError ) override;
 	ISphTokenizer * CloneIndexingTokenizer() const override { return m_pTokenizerIndexing->Clone ( SPH_CLONE_INDEX ); }
 	void SaveMeta ( bool bShutdown = false ) EXCLUDES ( m_tLock );
-	void SaveMeta ( const SharedPQSlice_t& dStored, bool bShutdown = false );
+	bool SaveMeta ( const SharedPQSlice_t& dStored, const VecTraits_T<BYTE>* pJournal, bool bShutdown = false );
 	bool LoadMeta ( const CSphString& sMeta, bool bStripPath, FilenameBuilder_i* pFilenameBuilder, StrVec_t& dWarnings );
+	bool LoadQueries ( const CSphString& sQueries );
+	bool SaveQueries ( const SharedPQSlice_t& dStored, const VecTraits_T<BYTE>* pJournal, CSphString& sError ) const;
 	bool LoadMetaLegacy ( const CSphString& sMeta, bool bStripPath, FilenameBuilder_i* pFilenameBuilder, StrVec_t& dWarnings );
 	bool Truncate ( CSphString & ) override EXCLUDES ( m_tLock );
 
@@ -130,7 +140,7 @@ public:
 
 private:
 	static const DWORD				META_HEADER_MAGIC = 0x50535451;	///< magic 'PSTQ' header
-	static const DWORD				META_VERSION = 9;				///< META in json format
+	static const DWORD				META_VERSION = 10;				///< META in json format, v.10 keeps stored queries in .pqs
 
 	int								m_iLockFD = -1;
 	CSphSourceStats					m_tStat;
@@ -147,6 +157,12 @@ private:
 	int64_t							m_iGeneration GUARDED_BY ( m_tLock ) { 0 }; // eliminate ABA race on insert/delete
 	mutable RwLock_t				m_tLock;
 
+	// stored queries file is a snapshot followed by journal of add/delete records; pending records are kept here until flush
+	CSphVector<BYTE>				m_dQueriesJournal GUARDED_BY ( m_tLock );
+	int64_t							m_iJournalOps GUARDED_BY ( m_tLock ) { 0 }; // adds and deletes written since last snapshot
+	bool							m_bQueriesSnapshot GUARDED_BY ( m_tLock ) { true }; // next save must rewrite whole file
+	CSphMutex						m_tSaveLock; // serializes writers of meta and stored queries files
+
 	CSphFixedVector<StoredQueryDesc_t>	m_dLoadedQueries { 0 }; // temporary, just descriptions
 	CSphSchema						m_tMatchSchema;
 	CSphVector<SphWordID_t>			m_dHitlessWords;
@@ -160,6 +176,8 @@ private:
 
 public:
 	PercolateMatchContext_t * CreateMatchContext ( const RtSegment_t * pSeg, const SegmentReject_t &tReject );
+	void SetupCompileContext ( PqCompileContext_t & tCtx ) const;
+	StoredQuery_i * CompileLoadedQuery ( int iQuery, PqCompileContext_t & tCtx );
 
 private:
 	int ReplayInsertAndDeleteQueries ( const VecTraits_T<StoredQuery_i*>& dNewQueries, const VecTraits_T<int64_t>& dDeleteQueries, const VecTraits_T<uint64_t>& dDeleteTags ) EXCLUDES ( m_tLock );
@@ -169,7 +187,10 @@ private:
 
 	StoredQuerySharedPtrVecSharedPtr_t MakeClone () const REQUIRES_SHARED ( m_tLock );
 	void AddToStoredUnl ( StoredQuerySharedPtr_t tNew ) REQUIRES ( m_tLock );
-	void PostSetupUnl () REQUIRES ( m_tLock  );
+	void PostSetupSettings ();
+	CSphFixedVector<StoredQuerySharedPtr_t> CompileLoadedQueries ();
+	void AddLoadedQueriesUnl ( const VecTraits_T<StoredQuerySharedPtr_t> & dCompiled ) REQUIRES ( m_tLock );
+	void JournalQueriesUnl ( const VecTraits_T<StoredQuerySharedPtr_t> & dNewQueries, const VecTraits_T<int64_t> & dDeleteQueries ) REQUIRES ( m_tLock );
 	SharedPQSlice_t GetStored () const EXCLUDES ( m_tLock );
 	SharedPQSlice_t GetStoredUnl () const REQUIRES_SHARED ( m_tLock );
 
@@ -723,8 +744,9 @@ PercolateIndex_c::PercolateIndex_c ( const CSphSchema & tSchema, const char * sI
 
 PercolateIndex_c::~PercolateIndex_c ()
 {
+	// dropped index has its logs forgotten already, and its meta is unlinked below
 	bool bValid = m_pTokenizer && m_pDict;
-	if ( bValid )
+	if ( bValid && !m_bIndexDeleted )
 		SaveMeta ( sphInterrupted() );
 	SafeClose ( m_iLockFD );
 
@@ -733,6 +755,8 @@ PercolateIndex_c::~PercolateIndex_c ()
 		CSphString sFile;
 		sFile.SetSprintf ( "%s.meta", m_sFilename.cstr() );
 		::unlink ( sFile.cstr() );
+		sFile.SetSprintf ( "%s.pqs", m_sFilename.cstr() );
+		::unlink ( sFile.cstr() );
 		sFile.SetSprintf ( "%s%s", m_sFilename.cstr(), sphGetExt ( SPH_EXT_SETTINGS ) );
 		::unlink ( sFile.cstr() );
 	}
@@ -1574,7 +1598,7 @@ void PercolateIndex_c::GetStatus ( CSphIndexStatus * pRes ) const
 
 	CSphString sError;
 	char sFile[SPH_MAX_FILENAME_LEN];
-	const char * sFiles[] = { ".meta", ".ram" };
+	const char * sFiles[] = { ".meta", ".pqs", ".ram" };
 	for ( const char * sName : sFiles )
 	{
 		snprintf ( sFile, sizeof ( sFile ), "%s%s", m_sFilename.cstr (), sName );
@@ -1628,6 +1652,9 @@ void PercolateIndex_c::CollectFiles ( StrVec_t & dFiles, StrVec_t & dExt ) const
 	sPath.SetSprintf ( "%s.meta", m_sFilename.cstr () );
 	if ( sphIsReadable ( sPath ) )
 		dFiles.Add ( sPath );
+	sPath.SetSprintf ( "%s.pqs", m_sFilename.cstr () );
+	if ( sphIsReadable ( sPath ) )
+		dFiles.Add ( sPath );
 }
 
 StoredQuery_i * PercolateIndex_c::CreateQuery ( PercolateQueryArgs_t & tArgs, CSphString & sError )
@@ -1817,7 +1844,7 @@ static void SaveInsertDeleteQueries_T ( const VecTraits_T<QUERY> & dNewQueries,
 		tWriter.ZipOffset ( iQuery );
 
 	tWriter.ZipInt ( dNewQueries.GetLength() );
-	for ( StoredQuery_i* pQuery : dNewQueries )
+	for ( const StoredQueryDesc_t * pQuery : dNewQueries )
 		SaveStoredQuery ( *pQuery, tWriter );
 }
 
@@ -1990,6 +2017,7 @@ int PercolateIndex_c::ReplayInsertAndDeleteQueries ( const VecTraits_T<StoredQue
 		}
 
 		m_tStat.m_iTotalDocuments += iNewInserted - iDeleted;
+		JournalQueriesUnl ( dNewSharedQueries, dAllToDelete );
 		Binlog::Commit ( Binlog::PQ_ADD_DELETE, &m_iTID, m_sIndexName.cstr(), true, [&dNewSharedQueries, dDeleteQueries, dDeleteTags] ( CSphWriter& tWriter ) {
 			SaveInsertDeleteQueries ( dNewSharedQueries, dDeleteQueries, dDeleteTags, tWriter );
 		} );
@@ -1998,6 +2026,213 @@ int PercolateIndex_c::ReplayInsertAndDeleteQueries ( const VecTraits_T<StoredQue
 	}
 }
 
+static const DWORD PQS_HEADER_MAGIC = 0x51535150;	///< magic 'PQSQ' header of stored queries file
+static const DWORD PQS_VERSION = 1;
+
+// record of stored queries file is dword length followed by the same add/delete payload as binlog uses.
+// deletes by tags are already resolved to ids here, so replaying the file doesn't depend on the stored set.
+void PqsAddRecord ( const VecTraits_T<const StoredQueryDesc_t *> & dNewQueries, const VecTraits_T<int64_t> & dDeleteQueries, CSphVector<BYTE> & dRecords )
+{
+	int iLenPos = dRecords.GetLength();
+	dRecords.AddN ( sizeof(DWORD) );
+	SaveInsertDeleteQueries ( dNewQueries, dDeleteQueries, VecTraits_T<uint64_t>(), dRecords );
+	DWORD uLen = dRecords.GetLength() - iLenPos - sizeof(DWORD);
+	memcpy ( dRecords.Begin() + iLenPos, &uLen, sizeof(uLen) );
+}
+
+bool PqsNeedsCompaction ( int64_t iJournalOps, int64_t iStored )
+{
+	return iJournalOps>Max ( iStored, (int64_t)PQS_JOURNAL_MIN_OPS );
+}
+
+bool PqsWriteSnapshot ( const CSphString & sFile, const VecTraits_T<const StoredQueryDesc_t *> & dQueries, CSphString & sError )
+{
+	CSphString sFileNew;
+	sFileNew.SetSprintf ( "%s.new", sFile.cstr() );
+
+	CSphVector<BYTE> dSnapshot;
+	SaveInsertDeleteQueries ( dQueries, VecTraits_T<int64_t>(), VecTraits_T<uint64_t>(), dSnapshot );
+
+	CSphWriter tWriter;
+	if ( !tWriter.OpenFile ( sFileNew, sError ) )
+		return false;
+
+	tWriter.PutDword ( PQS_HEADER_MAGIC );
+	tWriter.PutDword ( PQS_VERSION );
+	tWriter.PutDword ( dSnapshot.GetLength() );
+	tWriter.PutBytes ( dSnapshot.Begin(), dSnapshot.GetLength() );
+	tWriter.CloseFile();
+	if ( tWriter.IsError() )
+		return false;
+
+	if ( sph::rename ( sFileNew.cstr(), sFile.cstr() ) )
+	{
+		sError.SetSprintf ( "failed to rename %s to %s: %s", sFileNew.cstr(), sFile.cstr(), strerrorm ( errno ) );
+		return false;
+	}
+
+	return true;
+}
+
+bool PqsAppendRecords ( const CSphString & sFile, const VecTraits_T<BYTE> & dRecords, CSphString & sError )
+{
+	if ( dRecords.IsEmpty() )
+		return true;
+
+	CSphAutofile tFile ( sFile, SPH_O_APPEND, sError );
+	if ( tFile.GetFD()<0 )
+		return false;
+
+	return sphWriteThrottled ( tFile.GetFD(), dRecords.Begin(), dRecords.GetLength(), sFile.cstr(), sError );
+}
+
+bool PqsLoad ( const CSphString & sFile, CSphVector<StoredQueryDesc_t> & dQueries, int64_t & iJournalOps, bool & bTorn, CSphString & sError )
+{
+	CSphAutoreader tReader;
+	if ( !tReader.Open ( sFile, sError ) )
+		return false;
+
+	if ( tReader.GetDword()!=PQS_HEADER_MAGIC )
+	{
+		sError.SetSprintf ( "invalid stored queries file %s", sFile.cstr() );
+		return false;
+	}
+
+	DWORD uVersion = tReader.GetDword();
+	if ( uVersion==0 || uVersion>PQS_VERSION )
+	{
+		sError.SetSprintf ( "%s is v.%u, binary is v.%u", sFile.cstr(), uVersion, PQS_VERSION );
+		return false;
+	}
+
+	SphOffset_t iFileSize = tReader.GetFilesize();
+	OpenHash_T<int, int64_t, HashFunc_Int64_t> hQueries;
+	CSphVector<BYTE> dRecord;
+	CSphVector<StoredQueryDesc_t> dNewQueries;
+	CSphVector<int64_t> dDeleteQueries;
+	CSphVector<uint64_t> dDeleteTags;
+	bool bSnapshot = true;
+	dQueries.Reset();
+	iJournalOps = 0;
+	bTorn = false;
+
+	// first record is a snapshot, the rest are adds and deletes made since it
+	while ( tReader.GetPos()<iFileSize )
+	{
+		DWORD uLen = 0;
+		if ( tReader.GetPos() + (SphOffset_t)sizeof(uLen)<=iFileSize )
+			uLen = tReader.GetDword();
+
+		if ( !uLen || tReader.GetPos() + uLen>iFileSize )
+		{
+			bTorn = true;
+			break;
+		}
+
+		dRecord.Resize ( uLen );
+		tReader.GetBytes ( dRecord.Begin(), uLen );
+		if ( tReader.GetErrorFlag() )
+		{
+			sError = tReader.GetErrorMessage();
+			return false;
+		}
+
+		LoadInsertDeleteQueries ( dRecord.Begin(), uLen, dNewQueries, dDeleteQueries, dDeleteTags );
+		for ( int64_t iQUID : dDeleteQueries )
+		{
+			auto * pIdx = hQueries.Find ( iQUID );
+			if ( !pIdx )
+				continue;
+
+			int iIdx = *pIdx;
+			hQueries.Delete ( iQUID );
+			if ( iQUID!=dQueries.Last().m_iQUID )
+				*hQueries.Find ( dQueries.Last().m_iQUID ) = iIdx; // fixup to removeFast
+			dQueries.RemoveFast ( iIdx );
+		}
+
+		for ( auto & tQuery : dNewQueries )
+		{
+			auto * pIdx = hQueries.Find ( tQuery.m_iQUID );
+			if ( pIdx )
+				dQueries[*pIdx] = std::move ( tQuery );
+			else
+			{
+				hQueries.Add ( tQuery.m_iQUID, dQueries.GetLength() );
+				dQueries.Add ( std::move ( tQuery ) );
+			}
+		}
+
+		if ( !bSnapshot )
+			iJournalOps += dNewQueries.GetLength() + dDeleteQueries.GetLength();
+		bSnapshot = false;
+	}
+
+	// snapshot record is never empty, so the file without one got cut as well
+	bTorn |= bSnapshot;
+	return true;
+}
+
+void PercolateIndex_c::JournalQueriesUnl ( const VecTraits_T<StoredQuerySharedPtr_t> & dNewQueries, const VecTraits_T<int64_t> & dDeleteQueries ) REQUIRES ( m_tLock )
+{
+	if ( m_bQueriesSnapshot )
+		return; // whole set will be written on next save anyway
+
+	m_iJournalOps += dNewQueries.GetLength() + dDeleteQueries.GetLength();
+	if ( PqsNeedsCompaction ( m_iJournalOps, m_pQueries->GetLength() ) )
+	{
+		// journal outgrew the stored set; compact it on next save
+		m_dQueriesJournal.Reset();
+		m_bQueriesSnapshot = true;
+		return;
+	}
+
+	CSphVector<const StoredQueryDesc_t *> dNew;
+	dNew.Reserve ( dNewQueries.GetLength() );
+	for ( const StoredQueryDesc_t * pQuery : dNewQueries )
+		dNew.Add ( pQuery );
+
+	PqsAddRecord ( dNew, dDeleteQueries, m_dQueriesJournal );
+}
+
+bool PercolateIndex_c::SaveQueries ( const SharedPQSlice_t& dStored, const VecTraits_T<BYTE>* pJournal, CSphString& sError ) const
+{
+	CSphString sQueries;
+	sQueries.SetSprintf ( "%s.pqs", m_sFilename.cstr() );
+
+	if ( pJournal )
+		return PqsAppendRecords ( sQueries, *pJournal, sError );
+
+	CSphVector<const StoredQueryDesc_t *> dQueries;
+	dQueries.Reserve ( dStored.GetLength() );
+	for ( const StoredQueryDesc_t * pQuery : dStored )
+		dQueries.Add ( pQuery );
+
+	return PqsWriteSnapshot ( sQueries, dQueries, sError );
+}
+
+bool PercolateIndex_c::LoadQueries ( const CSphString& sQueries )
+{
+	CSphVector<StoredQueryDesc_t> dQueries;
+	int64_t iJournalOps = 0;
+	bool bTorn = false;
+	if ( !PqsLoad ( sQueries, dQueries, iJournalOps, bTorn, m_sLastError ) )
+		return false;
+
+	// tail left by interrupted append; its txns are still in binlog, as meta wasn't saved after it
+	if ( bTorn )
+		sphWarning ( "index '%s': %s has truncated tail, ignoring it", m_sIndexName.cstr(), sQueries.cstr() );
+
+	m_dLoadedQueries.Reset ( dQueries.GetLength() );
+	ARRAY_FOREACH ( i, dQueries )
+		m_dLoadedQueries[i] = std::move ( dQueries[i] );
+
+	ScWL_t wLock ( m_tLock );
+	m_iJournalOps = iJournalOps;
+	m_bQueriesSnapshot = bTorn;
+	return true;
+}
+
 bool PercolateIndex_c::Commit ( int * pDeleted, RtAccum_t * pAccExt )
 {
 	assert ( g_bRTChangesAllowed );
@@ -2358,7 +2593,7 @@ bool PercolateIndex_c::MultiQuery ( CSphQueryResult & tResult, const CSphQuery &
 	return false;
 }
 
-void PercolateIndex_c::PostSetupUnl()
+void PercolateIndex_c::PostSetupSettings()
 {
 	PercolateIndex_i::PostSetup();
 	m_iMaxCodepointLength = m_pTokenizer->GetMaxCodepointLength();
@@ -2389,20 +2624,6 @@ void PercolateIndex_c::PostSetupUnl()
 		( !m_tSettings.m_sZones.IsEmpty () && !m_pTokenizerIndexing->EnableZoneIndexing ( m_sLastError )) )
 		m_pTokenizerIndexing = nullptr;
 
-	bool bWordDict = m_pDict->GetSettings().m_bWordDict;
-
-	// create queries
-	TokenizerRefPtr_c pTokenizer { sphCloneAndSetupQueryTokenizer ( m_pTokenizer, IsStarDict ( bWordDict ), m_tSettings.m_bIndexExactWords, false ) };
-	TokenizerRefPtr_c pTokenizerJson { sphCloneAndSetupQueryTokenizer ( m_pTokenizer, IsStarDict ( bWordDict ), m_tSettings.m_bIndexExactWords, true ) };
-
-	DictRefPtr_c pDict { GetStatelessDict ( m_pDict ) };
-
-	if ( IsStarDict ( bWordDict ) )
-		SetupStarDict ( pDict );
-
-	if ( m_tSettings.m_bIndexExactWords )
-		SetupExactDict ( pDict );
-
 	CSphString sHitlessFiles = m_tSettings.m_sHitlessFiles.cstr();
 	if ( GetIndexFilenameBuilder() )
 	{
@@ -2414,41 +2635,142 @@ void PercolateIndex_c::PostSetupUnl()
 	// hitless
 	if ( !LoadHitlessWords ( sHitlessFiles, m_pTokenizerIndexing, m_pDict, m_dHitlessWords, m_sLastError ) )
 		sphWarning ( "index '%s': %s", m_sIndexName.cstr(), m_sLastError.cstr() );
+}
+
+void PercolateIndex_c::SetupCompileContext ( PqCompileContext_t & tCtx ) const
+{
+	bool bWordDict = m_pDict->GetSettings().m_bWordDict;
+	tCtx.m_pTokenizer = sphCloneAndSetupQueryTokenizer ( m_pTokenizer, IsStarDict ( bWordDict ), m_tSettings.m_bIndexExactWords, false );
+	tCtx.m_pTokenizerJson = sphCloneAndSetupQueryTokenizer ( m_pTokenizer, IsStarDict ( bWordDict ), m_tSettings.m_bIndexExactWords, true );
+	tCtx.m_pDict = GetStatelessDict ( m_pDict );
+
+	if ( IsStarDict ( bWordDict ) )
+		SetupStarDict ( tCtx.m_pDict );
 
-	m_pQueries->ReserveGap( m_dLoadedQueries.GetLength () );
+	if ( m_tSettings.m_bIndexExactWords )
+		SetupExactDict ( tCtx.m_pDict );
+}
+
+StoredQuery_i * PercolateIndex_c::CompileLoadedQuery ( int iQuery, PqCompileContext_t & tCtx )
+{
+	const StoredQueryDesc_t & tQuery = m_dLoadedQueries[iQuery];
+	const ISphTokenizer * pTok = tQuery.m_bQL ? tCtx.m_pTokenizer : tCtx.m_pTokenizerJson;
+	PercolateQueryArgs_t tArgs ( tQuery );
 
 	CSphString sError;
-	ARRAY_FOREACH ( i, m_dLoadedQueries )
+	auto * pQuery = CreateQuery ( tArgs, pTok, tCtx.m_pDict, sError );
+	if ( !pQuery )
+		sphWarning ( "index '%s': %d (id=" INT64_FMT ") query failed to load: %s", m_sIndexName.cstr(), iQuery, tQuery.m_iQUID, sError.cstr() );
+	return pQuery;
+}
+
+struct PqCompileContextRef_t
+{
+	PercolateIndex_c * m_pIndex;
+	PqCompileContext_t m_tCtx;
+
+	explicit PqCompileContextRef_t ( PercolateIndex_c * pIndex )
+		: m_pIndex ( pIndex )
+	{
+		m_pIndex->SetupCompileContext ( m_tCtx );
+	}
+
+	inline static bool IsClonable ()
+	{
+		return true;
+	}
+};
+
+struct PqCompileContextClone_t : public PqCompileContextRef_t, ISphNoncopyable
+{
+	explicit PqCompileContextClone_t ( const PqCompileContextRef_t & dParent )
+		: PqCompileContextRef_t ( dParent.m_pIndex )
+	{}
+};
+
+// parse and compile loaded descriptions; that is the heaviest part of the load, so spread it over workers.
+// result keeps order of m_dLoadedQueries, failed queries are left empty.
+CSphFixedVector<StoredQuerySharedPtr_t> PercolateIndex_c::CompileLoadedQueries ()
+{
+	int iJobs = m_dLoadedQueries.GetLength();
+	CSphFixedVector<StoredQuerySharedPtr_t> dCompiled ( iJobs );
+	if ( !iJobs )
+		return dCompiled;
+
+	// tools might load index outside of any scheduler
+	if ( !Threads::IsInsideCoroutine() )
+	{
+		PqCompileContextRef_t tCtx ( this );
+		ARRAY_FOREACH ( i, dCompiled )
+			dCompiled[i] = (StoredQuery_t *) CompileLoadedQuery ( i, tCtx.m_tCtx );
+		return dCompiled;
+	}
+
+	ClonableCtx_T<PqCompileContextRef_t, PqCompileContextClone_t> dCtx { this };
+	dCtx.LimitConcurrency ( GetEffectiveDistThreads () );
+
+	std::atomic<int32_t> iCurJob { 0 };
+	Coro::ExecuteN ( dCtx.Concurrency ( iJobs ), [&]
 	{
-		const StoredQueryDesc_t & tQuery = m_dLoadedQueries[i];
-		const ISphTokenizer * pTok = tQuery.m_bQL ? pTokenizer : pTokenizerJson;
-		PercolateQueryArgs_t tArgs ( tQuery );
-		if ( CanBeAdded ( tArgs, sError ) )
+		auto iJob = iCurJob.fetch_add ( 1, std::memory_order_acq_rel );
+		if ( iJob>=iJobs )
+			return; // already nothing to do, early finish.
+
+		auto tCtx = dCtx.CloneNewContext ();
+		Threads::Coro::Throttler_c tThrottler ( session::GetThrottlingPeriodMS () );
+		while ( true )
 		{
-			auto* pQuery = CreateQuery ( tArgs, pTok, pDict, sError );
-			if ( pQuery )
-			{
-				// as a new (not replace), query it will be anyway added to the tail.
-				// so, we may reserve ref in the hash, and then occupy it with the query.
-				assert ( !tArgs.m_bReplace );
-				AddToStoredUnl ( StoredQuerySharedPtr_t ((StoredQuery_t *) pQuery ));
-				continue;
-			}
+			dCompiled[iJob] = (StoredQuery_t *) CompileLoadedQuery ( iJob, tCtx.m_tCtx );
+
+			iJob = iCurJob.fetch_add ( 1, std::memory_order_acq_rel );
+			if ( iJob>=iJobs )
+				return;
+
+			tThrottler.ThrottleAndKeepCrashQuery ();
 		}
-		sphWarning ( "index '%s': %d (id=" INT64_FMT ") query failed to load, ignoring", m_sIndexName.cstr(), i, tQuery.m_iQUID );
-	}
-	m_dLoadedQueries.Reset ( 0 );
+	});
 
-	// still need index files for index just created from config
-	if ( !m_bHasFiles )
-		SaveMeta ( SharedPQSlice_t ( m_pQueries ) );
+	return dCompiled;
+}
+
+void PercolateIndex_c::AddLoadedQueriesUnl ( const VecTraits_T<StoredQuerySharedPtr_t> & dCompiled ) REQUIRES ( m_tLock )
+{
+	m_pQueries->ReserveGap ( dCompiled.GetLength () );
+
+	CSphString sError;
+	for ( const auto & pQuery : dCompiled )
+	{
+		if ( !pQuery )
+			continue;
+
+		PercolateQueryArgs_t tArgs ( *pQuery );
+		if ( !CanBeAdded ( tArgs, sError ) )
+		{
+			sphWarning ( "index '%s': (id=" INT64_FMT ") query failed to load, ignoring", m_sIndexName.cstr(), pQuery->m_iQUID );
+			continue;
+		}
 
+		// as a new (not replace), query it will be anyway added to the tail.
+		assert ( !tArgs.m_bReplace );
+		pQuery->m_iQUID = tArgs.m_iQUID;
+		AddToStoredUnl ( pQuery );
+	}
 }
 
 void PercolateIndex_c::PostSetup () EXCLUDES ( m_tLock )
 {
-	ScWL_t wLock ( m_tLock );
-	PostSetupUnl();
+	PostSetupSettings();
+	auto dCompiled = CompileLoadedQueries();
+	m_dLoadedQueries.Reset ( 0 );
+
+	{
+		ScWL_t wLock ( m_tLock );
+		AddLoadedQueriesUnl ( dCompiled );
+	}
+
+	// still need index files for index just created from config
+	if ( !m_bHasFiles )
+		SaveMeta();
 }
 
 // load old-style (legacy) binary meta
@@ -2659,7 +2981,13 @@ bool PercolateIndex_c::LoadMeta ( const CSphString& sMeta, bool bStripPath, File
 
 	// queries
 	auto tQueriesNode = tBson.ChildByName ( "pqs" );
-	if ( !IsNullNode( tQueriesNode) )
+	if ( uVersion>=10 )
+	{
+		CSphString sQueries;
+		sQueries.SetSprintf ( "%s.pqs", m_sFilename.cstr() );
+		if ( !LoadQueries ( sQueries ) )
+			return false;
+	} else if ( !IsNullNode( tQueriesNode) )
 	{
 		Bson_c tQueriesVec { tQueriesNode };
 		m_dLoadedQueries.Reset ( tQueriesVec.CountValues() );
@@ -2715,11 +3043,12 @@ bool PercolateIndex_c::Prealloc ( bool bStripPath, FilenameBuilder_i * pFilename
 
 void operator<< ( JsonEscapedBuilder& tOut, const StoredQueryDesc_t& tQuery );
 
-void PercolateIndex_c::SaveMeta ( const SharedPQSlice_t& dStored, bool bShutdown )
+// pJournal is pending records to append to stored queries file; without it whole dStored is written as new snapshot
+bool PercolateIndex_c::SaveMeta ( const SharedPQSlice_t& dStored, const VecTraits_T<BYTE>* pJournal, bool bShutdown )
 {
 	// sanity check
 	if ( m_iLockFD<0 || m_bSaveDisabled )
-		return;
+		return false;
 
 	// write new meta
 	CSphString sMeta, sMetaNew;
@@ -2727,6 +3056,12 @@ void PercolateIndex_c::SaveMeta ( const SharedPQSlice_t& dStored, bool bShutdown
 	sMetaNew.SetSprintf ( "%s.meta.new", m_sFilename.cstr() );
 
 	CSphString sError;
+	if ( !SaveQueries ( dStored, pJournal, sError ) )
+	{
+		sphWarning ( "index '%s': failed to save stored queries: %s", m_sIndexName.cstr(), sError.cstr() );
+		return false;
+	}
+
 	JsonEscapedBuilder sNewMeta;
 	sNewMeta.ObjectWBlock();
 
@@ -2749,13 +3084,6 @@ void PercolateIndex_c::SaveMeta ( const SharedPQSlice_t& dStored, bool bShutdown
 	sNewMeta.NamedVal ( "field_filter_settings", tFieldFilterSettings );
 	sNewMeta.NamedVal ( "tid", m_iTID );
 
-	{
-		sNewMeta.Named ( "pqs" );
-		auto _ = sNewMeta.ArrayW();
-		for ( const StoredQuery_t * pQuery : dStored )
-			sNewMeta << *pQuery;
-	}
-
 	Binlog::NotifyIndexFlush ( m_sIndexName.cstr(), m_iTID, bShutdown );
 
 	m_iSavedTID = m_iTID;
@@ -2770,7 +3098,7 @@ void PercolateIndex_c::SaveMeta ( const SharedPQSlice_t& dStored, bool bShutdown
 		assert ( bson::ValidateJson ( sNewMeta.cstr(), &sError ) );
 	} else {
 		sphWarning ( "failed to serialize meta: %s", sError.cstr() );
-		return;
+		return true; // stored queries are already on disk
 	}
 
 	// rename
@@ -2778,25 +3106,52 @@ void PercolateIndex_c::SaveMeta ( const SharedPQSlice_t& dStored, bool bShutdown
 		sphWarning ( "failed to rename meta (src=%s, dst=%s, errno=%d, error=%s)", sMetaNew.cstr(), sMeta.cstr(), errno, strerrorm( errno ) );
 
 	SaveMutableSettings ( m_tMutableSettings, m_sFilename );
+	return true;
 }
 
 
 void PercolateIndex_c::SaveMeta ( bool bShutdown )
 {
-	SaveMeta ( GetStored(), bShutdown );
+	if ( m_iLockFD<0 || m_bSaveDisabled )
+		return;
+
+	ScopedMutex_t tSaveLock ( m_tSaveLock );
+	SharedPQSlice_t dStored;
+	CSphVector<BYTE> dJournal;
+	bool bSnapshot;
+	{
+		ScWL_t wLock ( m_tLock );
+		dStored = GetStoredUnl();
+		bSnapshot = m_bQueriesSnapshot;
+		dJournal.SwapData ( m_dQueriesJournal );
+		m_bQueriesSnapshot = false;
+		if ( bSnapshot )
+			m_iJournalOps = 0;
+	}
+
+	if ( SaveMeta ( dStored, bSnapshot ? nullptr : &dJournal, bShutdown ) )
+		return;
+
+	// journal is lost now, so stored queries file has to be rewritten completely
+	ScWL_t wLock ( m_tLock );
+	m_dQueriesJournal.Reset();
+	m_bQueriesSnapshot = true;
 }
 
 bool PercolateIndex_c::Truncate ( CSphString & sError )
 {
+	ScopedMutex_t tSaveLock ( m_tSaveLock );
 	ScWL_t wLock ( m_tLock );
 
 	m_hQueries.Reset ( 256 );
 	m_pQueries = new CSphVector<StoredQuerySharedPtr_t>;
+	m_dQueriesJournal.Reset();
+	m_iJournalOps = 0;
 
 	// update and save meta
 	// current TID will be saved, so replay will properly skip preceding txns
 	// FIXME!!! however it should be replicated to cluster maybe with TOI
-	SaveMeta ( SharedPQSlice_t ( m_pQueries ) );
+	m_bQueriesSnapshot = !SaveMeta ( SharedPQSlice_t ( m_pQueries ), nullptr );
 
 	return true;
 }
@@ -2910,26 +3265,32 @@ bool PercolateIndex_c::Reconfigure ( CSphReconfigureSetup & tSetup )
 	m_iMaxCodepointLength = m_pTokenizer->GetMaxCodepointLength();
 	SetupQueryTokenizer();
 
-	ScWL_t wLock ( m_tLock ); // ensure nothing will be changed during reconfigure pass.
-
-	m_dLoadedQueries.Reset ( m_pQueries->GetLength() );
-	ARRAY_FOREACH ( i, m_dLoadedQueries )
+	// index is write-locked by daemon for reconfigure, so stored set may not change until we're done
 	{
-		StoredQueryDesc_t & tQuery = m_dLoadedQueries[i];
-		const StoredQuery_t * pStored = (*m_pQueries) [i];
-
-		tQuery.m_iQUID = pStored->m_iQUID;
-		tQuery.m_sQuery = pStored->m_sQuery;
-		tQuery.m_sTags = pStored->m_sTags;
-		tQuery.m_dFilters = pStored->m_dFilters;
-		tQuery.m_dFilterTree = pStored->m_dFilterTree;
+		ScRL_t rLock ( m_tLock );
+		m_dLoadedQueries.Reset ( m_pQueries->GetLength() );
+		ARRAY_FOREACH ( i, m_dLoadedQueries )
+		{
+			StoredQueryDesc_t & tQuery = m_dLoadedQueries[i];
+			const StoredQuery_t * pStored = (*m_pQueries) [i];
+
+			tQuery.m_iQUID = pStored->m_iQUID;
+			tQuery.m_sQuery = pStored->m_sQuery;
+			tQuery.m_sTags = pStored->m_sTags;
+			tQuery.m_dFilters = pStored->m_dFilters;
+			tQuery.m_dFilterTree = pStored->m_dFilterTree;
+			tQuery.m_bQL = pStored->m_bQL;
+		}
 	}
 
+	PostSetupSettings();
+	auto dCompiled = CompileLoadedQueries();
+	m_dLoadedQueries.Reset ( 0 );
+
+	ScWL_t wLock ( m_tLock );
 	m_pQueries = new CSphVector<StoredQuerySharedPtr_t>;
 	m_hQueries.Clear();
-
-	// note: m_tLockHash and m_tLock is still held here.
-	PostSetupUnl();
+	AddLoadedQueriesUnl ( dCompiled );
 	return true;
 }
 
@@ -3165,6 +3526,8 @@ void PercolateIndex_c::GetIndexFiles ( CSphVector<CSphString> & dFiles, const Fi
 {
 	CSphString & sMeta = dFiles.Add();
 	sMeta.SetSprintf ( "%s.meta", m_sFilename.cstr() );
+	CSphString & sQueries = dFiles.Add();
+	sQueries.SetSprintf ( "%s.pqs", m_sFilename.cstr() );
 
 	CSphScopedPtr<const FilenameBuilder_i> pFilenameBuilder ( nullptr );
 	if ( !pParentBuilder && GetIndexFilenameBuilder() )
@@ -116,6 +116,15 @@ void LoadDeleteQuery ( CSphVector<int64_t> & dQueries, CSphString & sTags, CSphR
 void SaveDeleteQuery ( const VecTraits_T<int64_t>& dQueries, const char * sTags, CSphVector<BYTE> & dOut );
 void SaveDeleteQuery ( const VecTraits_T<int64_t>& dQueries, const char * sTags, CSphWriter & tWriter );
 
+// stored queries file (.pqs) is a snapshot record followed by records of adds and deletes made since it
+static const int PQS_JOURNAL_MIN_OPS = 1024;	///< don't compact stored queries file while journal is small
+
+void PqsAddRecord ( const VecTraits_T<const StoredQueryDesc_t *> & dNewQueries, const VecTraits_T<int64_t> & dDeleteQueries, CSphVector<BYTE> & dRecords );
+bool PqsNeedsCompaction ( int64_t iJournalOps, int64_t iStored );
+bool PqsWriteSnapshot ( const CSphString & sFile, const VecTraits_T<const StoredQueryDesc_t *> & dQueries, CSphString & sError );
+bool PqsAppendRecords ( const CSphString & sFile, const VecTraits_T<BYTE> & dRecords, CSphString & sError );
+bool PqsLoad ( const CSphString & sFile, CSphVector<StoredQueryDesc_t> & dQueries, int64_t & iJournalOps, bool & bTorn, CSphString & sError );
+
 //////////////////////////////////////////////////////////////////////////
 
 struct DictTerm_t
@@ -14,6 +14,8 @@
 #include "exprtraits.h"
 #include "mini_timer.h"
 
+#include <atomic>
+
 //////////////////////////////////////////////////////////////////////////
 // QUERY CACHE
 //////////////////////////////////////////////////////////////////////////
@@ -26,30 +28,69 @@
 #define QCACHE_NO_ENTRY			(NULL)
 #define QCACHE_DEAD_ENTRY		((QcacheEntry_c*)-1)
 
+/// one shard of query cache, with its own lock and hash
+/// entries with the same key but different filters may coexist, so that is a plain open addressing table
+class QcacheShard_c
+{
+public:
+								QcacheShard_c();
+								~QcacheShard_c();
+
+	void						Add ( QcacheEntry_c * pEntry, double fInflation ) EXCLUDES ( m_tLock );
+	QcacheEntry_c *				Find ( uint64_t uKey, int64_t tmMin, const CSphQuery & q, const ISphSchema & tSorterSchema, double fInflation ) EXCLUDES ( m_tLock );
+	bool						GetMinPriority ( double & fPriority ) EXCLUDES ( m_tLock );
+	bool						EvictOne ( double & fPriority ) EXCLUDES ( m_tLock );
+	void						Sweep ( int64_t tmMin, int iThreshMs ) EXCLUDES ( m_tLock );
+	void						DeleteIndex ( int64_t iIndexId ) EXCLUDES ( m_tLock );
+
+	int							GetCachedQueries() const { return m_iCachedQueries.load ( std::memory_order_relaxed ); }
+	int64_t						GetUsedBytes() const { return m_iUsedBytes.load ( std::memory_order_relaxed ); }
+
+private:
+	CSphMutex					m_tLock;					///< shard lock
+	CSphVector<QcacheEntry_c*>	m_hData GUARDED_BY ( m_tLock );	///< our little queries hash
+	int							m_iMaxQueries GUARDED_BY ( m_tLock );	///< max load
+	CSphVector<QcacheEntry_c*>	m_dHeap GUARDED_BY ( m_tLock );	///< binary min-heap by priority; entries know their positions
+	std::atomic<int>			m_iCachedQueries { 0 };
+	std::atomic<int64_t>		m_iUsedBytes { 0 };
+
+	bool						IsValidEntry ( int i ) const REQUIRES ( m_tLock ) { return m_hData[i]!=QCACHE_NO_ENTRY && m_hData[i]!=QCACHE_DEAD_ENTRY; }
+	void						Rehash ( int iSize ) REQUIRES ( m_tLock );
+	void						Touch ( QcacheEntry_c * pEntry, double fInflation ) REQUIRES ( m_tLock );
+	int							FindSlot ( const QcacheEntry_c * pEntry ) const REQUIRES ( m_tLock );
+	void						DeleteEntry ( int iEntry ) REQUIRES ( m_tLock );
+
+	void						HeapSet ( int iIdx, QcacheEntry_c * pEntry ) REQUIRES ( m_tLock );
+	void						HeapSiftUp ( int iIdx ) REQUIRES ( m_tLock );
+	void						HeapSiftDown ( int iIdx ) REQUIRES ( m_tLock );
+	void						HeapRemove ( QcacheEntry_c * pEntry ) REQUIRES ( m_tLock );
+};
+
 /// query cache
 class Qcache_c : public QcacheStatus_t
 {
 private:
-	CSphMutex					m_tLock;			///< hash lock
-	CSphVector<QcacheEntry_c*>	m_hData;			///< our little queries hash
-	int							m_iMaxQueries;		///< max load
-	int							m_iMruHead;			///< most recently used entry
+	static const int			SHARDS = 16;		///< power of 2; shard is picked by high bits of the key
+	QcacheShard_c				m_dShards[SHARDS];
+	std::atomic<int64_t>		m_iHitsCount { 0 };
+	std::atomic<double>			m_fInflation { 0.0 };	///< GDSF clock, priority of the last evicted entry; common for all shards, so that priorities compare
 
 public:
 								Qcache_c();
-								~Qcache_c();
 
 	void						Setup ( int64_t iMaxBytes, int iThreshMsec, int iTtlSec );
 	void						Add ( const CSphQuery & q, QcacheEntry_c * pResult, const ISphSchema & tSorterSchema );
 	QcacheEntry_c *				Find ( int64_t iIndexId, const CSphQuery & q, const ISphSchema & tSorterSchema );
-	void						DeleteIndex ( int64_t iIndexId ) EXCLUDES ( m_tLock );
+	void						DeleteIndex ( int64_t iIndexId );
+	void						Sweep();
+	QcacheStatus_t				GetStatus() const;
 
 private:
 	static uint64_t				GetKey ( int64_t iIndexId, const CSphQuery & q );
-	bool						IsValidEntry ( int i ) { return m_hData[i]!=QCACHE_NO_ENTRY && m_hData[i]!=QCACHE_DEAD_ENTRY; }
-	void						EnforceLimits ( bool bSizeOnly ) EXCLUDES ( m_tLock );
-	void						MruToHead ( int iRes );
-	void						DeleteEntry ( int iEntry );
+	QcacheShard_c &				GetShard ( uint64_t uKey ) { return m_dShards [ ( uKey>>32 ) & ( SHARDS-1 ) ]; }
+	int64_t						GetUsedBytes() const;
+	void						EnforceLimits();
+	void						Inflate ( double fPriority );
 	bool						CanCacheQuery ( const CSphQuery & q ) const;
 };
 
@@ -247,28 +288,24 @@ void QcacheEntry_c::Finish()
 
 //////////////////////////////////////////////////////////////////////////
 
-Qcache_c::Qcache_c()
-{
-	// defaults are here
-	m_iMaxBytes = 16777216;
-#ifndef NDEBUG
-	m_iMaxBytes = 0; // disable qcache in debug builds
-#endif
+static bool CalcFilterHashes ( CSphVector<uint64_t> & dFilters, const CSphQuery & q, const ISphSchema & tSorterSchema );
 
-	m_iThreshMs = 3000;
-	m_iTtlS = 60;
+// GreedyDual-Size-Frequency: entries that took long to compute, got hit often and are small stay longest
+static inline double QcachePriority ( double fInflation, const QcacheEntry_c * pEntry )
+{
+	return fInflation + double ( pEntry->m_iFrequency ) * Max ( pEntry->m_iElapsedMsec, 1 ) / pEntry->GetSize();
+}
 
-	m_iCachedQueries = 0;
-	m_iUsedBytes = 0;
-	m_iHits = 0;
-	m_iMruHead = -1;
 
-	m_hData.Resize ( 256 );
+QcacheShard_c::QcacheShard_c()
+{
+	ScopedMutex_t dLock ( m_tLock );
+	m_hData.Resize ( 16 );
 	m_hData.Fill ( QCACHE_NO_ENTRY );
 	m_iMaxQueries = (int)( m_hData.GetLength()*0.7f );
 }
 
-Qcache_c::~Qcache_c()
+QcacheShard_c::~QcacheShard_c()
 {
 	ScopedMutex_t dLock ( m_tLock );
 	ARRAY_FOREACH ( i, m_hData )
@@ -276,40 +313,284 @@ Qcache_c::~Qcache_c()
 			SafeRelease ( m_hData[i] );
 }
 
-void Qcache_c::Setup ( int64_t iMaxBytes, int iThreshMsec, int iTtlSec )
+void QcacheShard_c::Rehash ( int iSize )
 {
-	m_iMaxBytes = Max ( iMaxBytes, 0 );
-	m_iThreshMs = Max ( iThreshMsec, 0 );
-	m_iTtlS = Max ( iTtlSec, 1 );
-	EnforceLimits ( false );
+	CSphVector<QcacheEntry_c*> hNew ( iSize );
+	hNew.Fill ( QCACHE_NO_ENTRY );
+
+	int iLenMask = hNew.GetLength() - 1;
+	ARRAY_FOREACH ( i, m_hData )
+		if ( IsValidEntry(i) )
+		{
+			int j = m_hData[i]->m_Key & iLenMask;
+			while ( hNew[j]!=QCACHE_NO_ENTRY )
+				j = ( j+1 ) & iLenMask;
+			hNew[j] = m_hData[i];
+		}
+
+	m_hData.SwapData ( hNew );
+	m_iMaxQueries = (int)( m_hData.GetLength()*0.7f );
+}
+
+void QcacheShard_c::HeapSet ( int iIdx, QcacheEntry_c * pEntry )
+{
+	m_dHeap[iIdx] = pEntry;
+	pEntry->m_iHeapIdx = iIdx;
 }
 
-void Qcache_c::MruToHead ( int iRes )
+void QcacheShard_c::HeapSiftUp ( int iIdx )
 {
-	// already the head? nothing to do
-	if ( iRes==m_iMruHead )
+	QcacheEntry_c * pEntry = m_dHeap[iIdx];
+	while ( iIdx>0 )
+	{
+		int iParent = ( iIdx-1 )/2;
+		if ( m_dHeap[iParent]->m_fPriority<=pEntry->m_fPriority )
+			break;
+
+		HeapSet ( iIdx, m_dHeap[iParent] );
+		iIdx = iParent;
+	}
+	HeapSet ( iIdx, pEntry );
+}
+
+void QcacheShard_c::HeapSiftDown ( int iIdx )
+{
+	QcacheEntry_c * pEntry = m_dHeap[iIdx];
+	int iLen = m_dHeap.GetLength();
+	while ( true )
+	{
+		int iChild = iIdx*2+1;
+		if ( iChild>=iLen )
+			break;
+
+		if ( iChild+1<iLen && m_dHeap[iChild+1]->m_fPriority < m_dHeap[iChild]->m_fPriority )
+			++iChild;
+
+		if ( pEntry->m_fPriority<=m_dHeap[iChild]->m_fPriority )
+			break;
+
+		HeapSet ( iIdx, m_dHeap[iChild] );
+		iIdx = iChild;
+	}
+	HeapSet ( iIdx, pEntry );
+}
+
+void QcacheShard_c::HeapRemove ( QcacheEntry_c * pEntry )
+{
+	int iIdx = pEntry->m_iHeapIdx;
+	assert ( iIdx>=0 && iIdx<m_dHeap.GetLength() && m_dHeap[iIdx]==pEntry );
+	pEntry->m_iHeapIdx = -1;
+
+	QcacheEntry_c * pLast = m_dHeap.Pop();
+	if ( pLast==pEntry )
 		return;
 
-	// detach from previous node, prev.next = my.next
-	QcacheEntry_c * p = m_hData[iRes];
-	if ( p->m_iMruPrev>=0 )
-		m_hData [ p->m_iMruPrev ]->m_iMruNext = p->m_iMruNext;
+	HeapSet ( iIdx, pLast );
+	HeapSiftUp ( iIdx );
+	HeapSiftDown ( pLast->m_iHeapIdx );
+}
+
+void QcacheShard_c::Touch ( QcacheEntry_c * pEntry, double fInflation )
+{
+	++pEntry->m_iFrequency;
+	pEntry->m_fPriority = QcachePriority ( fInflation, pEntry );
+
+	if ( pEntry->m_iHeapIdx<0 )
+	{
+		m_dHeap.Add ( pEntry );
+		HeapSiftUp ( m_dHeap.GetLength()-1 );
+	} else // priority only grows, as clock and frequency do
+		HeapSiftDown ( pEntry->m_iHeapIdx );
+}
+
+void QcacheShard_c::Add ( QcacheEntry_c * pEntry, double fInflation )
+{
+	ScopedMutex_t dLock ( m_tLock );
+
+	// rehash if needed
+	if ( GetCachedQueries()>=m_iMaxQueries )
+		Rehash ( 2*m_hData.GetLength() );
+
+	// add entry
+	int iLenMask = m_hData.GetLength() - 1;
+	int j = pEntry->m_Key & iLenMask;
+	while ( IsValidEntry(j) )
+		j = ( j+1 ) & iLenMask;
+	m_hData[j] = pEntry;
+
+	pEntry->m_iFrequency = 0;
+	pEntry->m_iHeapIdx = -1;
+	Touch ( pEntry, fInflation );
+
+	m_iCachedQueries.fetch_add ( 1, std::memory_order_relaxed );
+	m_iUsedBytes.fetch_add ( pEntry->GetSize(), std::memory_order_relaxed );
+}
 
-	// detach from next node, next.prev = my.prev
-	if ( p->m_iMruNext>=0 )
-		m_hData [ p->m_iMruNext ]->m_iMruPrev = p->m_iMruPrev;
+QcacheEntry_c * QcacheShard_c::Find ( uint64_t uKey, int64_t tmMin, const CSphQuery & q, const ISphSchema & tSorterSchema, double fInflation )
+{
+	bool bFilterHashesCalculated = false;
+	CSphVector<uint64_t> dFilters;
 
-	// become the new head
-	p->m_iMruPrev = -1;
-	p->m_iMruNext = m_iMruHead;
-	if ( p->m_iMruNext>=0 )
+	ScopedMutex_t dLock ( m_tLock );
+
+	int iLenMask = m_hData.GetLength() - 1;
+	int iLoop = m_hData.GetLength();
+	for ( int i = uKey & iLenMask; m_hData[i]!=QCACHE_NO_ENTRY && iLoop--!=0; i = ( i+1 ) & iLenMask )
 	{
-		assert ( m_hData [ p->m_iMruNext ]->m_iMruPrev<0 );
-		m_hData [ p->m_iMruNext ]->m_iMruPrev = iRes;
+		// check that entry is alive
+		QcacheEntry_c * e = m_hData[i]; // shortcut
+		if ( e==QCACHE_DEAD_ENTRY )
+			continue;
+
+		// check that key matches
+		if ( e->m_Key!=uKey )
+			continue;
+
+		// expired ones are left to background sweep
+		if ( e->m_tmStarted < tmMin )
+			continue;
+
+		// check that filters are compatible (ie. that entry filters are a subset of query filters)
+		if ( !bFilterHashesCalculated )
+		{
+			bFilterHashesCalculated = true;
+
+			if ( !CalcFilterHashes ( dFilters, q, tSorterSchema ) )
+				return nullptr;	// this query can't be cached because of the nature of expressions in filters
+		}
+
+		int j = 0;
+		for ( ; j < e->m_dFilters.GetLength(); j++ )
+			if ( !dFilters.BinarySearch ( e->m_dFilters[j] ) )
+				break;
+
+		// filters are good, return it
+		if ( j==e->m_dFilters.GetLength() )
+		{
+			e->AddRef();
+			Touch ( e, fInflation );
+			return e;
+		}
 	}
-	m_iMruHead = iRes;
+
+	return nullptr;
+}
+
+int QcacheShard_c::FindSlot ( const QcacheEntry_c * pEntry ) const
+{
+	int iLenMask = m_hData.GetLength() - 1;
+	for ( int i = pEntry->m_Key & iLenMask; m_hData[i]!=QCACHE_NO_ENTRY; i = ( i+1 ) & iLenMask )
+		if ( m_hData[i]==pEntry )
+			return i;
+
+	assert ( 0 && "cached entry is not in the hash" );
+	return -1;
+}
+
+bool QcacheShard_c::GetMinPriority ( double & fPriority )
+{
+	ScopedMutex_t dLock ( m_tLock );
+	if ( m_dHeap.IsEmpty() )
+		return false;
+
+	fPriority = m_dHeap[0]->m_fPriority;
+	return true;
+}
+
+bool QcacheShard_c::EvictOne ( double & fPriority )
+{
+	ScopedMutex_t dLock ( m_tLock );
+	if ( m_dHeap.IsEmpty() )
+		return false;
+
+	fPriority = m_dHeap[0]->m_fPriority;
+	DeleteEntry ( FindSlot ( m_dHeap[0] ) );
+	return true;
+}
+
+void QcacheShard_c::Sweep ( int64_t tmMin, int iThreshMs )
+{
+	ScopedMutex_t dLock ( m_tLock );
+	ARRAY_FOREACH ( i, m_hData )
+		if ( IsValidEntry(i) && ( m_hData[i]->m_tmStarted < tmMin || m_hData[i]->m_iElapsedMsec < iThreshMs ) )
+			DeleteEntry(i);
+
+	// drop tombstones once they occupy most of the table, so probe chains stay short
+	int iLive = GetCachedQueries();
+	int iDead = m_hData.count_of ( [] ( QcacheEntry_c * p ) { return p==QCACHE_DEAD_ENTRY; } );
+	if ( iDead>iLive )
+		Rehash ( m_hData.GetLength() );
+}
+
+void QcacheShard_c::DeleteIndex ( int64_t iIndexId )
+{
+	ScopedMutex_t dLock ( m_tLock );
+	ARRAY_FOREACH ( i, m_hData )
+		if ( IsValidEntry(i) && m_hData[i]->m_iIndexId==iIndexId )
+			DeleteEntry(i);
 }
 
+void QcacheShard_c::DeleteEntry ( int i )
+{
+	assert ( IsValidEntry(i) );
+	QcacheEntry_c * p = m_hData[i];
+	HeapRemove(p);
+
+	// adjust stats
+	m_iCachedQueries.fetch_sub ( 1, std::memory_order_relaxed );
+	m_iUsedBytes.fetch_sub ( p->GetSize(), std::memory_order_relaxed );
+
+	// release entry
+	p->Release();
+	m_hData[i] = QCACHE_DEAD_ENTRY;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+Qcache_c::Qcache_c()
+{
+	// defaults are here
+	m_iMaxBytes = 16777216;
+#ifndef NDEBUG
+	m_iMaxBytes = 0; // disable qcache in debug builds
+#endif
+
+	m_iThreshMs = 3000;
+	m_iTtlS = 60;
+
+	m_iCachedQueries = 0;
+	m_iUsedBytes = 0;
+	m_iHits = 0;
+}
+
+void Qcache_c::Setup ( int64_t iMaxBytes, int iThreshMsec, int iTtlSec )
+{
+	m_iMaxBytes = Max ( iMaxBytes, 0 );
+	m_iThreshMs = Max ( iThreshMsec, 0 );
+	m_iTtlS = Max ( iTtlSec, 1 );
+	Sweep();
+	EnforceLimits();
+}
+
+QcacheStatus_t Qcache_c::GetStatus() const
+{
+	QcacheStatus_t tRes = *this;
+	tRes.m_iCachedQueries = 0;
+	for ( const auto & tShard : m_dShards )
+		tRes.m_iCachedQueries += tShard.GetCachedQueries();
+
+	tRes.m_iUsedBytes = GetUsedBytes();
+	tRes.m_iHits = m_iHitsCount.load ( std::memory_order_relaxed );
+	return tRes;
+}
+
+int64_t Qcache_c::GetUsedBytes() const
+{
+	int64_t iBytes = 0;
+	for ( const auto & tShard : m_dShards )
+		iBytes += tShard.GetUsedBytes();
+	return iBytes;
+}
 
 static bool CalcFilterHashes ( CSphVector<uint64_t> & dFilters, const CSphQuery & q, const ISphSchema & tSorterSchema )
 {
@@ -358,63 +639,17 @@ void Qcache_c::Add ( const CSphQuery & q, QcacheEntry_c * pResult, const ISphSch
 	if ( !CanCacheQuery(q) )
 		return;
 
+	// search_after implicitly filters by the leading sort key, and that filter is not part of the key
+	if ( q.m_dSearchAfter.GetLength() )
+		return;
+
 	if ( !CalcFilterHashes ( pResult->m_dFilters, q, tSorterSchema ) )
 		return;	// this query can't be cached because of the nature of expressions in filters
 
 	pResult->AddRef();
 	pResult->m_Key = GetKey ( pResult->m_iIndexId, q );
-
-	ScopedMutex_t dLock (m_tLock);
-
-	// rehash if needed
-	if ( m_iCachedQueries>=m_iMaxQueries )
-	{
-		CSphVector<QcacheEntry_c*> hNew ( 2*m_hData.GetLength() );
-		hNew.Fill ( QCACHE_NO_ENTRY );
-
-		CSphVector<int> dRemap ( m_hData.GetLength() );
-		dRemap.Fill ( -1 );
-
-		int iLenMask = hNew.GetLength() - 1;
-		ARRAY_FOREACH ( i, m_hData )
-			if ( IsValidEntry(i) )
-		{
-			int j = m_hData[i]->m_Key & iLenMask;
-			while ( hNew[j]!=NULL )
-				j = ( j+1 ) & iLenMask;
-			hNew[j] = m_hData[i];
-			dRemap[i] = j;
-		}
-
-		ARRAY_FOREACH ( i, m_hData )
-			if ( IsValidEntry(i) )
-		{
-			QcacheEntry_c * p = hNew [ dRemap[i] ];
-			if ( p->m_iMruNext>=0 )
-				p->m_iMruNext = dRemap [ p->m_iMruNext ];
-			if ( p->m_iMruPrev>=0 )
-				p->m_iMruPrev = dRemap [ p->m_iMruPrev ];
-		}
-
-		m_hData.SwapData ( hNew );
-		m_iMruHead = dRemap [ m_iMruHead ];
-
-		m_iMaxQueries *= 2;
-	}
-
-	// add entry
-	int iLenMask = m_hData.GetLength() - 1;
-	int j = pResult->m_Key & iLenMask;
-	while ( IsValidEntry(j) )
-		j = ( j+1 ) & iLenMask;
-	m_hData[j] = pResult;
-
-	m_iCachedQueries++;
-	m_iUsedBytes += pResult->GetSize();
-	MruToHead(j);
-
-	dLock.Unlock();
-	EnforceLimits ( true );
+	GetShard ( pResult->m_Key ).Add ( pResult, m_fInflation.load ( std::memory_order_relaxed ) );
+	EnforceLimits();
 }
 
 QcacheEntry_c * Qcache_c::Find ( int64_t iIndexId, const CSphQuery & q, const ISphSchema & tSorterSchema )
@@ -426,64 +661,10 @@ QcacheEntry_c * Qcache_c::Find ( int64_t iIndexId, const CSphQuery & q, const IS
 		return nullptr;
 
 	uint64_t k = GetKey ( iIndexId, q );
-
-	bool bFilterHashesCalculated = false;
-	CSphVector<uint64_t> dFilters;
-	
-	ScopedMutex_t dLock (m_tLock);
-
 	int64_t tmMin = sphMicroTimer() - int64_t( m_iTtlS)*1000000;
-	int iLenMask = m_hData.GetLength() - 1;
-	int iLoop = m_hData.GetLength();
-	int iRes = -1;
-	for ( int i = k & iLenMask; m_hData[i]!=QCACHE_NO_ENTRY && iLoop--!=0; i = ( i+1 ) & iLenMask )
-	{
-		// check that entry is alive
-		QcacheEntry_c * e = m_hData[i]; // shortcut
-		if ( e==QCACHE_DEAD_ENTRY )
-			continue;
-
-		// check if we need to evict this one based on ttl
-		if ( e->m_tmStarted < tmMin )
-		{
-			DeleteEntry(i);
-			continue;
-		}
-
-		// check that key matches
-		if ( e->m_Key!=k )
-			continue;
-
-		// check that filters are compatible (ie. that entry filters are a subset of query filters)
-		if ( !bFilterHashesCalculated )
-		{
-			bFilterHashesCalculated = true;
-
-			if ( !CalcFilterHashes ( dFilters, q, tSorterSchema ) )
-				return nullptr;	// this query can't be cached because of the nature of expressions in filters
-		}
-
-		int j = 0;
-		for ( ; j < e->m_dFilters.GetLength(); j++ )
-			if ( !dFilters.BinarySearch ( e->m_dFilters[j] ) )
-				break;
-
-		// filters are good, return it
-		if ( j==e->m_dFilters.GetLength() )
-		{
-			iRes = i;
-			m_iHits++;
-			break;
-		}
-	}
-
-	QcacheEntry_c * p = nullptr;
-	if ( iRes>=0 )
-	{
-		p = m_hData[iRes];
-		p->AddRef();
-		MruToHead(iRes);
-	}
+	QcacheEntry_c * p = GetShard(k).Find ( k, tmMin, q, tSorterSchema, m_fInflation.load ( std::memory_order_relaxed ) );
+	if ( p )
+		m_iHitsCount.fetch_add ( 1, std::memory_order_relaxed );
 
 	return p;
 }
@@ -507,74 +688,56 @@ uint64_t Qcache_c::GetKey ( int64_t iIndexId, const CSphQuery & q )
 	return k;
 }
 
-void Qcache_c::DeleteEntry ( int i )
+bool Qcache_c::CanCacheQuery ( const CSphQuery & q ) const
 {
-	assert ( IsValidEntry(i) );
-	QcacheEntry_c * p = m_hData[i];
-
-	// adjust MRU list
-	if ( p->m_iMruNext>=0 )
-		m_hData[p->m_iMruNext]->m_iMruPrev = p->m_iMruPrev;
-
-	assert ( p->m_iMruPrev>=0 || m_iMruHead==i );
-	if ( p->m_iMruPrev>=0 )
-		m_hData[p->m_iMruPrev]->m_iMruNext = p->m_iMruNext;
-	else
-		m_iMruHead = p->m_iMruNext;
-
-	// adjust stats
-	m_iCachedQueries--;
-	m_iUsedBytes -= p->GetSize();
-
-	// release entry
-	p->Release();
-	m_hData[i] = QCACHE_DEAD_ENTRY;
+	// sampled result sets are partial, and the sample filter is not part of the key
+	return q.m_eMode!=SPH_MATCH_FULLSCAN && !q.m_sQuery.IsEmpty() && q.m_fSampleRate>=1.0f;
 }
 
-
-bool Qcache_c::CanCacheQuery ( const CSphQuery & q ) const
+// age everything cached, so that once popular but now idle entries eventually go away; clock never goes back
+void Qcache_c::Inflate ( double fPriority )
 {
-	return q.m_eMode!=SPH_MATCH_FULLSCAN && !q.m_sQuery.IsEmpty();
+	double fClock = m_fInflation.load ( std::memory_order_relaxed );
+	while ( fClock<fPriority && !m_fInflation.compare_exchange_weak ( fClock, fPriority, std::memory_order_relaxed ) )
+		;
 }
 
-void Qcache_c::EnforceLimits ( bool bSizeOnly )
+// evict cheapest entries until we fit; each shard keeps its cheapest entry on top of a heap, so one victim costs a look at every shard top
+// shards are locked one at a time, so a concurrent touch might make the victim not the cheapest one anymore; that is fine
+void Qcache_c::EnforceLimits()
 {
-	if ( bSizeOnly && m_iUsedBytes<=m_iMaxBytes )
-		return;
+	while ( GetUsedBytes()>m_iMaxBytes )
+	{
+		QcacheShard_c * pVictim = nullptr;
+		double fMin = 0.0;
+		for ( auto & tShard : m_dShards )
+		{
+			double fPriority;
+			if ( tShard.GetMinPriority ( fPriority ) && ( !pVictim || fPriority<fMin ) )
+			{
+				pVictim = &tShard;
+				fMin = fPriority;
+			}
+		}
 
-	ScopedMutex_t dLock ( m_tLock );
+		if ( !pVictim || !pVictim->EvictOne ( fMin ) )
+			break;
 
-	// first, enforce size limits
-	int iCur = m_iMruHead;
-	int64_t iBytes = 0;
-	while ( iCur>=0 && m_iUsedBytes>m_iMaxBytes )
-	{
-		assert ( IsValidEntry(iCur) );
-		int iNext = m_hData[iCur]->m_iMruNext;
-		if ( iBytes + m_hData[iCur]->GetSize() > m_iMaxBytes )
-			DeleteEntry ( iCur );
-		else
-			iBytes += m_hData[iCur]->GetSize();
-		iCur = iNext;
+		Inflate ( fMin );
 	}
+}
 
-	if ( bSizeOnly )
-		return;
-
-	// if requested, do a full sweep, and recheck ttl and thresh limits
+void Qcache_c::Sweep()
+{
 	int64_t tmMin = sphMicroTimer() - int64_t( m_iTtlS)*1000000;
-	ARRAY_FOREACH ( i, m_hData )
-		if ( IsValidEntry(i) && ( m_hData[i]->m_tmStarted < tmMin || m_hData[i]->m_iElapsedMsec < m_iThreshMs ) )
-			DeleteEntry(i);
-
+	for ( auto & tShard : m_dShards )
+		tShard.Sweep ( tmMin, m_iThreshMs );
 }
 
 void Qcache_c::DeleteIndex ( int64_t iIndexId )
 {
-	ScopedMutex_t dLock ( m_tLock );
-	ARRAY_FOREACH ( i, m_hData )
-		if ( IsValidEntry(i) && m_hData[i]->m_iIndexId==iIndexId )
-			DeleteEntry(i);
+	for ( auto & tShard : m_dShards )
+		tShard.DeleteIndex ( iIndexId );
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -684,9 +847,9 @@ ISphRanker * QcacheRanker ( QcacheEntry_c * pEntry, const ISphQwordSetup & tSetu
 	return new QcacheRanker_c ( pEntry, tSetup );
 }
 
-const QcacheStatus_t & QcacheGetStatus()
+QcacheStatus_t QcacheGetStatus()
 {
-	return g_Qcache;
+	return g_Qcache.GetStatus();
 }
 
 void QcacheSetup ( int64_t iMaxBytes, int iThreshMsec, int iTtlSec )
@@ -698,3 +861,8 @@ void QcacheDeleteIndex ( int64_t iIndexId )
 {
 	g_Qcache.DeleteIndex ( iIndexId );
 }
+
+void QcacheSweep()
+{
+	g_Qcache.Sweep();
+}
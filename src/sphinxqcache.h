@@ -36,8 +36,9 @@ public:
 	int							m_iElapsedMsec = 0;
 	CSphVector<uint64_t>		m_dFilters;			///< hashes of the filters that were applied to cached query
 	uint64_t					m_Key = 0;
-	int							m_iMruPrev = -1;
-	int							m_iMruNext = -1;
+	int							m_iFrequency = 0;	///< hits since entry was cached, plus one
+	double						m_fPriority = 0.0;	///< GDSF eviction priority; lowest one goes first
+	int							m_iHeapIdx = -1;	///< position in the eviction heap of its shard
 
 private:
 	static const int			MAX_FRAME_SIZE = 32;
@@ -83,8 +84,9 @@ struct QcacheStatus_t
 void					QcacheAdd ( const CSphQuery & q, QcacheEntry_c * pResult, const ISphSchema & tSorterSchema );
 QcacheEntry_c *			QcacheFind ( int64_t iIndexId, const CSphQuery & q, const ISphSchema & tSorterSchema );
 ISphRanker *			QcacheRanker ( QcacheEntry_c * pEntry, const ISphQwordSetup & tSetup );
-const QcacheStatus_t &	QcacheGetStatus();
+QcacheStatus_t			QcacheGetStatus();
 void					QcacheSetup ( int64_t iMaxBytes, int iThreshMsec, int iTtlSec );
 void					QcacheDeleteIndex ( int64_t iIndexId );
+void					QcacheSweep();		///< drop entries expired by ttl; called periodically from daemon
 
 #endif // _sphinxqcache_
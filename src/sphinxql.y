@@ -1089,6 +1089,11 @@ option_item:
 			if ( !pParser->AddOption ( $1, $3 ) )
 				YYERROR;
 		}
+	| ident_no_option '=' TOK_CONST_FLOAT
+		{
+			if ( !pParser->AddFloatOption ( $1, $3 ) )
+				YYERROR;
+		}
 	| ident_no_option '=' '(' named_const_list ')'
 		{
 			if ( !pParser->AddOption ( $1, pParser->GetNamedVec ( $4.m_iValue ) ) )
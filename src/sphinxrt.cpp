@@ -54,6 +54,7 @@
 #include "attrindex_builder.h"
 #include "tokenizer/tokenizer.h"
 #include "queryfilter.h"
+#include "termfilter.h"
 
 using namespace Threads;
 
@@ -130,6 +131,18 @@ volatile int &AutoOptimizeCutoff() noexcept
 	return iAutoOptimizeCutoff;
 }
 
+volatile int &OptimizeDeadPercent() noexcept
+{
+	static int iOptimizeDeadPercent = 10;
+	return iOptimizeDeadPercent;
+}
+
+volatile int &OptimizeWriteAmplification() noexcept
+{
+	static int iOptimizeWriteAmplification = 0;
+	return iOptimizeWriteAmplification;
+}
+
 volatile EnqueueForOptimizeFnPtr& EnqueueForOptimizeExecutor() noexcept
 {
 	static EnqueueForOptimizeFnPtr EnqueueForOptimizeFn = nullptr;
@@ -403,8 +416,11 @@ RowID_t RtSegment_t::GetRowidByDocid ( DocID_t tDocID ) const
 
 int RtSegment_t::Kill ( DocID_t tDocID )
 {
-	if ( m_tDeadRowMap.Set ( GetRowidByDocid ( tDocID ) ) )
+	RowID_t tRowID = GetRowidByDocid ( tDocID );
+	ScopedMutex_t tRollupLock ( m_tRollups.m_tLock );
+	if ( m_tDeadRowMap.Set ( tRowID ) )
 	{
+		m_tRollups.Retract ( GetDocinfoByRowID ( tRowID ) );
 		assert ( m_tAliveRows>0 );
 		m_tAliveRows.fetch_sub ( 1, std::memory_order_relaxed );
 
@@ -938,6 +954,7 @@ class RtData_c
 	mutable RwLock_t			m_tLock;	// very short-term
 	ConstDiskChunkVecRefPtr_t	m_pChunks GUARDED_BY ( m_tLock );
 	ConstRtSegVecRefPtr_t		m_pSegments GUARDED_BY ( m_tLock );
+	std::atomic<int64_t>		m_iGeneration { 0 };	// bumped on every change of the set of chunks and segments
 
 	friend class RtWriter_c;
 
@@ -994,6 +1011,11 @@ public:
 		ScRL_t rLock ( m_tLock );
 		return m_pChunks->GetLength ();
 	}
+
+	int64_t GetGeneration() const
+	{
+		return m_iGeneration.load ( std::memory_order_acquire );
+	}
 };
 
 // helper for easier access to ConstRtData members
@@ -1034,18 +1056,21 @@ public:
 		if ( !m_pNewDiskChunks && !m_pNewRamSegs )
 			return;
 
+		bool bRamSegsChanged = !!m_pNewRamSegs;
 		{
 			ScWL_t wLock ( m_tOwner.m_tLock );
 			// use leak since we convert 'data*' to 'const data*' here.
 			if ( m_pNewDiskChunks )
 				m_tOwner.m_pChunks = m_pNewDiskChunks.Leak();
 
-			if ( !m_pNewRamSegs )
-				return;
+			if ( m_pNewRamSegs )
+				m_tOwner.m_pSegments = m_pNewRamSegs.Leak();
 
-			m_tOwner.m_pSegments = m_pNewRamSegs.Leak();
+			m_tOwner.m_iGeneration.fetch_add ( 1, std::memory_order_acq_rel );
 		}
-		m_fnOnRamSegsChanged();
+
+		if ( bRamSegsChanged )
+			m_fnOnRamSegsChanged();
 	}
 	enum Copy_e { copy };
 	enum Empty_e { empty };
@@ -1166,7 +1191,7 @@ public:
 	void				Optimize ( OptimizeTask_t tTask ) final;
 	void				CheckStartAutoOptimize ();
 	int					ClassicOptimize ();
-	int					ProgressiveOptimize ( int iCutoff );
+	int					ProgressiveOptimize ( int iCutoff, int iDeadPercent );
 	int					CommonOptimize ( OptimizeTask_t tTask );
 	void				DropDiskChunk ( int iChunk, int* pAffected=nullptr );
 	bool				CompressOneChunk ( int iChunk, int* pAffected = nullptr );
@@ -1212,7 +1237,8 @@ public:
 
 	int					UpdateAttributes ( AttrUpdateInc_t & tUpd, bool & bCritical, CSphString & sError, CSphString & sWarning ) final;
 	bool				SaveAttributes ( CSphString & sError ) const final;
-	DWORD				GetAttributeStatus () const final { return m_uDiskAttrStatus; }
+	DWORD				GetAttributeStatus () const final { return m_uDiskAttrStatus.load ( std::memory_order_relaxed ); }
+	int					RefreshStaleMinMax ( int iMaxBlocks ) final;
 
 	bool				AddRemoveAttribute ( bool bAdd, const AttrAddRemoveCtx_t & tCtx, CSphString & sError ) final;
 	bool				AddRemoveField ( bool bAdd, const CSphString & sFieldName, DWORD uFieldFlags, CSphString & sError ) final;
@@ -1224,10 +1250,12 @@ public:
 
 	bool				EarlyReject ( CSphQueryContext * pCtx, CSphMatch & ) const final;
 	const CSphSourceStats &		GetStats () const final { return m_tStats; }
+	int64_t				GetDataVersion() const final { return CSphIndex::GetDataVersion() + m_tRtChunks.GetGeneration(); }
 	int64_t *			GetFieldLens() const final { return m_tSettings.m_bIndexFieldLens ? m_dFieldLens.Begin() : nullptr; }
 	void				GetStatus ( CSphIndexStatus* ) const final;
 
 	bool				MultiQuery ( CSphQueryResult& tResult, const CSphQuery& tQuery, const VecTraits_T<ISphMatchSorter*>& dAllSorters, const CSphMultiQueryArgs& tArgs ) const final;
+	bool				QueryRollup ( CSphQueryResult& tResult, const CSphQuery& tQuery, const VecTraits_T<ISphMatchSorter*>& dSorters, const CSphMultiQueryArgs& tArgs, const RtGuard_t& tGuard ) const;
 	void				DoGetKeywords ( CSphVector<CSphKeywordInfo>& dKeywords, const char* sQuery, const GetKeywordsSettings_t& tSettings, bool bFillOnly, CSphString* pError, const RtGuard_t& tGuard ) const;
 	bool				GetKeywords ( CSphVector<CSphKeywordInfo>& dKeywords, const char* sQuery, const GetKeywordsSettings_t& tSettings, CSphString* pError ) const final;
 	bool				FillKeywords ( CSphVector <CSphKeywordInfo> & dKeywords ) const final;
@@ -1296,7 +1324,7 @@ private:
 
 	int64_t						m_iSavedTID;
 	int64_t						m_tmSaved;
-	mutable DWORD				m_uDiskAttrStatus = 0;
+	mutable std::atomic<DWORD>	m_uDiskAttrStatus { 0 };	///< or-ed by updates and by background min/max refresh
 
 	bool						m_bKeywordDict;
 	int							m_iWordsCheckpoint = RTDICT_CHECKPOINT_V5;
@@ -1312,11 +1340,14 @@ private:
 	CSphFixedVector<int64_t>	m_dFieldLensDisk { SPH_MAX_FIELDS };	///< field lengths summed over all disk chunks
 	CSphBitvec					m_tMorphFields;
 	CSphVector<SphWordID_t>		m_dHitlessWords;
+	CSphVector<RollupDesc_t>	m_dRollups;		///< parsed 'rollup' setting
 
 	CSphScopedPtr<DocstoreFields_i> m_pDocstoreFields {nullptr};	// rt index doesn't have its own docstore, but it must keep all fields to get their ids for GetDoc
 	mutable int					m_iTrackFailedRamActions;
 
 	RtAccum_t *					CreateAccum ( RtAccum_t * pAccExt, CSphString & sError ) final;
+	void						SetupRollups();
+	void						ResetRollups();
 
 	int							CompareWords ( const RtWord_t * pWord1, const RtWord_t * pWord2 ) const;
 
@@ -1340,7 +1371,7 @@ private:
 	void						SaveMeta ( int64_t iTID, VecTraits_T<int> dChunkNames );
 	void						SaveMeta ();
 	void						SaveDiskHeader ( SaveDiskDataContext_t & tCtx, const ChunkStats_t & tStats ) const;
-	void						SaveDiskData ( const char * szFilename, const ConstRtSegmentSlice_t & tSegs, const ChunkStats_t & tStats ) const;
+	bool						SaveDiskData ( const char * szFilename, const ConstRtSegmentSlice_t & tSegs, const ChunkStats_t & tStats, CSphString & sError ) const;
 	bool						SaveDiskChunk ( bool bForced, bool bEmergent=false, bool bBootstrap=false ) REQUIRES ( m_tWorkers.SerialChunkAccess() );
 	CSphIndex *					PreallocDiskChunk ( const char * sChunk, int iChunk, FilenameBuilder_i * pFilenameBuilder, StrVec_t & dWarnings, CSphString & sError, const char * sName=nullptr ) const;
 	bool						LoadRamChunk ( DWORD uVersion, bool bRebuildInfixes, bool bFixup = true );
@@ -1366,7 +1397,8 @@ private:
 	void						AddRemoveRowwiseAttr ( RtGuard_t & tGuard, bool bAdd, const CSphString & sAttrName, ESphAttr eAttrType, const CSphSchema & tOldSchema, const CSphSchema & tNewSchema, CSphString & sError );
 
 	bool						Update_WriteBlobRow ( UpdateContext_t& tCtx, CSphRowitem* pDocinfo, const BYTE* pBlob, int iLength, int nBlobAttrs, const CSphAttrLocator& tBlobRowLoc, bool& bCritical, CSphString& sError ) override;
-	bool						Update_DiskChunks ( AttrUpdateInc_t& tUpd, const DiskChunkSlice_t& dDiskChunks, CSphString& sError );
+	CSphFixedVector<RowIdsToUpdate_t> Update_CollectDiskChunkRows ( const AttrUpdateInc_t& tUpd, const DiskChunkSlice_t& dDiskChunks ) const;
+	bool						Update_DiskChunks ( AttrUpdateInc_t& tUpd, const DiskChunkSlice_t& dDiskChunks, const CSphFixedVector<RowIdsToUpdate_t>& dChunkRows, CSphString& sError );
 
 	void						GetIndexFiles ( CSphVector<CSphString> & dFiles, const FilenameBuilder_i * pParentBuilder ) const override;
 	DocstoreBuilder_i::Doc_t *	FetchDocFields ( DocstoreBuilder_i::Doc_t & tStoredDoc, const InsertDocData_t & tDoc, CSphSource_StringVector & tSrc, CSphVector<CSphVector<BYTE>> & dTmpAttrStorage ) const;
@@ -1463,7 +1495,8 @@ RtIndex_c::~RtIndex_c ()
 	if ( m_iLockFD>=0 )
 		::close ( m_iLockFD );
 
-	if ( bValid )
+	// dropped index has its logs forgotten already; a new index of the same name might own that stream now
+	if ( bValid && !m_bIndexDeleted )
 		Binlog::NotifyIndexFlush ( m_sIndexName.cstr(), m_iTID, sphInterrupted () );
 
 	if ( m_bIndexDeleted )
@@ -3114,6 +3147,9 @@ bool RtIndex_c::UpdateAttributesInRamSegment ( const RowsToUpdate_t& dRows, Upda
 		return false;
 
 	Update_Plain ( dRows, tCtx );
+
+	// rows are already written, so a state built concurrently goes away too
+	( (RtSegment_t *)tCtx.m_pSegment )->m_tRollups.Invalidate ( *tCtx.m_tUpd.m_pUpdate );
 	return true;
 }
 
@@ -3578,6 +3614,9 @@ int RtIndex_c::CommitReplayable ( RtSegment_t * pNewSeg, const CSphVector<DocID_
 			m_dFieldLens[i] = m_dFieldLensRam[i] + m_dFieldLensDisk[i];
 		}
 
+	// kills alone do not change the set of segments
+	BumpDataVersion();
+
 	// backoff segments merging and m.b. saving disk chunk (that is not our deal, other worker will do it).
 	StartMergeSegments ( pNewSeg ? MergeSeg_e::NEWSEG : MergeSeg_e::KILLED );
 
@@ -3641,6 +3680,7 @@ struct SaveDiskDataContext_t : public BuildHeader_t
 	CSphScopedPtr<ISphInfixBuilder>	m_pInfixer {nullptr};
 	CSphVector<Checkpoint_t>		m_dCheckpoints;
 	CSphVector<BYTE>				m_dKeywordCheckpoints;
+	TermFilterBuilder_c				m_tTermFilter;
 	CSphVector<CSphVector<RowID_t>>	m_dRowMaps;
 	const char *					m_szFilename;
 	const ConstRtSegmentSlice_t&	m_tRamSegments;
@@ -3980,6 +4020,11 @@ bool RtIndex_c::WriteDocs ( SaveDiskDataContext_t & tCtx, CSphWriter & tWriterDi
 
 			++iWords;
 
+			if ( m_bKeywordDict )
+				tCtx.m_tTermFilter.Add ( TermFilterKey ( pWord->m_sWord+1, pWord->m_sWord[0] ) );
+			else
+				tCtx.m_tTermFilter.Add ( pWord->m_uWordID );
+
 			if ( m_bKeywordDict )
 			{
 				tLastWord.PutDelta ( tWriterDict, pWord->m_sWord+1, pWord->m_sWord[0] );
@@ -4102,10 +4147,8 @@ bool RtIndex_c::WriteDeadRowMap ( SaveDiskDataContext_t & tCtx, CSphString & sEr
 
 // SaveDiskChunk -> SaveDiskData
 // RO save RAM chunks from tSegs into new disk chunk (nothing added/released, just disk files created)
-void RtIndex_c::SaveDiskData ( const char * szFilename, const ConstRtSegmentSlice_t& tSegs, const ChunkStats_t & tStats ) const
+bool RtIndex_c::SaveDiskData ( const char * szFilename, const ConstRtSegmentSlice_t& tSegs, const ChunkStats_t & tStats, CSphString & sError ) const
 {
-	CSphString sError; // FIXME!!! report collected (sError) errors
-
 	RTSAVELOG << "SaveDiskData to " << szFilename << ", " << tSegs.GetLength() << " segments";
 
 	SaveDiskDataContext_t tCtx ( szFilename, tSegs ); // only RAM segments here in game.
@@ -4125,7 +4168,15 @@ void RtIndex_c::SaveDiskData ( const char * szFilename, const ConstRtSegmentSlic
 	WriteDocs ( tCtx, tWriterDict, sError );
 	WriteCheckpoints ( tCtx, tWriterDict );
 
+	// the filter signs the complete dictionary
+	tWriterDict.CloseFile();
+	CSphString sSPIF;
+	sSPIF.SetSprintf ( "%s%s", szFilename, sphGetExt ( SPH_EXT_SPIF ) );
+	if ( !tCtx.m_tTermFilter.Save ( sSPIF, sSPI, tCtx.m_iDictCheckpointsOffset, sError ) )
+		return false;
+
 	SaveDiskHeader ( tCtx, tStats );
+	return true;
 }
 
 
@@ -4361,21 +4412,22 @@ bool RtIndex_c::SaveDiskChunk ( bool bForced, bool bEmergent, bool bBootstrap )
 		// if forced, continue to work in the same fiber; otherwise split to merge fiber
 		ScopedScheduler_c tSaveFiber { bForced ? Coro::CurrentScheduler () : m_tWorkers.SaveSegmentsWorker() };
 		tmSave = -sphMicroTimer();
-		SaveDiskData ( sChunk.cstr (), dSegments, tStats );
-		// fixme! process errors.
-
-		// bring new disk chunk online
-		auto fnFnameBuilder = GetIndexFilenameBuilder ();
-		StrVec_t dWarnings; // fixme!
-		CSphScopedPtr<FilenameBuilder_i> pFilenameBuilder { fnFnameBuilder ? fnFnameBuilder ( m_sIndexName.cstr () ) : nullptr };
-		pNewChunk = PreallocDiskChunk ( sChunk.cstr (), iChunkID, pFilenameBuilder.Ptr (), dWarnings, m_sLastError );
+		// fixme! only the term filter errors are reported so far
+		if ( SaveDiskData ( sChunk.cstr (), dSegments, tStats, m_sLastError ) )
+		{
+			// bring new disk chunk online
+			auto fnFnameBuilder = GetIndexFilenameBuilder ();
+			StrVec_t dWarnings; // fixme!
+			CSphScopedPtr<FilenameBuilder_i> pFilenameBuilder { fnFnameBuilder ? fnFnameBuilder ( m_sIndexName.cstr () ) : nullptr };
+			pNewChunk = PreallocDiskChunk ( sChunk.cstr (), iChunkID, pFilenameBuilder.Ptr (), dWarnings, m_sLastError );
+		}
 		tmSave += sphMicroTimer();
 	}
 
 	// here we back into serial fiber. As we're switched, we can't rely on m_iTID and index stats anymore
 	if ( !pNewChunk )
 	{
-		sphWarning ( "rt: index %s failed to load disk chunk after RAM save: %s", m_sIndexName.cstr (), m_sLastError.cstr () );
+		sphWarning ( "rt: index %s failed to save or load disk chunk after RAM save: %s", m_sIndexName.cstr (), m_sLastError.cstr () );
 		return false;
 	}
 
@@ -4880,6 +4932,7 @@ bool RtIndex_c::Prealloc ( bool bStripPath, FilenameBuilder_i * pFilenameBuilder
 	if ( !m_tMutableSettings.Load ( sMutableFile.cstr(), m_sIndexName.cstr() ) )
 		return false;
 	SetMemLimit ( m_tMutableSettings.m_iMemLimit );
+	SetupRollups();
 
 	m_bPathStripped = bStripPath;
 
@@ -7633,6 +7686,70 @@ ConstRtData FilterReaderChunks ( ConstRtData tOrigin, const VecTraits_T<int64_t>
 	return { pConstChunks, pConstSegments };
 }
 
+void RtIndex_c::SetupRollups()
+{
+	m_dRollups.Reset();
+
+	CSphString sError;
+	if ( ParseRollups ( m_tMutableSettings.m_sRollup, m_dRollups, sError ) && CheckRollups ( m_dRollups, m_tSchema, sError ) )
+		return;
+
+	sphWarning ( "index '%s': rollups disabled: %s", m_sIndexName.cstr(), sError.cstr() );
+	m_dRollups.Reset();
+}
+
+void RtIndex_c::ResetRollups()
+{
+	for ( const auto & pChunk : *m_tRtChunks.DiskChunks() )
+		pChunk->Cidx().ResetRollups();
+
+	for ( const auto & pSeg : *m_tRtChunks.RamSegs() )
+		pSeg->m_tRollups.Reset();
+}
+
+// grouped full-scan answered by one of the rollups: every segment and chunk pushes its pre-aggregated groups instead of the rows
+bool RtIndex_c::QueryRollup ( CSphQueryResult & tResult, const CSphQuery & tQuery, const VecTraits_T<ISphMatchSorter *> & dSorters, const CSphMultiQueryArgs & tArgs, const RtGuard_t & tGuard ) const
+{
+	if ( m_dRollups.IsEmpty() || dSorters.GetLength()!=1 || !dSorters[0]->IsGroupby() || !tQuery.m_pQueryParser->IsFullscan ( tQuery ) )
+		return false;
+
+	ISphMatchSorter * pSorter = dSorters[0];
+	RollupQuery_t tRollup;
+	if ( !SetupRollupQuery ( tQuery, *pSorter->GetSchema(), m_tSchema, m_dRollups, tRollup ) )
+		return false;
+
+	CSphScopedProfile tProf ( tResult.m_pMeta->m_pProfile, SPH_QSTATE_FULLSCAN );
+
+	CSphMatch tMatch;
+	tMatch.Reset ( pSorter->GetSchema()->GetDynamicSize() );
+	tMatch.m_iWeight = tArgs.m_iIndexWeight;
+
+	int nRamSegs = tGuard.m_dRamSegs.GetLength();
+	SorterSchemaTransform_c tSSTransform ( tGuard.m_dDiskChunks.GetLength(), tArgs.m_bFinalizeSorters );
+	ARRAY_FOREACH ( i, tGuard.m_dDiskChunks )
+	{
+		CSphQueryResultMeta tChunkMeta;
+		CSphQueryResult tChunkResult;
+		tChunkResult.m_pMeta = &tChunkMeta;
+
+		tMatch.m_iTag = nRamSegs+i+1;
+		tGuard.m_dDiskChunks[i]->Cidx().PushRollup ( tRollup, pSorter, tMatch, tChunkResult );
+		tSSTransform.Set ( i, tChunkResult );
+	}
+
+	ARRAY_FOREACH ( i, tGuard.m_dRamSegs )
+	{
+		const RtSegment_t & tSeg = *tGuard.m_dRamSegs[i];
+		SccRL_t rLock ( tSeg.m_tLock );
+		tMatch.m_iTag = i+1;
+		tSeg.m_tRollups.Push ( tRollup, tSeg.m_dRows.Begin(), m_iStride, tSeg.m_uRows, tSeg.m_tDeadRowMap, pSorter, tMatch );
+	}
+
+	tSSTransform.Transform ( pSorter, tGuard );
+	tResult.m_pDocstore = m_tSchema.HasStoredFields() ? this : nullptr;
+	return true;
+}
+
 // FIXME! missing MVA, index_exact_words support
 // FIXME? any chance to factor out common backend agnostic code?
 // FIXME? do we need to support pExtraFilters?
@@ -7677,6 +7794,13 @@ bool RtIndex_c::MultiQuery ( CSphQueryResult & tResult, const CSphQuery & tQuery
 	RtGuard_t tGuard ( std::move ( tRtData ) );
 	auto& dDiskChunks = tGuard.m_dDiskChunks;
 
+	if ( QueryRollup ( tResult, tQuery, dSorters, tArgs, tGuard ) )
+	{
+		tMeta.m_iQueryTime = int ( ( sphMicroTimer()-tmQueryStart )/1000 );
+		tMeta.m_iCpuTime += sphTaskCpuTimer ()-tmCpuQueryStart;
+		return true;
+	}
+
 	// wrappers
 	DictRefPtr_c pDict { GetStatelessDict ( m_pDict ) };
 
@@ -8116,7 +8240,53 @@ static void AddDerivedUpdate ( const RowsToUpdate_t & dRows, const UpdateContext
 	});
 }
 
-bool RtIndex_c::Update_DiskChunks ( AttrUpdateInc_t& tUpd, const DiskChunkSlice_t& dDiskChunks, CSphString & sError )
+// resolve docids of the update to rowids of every disk chunk. Docids are sorted once and then merge-joined against
+// docid lookup of each chunk; that is read-only, so chunks are processed in parallel.
+// Only rowids are collected: that runs out of the serial fiber, and attributes might be remapped by ALTER before the write
+CSphFixedVector<RowIdsToUpdate_t> RtIndex_c::Update_CollectDiskChunkRows ( const AttrUpdateInc_t& tUpd, const DiskChunkSlice_t& dDiskChunks ) const
+{
+	CSphFixedVector<RowIdsToUpdate_t> dChunkRows { dDiskChunks.GetLength() };
+	if ( dDiskChunks.IsEmpty() )
+		return dChunkRows;
+
+	const auto& dDocids = tUpd.m_pUpdate->m_dDocids;
+	CSphVector<int> dSorted;
+	dSorted.Reserve ( dDocids.GetLength() - tUpd.m_iAffected );
+	ARRAY_CONSTFOREACH ( i, dDocids )
+		if ( !tUpd.m_dUpdated.BitGet ( i ) )
+			dSorted.Add ( i );
+
+	if ( dSorted.IsEmpty() )
+		return dChunkRows;
+
+	dSorted.Sort ( Lesser ( [&dDocids] ( int a, int b ) { return dDocids[a]<dDocids[b]; } ) );
+
+	int iJobs = dDiskChunks.GetLength();
+	int iConcurrency = GetEffectiveDistThreads();
+	iConcurrency = Min ( iJobs, iConcurrency ? iConcurrency : Threads::NThreads() );
+
+	// binlog replay runs outside of coroutines
+	if ( iConcurrency<=1 || !Threads::IsInsideCoroutine() )
+	{
+		ARRAY_FOREACH ( iChunk, dChunkRows )
+			dChunkRows[iChunk] = dDiskChunks[iChunk]->Cidx().CollectRowsToUpdate ( tUpd, dSorted );
+		return dChunkRows;
+	}
+
+	std::atomic<int32_t> iCurChunk { 0 };
+	Coro::ExecuteN ( iConcurrency, [&]
+	{
+		for ( auto iChunk = iCurChunk.fetch_add ( 1, std::memory_order_acq_rel ); iChunk<iJobs; iChunk = iCurChunk.fetch_add ( 1, std::memory_order_acq_rel ) )
+		{
+			myinfo::SetThreadInfo ( "update ch %d:", iChunk );
+			dChunkRows[iChunk] = dDiskChunks[iChunk]->Cidx().CollectRowsToUpdate ( tUpd, dSorted );
+		}
+	});
+
+	return dChunkRows;
+}
+
+bool RtIndex_c::Update_DiskChunks ( AttrUpdateInc_t& tUpd, const DiskChunkSlice_t& dDiskChunks, const CSphFixedVector<RowIdsToUpdate_t>& dChunkRows, CSphString & sError )
 {
 	bool bCritical = false;
 	CSphString sWarning;
@@ -8133,12 +8303,15 @@ bool RtIndex_c::Update_DiskChunks ( AttrUpdateInc_t& tUpd, const DiskChunkSlice_
 		if ( tUpd.AllApplied () )
 			break;
 
+		if ( dChunkRows[iChunk].IsEmpty() )
+			continue;
+
 		auto& pDiskChunk = dDiskChunks[iChunk];
 
 		// acquire fine-grain lock
 		SccWL_t wLock ( pDiskChunk->m_tLock );
 
-		int iRes = pDiskChunk->CastIdx().UpdateAttributes ( tUpd, bCritical, sError, sWarning );
+		int iRes = pDiskChunk->CastIdx().UpdateCollectedRows ( dChunkRows[iChunk], tUpd, bCritical, sError, sWarning );
 
 		// FIXME! need to handle critical failures here (chunk is unusable at this point)
 		assert ( !bCritical );
@@ -8148,7 +8321,7 @@ bool RtIndex_c::Update_DiskChunks ( AttrUpdateInc_t& tUpd, const DiskChunkSlice_
 			return false;
 
 		// update stats
-		m_uDiskAttrStatus |= pDiskChunk->Cidx().GetAttributeStatus();
+		m_uDiskAttrStatus.fetch_or ( pDiskChunk->Cidx().GetAttributeStatus(), std::memory_order_relaxed );
 	}
 
 	return true;
@@ -8217,8 +8390,10 @@ int RtIndex_c::UpdateAttributes ( AttrUpdateInc_t & tUpd, bool & bCritical, CSph
 	// do update in serial fiber. That ensures no concurrency with set of chunks changing, however need to dispatch
 	// with changers themselves (merge segments, merge chunks, save disk chunks).
 	// fixme! Find another way (dedicated fiber?), as long op in serial fiber may pause another ops.
+	// Resolving docids to rows is the long part, and it doesn't modify anything; so it is done in parallel beforehand.
 	auto tGuard = RtGuard();
 	auto dRamUpdateSets = Update_CollectRowPtrs ( tCtx, tGuard.m_dRamSegs );
+	auto dDiskChunkRows = Update_CollectDiskChunkRows ( tUpd, tGuard.m_dDiskChunks );
 
 	ScopedScheduler_c tSerialFiber ( m_tWorkers.SerialChunkAccess() );
 	ARRAY_CONSTFOREACH ( i, dRamUpdateSets )
@@ -8243,11 +8418,12 @@ int RtIndex_c::UpdateAttributes ( AttrUpdateInc_t & tUpd, bool & bCritical, CSph
 			break;
 	}
 
-	if ( !Update_DiskChunks ( tUpd, tGuard.m_dDiskChunks, sError ) ) // fixme!
+	if ( !Update_DiskChunks ( tUpd, tGuard.m_dDiskChunks, dDiskChunkRows, sError ) ) // fixme!
 		sphWarn ( "INTERNAL ERROR: index %s update failure: %s", m_sIndexName.cstr(), sError.cstr() );
 
 	// bump the counter, binlog the update!
 	Binlog::CommitUpdateAttributes ( &m_iTID, m_sIndexName.cstr(), tUpdc );
+	BumpDataVersion();
 
 	iUpdated = tUpd.m_iAffected - iUpdated;
 	if ( !Update_HandleJsonWarnings ( tCtx, iUpdated, sWarning, sError ) )
@@ -8258,9 +8434,27 @@ int RtIndex_c::UpdateAttributes ( AttrUpdateInc_t & tUpd, bool & bCritical, CSph
 }
 
 
+// only disk chunks have block min/max; ram segments are scanned without it
+int RtIndex_c::RefreshStaleMinMax ( int iMaxBlocks )
+{
+	auto tGuard = RtGuard();
+	int iRefreshed = 0;
+	for ( const auto & pChunk : tGuard.m_dDiskChunks )
+	{
+		if ( iRefreshed>=iMaxBlocks )
+			break;
+
+		iRefreshed += pChunk->CastIdx().RefreshStaleMinMax ( iMaxBlocks-iRefreshed );
+		m_uDiskAttrStatus.fetch_or ( pChunk->Cidx().GetAttributeStatus(), std::memory_order_relaxed );
+	}
+
+	return iRefreshed;
+}
+
+
 bool RtIndex_c::SaveAttributes ( CSphString & sError ) const
 {
-	DWORD uStatus = m_uDiskAttrStatus;
+	DWORD uStatus = m_uDiskAttrStatus.load ( std::memory_order_relaxed );
 	bool bAllSaved = true;
 
 	const auto& pDiskChunks = m_tRtChunks.DiskChunks();
@@ -8271,8 +8465,8 @@ bool RtIndex_c::SaveAttributes ( CSphString & sError ) const
 	for ( auto& pChunk : *pDiskChunks )
 		bAllSaved &= pChunk->Cidx().SaveAttributes ( sError );
 
-	if ( uStatus==m_uDiskAttrStatus )
-		m_uDiskAttrStatus = 0;
+	// only clear if nobody marked new changes while we were saving
+	m_uDiskAttrStatus.compare_exchange_strong ( uStatus, 0, std::memory_order_relaxed );
 
 	return bAllSaved;
 }
@@ -8485,6 +8679,7 @@ void RtIndex_c::AlterSave ( bool bSaveRam )
 	Binlog::NotifyIndexFlush ( m_sIndexName.cstr (), m_iTID, false );
 
 	QcacheDeleteIndex ( GetIndexId() );
+	BumpDataVersion();
 }
 
 bool RtIndex_c::AddRemoveAttribute ( bool bAdd, const AttrAddRemoveCtx_t & tCtx, CSphString & sError )
@@ -8542,6 +8737,10 @@ bool RtIndex_c::AddRemoveAttribute ( bool bAdd, const AttrAddRemoveCtx_t & tCtx,
 
 	AddRemoveFromRamDocstore ( tOldSchema, tNewSchema );
 
+	// rollup states address the rows by the old schema
+	for ( auto & pSeg : tGuard.m_dRamSegs )
+		pSeg->m_tRollups.Reset();
+
 	// fixme: we can't rollback at this point
 	AlterSave ( true );
 	return true;
@@ -8850,29 +9049,74 @@ static int64_t GetChunkSize ( const CSphIndex& tIndex )
 	return GetEffectiveSize ( tDisk, tIndex.GetStats().m_iTotalDocuments );
 }
 
-struct ChunkAndSize_t
+static CSphVector<ChunkMergeStats_t> GetMergeCandidates ( const DiskChunkVec_c& dDiskChunks )
 {
-	int m_iId;
-	int64_t m_iSize;
-};
-
-static ChunkAndSize_t GetNextSmallestChunkByID ( const DiskChunkVec_c& dDiskChunks, int iChunkID )
-{
-	int iRes = -1;
-	int64_t iLastSize = INT64_MAX;
+	CSphVector<ChunkMergeStats_t> dRes;
 	for ( const auto& pDiskChunk : dDiskChunks )
 	{
 		if ( pDiskChunk->m_bOptimizing.load(std::memory_order_relaxed) )
 			continue;
 		const CSphIndex& dDiskChunk = pDiskChunk->Cidx();
-		int64_t iSize = GetChunkSize ( dDiskChunk );
-		if ( iSize < iLastSize && iChunkID != dDiskChunk.m_iChunk )
+		CSphIndexStatus tStatus;
+		dDiskChunk.GetStatus ( &tStatus );
+		int64_t iTotalDocs = dDiskChunk.GetStats().m_iTotalDocuments;
+		dRes.Add ( { dDiskChunk.m_iChunk, GetEffectiveSize ( tStatus, iTotalDocs ), tStatus.m_iDiskUse, iTotalDocs, tStatus.m_iDead } );
+	}
+	return dRes;
+}
+
+// small chunks are all considered to be of that size, so that merging tiny ones is never 'unbalanced'
+static const int64_t MERGE_FLOOR_SIZE = 2*1024*1024;
+
+// bytes written per byte of the smaller chunk; never below 2, as merge rewrites both chunks
+double MergeWriteAmplification ( const ChunkMergeStats_t & tA, const ChunkMergeStats_t & tB )
+{
+	auto iA = Max ( tA.m_iSize, MERGE_FLOOR_SIZE );
+	auto iB = Max ( tB.m_iSize, MERGE_FLOOR_SIZE );
+	return double ( iA+iB ) / double ( Min ( iA, iB ) );
+}
+
+// lower is better: prefer balanced merges, merges that reclaim many dead rows, and smaller merges
+static double MergeScore ( const ChunkMergeStats_t & tA, const ChunkMergeStats_t & tB )
+{
+	double fMax = (double)Max ( Max ( tA.m_iSize, tB.m_iSize ), MERGE_FLOOR_SIZE );
+	double fMin = (double)Max ( Min ( tA.m_iSize, tB.m_iSize ), MERGE_FLOOR_SIZE );
+	double fSkew = fMax / ( fMax+fMin );
+	double fAlive = double ( tA.m_iSize+tB.m_iSize+1 ) / double ( tA.m_iDiskUse+tB.m_iDiskUse+1 );
+	return fSkew * pow ( fMax+fMin, 0.05 ) * fAlive * fAlive;
+}
+
+// pick a pair to merge; pairs that exceed write amplification budget are taken only when nothing else is left
+std::pair<int,int> GetBestMergePair ( const CSphVector<ChunkMergeStats_t> & dChunks, int iMaxWriteAmp )
+{
+	std::pair<int,int> tBest { -1, -1 };
+	double fBestScore = 0.0;
+	std::pair<int,int> tCheapest { -1, -1 };
+	int64_t iCheapest = INT64_MAX;
+
+	for ( int i = 0; i<dChunks.GetLength(); ++i )
+		for ( int j = i+1; j<dChunks.GetLength(); ++j )
 		{
-			iLastSize = iSize;
-			iRes = dDiskChunk.m_iChunk;
+			const auto & tA = dChunks[i];
+			const auto & tB = dChunks[j];
+			if ( tA.m_iSize+tB.m_iSize<iCheapest )
+			{
+				iCheapest = tA.m_iSize+tB.m_iSize;
+				tCheapest = { i, j };
+			}
+
+			if ( iMaxWriteAmp>0 && MergeWriteAmplification ( tA, tB )>iMaxWriteAmp )
+				continue;
+
+			double fScore = MergeScore ( tA, tB );
+			if ( tBest.first<0 || fScore<fBestScore )
+			{
+				fBestScore = fScore;
+				tBest = { i, j };
+			}
 		}
-	}
-	return { iRes, iLastSize };
+
+	return tBest.first<0 ? tCheapest : tBest;
 }
 
 static int GetNumOfOptimizingNow ( const DiskChunkVec_c& dDiskChunks )
@@ -9634,7 +9878,7 @@ int RtIndex_c::ClassicOptimize ()
 	return iAffected;
 }
 
-int RtIndex_c::ProgressiveOptimize ( int iCutoff )
+int RtIndex_c::ProgressiveOptimize ( int iCutoff, int iDeadPercent )
 {
 	int iAffected = 0;
 	if ( !iCutoff )
@@ -9647,24 +9891,36 @@ int RtIndex_c::ProgressiveOptimize ( int iCutoff )
 		if ( ( pChunks->GetLength() - GetNumOfOptimizingNow ( *pChunks ) ) <= iCutoff )
 			break;
 
-		// merge 'smallest' to 'smaller' and get 'merged' that names like 'A'+.tmp
-		// however 'merged' got placed at 'B' position and 'merged' renamed to 'B' name
+		auto dCandidates = GetMergeCandidates ( *pChunks );
+		const ChunkMergeStats_t * pEmpty = nullptr;
+		for ( const auto & tChunk : dCandidates )
+			if ( !tChunk.m_iSize )
+			{
+				pEmpty = &tChunk;
+				break;
+			}
 
-		auto chA = GetNextSmallestChunkByID ( *pChunks, -1 );
-		if ( !chA.m_iSize ) // empty chunk - just remove
+		if ( pEmpty ) // empty chunk - just remove
 		{
-			RTDLOG << "Optimize: drop chunk " << chA.m_iId;
-			DropDiskChunk ( chA.m_iId, &iAffected );
+			RTDLOG << "Optimize: drop chunk " << pEmpty->m_iId;
+			DropDiskChunk ( pEmpty->m_iId, &iAffected );
 			continue;
 		}
 
-		auto chB = GetNextSmallestChunkByID ( *pChunks, chA.m_iId );
-		if ( chA.m_iId < 0 || chB.m_iId < 0 )
+		// merge 'A' to 'B' and get 'merged' that names like 'A'+.tmp
+		// however 'merged' got placed at 'B' position and 'merged' renamed to 'B' name
+		auto tPair = GetBestMergePair ( dCandidates, OptimizeWriteAmplification() );
+		if ( tPair.first<0 )
 		{
-			//	sphWarning ( "Couldn't find smallest chunk" );
+			//	sphWarning ( "Couldn't find chunks to merge" );
 			break;
 		}
 
+		auto chA = dCandidates[tPair.first];
+		auto chB = dCandidates[tPair.second];
+		sphLogDebug ( "rt optimize: index %s: merge %d (" INT64_FMT " kb, " INT64_FMT " dead) and %d (" INT64_FMT " kb, " INT64_FMT " dead), score %.3f",
+			m_sIndexName.cstr(), chA.m_iId, chA.m_iSize/1024, chA.m_iDeadDocs, chB.m_iId, chB.m_iSize/1024, chB.m_iDeadDocs, MergeScore ( chA, chB ) );
+
 		// we need to make sure that A is the oldest one
 		// indexes go from oldest to newest so A must go before B (A is always older than B)
 		// this is not required by bitmap killlists, but by some other stuff (like ALTER RECONFIGURE)
@@ -9676,11 +9932,28 @@ int RtIndex_c::ProgressiveOptimize ( int iCutoff )
 	}
 
 	RTDLOG << "Optimize: start compressing pass for the rest of " << m_tRtChunks.GetDiskChunksCount() << " chunks.";
-	// optimize (wipe deletes) in the rest of the chunks
+	// optimize (wipe deletes) in the rest of the chunks; rewriting a big chunk for a handful of kills is not worth it
 	for ( int i = 0; bWork && i < m_tRtChunks.GetDiskChunksCount(); ++i )
 	{
-		bWork &= CompressOneChunk ( ChunkIDByChunkIdx ( i ), &iAffected );
-		RTDLOG << "Optimize: compress chunk " << ChunkIDByChunkIdx ( i ) << " (" << i << ")";
+		int iChunkID = ChunkIDByChunkIdx ( i );
+		if ( iDeadPercent>0 )
+		{
+			auto pChunk = m_tRtChunks.DiskChunkByID ( iChunkID );
+			if ( !pChunk )
+				continue;
+
+			const CSphIndex & tChunk = pChunk->Cidx();
+			int64_t iTotalDocs = tChunk.GetStats().m_iTotalDocuments;
+			int64_t iAliveDocs = NumAliveDocs ( tChunk );
+			if ( iAliveDocs && ( iTotalDocs-iAliveDocs )*100 < iTotalDocs*iDeadPercent )
+			{
+				RTDLOG << "Optimize: skip compressing chunk " << iChunkID << ", " << iTotalDocs-iAliveDocs << " of " << iTotalDocs << " killed";
+				continue;
+			}
+		}
+
+		bWork &= CompressOneChunk ( iChunkID, &iAffected );
+		RTDLOG << "Optimize: compress chunk " << iChunkID << " (" << i << ")";
 	}
 	return iAffected;
 }
@@ -9688,6 +9961,7 @@ int RtIndex_c::ProgressiveOptimize ( int iCutoff )
 int RtIndex_c::CommonOptimize ( OptimizeTask_t tTask )
 {
 	bool bProgressive = g_bProgressiveMerge;
+	int iDeadPercent = 0; // explicit OPTIMIZE wipes all the kills
 	int iChunks = 0;
 
 	switch ( tTask.m_eVerb ) // process all 'single' manual commands
@@ -9698,11 +9972,12 @@ int RtIndex_c::CommonOptimize ( OptimizeTask_t tTask )
 	case OptimizeTask_t::eSplit: SplitOneChunk ( tTask.m_iFrom, tTask.m_sUvarFilter.cstr(), &iChunks ); return iChunks;
 	case OptimizeTask_t::eAutoOptimize:
 		bProgressive = true;
+		iDeadPercent = OptimizeDeadPercent();
 	default:
 		break;
 	}
 
-	return bProgressive ? ProgressiveOptimize( tTask.m_iCutoff ) : ClassicOptimize();
+	return bProgressive ? ProgressiveOptimize ( tTask.m_iCutoff, iDeadPercent ) : ClassicOptimize();
 }
 
 void RtIndex_c::CheckStartAutoOptimize()
@@ -9773,6 +10048,7 @@ void RtIndex_c::GetStatus ( CSphIndexStatus * pRes ) const
 		pRes->m_iMappedHits += tDisk.m_iMappedHits;
 		pRes->m_iMappedResidentHits += tDisk.m_iMappedResidentHits;
 		pRes->m_iDead += tDisk.m_iDead;
+		pRes->m_iStaleMinMaxBlocks += tDisk.m_iStaleMinMaxBlocks;
 	}
 
 	pRes->m_iNumRamChunks = tGuard.m_dRamSegs.GetLength();
@@ -9927,8 +10203,12 @@ bool RtIndex_c::Reconfigure ( CSphReconfigureSetup & tSetup )
 	{
 		m_tMutableSettings.Combine ( tSetup.m_tMutableSettings );
 		SetMemLimit ( m_tMutableSettings.m_iMemLimit );
+		SetupRollups();
 	}
 
+	// states of the chunks were built under the old declarations and schema
+	ResetRollups();
+
 	Setup ( tSetup.m_tIndex );
 	SetTokenizer ( tSetup.m_pTokenizer );
 	SetDictionary ( tSetup.m_pDict );
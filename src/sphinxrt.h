@@ -20,6 +20,7 @@
 #include "attribute.h"
 #include "docstore.h"
 #include "columnarrt.h"
+#include "rollup.h"
 #include "coroutine.h"
 #include "tokenizer/tokenizer.h"
 #include "indexing_sources/source_document.h"
@@ -188,6 +189,18 @@ typedef void ProgressCallbackSimple_t ();
 #define SPH_MAX_KEYWORD_LEN (3*SPH_MAX_WORD_LEN+4)
 STATIC_ASSERT ( SPH_MAX_KEYWORD_LEN<255, MAX_KEYWORD_LEN_SHOULD_FITS_BYTE );
 
+struct ChunkMergeStats_t
+{
+	int		m_iId;
+	int64_t	m_iSize;		// effective (alive) size, that is what a merge rewrites
+	int64_t	m_iDiskUse;		// alive + dead
+	int64_t	m_iTotalDocs;
+	int64_t	m_iDeadDocs;
+};
+
+double				MergeWriteAmplification ( const ChunkMergeStats_t & tA, const ChunkMergeStats_t & tB );
+std::pair<int,int>	GetBestMergePair ( const CSphVector<ChunkMergeStats_t> & dChunks, int iMaxWriteAmp );
+
 struct RtDoc_t
 {
 	RowID_t m_tRowID { INVALID_ROWID };	///< row id
@@ -246,6 +259,7 @@ public:
 	DeadRowMap_Ram_c				m_tDeadRowMap;
 	CSphScopedPtr<DocstoreRT_i>		m_pDocstore{nullptr};
 	CSphScopedPtr<ColumnarRT_i>		m_pColumnar{nullptr};
+	mutable RollupCache_c			m_tRollups;				///< per-group aggregates of the declared rollups
 
 	mutable bool					m_bConsistent{false};
 
@@ -433,6 +447,15 @@ volatile bool &RTChangesAllowed () noexcept;
 volatile int & AutoOptimizeCutoffMultiplier() noexcept;
 volatile int & AutoOptimizeCutoff() noexcept;
 
+// auto-optimize compresses only chunks with at least that % of killed docs
+volatile int & OptimizeDeadPercent() noexcept;
+
+// max bytes rewritten per byte of the smaller chunk in one merge (0 = no limit)
+volatile int & OptimizeWriteAmplification() noexcept;
+
+// merge always rewrites both chunks, so any nonzero limit below that would filter out every pair
+static const int OPTIMIZE_MIN_WRITE_AMPLIFICATION = 2;
+
 using EnqueueForOptimizeFnPtr = void (*) ( CSphString , OptimizeTask_t );
 volatile EnqueueForOptimizeFnPtr& EnqueueForOptimizeExecutor() noexcept;
 
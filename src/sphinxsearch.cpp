@@ -192,6 +192,23 @@ protected:
 			return true;
 		}
 
+		if ( eType==EXTRA_SET_ROWID_ITERATOR )
+		{
+			auto & tSetup = *(RowIdIteratorSetup_t*)ppResult;
+			if ( !m_pRoot || m_pOriginalRoot )
+				return false;
+
+			// every filtered row costs a doclist skip, which is several times pricier than decoding a doc and checking filters on it
+			const int64_t SKIP_COST = 4;
+			int64_t iTreeDocs = Min ( (int64_t)m_pRoot->GetDocsCount(), tSetup.m_iTotalDocs );
+			if ( tSetup.m_iRsetEstimate*SKIP_COST>=iTreeDocs )
+				return false;
+
+			m_pOriginalRoot = m_pRoot;
+			m_pRoot = CreateRowIdIteratorNode ( m_pRoot, tSetup.m_pIterator, tSetup.m_bOrdered );
+			return true;
+		}
+
 		return false;
 	}
 };
@@ -4242,6 +4259,7 @@ ISphRanker * sphCreateRanker ( const XQQuery_t & tXQ, const CSphQuery & tQuery,
 
 	// setup eval-tree
 	ExtRanker_c * pRanker = nullptr;
+	tTermSetup.m_bRowidsOnly = ( tQuery.m_eRanker==SPH_RANK_NONE );
 	switch ( tQuery.m_eRanker )
 	{
 		case SPH_RANK_PROXIMITY_BM25:
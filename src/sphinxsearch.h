@@ -102,6 +102,10 @@ public:
 	virtual void				CollectHitMask ();
 	virtual void				Reset();
 
+	/// all the rows of a frequent term as a bitmap, for O(1) membership probes instead of advancing the doclist
+	/// nullptr if the term is not frequent enough or bitmaps are not supported; must be called before iterating
+	virtual const CSphBitvec *	GetDocBitmap() { return nullptr; }
+
 	int							GetAtomPos() const;
 
 	virtual bool SetupScan ( const RtIndex_c * pIndex, int iSegment, const RtGuard_t& tGuard ) { return false; }
@@ -124,6 +128,7 @@ public:
 	mutable ISphZoneCheck *	m_pZoneChecker	{nullptr};
 	CSphQueryStats *		m_pStats		{nullptr};
 	mutable bool			m_bSetQposMask	{false};
+	mutable bool			m_bRowidsOnly	{false};	///< ranker needs neither hits nor per-term fields and tf, just matching rowids
 	DictRefPtr_c			m_pDict;
 	bool					m_bHasWideFields { false };
 
@@ -25,6 +25,7 @@
 #include "docstore.h"
 #include "schema/rset.h"
 #include "aggregate.h"
+#include "civiltime.h"
 
 #include <time.h>
 #include <math.h>
@@ -783,14 +784,18 @@ private:
 	template <typename MATCH, typename PUSHER>
 	bool PushT ( MATCH && tEntry, PUSHER && PUSH )
 	{
-		++m_iTotal;
-
 		if_const ( NOTIFICATIONS )
 		{
 			m_tJustPushed = RowTagged_t();
 			m_dJustPopped.Resize(0);
 		}
 
+		// keyset pagination; rows up to the cursor were on the previous pages
+		if ( !m_tState.IsAfterCursor ( tEntry ) )
+			return true;
+
+		++m_iTotal;
+
 		if ( Used()==m_iSize )
 		{
 			// if it's worse that current min, reject it, else pop off current min
@@ -1093,6 +1098,9 @@ private:
 		}
 
 		// quick early rejection checks
+		if ( !m_tState.IsAfterCursor ( tEntry ) )
+			return true;
+
 		++m_iTotal;
 		if ( m_pWorst && COMP::IsLess ( tEntry, *m_pWorst, m_tState ) )
 			return true;
@@ -1243,8 +1251,9 @@ void CSphUpdateQueue::DoUpdate()
 	if ( !m_iTotal )
 		return;
 
-	int iMemoryNeed = (int) Min ( m_iCount, m_iTotal );
-	m_pWorkSet->m_dDocids.Reserve ( iMemoryNeed );
+	// all the matched docs go as one batch; that is one pass over the index (disk chunks are resolved in parallel)
+	// and one binlog record instead of one per every m_iCount docs
+	m_pWorkSet->m_dDocids.Reserve ( m_iTotal );
 
 	DocID_t iLastId = 0;
 	MemoryReader_c tReader ( m_dDocid.Begin(), m_dDocid.GetLength() );
@@ -1254,15 +1263,9 @@ void CSphUpdateQueue::DoUpdate()
 		DocID_t iCur = iLastId + tReader.UnzipOffset();
 		iLastId = iCur;
 		m_pWorkSet->m_dDocids.Add ( iCur );
-
-		if ( ( ( i+1 )%m_iCount )!=0 )
-			continue;
-
-		Update();
 	}
 
-	if ( !m_pWorkSet->m_dDocids.IsEmpty() )
-		Update();
+	Update();
 }
 
 
@@ -1390,9 +1393,8 @@ static bool IsGroupbyMagic ( const CSphString & s )
 
 #define GROUPER_BEGIN_SPLIT(_name) \
 	GROUPER_BEGIN(_name) \
-	time_t tStamp = (time_t)uValue; \
-	struct tm tSplit; \
-	localtime_r ( &tStamp, &tSplit );
+	CivilTime_t tSplit; \
+	CivilTime::FromLocal ( uValue, tSplit );
 
 GROUPER_BEGIN ( CSphGrouperAttr )
 	return uValue;
@@ -1400,12 +1402,12 @@ GROUPER_END
 
 
 GROUPER_BEGIN_SPLIT ( CSphGrouperDay )
-	return (tSplit.tm_year+1900)*10000 + (1+tSplit.tm_mon)*100 + tSplit.tm_mday;
+	return tSplit.m_iYear*10000 + tSplit.m_iMonth*100 + tSplit.m_iDay;
 GROUPER_END
 
 GROUPER_BEGIN_SPLIT ( CSphGrouperWeek )
-	int iPrevSunday = (1+tSplit.tm_yday) - tSplit.tm_wday; // prev Sunday day of year, base 1
-	int iYear = tSplit.tm_year+1900;
+	int iPrevSunday = (1+tSplit.m_iYearDay) - tSplit.m_iWeekDay; // prev Sunday day of year, base 1
+	int iYear = tSplit.m_iYear;
 	if ( iPrevSunday<=0 ) // check if we crossed year boundary
 	{
 		// adjust day and year
@@ -1420,26 +1422,25 @@ GROUPER_BEGIN_SPLIT ( CSphGrouperWeek )
 GROUPER_END
 
 GROUPER_BEGIN_SPLIT ( CSphGrouperMonth )
-	return (tSplit.tm_year+1900)*100 + (1+tSplit.tm_mon);
+	return tSplit.m_iYear*100 + tSplit.m_iMonth;
 GROUPER_END
 
 GROUPER_BEGIN_SPLIT ( CSphGrouperYear )
-	return (tSplit.tm_year+1900);
+	return tSplit.m_iYear;
 GROUPER_END
 
 #define GROUPER_BEGIN_SPLIT_UTC( _name ) \
     GROUPER_BEGIN(_name) \
-    time_t tStamp = (time_t)uValue; \
-    struct tm tSplit; \
-    gmtime_r ( &tStamp, &tSplit );
+    CivilTime_t tSplit; \
+    CivilTime::FromUTC ( uValue, tSplit );
 
 GROUPER_BEGIN_SPLIT_UTC ( CSphGrouperDayUtc )
-		return (tSplit.tm_year + 1900) * 10000 + (1 + tSplit.tm_mon) * 100 + tSplit.tm_mday;
+		return tSplit.m_iYear * 10000 + tSplit.m_iMonth * 100 + tSplit.m_iDay;
 GROUPER_END
 
 GROUPER_BEGIN_SPLIT_UTC ( CSphGrouperWeekUtc )
-		int iPrevSunday = (1 + tSplit.tm_yday) - tSplit.tm_wday; // prev Sunday day of year, base 1
-		int iYear = tSplit.tm_year + 1900;
+		int iPrevSunday = (1 + tSplit.m_iYearDay) - tSplit.m_iWeekDay; // prev Sunday day of year, base 1
+		int iYear = tSplit.m_iYear;
 		if ( iPrevSunday<=0 ) // check if we crossed year boundary
 		{
 			// adjust day and year
@@ -1454,11 +1455,11 @@ GROUPER_BEGIN_SPLIT_UTC ( CSphGrouperWeekUtc )
 GROUPER_END
 
 GROUPER_BEGIN_SPLIT_UTC ( CSphGrouperMonthUtc )
-		return (tSplit.tm_year + 1900) * 100 + (1 + tSplit.tm_mon);
+		return tSplit.m_iYear * 100 + tSplit.m_iMonth;
 GROUPER_END
 
 GROUPER_BEGIN_SPLIT_UTC ( CSphGrouperYearUtc )
-		return (tSplit.tm_year + 1900);
+		return tSplit.m_iYear;
 GROUPER_END
 
 static bool g_bSortGroupingInUtc = false;
@@ -2647,6 +2648,8 @@ class CSphKBufferGroupSorter : public KBufferGroupSorter_T<COMPGROUP,DISTINCT,NO
 	using MYTYPE = CSphKBufferGroupSorter<COMPGROUP, DISTINCT, NOTIFICATIONS, HAS_AGGREGATES>;
 	bool m_bMatchesFinalized = false;
 	int m_iMaxUsed = -1;
+	CSphVector<SphGroupKey_t> m_dBatchKeys;
+	CSphVector<AggrStep_t> m_dAggrSteps;
 
 protected:
 	OpenHash_T < CSphMatch *, SphGroupKey_t >	m_hGroup2Match;
@@ -2698,10 +2701,35 @@ public:
 	{}
 
 	bool	Push ( const CSphMatch & tEntry ) override						{ return PushEx<false> ( tEntry, m_pGrouper->KeyFromMatch(tEntry), false ); }
-	void	Push ( const VecTraits_T<const CSphMatch> & dMatches ) override	{ assert ( 0 && "Not supported in grouping"); }
 	bool	PushGrouped ( const CSphMatch & tEntry, bool, bool bUpdateDistinct ) override { return PushEx<true> ( tEntry, tEntry.GetAttr ( m_tLocGroupby ), false, nullptr, bUpdateDistinct ); }
 	ISphMatchSorter * Clone() const override								{ return this->template CloneSorterT<MYTYPE>(); }
 
+	/// batch push (from columnar proxy): decode all group keys at once, then probe the hash
+	/// prefetching the slots a few matches ahead so that probes don't stall on cache misses.
+	/// aggregates are not updated match by match; the steps are collected and applied per aggregate
+	/// (see FlushAggrSteps), so that columnar aggregates fetch their values for the whole batch at once
+	void Push ( const VecTraits_T<const CSphMatch> & dMatches ) override
+	{
+		const int PREFETCH_DIST = 8;
+
+		int iMatches = dMatches.GetLength();
+		m_dBatchKeys.Resize ( iMatches );
+		m_pGrouper->KeysFromMatches ( dMatches, m_dBatchKeys.Begin() );
+
+		for ( int i = 0; i < Min ( iMatches, PREFETCH_DIST ); ++i )
+			m_hGroup2Match.Prefetch ( m_dBatchKeys[i] );
+
+		for ( int i = 0; i < iMatches; ++i )
+		{
+			if ( i+PREFETCH_DIST < iMatches )
+				m_hGroup2Match.Prefetch ( m_dBatchKeys[i+PREFETCH_DIST] );
+
+			PushEx<false,true> ( dMatches[i], m_dBatchKeys[i], false );
+		}
+
+		FlushAggrSteps();
+	}
+
 	/// store all entries into specified location in sorted order, and remove them from queue
 	int Flatten ( CSphMatch * pTo ) override
 	{
@@ -2802,6 +2830,7 @@ public:
 	}
 
 protected:
+	template <bool BATCH=false>
 	bool PushIntoExistingGroup( CSphMatch & tGroup, const CSphMatch & tEntry, SphGroupKey_t uGroupKey, bool bGrouped, SphAttr_t * pAttr, bool bUpdateDistinct )
 	{
 		assert ( tGroup.GetAttr ( m_tLocGroupby )==uGroupKey );
@@ -2814,7 +2843,12 @@ protected:
 			tGroup.AddCounterScalar ( tLocCount, 1 );
 
 		if_const ( HAS_AGGREGATES )
-			AggrUpdate ( tGroup, tEntry, bGrouped );
+		{
+			if_const ( BATCH )
+				m_dAggrSteps.Add ( { &tGroup, &tEntry, false } );
+			else
+				AggrUpdate ( tGroup, tEntry, bGrouped );
+		}
 
 		// if new entry is more relevant, update from it
 		if ( m_tSubSorter.MatchIsGreater ( tEntry, tGroup ) )
@@ -2839,7 +2873,8 @@ protected:
 	}
 
 	/// add entry to the queue
-	template <bool GROUPED>
+	/// BATCH means the aggregate steps are deferred until FlushAggrSteps (not grouped matches only)
+	template <bool GROUPED, bool BATCH=false>
 	FORCE_INLINE bool PushEx ( const CSphMatch & tEntry, const SphGroupKey_t uGroupKey, bool, SphAttr_t * pAttr=nullptr, bool bUpdateDistinct=true )
 	{
 		if_const ( NOTIFICATIONS )
@@ -2860,7 +2895,7 @@ protected:
 			CSphMatch * pMatch = (*ppMatch);
 			assert ( pMatch );
 			assert ( pMatch->GetAttr ( m_tLocGroupby )==uGroupKey );
-			return PushIntoExistingGroup ( *pMatch, tEntry, uGroupKey, GROUPED, pAttr, bUpdateDistinct );
+			return PushIntoExistingGroup<BATCH> ( *pMatch, tEntry, uGroupKey, GROUPED, pAttr, bUpdateDistinct );
 		}
 
 		// submit actual distinct value
@@ -2868,8 +2903,14 @@ protected:
 			UpdateDistinct ( tEntry, uGroupKey, GROUPED );
 
 		// if we're full, let's cut off some worst groups
+		// (pending aggregate steps point to the groups, so they have to land before the cut)
 		if ( Used()==m_iSize )
+		{
+			if_const ( BATCH )
+				FlushAggrSteps();
+
 			CutWorst ( m_iLimit * (int)(GROUPBY_FACTOR/2) );
+		}
 
 		// do add
 		assert ( Used()<m_iSize );
@@ -2877,7 +2918,12 @@ protected:
 		m_pSchema->CloneMatch ( tNew, tEntry );
 
 		if_const ( HAS_AGGREGATES )
-			AggrSetup ( tNew, tEntry, GROUPED );
+		{
+			if_const ( BATCH )
+				m_dAggrSteps.Add ( { &tNew, &tEntry, true } );
+			else
+				AggrSetup ( tNew, tEntry, GROUPED );
+		}
 
 		if_const ( NOTIFICATIONS )
 			m_tJustPushed = RowTagged_t ( tNew );
@@ -2905,6 +2951,22 @@ protected:
 
 private:
 	enum class Avg_e { FINALIZE, UNGROUP };
+
+	/// apply the aggregate steps collected by the batch push, in the order of the matches
+	void FlushAggrSteps()
+	{
+		if_const ( !HAS_AGGREGATES )
+			return;
+
+		if ( m_dAggrSteps.IsEmpty() )
+			return;
+
+		for ( auto * pAggregate : this->m_dAggregates )
+			pAggregate->UpdateBatch ( m_dAggrSteps );
+
+		m_dAggrSteps.Resize(0);
+	}
+
 	void CalcAvg ( Avg_e eGroup )
 	{
 		if ( m_dAvgs.IsEmpty() )
@@ -4634,6 +4696,7 @@ private:
 	void	ReplaceJsonWithExprs ( CSphMatchComparatorState & tState, CSphVector<ExtraSortExpr_t> & dExtraExprs );
 	void	AddColumnarExprsAsAttrs ( CSphMatchComparatorState & tState, CSphVector<ExtraSortExpr_t> & dExtraExprs );
 	void	RemapAttrs ( CSphMatchComparatorState & tState, CSphVector<ExtraSortExpr_t> & dExtraExprs );
+	void	AddStringSortKeys ( CSphMatchComparatorState & tState );
 	void	SetupRemapColJson ( CSphColumnInfo & tRemapCol, CSphMatchComparatorState & tState, CSphVector<ExtraSortExpr_t> & dExtraExprs, int iStateAttr ) const;
 	const CSphColumnInfo * GetGroupbyStr ( int iAttr, int iNumOldAttrs ) const;
 
@@ -4641,6 +4704,7 @@ private:
 	bool	SetupGroupSortingFunc ( bool bGotDistinct );
 	bool	AddGroupbyStuff();
 	bool	SetGroupSorting();
+	bool	SetupSearchAfter();
 	void	ExtraAddSortkeys ( const int * dAttrs );
 	bool	AddStoredFieldExpressions();
 	bool	AddColumnarAttributeExpressions();
@@ -5070,6 +5134,51 @@ private:
 };
 
 
+// expression that calculates collated sort key prefix of a string ptr attr
+class ExprSortStringKey_c : public ISphExpr
+{
+public:
+	ExprSortStringKey_c ( const CSphAttrLocator & tLocator, StrSortKey_fn fnKey )
+		: m_tLocator ( tLocator )
+		, m_fnKey ( fnKey )
+	{}
+
+	float Eval ( const CSphMatch & tMatch ) const override { return (float)Int64Eval ( tMatch ); }
+	int IntEval ( const CSphMatch & tMatch ) const override { return (int)Int64Eval ( tMatch ); }
+
+	int64_t Int64Eval ( const CSphMatch & tMatch ) const override
+	{
+		// keys are unsigned, but attrs are compared as signed
+		uint64_t uKey = m_fnKey ( sphUnpackPtrAttr ( (const BYTE *)tMatch.GetAttr ( m_tLocator ) ) );
+		return (int64_t)( uKey ^ 0x8000000000000000ULL );
+	}
+
+	void FixupLocator ( const ISphSchema * pOldSchema, const ISphSchema * pNewSchema ) override
+	{
+		sphFixupLocator ( m_tLocator, pOldSchema, pNewSchema );
+	}
+
+	void Command ( ESphExprCommand, void * ) override {}
+
+	uint64_t GetHash ( const ISphSchema & tSorterSchema, uint64_t uPrevHash, bool & bDisable ) override
+	{
+		EXPR_CLASS_NAME_NOCHECK("ExprSortStringKey_c");
+		uHash = sphFNV64 ( &m_tLocator, sizeof(m_tLocator), uHash );
+		CALC_POD_HASH(m_fnKey);
+		return CALC_DEP_HASHES();
+	}
+
+	ISphExpr * Clone() const final
+	{
+		return new ExprSortStringKey_c ( m_tLocator, m_fnKey );
+	}
+
+private:
+	CSphAttrLocator		m_tLocator;
+	StrSortKey_fn		m_fnKey;
+};
+
+
 // expression that transform string pool base + offset -> ptr
 class ExprSortJson2StringPtr_c : public BlobPool_c, public ISphExpr
 {
@@ -6159,6 +6268,50 @@ void QueueCreator_c::RemapAttrs ( CSphMatchComparatorState & tState, CSphVector<
 		ExtraAddSortkeys ( tState.m_dAttrs );
 }
 
+
+void QueueCreator_c::AddStringSortKeys ( CSphMatchComparatorState & tState )
+{
+	// strings that we evaluate at presort anyway also get a precomputed 8-byte collated prefix
+	// so that most of the comparisons in the queue are just integer compares
+	// final merges do not compute anything, so there's nothing to precompute there
+	if ( !m_tSettings.m_bComputeItems )
+		return;
+
+	StrSortKey_fn fnKey = GetStringSortKeyFunc ( m_tQuery.m_eCollation );
+	if ( !fnKey )
+		return;
+
+	assert ( m_pSorterSchema );
+	auto & tSorterSchema = *m_pSorterSchema.Ptr();
+
+	for ( int i = 0; i<CSphMatchComparatorState::MAX_ATTRS; i++ )
+	{
+		if ( tState.m_eKeypart[i]!=SPH_KEYPART_STRINGPTR || !tState.m_dRemapped.BitGet(i) || tState.m_dAttrs[i]<0 )
+			continue;
+
+		const CSphColumnInfo & tStrCol = tSorterSchema.GetAttr ( tState.m_dAttrs[i] );
+		if ( tStrCol.m_eStage!=SPH_EVAL_PRESORT || !tStrCol.m_pExpr || tStrCol.m_eAggrFunc!=SPH_AGGR_NONE )
+			continue;
+
+		CSphString sKeyCol;
+		sKeyCol.SetSprintf ( "%s@sortkey_%s", g_sIntAttrPrefix, tStrCol.m_sName.cstr() );
+
+		int iKey = tSorterSchema.GetAttrIndex ( sKeyCol.cstr() );
+		if ( iKey==-1 )
+		{
+			CSphColumnInfo tKeyCol ( sKeyCol.cstr(), SPH_ATTR_BIGINT );
+			tKeyCol.m_eStage = SPH_EVAL_PRESORT;
+			tKeyCol.m_pExpr = new ExprSortStringKey_c ( tStrCol.m_tLocator, fnKey );
+
+			iKey = tSorterSchema.GetAttrsCount();
+			tSorterSchema.AddAttr ( tKeyCol, true );
+		}
+
+		tState.m_tKeyLocator[i] = tSorterSchema.GetAttr(iKey).m_tLocator;
+		tState.m_uKeyedAttrs |= 1<<i;
+	}
+}
+
 // matches sorting function
 bool QueueCreator_c::SetupMatchesSortingFunc ()
 {
@@ -6176,6 +6329,7 @@ bool QueueCreator_c::SetupMatchesSortingFunc ()
 
 		AssignOrderByToPresortStage ( m_tStateMatch.m_dAttrs, CSphMatchComparatorState::MAX_ATTRS );
 		RemapAttrs ( m_tStateMatch, m_dMatchJsonExprs );
+		AddStringSortKeys ( m_tStateMatch );
 		return true;
 	}
 
@@ -6204,6 +6358,7 @@ bool QueueCreator_c::SetupMatchesSortingFunc ()
 		m_tStateMatch.m_tLocator[0] = tAttr.m_tLocator;
 		m_tStateMatch.m_dAttrs[0] = iSortAttr;
 		RemapAttrs ( m_tStateMatch, m_dMatchJsonExprs );
+		AddStringSortKeys ( m_tStateMatch );
 	}
 
 	ExtraAddSortkeys ( m_tStateMatch.m_dAttrs );
@@ -6357,6 +6512,63 @@ bool QueueCreator_c::SetGroupSorting()
 }
 
 
+bool QueueCreator_c::SetupSearchAfter()
+{
+	m_tStateMatch.m_pAfter = nullptr;
+
+	// final (merging) sorters get matches that already passed the cursor on indexes and agents
+	if ( m_tQuery.m_dSearchAfter.IsEmpty() || !m_tSettings.m_bComputeItems )
+		return true;
+
+	if ( m_bGotGroupby )
+		return Err ( "search_after is not supported with GROUP BY" );
+
+	if ( m_tQuery.m_eSort!=SPH_SORT_EXTENDED || m_bRandomize || m_eMatchFunc<FUNC_GENERIC1 || m_eMatchFunc>FUNC_GENERIC5 )
+		return Err ( "search_after requires an explicit ORDER BY" );
+
+	int iKeys = m_eMatchFunc-FUNC_GENERIC1+1;
+	if ( m_tQuery.m_dSearchAfter.GetLength()>iKeys )
+		return Err ( "search_after has %d values, but ORDER BY has %d sort key(s)", m_tQuery.m_dSearchAfter.GetLength(), iKeys );
+
+	SharedPtr_t<SearchAfter_t> pAfter { new SearchAfter_t };
+	pAfter->m_iKeys = m_tQuery.m_dSearchAfter.GetLength();
+	ARRAY_FOREACH ( i, m_tQuery.m_dSearchAfter )
+	{
+		const char * szValue = m_tQuery.m_dSearchAfter[i].scstr();
+		char * szEnd = nullptr;
+		switch ( m_tStateMatch.m_eKeypart[i] )
+		{
+		case SPH_KEYPART_WEIGHT:
+		case SPH_KEYPART_INT:
+			pAfter->m_dInts[i] = strtoll ( szValue, &szEnd, 10 );
+			break;
+
+		case SPH_KEYPART_FLOAT:
+			pAfter->m_dFloats[i] = (float)strtod ( szValue, &szEnd );
+			break;
+
+		case SPH_KEYPART_STRINGPTR:
+		{
+			auto iLen = (int) strlen ( szValue );
+			CSphVector<BYTE> & dPacked = pAfter->m_dStrings[i];
+			dPacked.Resize ( sphCalcPackedLength ( iLen ) );
+			sphPackPtrAttr ( dPacked.Begin(), { (const BYTE *)szValue, iLen } );
+			break;
+		}
+
+		default:
+			return Err ( "search_after: sort key %d can not be used in a cursor", i+1 );
+		}
+
+		if ( szEnd && ( szEnd==szValue || *szEnd ) )
+			return Err ( "search_after: value '%s' for sort key %d is not a number", szValue, i+1 );
+	}
+
+	m_tStateMatch.m_pAfter = pAfter;
+	return true;
+}
+
+
 bool QueueCreator_c::PredictAggregates() const
 {
 	for ( int i = 0; i < m_pSorterSchema->GetAttrsCount(); i++ )
@@ -6397,10 +6609,23 @@ ISphMatchSorter * QueueCreator_c::SpawnQueue()
 		if ( !pResult )
 			return nullptr;
 
+		// columnar proxy rejects by the worst match before the cursor check, and it assumes every pushed match is kept
+		if ( m_tStateMatch.m_pAfter )
+			return pResult;
+
 		return CreateColumnarProxySorter ( pResult, iMaxMatches, *m_pSorterSchema, m_tStateMatch, m_eMatchFunc, bNeedFactors, m_tSettings.m_bComputeItems, m_bMulti );
 	}
 
-	return sphCreateSorter1st ( m_eMatchFunc, m_eGroupFunc, &m_tQuery, m_tGroupSorterSettings, bNeedFactors, PredictAggregates() );
+	ISphMatchSorter * pResult = sphCreateSorter1st ( m_eMatchFunc, m_eGroupFunc, &m_tQuery, m_tGroupSorterSettings, bNeedFactors, PredictAggregates() );
+	if ( !pResult )
+		return nullptr;
+
+	// only the plain kbuffer group sorter supports batch pushes
+	bool bBatchPush = !m_tGroupSorterSettings.m_bJson && m_tQuery.m_iGroupbyLimit<=1 && !m_tGroupSorterSettings.m_bImplicit;
+	if ( !bBatchPush )
+		return pResult;
+
+	return CreateColumnarProxyGroupSorter ( pResult, *m_pSorterSchema, m_tGroupSorterSettings.m_pGrouper, bNeedFactors, m_tSettings.m_bComputeItems, m_bMulti );
 }
 
 bool QueueCreator_c::SetupComputeQueue ()
@@ -6415,7 +6640,8 @@ bool QueueCreator_c::SetupGroupQueue ()
 {
 	return AddGroupbyStuff ()
 		&& SetupMatchesSortingFunc ()
-		&& SetGroupSorting ();
+		&& SetGroupSorting ()
+		&& SetupSearchAfter ();
 }
 
 bool QueueCreator_c::ConvertColumnarToDocstore()
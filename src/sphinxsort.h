@@ -159,6 +159,16 @@ public:
 	virtual bool			IsMultiValue() const { return false; }
 	virtual void			SetColumnar ( const columnar::Columnar_i * ) {}
 
+	/// true if the grouper decodes keys for a batch of matches faster than one by one
+	virtual bool			CanFetchKeys() const { return false; }
+
+	/// fills pKeys with one group key per match
+	virtual void			KeysFromMatches ( const VecTraits_T<const CSphMatch> & dMatches, SphGroupKey_t * pKeys ) const
+	{
+		for ( const auto & tMatch : dMatches )
+			*pKeys++ = KeyFromMatch(tMatch);
+	}
+
 protected:
 							~CSphGrouper () override {} // =default causes bunch of errors building on wheezy
 };
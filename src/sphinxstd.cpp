@@ -774,7 +774,50 @@ const char * GET_MANTICORE_MODULES ()
 	return sModulesPrefix.cstr();
 }
 
+static HugePages_e g_eHugePages = HugePages_e::NONE;
+static std::atomic<int64_t> g_iHugeAdvised { 0 };
+static std::atomic<int64_t> g_iHugeFallbacks { 0 };
+static std::atomic<int64_t> g_iHugeExplicitBytes { 0 };
+
+void SetHugePages ( HugePages_e eMode )
+{
+	g_eHugePages = eMode;
+}
+
+HugePages_e GetHugePages()
+{
+	return g_eHugePages;
+}
+
+HugePagesStats_t GetHugePagesStats()
+{
+	HugePagesStats_t tStats;
+	tStats.m_iAdvised = g_iHugeAdvised.load ( std::memory_order_relaxed );
+	tStats.m_iFallbacks = g_iHugeFallbacks.load ( std::memory_order_relaxed );
+	tStats.m_iExplicitBytes = g_iHugeExplicitBytes.load ( std::memory_order_relaxed );
+	return tStats;
+}
+
+// warn only once, then just count; huge pages unavailability is not an error
+static void HugePagesFallback ( const char * szWhat )
+{
+	if ( !g_iHugeFallbacks.fetch_add ( 1, std::memory_order_relaxed ) )
+		sphWarning ( "huge_pages: %s failed (%s), falling back to regular pages", szWhat, strerrorm(errno) );
+}
+
 #if _WIN32
+	void * mmallochuge ( size_t uSize, Share_e eAccess, size_t & uMapped, bool & bExplicit )
+	{
+		uMapped = uSize;
+		bExplicit = false;
+		return mmalloc ( uSize, Mode_e::RW, eAccess );
+	}
+
+	int mmfreehuge ( void * pMem, size_t uMapped, bool )
+	{
+		return mmfree ( pMem, uMapped );
+	}
+
 	void * mmalloc ( size_t uSize, Mode_e, Share_e )
 	{
 		return ::malloc ( (size_t)uSize );
@@ -867,6 +910,89 @@ void mmadvise ( void * pMem, size_t uSize, Advise_e eAdvise )
 	}
 }
 
+// advise the whole 2M pages inside of our own anonymous mapping; refusal is not an error, just fallback to regular pages
+static void AdviseHugePages ( void * pMem, size_t uSize )
+{
+	// only whole aligned 2M pages inside of the region may be huge
+	auto uStart = ( (uintptr_t)pMem + HUGE_PAGE_SIZE - 1 ) & ~( HUGE_PAGE_SIZE - 1 );
+	auto uEnd = ( (uintptr_t)pMem + uSize ) & ~( HUGE_PAGE_SIZE - 1 );
+	if ( uEnd<=uStart )
+		return;
+
+#ifdef MADV_HUGEPAGE
+	if ( madvise ( (void *)uStart, uEnd-uStart, MADV_HUGEPAGE )==0 )
+	{
+		g_iHugeAdvised.fetch_add ( 1, std::memory_order_relaxed );
+		return;
+	}
+#else
+	errno = ENOSYS;
+#endif
+
+	HugePagesFallback ( "madvise(MADV_HUGEPAGE)" );
+}
+
+void * mmallochuge ( size_t uSize, Share_e eAccess, size_t & uMapped, bool & bExplicit )
+{
+	uMapped = uSize;
+	bExplicit = false;
+	if ( g_eHugePages==HugePages_e::NONE || uSize<HUGE_PAGE_MIN_BUFFER )
+		return mmalloc ( uSize, Mode_e::RW, eAccess );
+
+#ifdef MAP_HUGETLB
+	// hugetlb mapping is made of whole huge pages, so only here the size is rounded up
+	if ( g_eHugePages==HugePages_e::EXPLICIT )
+	{
+		size_t uRounded = ( uSize + HUGE_PAGE_SIZE - 1 ) & ~( HUGE_PAGE_SIZE - 1 );
+		void * pMem = mmap ( nullptr, uRounded, PROT_READ | PROT_WRITE, hwShare ( eAccess ) | MAP_HUGETLB, -1, 0 );
+		if ( pMem!=MAP_FAILED )
+		{
+			uMapped = uRounded;
+			bExplicit = true;
+			g_iHugeExplicitBytes.fetch_add ( uRounded, std::memory_order_relaxed );
+			return pMem;
+		}
+
+		HugePagesFallback ( "mmap(MAP_HUGETLB)" );
+	}
+#endif
+
+	// over-allocate, then trim head and tail, so that mapping starts at 2M boundary and keeps its size
+	// (shared mappings can't be trimmed safely, only their aligned middle is advised)
+	if ( eAccess==Share_e::ANON_SHARED )
+	{
+		void * pMem = mmalloc ( uSize, Mode_e::RW, eAccess );
+		if ( mmapvalid ( pMem ) )
+			AdviseHugePages ( pMem, uSize );
+		return pMem;
+	}
+
+	auto * pRaw = (BYTE *) mmalloc ( uSize + HUGE_PAGE_SIZE, Mode_e::RW, eAccess );
+	if ( !mmapvalid ( pRaw ) )
+		return pRaw;
+
+	auto * pAligned = (BYTE *) ( ( (uintptr_t)pRaw + HUGE_PAGE_SIZE - 1 ) & ~( HUGE_PAGE_SIZE - 1 ) );
+	if ( pAligned>pRaw )
+		munmap ( pRaw, pAligned-pRaw );
+
+	auto uPage = (size_t) sphGetMemPageSize();
+	BYTE * pTail = pAligned + ( ( uSize + uPage - 1 ) & ~( uPage - 1 ) );
+	BYTE * pRawEnd = pRaw + uSize + HUGE_PAGE_SIZE;
+	if ( pRawEnd>pTail )
+		munmap ( pTail, pRawEnd-pTail );
+
+	// the tail shorter than 2M stays on regular pages
+	AdviseHugePages ( pAligned, uSize );
+	return pAligned;
+}
+
+int mmfreehuge ( void * pMem, size_t uMapped, bool bExplicit )
+{
+	if ( bExplicit )
+		g_iHugeExplicitBytes.fetch_sub ( uMapped, std::memory_order_relaxed );
+	return mmfree ( pMem, uMapped );
+}
+
 bool mmlock ( void * pMem, size_t uSize )
 {
 	return mlock ( pMem, uSize )==0;
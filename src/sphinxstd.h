@@ -4170,6 +4170,32 @@ void mmadvise ( void* pMem, size_t uSize, Advise_e = Advise_e::NODUMP );
 bool mmlock( void * pMem, size_t uSize );
 bool mmunlock( void * pMem, size_t uSize );
 
+enum class HugePages_e
+{
+	NONE,			///< regular pages only (default)
+	TRANSPARENT,	///< ask kernel for transparent huge pages with madvise()
+	EXPLICIT,		///< use preallocated hugetlb pages for anonymous buffers, fall back to transparent
+};
+
+static const size_t HUGE_PAGE_SIZE = 2*1024*1024;
+static const size_t HUGE_PAGE_MIN_BUFFER = 8*HUGE_PAGE_SIZE; // smaller buffers stay on regular pages; explicit rounding wastes at most 1/8
+
+struct HugePagesStats_t
+{
+	int64_t m_iAdvised = 0;			///< regions advised to use transparent huge pages
+	int64_t m_iFallbacks = 0;		///< regions where huge pages were refused by the kernel
+	int64_t m_iExplicitBytes = 0;	///< currently allocated from hugetlb pool
+};
+
+void SetHugePages ( HugePages_e eMode );
+HugePages_e GetHugePages();
+HugePagesStats_t GetHugePagesStats();
+
+/// anonymous mapping that might be backed by huge pages (only large ones are, see HUGE_PAGE_MIN_BUFFER)
+/// uMapped receives the size to be passed to mmfreehuge()
+void * mmallochuge ( size_t uSize, Share_e eAccess, size_t & uMapped, bool & bExplicit );
+int mmfreehuge ( void * pMem, size_t uMapped, bool bExplicit );
+
 //////////////////////////////////////////////////////////////////////////
 
 /// buffer trait that neither own buffer nor clean-up it on destroy
@@ -4269,7 +4295,7 @@ public:
 			return false;
 		}
 
-		auto * pData = (T *) mmalloc ( iLength, Mode_e::RW, SHARED ? Share_e::ANON_SHARED : Share_e::ANON_PRIVATE );
+		auto * pData = (T *) mmallochuge ( iLength, SHARED ? Share_e::ANON_SHARED : Share_e::ANON_PRIVATE, m_uMapped, m_bExplicitHuge );
 		if ( !mmapvalid ( pData ) )
 		{
 			if ( iLength>(int64_t)0x7fffffffUL )
@@ -4299,13 +4325,19 @@ public:
 		if ( !this->GetWritePtr() )
 			return;
 
-		int iRes = mmfree ( this->GetWritePtr(), this->GetLengthBytes() );
+		int iRes = mmfreehuge ( this->GetWritePtr(), m_uMapped, m_bExplicitHuge );
 		if ( iRes )
 			sphWarn ( "munmap() failed: %s", strerrorm(errno) );
 
 		sph::MemStatMMapDel ( this->GetLengthBytes() );
 		this->Set ( NULL, 0 );
+		m_uMapped = 0;
+		m_bExplicitHuge = false;
 	}
+
+private:
+	size_t	m_uMapped = 0;
+	bool	m_bExplicitHuge = false;
 };
 
 //////////////////////////////////////////////////////////////////////////
@@ -5299,6 +5331,15 @@ public:
 		return m_iSize * sizeof ( Entry_t );
 	}
 
+	/// hint the cpu that the slot for k is going to be probed soon
+	void Prefetch ( KEY k ) const
+	{
+#if defined(__GNUC__)
+		if ( m_pHash )
+			__builtin_prefetch ( m_pHash + ( HASHFUNC::GetHash(k) & ( m_iSize-1 ) ) );
+#endif
+	}
+
 	/// iterate the hash by entry index, starting from 0
 	/// finds the next alive key-value pair starting from the given index
 	/// returns that pair and updates the index on success
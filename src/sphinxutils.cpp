@@ -793,11 +793,13 @@ static KeyDesc_t g_dKeysIndex[] =
 	{ "access_blob_attrs",		0, nullptr },
 	{ "access_doclists",		0, nullptr },
 	{ "access_hitlists",		0, nullptr },
+	{ "rollup",					0, nullptr },
 	{ "stored_fields",			0, nullptr },
 	{ "stored_only_fields",		0, nullptr },
 	{ "docstore_block_size",	0, nullptr },
 	{ "docstore_compression",	0, nullptr },
 	{ "docstore_compression_level",	0, nullptr },
+	{ "docstore_separate_fields",	0, nullptr },
 	{ "columnar_attrs",			0, nullptr },
 	{ "columnar_no_fast_fetch", 0, nullptr },
 	{ "rowwise_attrs",			0, nullptr },
@@ -867,6 +869,7 @@ static KeyDesc_t g_dKeysSearchd[] =
 	{ "binlog_flush",			0, NULL },
 	{ "binlog_path",			0, NULL },
 	{ "binlog_max_log_size",	0, NULL },
+	{ "binlog_common",			0, NULL },
 	{ "thread_stack",			0, NULL },
 	{ "expansion_limit",		0, NULL },
 	{ "rt_flush_period",		0, NULL },
@@ -901,6 +904,9 @@ static KeyDesc_t g_dKeysSearchd[] =
 	{ "qcache_ttl_sec",			0, NULL },
 	{ "qcache_max_bytes",		0, NULL },
 	{ "qcache_thresh_msec",		0, NULL },
+	{ "rcache_ttl_sec",			0, NULL },
+	{ "rcache_max_bytes",		0, NULL },
+	{ "rcache_thresh_msec",		0, NULL },
 	{ "sphinxql_timeout",		0, NULL },
 	{ "hostname_lookup",		0, NULL },
 	{ "grouping_in_utc",		0, NULL },
@@ -915,17 +921,25 @@ static KeyDesc_t g_dKeysSearchd[] =
 	{ "access_doclists",		0, nullptr },
 	{ "access_hitlists",		0, nullptr },
 	{ "docstore_cache_size",	0, nullptr },
+	{ "doclist_bitmap_cache_size",	0, nullptr },
 	{ "ssl_cert",				0, nullptr },
 	{ "ssl_key",				0, nullptr },
 	{ "ssl_ca",					0, nullptr },
 	{ "max_connections",		0, nullptr },
 	{ "threads",				0, nullptr },
+	{ "numa_aware",				0, nullptr },
+	{ "huge_pages",				0, nullptr },
 	{ "jobs_queue_size",		0, nullptr },
+	{ "queue_max_wait",			0, nullptr },
+	{ "queue_max_wait_low",		0, nullptr },
 	{ "not_terms_only_allowed",	0, nullptr },
 	{ "query_log_commands",		0, nullptr },
 	{ "auto_optimize",			0, nullptr },
 	{ "pseudo_sharding",		0, nullptr },
 	{ "optimize_cutoff",		0, nullptr },
+	{ "optimize_dead_percent",	0, nullptr },
+	{ "optimize_write_amplification",	0, nullptr },
+	{ "minmax_refresh_period",	0, nullptr },
 	{ NULL,						0, NULL }
 };
 
@@ -0,0 +1,67 @@
+//
+// Copyright (c) 2022, Manticore Software LTD (https://manticoresearch.com)
+// All rights reserved
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License. You should have
+// received a copy of the GPL license along with this program; if you
+// did not, you can find it at http://www.gnu.org/
+//
+
+#include "taskminmax.h"
+#include "searchdtask.h"
+#include "searchdaemon.h"
+#include "coroutine.h"
+
+// blocks refreshed under one lock of an index; updates and kills of that index wait meanwhile
+static const int MINMAX_REFRESH_BATCH = 1024;
+
+static int64_t g_iMinMaxRefreshPeriodUs = DEFAULT_MINMAX_REFRESH_PERIOD;
+static int64_t g_iLastRefreshFinishedTime = 0;
+
+void SetMinMaxRefreshPeriod ( int64_t iPeriod )
+{
+	g_iMinMaxRefreshPeriodUs = iPeriod;
+}
+
+static void RefreshMinMax ( void* )
+{
+	auto pDesc = PublishSystemInfo ( "REFRESH minmax" );
+
+	int64_t iTotal = 0;
+	for ( RLockedServedIt_c it ( g_pLocalIndexes ); it.Next (); )
+	{
+		ServedDescRPtr_c pServed ( it.Get ());
+		if ( !pServed )
+			continue;
+
+		int iRefreshed;
+		do
+		{
+			iRefreshed = pServed->m_pIndex->RefreshStaleMinMax ( MINMAX_REFRESH_BATCH );
+			iTotal += iRefreshed;
+			Threads::Coro::Reschedule();
+		} while ( iRefreshed==MINMAX_REFRESH_BATCH && !sphInterrupted() );
+	}
+
+	if ( iTotal )
+		sphLogDebug ( "minmax: " INT64_FMT " stale blocks refreshed", iTotal );
+
+	g_iLastRefreshFinishedTime = sphMicroTimer();
+	ScheduleMinMaxRefresh();
+}
+
+void ScheduleMinMaxRefresh()
+{
+	if ( !g_iMinMaxRefreshPeriodUs )
+		return;
+
+	static TaskID iRefreshTask = -1;
+	if ( iRefreshTask<0 )
+		iRefreshTask = TaskManager::RegisterGlobal ( "Refresh stale attribute min/max", RefreshMinMax, nullptr, 1, 1 );
+
+	if ( !g_iLastRefreshFinishedTime )
+		g_iLastRefreshFinishedTime = sphMicroTimer();
+
+	TaskManager::ScheduleJob ( iRefreshTask, g_iLastRefreshFinishedTime + g_iMinMaxRefreshPeriodUs );
+}
@@ -0,0 +1,26 @@
+//
+// Copyright (c) 2022, Manticore Software LTD (https://manticoresearch.com)
+// All rights reserved
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License. You should have
+// received a copy of the GPL license along with this program; if you
+// did not, you can find it at http://www.gnu.org/
+//
+/// @file taskminmax.h
+/// Task to tighten attribute block min/max of local indexes after updates and kills
+
+#ifndef MANTICORE_TASKMINMAX_H
+#define MANTICORE_TASKMINMAX_H
+
+#include "sphinxstd.h"
+
+#define DEFAULT_MINMAX_REFRESH_PERIOD (60*1000000)
+
+// set from param `minmax_refresh_period`; 0 means "do not refresh"
+void SetMinMaxRefreshPeriod ( int64_t iPeriod );
+
+// start periodical refresh, if enabled
+void ScheduleMinMaxRefresh();
+
+#endif //MANTICORE_TASKMINMAX_H
@@ -12,6 +12,7 @@
 #include "taskoptimize.h"
 #include "searchdtask.h"
 #include "searchdaemon.h"
+#include "coroutine.h"
 
 /////////////////////////////////////////////////////////////////////////////
 // index optimization
@@ -47,6 +48,9 @@ void EnqueueForOptimize ( CSphString sIndex, OptimizeTask_t tTask )
 				// want to track optimize only at work
 				auto pDesc = PublishSystemInfo ( "OPTIMIZE" );
 
+				// merges must not delay searches
+				Threads::Coro::SetPriority ( Threads::Priority_e::LOW );
+
 				// FIXME: MVA update would wait w-lock here for a very long time
 				assert ( dReadLocked->m_eType==IndexType_e::RT );
 				static_cast<RtIndex_i*> ( dReadLocked->m_pIndex )->Optimize ( std::move ( pJob->m_tTask ) );
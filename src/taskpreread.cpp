@@ -12,6 +12,7 @@
 #include "taskpreread.h"
 #include "searchdtask.h"
 #include "searchdaemon.h"
+#include "numautils.h"
 
 OneshotEvent_c g_tPrereadFinished;
 
@@ -46,8 +47,12 @@ static void PrereadFunc ( void* )
 
 		sphLogDebug ( "prereading index '%s'", sName.cstr ());
 
-		dReadLock->m_pIndex->Preread ();
+		// with numa_aware, touch the index from its node, so that its pages are allocated there
+		int iNode = Numa::AssignIndexNode();
+		Numa::RunOnNode ( iNode, [&dReadLock] { dReadLock->m_pIndex->Preread (); } );
 		ServedDesc_t::UpdateMass ( dReadLock );
+		ServedDesc_t::SetNumaNode ( dReadLock, iNode );
+		Numa::AddIndexMass ( iNode, dReadLock->m_iMass );
 		if ( !dReadLock->m_pIndex->GetLastWarning ().IsEmpty ())
 			sphWarning ( "'%s' preread: %s", sName.cstr (), dReadLock->m_pIndex->GetLastWarning ().cstr ());
 
@@ -0,0 +1,35 @@
+//
+// Copyright (c) 2017-2022, Manticore Software LTD (https://manticoresearch.com)
+// All rights reserved
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License. You should have
+// received a copy of the GPL license along with this program; if you
+// did not, you can find it at http://www.gnu.org/
+//
+
+#include "taskqcache.h"
+#include "searchdtask.h"
+#include "sphinxqcache.h"
+
+// sweep twice per ttl, but not more often than once a second
+static int64_t QcacheSweepPeriod ()
+{
+	return Max ( (int64_t)QcacheGetStatus().m_iTtlS * 500000, (int64_t)1000000 );
+}
+
+static void QcacheSweepFunc ( void* )
+{
+	if ( QcacheGetStatus().m_iMaxBytes>0 )
+		QcacheSweep();
+
+	ScheduleQcacheSweep();
+}
+
+void ScheduleQcacheSweep ()
+{
+	static int iQcacheSweepTask = -1;
+	if ( iQcacheSweepTask<0 )
+		iQcacheSweepTask = TaskManager::RegisterGlobal ( "Query cache ttl sweep", QcacheSweepFunc, nullptr, 1, 1 );
+	TaskManager::ScheduleJob ( iQcacheSweepTask, sphMicroTimer() + QcacheSweepPeriod() );
+}
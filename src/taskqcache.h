@@ -0,0 +1,19 @@
+//
+// Copyright (c) 2017-2022, Manticore Software LTD (https://manticoresearch.com)
+// All rights reserved
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License. You should have
+// received a copy of the GPL license along with this program; if you
+// did not, you can find it at http://www.gnu.org/
+//
+
+/// @file taskqcache.h
+/// Task to periodically drop query cache entries expired by ttl
+
+#ifndef MANTICORE_TASKQCACHE_H
+#define MANTICORE_TASKQCACHE_H
+
+void ScheduleQcacheSweep ();
+
+#endif //MANTICORE_TASKQCACHE_H
@@ -0,0 +1,182 @@
+//
+// Copyright (c) 2022, Manticore Software LTD (https://manticoresearch.com)
+// All rights reserved
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License. You should have
+// received a copy of the GPL license along with this program; if you
+// did not, you can find it at http://www.gnu.org/
+//
+
+#include "termfilter.h"
+#include "fileio.h"
+#include "fnv64.h"
+
+namespace {
+
+// 256-bit blocks of 8 words, one bit set per word; ~12 bits per term give under 1% false positives
+const int		WORDS_PER_BLOCK = 8;
+const int		BITS_PER_TERM = 12;
+const DWORD		TERM_FILTER_VERSION = 2;
+const int		DICT_SIGNATURE_BYTES = 65536;
+
+const DWORD g_dSalts[WORDS_PER_BLOCK] = { 0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU, 0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U };
+
+inline uint64_t Mix ( uint64_t uKey )
+{
+	uKey ^= uKey >> 33;
+	uKey *= 0xff51afd7ed558ccdULL;
+	uKey ^= uKey >> 33;
+	return uKey;
+}
+
+inline DWORD BlockOf ( uint64_t uHash, DWORD uBlocks )
+{
+	return DWORD ( ( ( uHash >> 32 ) * uBlocks ) >> 32 );
+}
+
+inline DWORD BitOf ( uint64_t uHash, int iWord )
+{
+	return 1U << ( ( DWORD(uHash) * g_dSalts[iWord] ) >> 27 );
+}
+
+// dictionary file size and the hash of its checkpoints (the head of them, for huge dictionaries)
+// checkpoints hold every few terms with their offsets, so another dictionary hardly ever matches
+bool DictSignature ( const CSphString & sDictFile, int64_t iDictCheckpointsOffset, uint64_t & uSignature, CSphString & sError )
+{
+	CSphAutoreader tReader;
+	if ( !tReader.Open ( sDictFile, sError ) )
+		return false;
+
+	SphOffset_t iSize = tReader.GetFilesize();
+	if ( iDictCheckpointsOffset<0 || iDictCheckpointsOffset>iSize )
+	{
+		sError.SetSprintf ( "dictionary checkpoints offset " INT64_FMT " is out of %s", iDictCheckpointsOffset, sDictFile.cstr() );
+		return false;
+	}
+
+	int iBytes = (int)Min ( iSize-iDictCheckpointsOffset, (SphOffset_t)DICT_SIGNATURE_BYTES );
+	CSphFixedVector<BYTE> dBytes ( iBytes );
+	tReader.SeekTo ( iDictCheckpointsOffset, iBytes );
+	tReader.GetBytes ( dBytes.Begin(), iBytes );
+	if ( tReader.GetErrorFlag() )
+	{
+		sError = tReader.GetErrorMessage();
+		return false;
+	}
+
+	uSignature = sphFNV64 ( dBytes.Begin(), iBytes, sphFNV64 ( &iSize, sizeof(iSize) ) );
+	return true;
+}
+
+} // namespace
+
+
+bool TermFilter_c::MayContain ( uint64_t uKey ) const
+{
+	if ( !m_uBlocks )
+		return false;
+
+	uint64_t uHash = Mix(uKey);
+	const DWORD * pBlock = m_dWords.Begin() + (int64_t)BlockOf ( uHash, m_uBlocks )*WORDS_PER_BLOCK;
+	for ( int i = 0; i < WORDS_PER_BLOCK; i++ )
+		if ( !( pBlock[i] & BitOf ( uHash, i ) ) )
+			return false;
+
+	return true;
+}
+
+
+bool TermFilter_c::Load ( const CSphString & sFile, const CSphString & sDictFile, int64_t iDictCheckpointsOffset, CSphString & sError )
+{
+	CSphAutoreader tReader;
+	if ( !tReader.Open ( sFile, sError ) )
+		return false;
+
+	DWORD uVersion = tReader.GetDword();
+	if ( uVersion!=TERM_FILTER_VERSION )
+	{
+		sError.SetSprintf ( "unsupported term filter version %u in %s", uVersion, sFile.cstr() );
+		return false;
+	}
+
+	SphOffset_t iFilterOffset = tReader.GetOffset();
+	uint64_t uFilterSignature = (uint64_t)tReader.GetOffset();
+	uint64_t uSignature = 0;
+	if ( !DictSignature ( sDictFile, iDictCheckpointsOffset, uSignature, sError ) )
+		return false;
+
+	if ( iFilterOffset!=iDictCheckpointsOffset || uFilterSignature!=uSignature )
+	{
+		sError.SetSprintf ( "term filter %s does not match the dictionary", sFile.cstr() );
+		return false;
+	}
+
+	m_uBlocks = tReader.GetDword();
+	m_dWords.Reset ( (int64_t)m_uBlocks*WORDS_PER_BLOCK );
+	tReader.GetBytes ( m_dWords.Begin(), (int)m_dWords.GetLengthBytes64() );
+
+	if ( tReader.GetErrorFlag() )
+	{
+		sError = tReader.GetErrorMessage();
+		m_uBlocks = 0;
+		m_dWords.Reset(0);
+		return false;
+	}
+
+	return true;
+}
+
+
+void TermFilterBuilder_c::Build ( TermFilter_c & tFilter ) const
+{
+	int64_t iBits = Max ( m_dKeys.GetLength64()*BITS_PER_TERM, (int64_t)1 );
+	tFilter.m_uBlocks = DWORD ( ( iBits + WORDS_PER_BLOCK*32 - 1 ) / ( WORDS_PER_BLOCK*32 ) );
+	tFilter.m_dWords.Reset ( (int64_t)tFilter.m_uBlocks*WORDS_PER_BLOCK );
+	tFilter.m_dWords.ZeroVec();
+
+	for ( auto uKey : m_dKeys )
+	{
+		uint64_t uHash = Mix(uKey);
+		DWORD * pBlock = tFilter.m_dWords.Begin() + (int64_t)BlockOf ( uHash, tFilter.m_uBlocks )*WORDS_PER_BLOCK;
+		for ( int i = 0; i < WORDS_PER_BLOCK; i++ )
+			pBlock[i] |= BitOf ( uHash, i );
+	}
+}
+
+
+bool TermFilterBuilder_c::Save ( const CSphString & sFile, const CSphString & sDictFile, int64_t iDictCheckpointsOffset, CSphString & sError ) const
+{
+	uint64_t uSignature = 0;
+	if ( !DictSignature ( sDictFile, iDictCheckpointsOffset, uSignature, sError ) )
+		return false;
+
+	TermFilter_c tFilter;
+	Build(tFilter);
+
+	CSphWriter tWriter;
+	if ( !tWriter.OpenFile ( sFile, sError ) )
+		return false;
+
+	tWriter.PutDword ( TERM_FILTER_VERSION );
+	tWriter.PutOffset ( iDictCheckpointsOffset );
+	tWriter.PutOffset ( (SphOffset_t)uSignature );
+	tWriter.PutDword ( tFilter.m_uBlocks );
+	tWriter.PutBytes ( tFilter.m_dWords.Begin(), tFilter.m_dWords.GetLengthBytes64() );
+	tWriter.CloseFile();
+
+	if ( tWriter.IsError() )
+	{
+		sError.SetSprintf ( "error saving term filter to %s", sFile.cstr() );
+		::unlink ( sFile.cstr() );
+		return false;
+	}
+
+	return true;
+}
+
+
+uint64_t TermFilterKey ( const BYTE * pWord, int iLen )
+{
+	return sphFNV64 ( pWord, iLen );
+}
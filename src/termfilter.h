@@ -0,0 +1,48 @@
+//
+// Copyright (c) 2022, Manticore Software LTD (https://manticoresearch.com)
+// All rights reserved
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License. You should have
+// received a copy of the GPL license along with this program; if you
+// did not, you can find it at http://www.gnu.org/
+//
+
+/// @file termfilter.h
+/// Approximate membership filter over the terms of a disk index, to skip dictionary lookups of absent terms
+
+#pragma once
+
+#include "sphinxstd.h"
+
+/// split block bloom filter; no false negatives, so a miss means the term is surely not in the dictionary
+/// the filter is tied to the dictionary it was built along with by a signature of the dictionary file; a filter left from another build is refused
+class TermFilter_c
+{
+	friend class TermFilterBuilder_c;
+
+public:
+	bool		MayContain ( uint64_t uKey ) const;
+	bool		Load ( const CSphString & sFile, const CSphString & sDictFile, int64_t iDictCheckpointsOffset, CSphString & sError );
+	int64_t		GetLengthBytes() const { return m_dWords.GetLengthBytes64(); }
+
+private:
+	CSphFixedVector<DWORD>	m_dWords {0};
+	DWORD					m_uBlocks = 0;
+};
+
+/// collects the keys of the terms while a dictionary is written, then saves the filter next to it (the dictionary must be complete by then)
+class TermFilterBuilder_c
+{
+public:
+	void		Add ( uint64_t uKey )	{ m_dKeys.Add(uKey); }
+	bool		Save ( const CSphString & sFile, const CSphString & sDictFile, int64_t iDictCheckpointsOffset, CSphString & sError ) const;
+
+	void		Build ( TermFilter_c & tFilter ) const;
+
+private:
+	CSphVector<uint64_t>	m_dKeys;
+};
+
+/// dict=crc terms are keyed by their word ids; dict=keywords ones by the keyword bytes
+uint64_t TermFilterKey ( const BYTE * pWord, int iLen );
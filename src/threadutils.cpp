@@ -96,6 +96,7 @@ int GetOsThreadId ()
 #include <atomic>
 #include "event.h"
 #include "optional.h"
+#include "numautils.h"
 
 //////////////////////////////////////////////////////////////////////////
 /// functional threadpool with minimum footprint
@@ -220,6 +221,31 @@ thread_local typename CallStack_c<Key, Value>::Context_c* CallStack_c<Key,Value>
 
 #define LOG_COMPONENT_SVC LOG_COMPONENT_MT << " [" << &m_iOutstandingWork << "]=" << m_iOutstandingWork
 
+// how many ops of each priority class are taken from the secondary queue in one round-robin round
+static const int g_dPriorityWeights[PRIORITY_CLASSES] = { 16, 4, 1 };
+
+const char * PriorityName ( Priority_e ePrio )
+{
+	switch ( ePrio )
+	{
+	case Priority_e::HIGH: return "high";
+	case Priority_e::LOW: return "low";
+	case Priority_e::NORMAL:
+	default: return "normal";
+	}
+}
+
+bool PriorityFromName ( const CSphString & sName, Priority_e & ePrio )
+{
+	for ( int i = 0; i<PRIORITY_CLASSES; ++i )
+		if ( sName==PriorityName ( (Priority_e)i ) )
+		{
+			ePrio = (Priority_e)i;
+			return true;
+		}
+	return false;
+}
+
 /// performs tasks pushed with post() in one or many threads until they done.
 /// Naming convention of members is inherited from boost::asio as drop-in replacement.
 struct Service_t : public TaskService_t//, public Service_i
@@ -229,9 +255,16 @@ struct Service_t : public TaskService_t//, public Service_i
 	bool m_bStopped = false;                	/// dispatcher has been stopped.
 	bool m_bOneThread;                			/// optimize for single-threaded use case
 	sph::Event_c m_tWakeupEvent;				/// event to wake up blocked threads
-	OpSchedule_t m_OpQueue;						/// The queue of handlers that are ready to be delivered
+	OpSchedule_t m_dOpQueues[PRIORITY_CLASSES];	/// The queues of handlers that are ready to be delivered, one per priority class
 	OpSchedule_t m_OpVipQueue;					/// The queue of handlers that have to be delivered BEFORE OpQueue
 
+	// queue accounting (protected by m_dMutex) used for weighted round-robin and wait prediction
+	int m_iVipQueued = 0;
+	int m_dQueued[PRIORITY_CLASSES] {0};
+	int m_dCredits[PRIORITY_CLASSES] {0};
+	int64_t m_dServed[PRIORITY_CLASSES] {0};
+	std::atomic<int64_t> m_iAvgOpUS {0};		/// moving average of op duration (not tracked in one-thread mode)
+
 	// Per-thread call stack to track the state of each thread in the service.
 	using ThreadCallStack_c = CallStack_c<Service_t, TaskServiceThreadInfo_t>;
 
@@ -248,6 +281,11 @@ public:
 		post_immediate_completion ( pOp, false );
 	}
 
+	inline void post_prio_op ( Service_t::operation* pOp, Priority_e ePrio ) // post into secondary queue of given class
+	{
+		post_immediate_completion ( pOp, false, ePrio );
+	}
+
 	inline void defer_op ( Service_t::operation* pOp ) // post into primary queue
 	{
 		post_immediate_completion ( pOp, true );
@@ -287,10 +325,11 @@ public:
 		ScopedMutex_t dLock ( m_dMutex );
 		LOG ( SERVICE, SVC ) << "post";
 		m_OpVipQueue.Push ( pOp );
+		++m_iVipQueued;
 		wake_one_thread_and_unlock ( dLock );
 	}
 
-	void post_immediate_completion ( Service_t::operation * pOp, bool bVip )
+	void post_immediate_completion ( Service_t::operation * pOp, bool bVip, Priority_e ePrio = Priority_e::NORMAL )
 	{
 		if ( m_bOneThread )
 		{
@@ -307,9 +346,14 @@ public:
 		ScopedMutex_t dLock ( m_dMutex );
 		LOG ( SERVICE, MT ) << "post";
 		if ( bVip )
+		{
 			m_OpVipQueue.Push ( pOp );
-		else
-			m_OpQueue.Push ( pOp );
+			++m_iVipQueued;
+		} else
+		{
+			m_dOpQueues[(int)ePrio].Push ( pOp );
+			++m_dQueued[(int)ePrio];
+		}
 		wake_one_thread_and_unlock ( dLock );
 	}
 
@@ -334,7 +378,82 @@ public:
 
 	bool queue_empty() const REQUIRES ( m_dMutex )
 	{
-		return m_OpQueue.Empty () && m_OpVipQueue.Empty ();
+		if ( !m_OpVipQueue.Empty () )
+			return false;
+		for ( const auto & dQueue : m_dOpQueues )
+			if ( !dQueue.Empty () )
+				return false;
+		return true;
+	}
+
+	// vip queue goes first; then classes by weighted round-robin.
+	// New round starts when every non-empty class spent its credits.
+	Service_t::operation * pop_op () REQUIRES ( m_dMutex )
+	{
+		Service_t::operation * pOp = m_OpVipQueue.Front ();
+		if ( pOp )
+		{
+			m_OpVipQueue.Pop ();
+			--m_iVipQueued;
+			return pOp;
+		}
+
+		for ( int iPass = 0; iPass<2; ++iPass )
+		{
+			for ( int i = 0; i<PRIORITY_CLASSES; ++i )
+			{
+				if ( m_dCredits[i]<=0 || m_dOpQueues[i].Empty () )
+					continue;
+
+				pOp = m_dOpQueues[i].Front ();
+				m_dOpQueues[i].Pop ();
+				--m_dCredits[i];
+				--m_dQueued[i];
+				++m_dServed[i];
+				return pOp;
+			}
+
+			for ( int i = 0; i<PRIORITY_CLASSES; ++i )
+				m_dCredits[i] = g_dPriorityWeights[i];
+		}
+
+		assert ( false && "pop_op called on empty queue" );
+		return nullptr;
+	}
+
+	// ops ahead of the new one of given class: whole vip queue, own class, and shares of other classes
+	// which round-robin serves meanwhile.
+	int64_t estimated_wait_us ( Priority_e ePrio, int iThreads ) const
+	{
+		auto iAvgOpUS = m_iAvgOpUS.load ( std::memory_order_relaxed );
+		if ( !iAvgOpUS )
+			return 0;
+
+		int iClass = (int)ePrio;
+		ScopedMutex_t dLock ( m_dMutex );
+		int64_t iAhead = m_iVipQueued + m_dQueued[iClass];
+		int64_t iRounds = m_dQueued[iClass] / g_dPriorityWeights[iClass] + 1;
+		for ( int i = 0; i<PRIORITY_CLASSES; ++i )
+			if ( i!=iClass )
+				iAhead += Min ( (int64_t)m_dQueued[i], iRounds * g_dPriorityWeights[i] );
+		dLock.Unlock ();
+
+		return iAhead * iAvgOpUS / Max ( iThreads, 1 );
+	}
+
+	QueueStats_t queue_stats () const
+	{
+		QueueStats_t tStats;
+		ScopedMutex_t dLock ( m_dMutex );
+		tStats.m_iVip = m_iVipQueued;
+		for ( int i = 0; i<PRIORITY_CLASSES; ++i )
+		{
+			tStats.m_dQueued[i] = m_dQueued[i];
+			tStats.m_dServed[i] = m_dServed[i];
+		}
+		dLock.Unlock ();
+		tStats.m_iAvgOpUS = m_iAvgOpUS.load ( std::memory_order_relaxed );
+		return tStats;
 	}
 
 	bool do_run_one ( ScopedMutex_t& dLock, TaskServiceThreadInfo_t& this_thread )
@@ -351,9 +470,7 @@ public:
 				continue;
 			}
 
-			auto & dOpQueue = m_OpVipQueue.Empty () ? m_OpQueue : m_OpVipQueue;
-			auto * pOp = dOpQueue.Front ();
-			dOpQueue.Pop ();
+			auto * pOp = pop_op ();
 
 			if ( !queue_empty () && !m_bOneThread )
 				wake_one_thread_and_unlock ( dLock );
@@ -361,7 +478,15 @@ public:
 				dLock.Unlock ();
 
 			boost::context::detail::prefetch_range ( pOp, sizeof ( Operation_t ) );
-			pOp->Complete (this);
+			if ( m_bOneThread )
+				pOp->Complete (this);
+			else
+			{
+				auto tmStart = sphMicroTimer ();
+				pOp->Complete (this);
+				auto iAvg = m_iAvgOpUS.load ( std::memory_order_relaxed );
+				m_iAvgOpUS.store ( iAvg + ( sphMicroTimer ()-tmStart-iAvg ) / 16, std::memory_order_relaxed );
+			}
 
 			LOG ( SERVICE, MT ) << "completed & unlocked";
 			if ( this_thread.m_iPrivateOutstandingWork>1 )
@@ -372,11 +497,13 @@ public:
 			else if ( this_thread.m_iPrivateOutstandingWork<1 )
 				work_finished ();
 
+			auto iPrivateOps = this_thread.m_iPrivateOutstandingWork;
 			this_thread.m_iPrivateOutstandingWork = 0;
 			if ( !this_thread.m_dPrivateQueue.Empty ())
 			{
 				dLock.Lock ();
 				m_OpVipQueue.Push ( this_thread.m_dPrivateQueue );
+				m_iVipQueued += (int)iPrivateOps;
 			}
 			return true;
 		}
@@ -705,6 +832,7 @@ class ThreadPool_c final : public Worker_i
 	using Work = Service_t::Work_c;
 
 	const char * m_szName = nullptr;
+	int m_iNumaNode = -1;
 	Service_t m_tService;
 	Optional_T<Work> m_dWork;
 	CSphVector<SphThread_t> m_dThreads;
@@ -745,6 +873,9 @@ class ThreadPool_c final : public Worker_i
 
 	void loop (int iChild)
 	{
+		if ( m_iNumaNode>=0 )
+			Numa::PinCurrentThread ( m_iNumaNode );
+
 		{
 			ScWL_t _ ( m_dChildGuard );
 			m_dChildren[iChild] = &MyThd ();
@@ -767,8 +898,9 @@ class ThreadPool_c final : public Worker_i
 	}
 
 public:
-	ThreadPool_c ( size_t iThreadCount, const char * szName )
+	ThreadPool_c ( size_t iThreadCount, const char * szName, int iNumaNode = -1 )
 		: m_szName {szName}
+		, m_iNumaNode { iNumaNode }
 		, m_tService ( iThreadCount==1 )
 	{
 		createWork ();
@@ -803,6 +935,21 @@ public:
 		PostContinuation ( pOp );
 	}
 
+	void SchedulePrioOp ( Threads::details::SchedulerOperation_t* pOp, Priority_e ePrio ) final
+	{
+		m_tService.post_prio_op ( pOp, ePrio );
+	}
+
+	int64_t EstimatedWaitUS ( Priority_e ePrio ) const final
+	{
+		return m_tService.estimated_wait_us ( ePrio, m_dThreads.GetLength() );
+	}
+
+	QueueStats_t GetQueueStats() const final
+	{
+		return m_tService.queue_stats();
+	}
+
 #define LOG_LEVEL_SERVICE_KEEP_MT false
 #if LOG_LEVEL_SERVICE_KEEP_MT
 	static intptr_t KeepWorkingID()
@@ -983,6 +1130,11 @@ public:
 		m_pScheduler->ScheduleContinuationOp ( pOp );
 	}
 
+	void SchedulePrioOp ( details::SchedulerOperation_t* pOp, Priority_e ePrio ) final
+	{
+		m_pScheduler->SchedulePrioOp ( pOp, ePrio );
+	}
+
 	Keeper_t KeepWorking() final
 	{
 		return m_pScheduler->KeepWorking();
@@ -1000,9 +1152,9 @@ public:
 };
 
 
-WorkerSharedPtr_t MakeThreadPool ( size_t iThreadCount, const char* szName )
+WorkerSharedPtr_t MakeThreadPool ( size_t iThreadCount, const char* szName, int iNumaNode )
 {
-	return WorkerSharedPtr_t { new ThreadPool_c ( iThreadCount, szName ) };
+	return WorkerSharedPtr_t { new ThreadPool_c ( iThreadCount, szName, iNumaNode ) };
 }
 
 WorkerSharedPtr_t MakeAloneThread ( size_t iOrderNum, const char* szName )
@@ -1105,7 +1257,12 @@ void StartGlobalWorkPool ()
 {
 	sphLogDebug ( "StartGlobalWorkpool" );
 	WorkerSharedPtr_t& pPool = GlobalPoolSingletone ();
-	pPool = new ThreadPool_c ( g_iMaxChildrenThreads, "work" );
+
+	// with per-node pools the common pool only handles what is not bound to an index, so it gets a share of one node
+	int iThreads = g_iMaxChildrenThreads;
+	int iCommonThreads = Numa::CommonPoolThreads ( iThreads, Numa::IsEnabled() ? Numa::NodesCount() : 0 );
+	pPool = new ThreadPool_c ( iCommonThreads, "work" );
+	Numa::StartNodePools ( iThreads-iCommonThreads );
 }
 
 void SetMaxChildrenThreads ( int iThreads )
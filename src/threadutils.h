@@ -113,6 +113,20 @@ using Handlers = std::initializer_list<Handler>;
 // used to RAII keep Scheduler running (when work finished - it is usually destroyed)
 using Keeper_t = SharedPtrCustom_t<void>;
 
+// priority class of the work in secondary (non-vip) queue of the thread pool.
+// Classes are served by weighted round-robin, so low class is never starved completely.
+enum class Priority_e : BYTE
+{
+	HIGH,
+	NORMAL,
+	LOW,
+};
+
+static const int PRIORITY_CLASSES = 3;
+
+const char * PriorityName ( Priority_e ePrio );
+bool PriorityFromName ( const CSphString & sName, Priority_e & ePrio );
+
 struct Scheduler_i
 {
 	virtual ~Scheduler_i() = default;
@@ -122,6 +136,10 @@ struct Scheduler_i
 	{
 		ScheduleOp ( pOp, false );
 	}
+	virtual void SchedulePrioOp ( Threads::details::SchedulerOperation_t* pOp, Priority_e ) // secondary queue of given class
+	{
+		ScheduleOp ( pOp, false );
+	}
 	// RAII keeper of scheduler (when it exists, scheduler will not finish). That is necessary, say, if the only work is
 	// paused and moved somewhere (for example, as cb in epoll polling). Without keeper scheduler then finish and it will
 	// be impossible to resume it later.
@@ -143,6 +161,9 @@ struct Scheduler_i
 
 	template<typename HANDLER>
 	void ScheduleContinuation ( HANDLER handler );
+
+	template<typename HANDLER>
+	void SchedulePrio ( HANDLER handler, Priority_e ePrio );
 };
 
 struct SchedulerWithBackend_i: public Scheduler_i
@@ -150,19 +171,32 @@ struct SchedulerWithBackend_i: public Scheduler_i
 	virtual bool SetBackend ( Scheduler_i* pBackend ) = 0;
 };
 
+struct QueueStats_t
+{
+	int m_iVip = 0;								///< ops in primary (vip) queue
+	int m_dQueued[PRIORITY_CLASSES] {0};		///< ops in secondary queue, per priority class
+	int64_t m_dServed[PRIORITY_CLASSES] {0};	///< ops taken from secondary queue, per priority class
+	int64_t m_iAvgOpUS = 0;						///< moving average of time of one op
+};
+
 struct Worker_i: public Scheduler_i
 {
 	virtual int Works() const = 0;
 	virtual void StopAll () = 0;
 	virtual void DiscardOnFork() {}
 	virtual void IterateChildren ( ThreadFN & fnHandler ) {}
+
+	// predicted time new work of given class will wait in the queue before start. 0 if unknown
+	virtual int64_t EstimatedWaitUS ( Priority_e ) const { return 0; }
+	virtual QueueStats_t GetQueueStats() const { return {}; }
 };
 
 using SchedulerSharedPtr_t = SharedPtr_t<Scheduler_i>;
 using WorkerSharedPtr_t = SharedPtr_t<Worker_i>;
 
 // none of the functions below used in the code. Both maybe only in tests.
-WorkerSharedPtr_t MakeThreadPool ( size_t iThreadCount, const char* szName = "" );
+// iNumaNode>=0 binds all threads of the pool to cpus of that node (see numautils.h)
+WorkerSharedPtr_t MakeThreadPool ( size_t iThreadCount, const char* szName = "", int iNumaNode = -1 );
 WorkerSharedPtr_t MakeAloneThread ( size_t iOrderNum, const char* szName = "" );
 
 // Alone scheduler works on top of another scheduler and provides sequental execution of the tasks (each time only one
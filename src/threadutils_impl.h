@@ -260,4 +260,10 @@ void Threads::Scheduler_i::ScheduleContinuation ( HANDLER handler )
 	ScheduleContinuationOp ( Threads::details::Handler2Op ( std::move ( handler ) ) );
 }
 
+template<typename HANDLER>
+void Threads::Scheduler_i::SchedulePrio ( HANDLER handler, Priority_e ePrio )
+{
+	SchedulePrioOp ( Threads::details::Handler2Op ( std::move ( handler ) ), ePrio );
+}
+
 #endif //MANTICORE_THREADUTILS_INC